@@ -1,39 +1,109 @@
-#include <cstring>
-#include <string>
-#include <iostream>
-
-#include "Config.h"
-
-// Initializes config to defaults.
-Config::Config() {
-	memset(mModified, 0, _OPT_LENGTH * sizeof(int));
-	mOutputModified = 0;
-
-
-	memset(mOptions, 0, _OPT_INC * sizeof(int));
-
-	// TODO: Defaults
-	// options
-	// mOutput
-}
-
-
-// Attempts to add an input file to the list.
-bool Config::addInput(std::string const& file) {
-	// TODO
-	return false;
-}
-
-// Attempts to open all of the input files and generate a compound input stream.
-std::istream* openInputs() {
-	// TODO
-
-	return NULL;
-}
-
-// Attempts to open the output file for writing.
-std::ostream* openOutput() {
-	// TODO
-
-	return NULL;
-}
\ No newline at end of file
+#include <cstring>
+#include <string>
+#include <iostream>
+#include <fstream>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "utilities/CompoundFileSource.h"
+#include "elements/Binary.h"
+#include "Config.h"
+
+// Initializes config to defaults.
+Config::Config() {
+	memset(mModified, 0, _OPT_LENGTH * sizeof(int));
+	mOutputModified = 0;
+	mCacheModified = 0;
+	mServeModified = 0;
+	mDecodeModified = 0;
+
+
+	memset(mOptions, 0, _OPT_LENGTH * sizeof(int));
+
+	// TODO: Defaults
+	// options
+	intOpt(OPT_THREADS, 0, false);
+	boolOpt(OPT_PARALLEL_PARSE, false, false);
+	boolOpt(OPT_WRITE_SMT, false, false);
+	intOpt(OPT_MODELS, 1, false);
+	intOpt(OPT_PORTFOLIO, 0, false);
+	intOpt(OPT_CACHE_SIZE, 256, false);
+	intOpt(OPT_WRITE_BINARY, 0, false);
+	boolOpt(OPT_WATCH, false, false);
+	intOpt(OPT_STATS, 0, false);
+	intOpt(OPT_MEMORY_BUDGET, 0, false);
+	boolOpt(OPT_WRITE_DIMACS, false, false);
+	intOpt(OPT_PREFETCH, 0, false);
+	// mOutput
+}
+
+
+// Attempts to add an input file to the list.
+bool Config::addInput(std::string const& file) {
+	try {
+		if (!boost::filesystem::is_regular_file(file)) return false;
+	} catch (boost::filesystem::filesystem_error& e) {
+		return false;
+	}
+
+	if (elements::Binary::recognize(file)) mBinaries.push_back(file);
+	else mInputs.push_back(file);
+	return true;
+}
+
+// Attempts to add a query file to the list.
+bool Config::addQuery(std::string const& file) {
+	try {
+		if (!boost::filesystem::is_regular_file(file)) return false;
+	} catch (boost::filesystem::filesystem_error& e) {
+		return false;
+	}
+
+	mQueries.push_back(file);
+	return true;
+}
+
+// Gets the name a file is displayed by.
+std::string const& Config::name(std::string const& file) const {
+	std::map<std::string, std::string>::const_iterator it = mNames.find(file);
+	return (it != mNames.end()) ? it->second : file;
+}
+
+// Names the file at the start of a message.
+std::string Config::named(std::string const& message) const {
+	for (std::map<std::string, std::string>::const_iterator it = mNames.begin(); it != mNames.end(); it++) {
+		if (message.compare(0, it->first.size(), it->first) == 0 && message.size() > it->first.size() && message[it->first.size()] == ':') {
+			return it->second + message.substr(it->first.size());
+		}
+	}
+	return message;
+}
+
+// Attempts to open all of the input files and generate a compound input stream.
+std::istream* Config::openInputs() {
+	if (mInputs.empty()) return NULL;
+
+	utils::CompoundFileStream* stream = new utils::CompoundFileStream();
+	stream->open(utils::CompoundFileSource());
+
+	for (std::list<std::string>::const_iterator it = mInputs.begin(); it != mInputs.end(); it++) {
+		if (!(*stream)->append(*it)) {
+			delete stream;
+			return NULL;
+		}
+	}
+
+	return stream;
+}
+
+// Attempts to open the output file for writing.
+std::ostream* Config::openOutput() const {
+	if (mOutput.empty()) return new std::ostream(std::cout.rdbuf());
+
+	std::ofstream* out = new std::ofstream(mOutput.c_str(), (intOpt(OPT_WRITE_BINARY)) ? std::ios::out | std::ios::binary : std::ios::out);
+	if (!out->good()) {
+		delete out;
+		return NULL;
+	}
+	return out;
+}
@@ -1,155 +1,301 @@
-#ifndef __H_CONFIG__
-#define __H_CONFIG__
-
-#include <string>
-#include <list>
-#include <iostream>
-
-/**
- * @brief A structure used to maintain and enforce configuration options.
- */
-class Config
-{
-public:
-	/***********************************************************************/
-	/* Public Types */
-	/***********************************************************************/
-
-	/**
-	 * @brief An enumeration of the different configuration options that can be used.
-	 */
-	enum Option
-	{
-		_OPT_BEGIN = 0x00,			///< Fake option used to indicate the beginning of the options enum.
-		_OPT_INC = 0x01,				///< Fake option used for conveniently incrementing the options.
-
-		// TODO
-
-		_OPT_LENGTH = 0x01			///< Fake option used to determine the number of options available.
-	};
-
-private:
-	/***********************************************************************/
-	/* Members */
-	/***********************************************************************/
-
-	int mOptions[_OPT_LENGTH];		///< The set values of each of the options.
-	int mModified[_OPT_LENGTH];		///< The number of times each option has been modified.
-	std::list<std::string> mInputs;	///< A list of files that we will be reading as input.
-
-	std::string mOutput;			///< The file we will be outputting to.
-	int mOutputModified;			///< The  of times the output file has been modified by the user.
-
-public:
-	/***********************************************************************/
-	/* Constructors / Destructors */
-	/***********************************************************************/
-
-	/**
-	 * @brief Basic Constructor.
-	 */
-	Config();
-
-	/**
-	 * @brief Basic Destructor.
-	 * Does nothing.
-	 */
-	virtual inline ~Config()		{ /* Intentionally Left Blank */ }
-
-	/***********************************************************************/
-	/* Accessors / Mutators */
-	/***********************************************************************/
-	
-	/**
-	 * @brief Gets the (integer) value of a configuration option.
-	 * @param opt The option to read.
-	 * @return The integer value of the option.
-	 */
-	inline int intOpt(Option opt) const								{ return mOptions[opt]; }
-
-	/**
-	 * @brief Sets the (integer) value of a configuration option.
-	 * @param opt The option to write.
-	 * @param val The new value of the option.
-	 * @param user Whether we should tally this as a user configuration.
-	 * @return The number of times the option has been written by the user previously.
-	 */
-	inline int intOpt(Option opt, int val, bool user = true)		{ mOptions[opt] = val; return (user) ? mModified[opt]++ : mModified[opt]; }
-
-	/**
-	 * @brief Gets the (boolean) value of a configuration option.
-	 * @param opt The option to read.
-	 * @return The boolean value of the option.
-	 */
-	inline bool boolOpt(Option opt) const							{ return (bool)mOptions[opt]; }
-
-	/**
-	 * @brief Sets the (boolean) value of a configuration option.
-	 * @param opt The option to write.
-	 * @param val The new value of the option.
-	 * @param user Whether we should tally this as a user configuration.
-	 * @return The number of times the option has been written by the user previously.
-	 */
-	inline int boolOpt(Option opt, bool val, bool user = true)		{ mOptions[opt] = (int)val; return (user) ? mModified[opt]++ : mModified[opt]; }
-
-
-	/**
-	 * @brief Determines the number of times an option has been written to by a user.
-	 * @param opt The option to access.
-	 * @return The number of times a user has written to the provided option.
-	 */
-	inline int modCount(Option opt)									{ return mModified[opt]; }
-
-	/**
-	 * @brief Attempts to add an input file to the list.
-	 * @param file The input file to add.
-	 * @return True if the file could be resolved, false otherwise.
-	 */
-	bool addInput(std::string const& file);				
-
-	/**
-	 * @brief Gets an iterator pointing to the beginning of the input files list.
-	 * @return The requested iterator.
-	 */
-	inline std::list<std::string>::const_iterator
-		beginInputs() const											{ return mInputs.begin(); }
-
-	/**
-	 * @brief Gets an iterator pointing to the end of the input files list.
-	 * @return The requested iterator.
-	 */
-	inline std::list<std::string>::const_iterator
-		endInputs() const											{ return mInputs.end(); }
-
-	/**
-	 * @brief Gets the name of the currently configured output file.
-	 * @return The name of the output file.
-	 */
-	inline std::string const& output() const						{ return mOutput; }
-
-	/**
-	 * @brief Sets the name of the file to write output to.
-	 * @param file The new output file.
-	 * @param user Whether this is a user-issued configuration or not.
-	 * @return The number of times the user has changed the output file previously.
-	 */
-	inline int output(std::string const& file, bool user = true)	{ mOutput = file; return (user) ? mOutputModified++ : mOutputModified; }
-
-	/**
-	 * Opens each configured input file and produces a compound input stream.
-	 * @return A compound input stream for all input files or NULL if one or more input file cannot be opened or there are no input files.
-	 */
-	std::istream* openInputs();
-
-	/**
-	 * Opens the configured output file.
-	 * @return The output stream corresponding to the output file or NULL if the output file cannot be opened.
-	 */
-	std::ostream* openOutput();
-
-
-};
-
-
-
-#endif
+#ifndef __H_CONFIG__
+#define __H_CONFIG__
+
+#include <string>
+#include <list>
+#include <map>
+#include <iostream>
+
+/**
+ * @brief A structure used to maintain and enforce configuration options.
+ */
+class Config
+{
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief An enumeration of the different configuration options that can be used.
+	 */
+	enum Option
+	{
+		_OPT_BEGIN = 0x00,			///< Fake option used to indicate the beginning of the options enum.
+		_OPT_INC = 0x01,				///< Fake option used for conveniently incrementing the options.
+
+		OPT_THREADS = 0x00,			///< The number of worker threads to use, or 0 to use one per hardware thread.
+		OPT_PARALLEL_PARSE = 0x01,	///< Whether each input file should be parsed independently (and concurrently) and the results merged.
+		OPT_WRITE_SMT = 0x02,		///< Whether the program should be written as SMT-LIB text rather than solved in-process.
+		OPT_MODELS = 0x03,			///< The maximum number of models to display, or 0 to display every model.
+		OPT_PORTFOLIO = 0x04,		///< The solver configurations to race, a bit for each, or 0 to run the solver directly.
+		OPT_CACHE_SIZE = 0x05,		///< The maximum total size of the translation cache, in megabytes.
+		OPT_WRITE_BINARY = 0x06,	///< The kind of binary program to write instead of solving (an elements::Binary::Kind), or 0 to solve.
+		OPT_WATCH = 0x07,			///< Whether the input files should be watched and the program retranslated whenever they change.
+		OPT_STATS = 0x08,			///< How to write the time and memory taken by each stage (a utils::Stats::Format), or 0 not to.
+		OPT_MEMORY_BUDGET = 0x09,	///< The memory the ground program may take up before it's spilled to disk, in megabytes, or 0 for no limit.
+		OPT_WRITE_DIMACS = 0x0A,	///< Whether the program should be written as DIMACS CNF for a SAT solver rather than solved in-process.
+		OPT_PREFETCH = 0x0B,		///< The memory the following input files may be read ahead into while one is parsed, in megabytes, or 0 not to.
+
+		// TODO
+
+		_OPT_LENGTH = 0x0C			///< Fake option used to determine the number of options available.
+	};
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	int mOptions[_OPT_LENGTH];		///< The set values of each of the options.
+	int mModified[_OPT_LENGTH];		///< The number of times each option has been modified.
+	std::list<std::string> mInputs;	///< A list of files that we will be reading as input.
+	std::list<std::string> mBinaries;	///< A list of binary programs that we will be reading as input.
+	std::list<std::string> mQueries;	///< A list of files to solve incrementally against the program, in order.
+	std::map<std::string, std::string> mNames;	///< The names which files are displayed by, where they differ from their paths.
+
+	std::string mOutput;			///< The file we will be outputting to.
+	int mOutputModified;			///< The  of times the output file has been modified by the user.
+
+	std::string mServe;				///< The socket to serve requests on, or empty if we aren't a server.
+	int mServeModified;				///< The number of times the socket has been modified by the user.
+
+	std::string mCache;				///< The directory translations are cached in, or empty if they aren't cached.
+	int mCacheModified;				///< The number of times the cache directory has been modified by the user.
+
+	std::string mDecode;			///< The DIMACS program to decode a SAT solver's answer for, or empty if we aren't decoding.
+	int mDecodeModified;			///< The number of times the DIMACS program to decode has been modified by the user.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 */
+	Config();
+
+	/**
+	 * @brief Basic Destructor.
+	 * Does nothing.
+	 */
+	virtual inline ~Config()		{ /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/* Accessors / Mutators */
+	/***********************************************************************/
+	
+	/**
+	 * @brief Gets the (integer) value of a configuration option.
+	 * @param opt The option to read.
+	 * @return The integer value of the option.
+	 */
+	inline int intOpt(Option opt) const								{ return mOptions[opt]; }
+
+	/**
+	 * @brief Sets the (integer) value of a configuration option.
+	 * @param opt The option to write.
+	 * @param val The new value of the option.
+	 * @param user Whether we should tally this as a user configuration.
+	 * @return The number of times the option has been written by the user previously.
+	 */
+	inline int intOpt(Option opt, int val, bool user = true)		{ mOptions[opt] = val; return (user) ? mModified[opt]++ : mModified[opt]; }
+
+	/**
+	 * @brief Gets the (boolean) value of a configuration option.
+	 * @param opt The option to read.
+	 * @return The boolean value of the option.
+	 */
+	inline bool boolOpt(Option opt) const							{ return (bool)mOptions[opt]; }
+
+	/**
+	 * @brief Sets the (boolean) value of a configuration option.
+	 * @param opt The option to write.
+	 * @param val The new value of the option.
+	 * @param user Whether we should tally this as a user configuration.
+	 * @return The number of times the option has been written by the user previously.
+	 */
+	inline int boolOpt(Option opt, bool val, bool user = true)		{ mOptions[opt] = (int)val; return (user) ? mModified[opt]++ : mModified[opt]; }
+
+
+	/**
+	 * @brief Determines the number of times an option has been written to by a user.
+	 * @param opt The option to access.
+	 * @return The number of times a user has written to the provided option.
+	 */
+	inline int modCount(Option opt)									{ return mModified[opt]; }
+
+	/**
+	 * @brief Attempts to add an input file to the list.
+	 * Binary programs (see elements::Binary) are recognized by their contents and kept in a list of their own.
+	 * @param file The input file to add.
+	 * @return True if the file could be resolved, false otherwise.
+	 */
+	bool addInput(std::string const& file);				
+
+	/**
+	 * @brief Gets an iterator pointing to the beginning of the input files list.
+	 * @return The requested iterator.
+	 */
+	inline std::list<std::string>::const_iterator
+		beginInputs() const											{ return mInputs.begin(); }
+
+	/**
+	 * @brief Gets an iterator pointing to the end of the input files list.
+	 * @return The requested iterator.
+	 */
+	inline std::list<std::string>::const_iterator
+		endInputs() const											{ return mInputs.end(); }
+
+	/**
+	 * @brief Gets an iterator pointing to the beginning of the binary input files list.
+	 * @return The requested iterator.
+	 */
+	inline std::list<std::string>::const_iterator
+		beginBinaries() const										{ return mBinaries.begin(); }
+
+	/**
+	 * @brief Gets an iterator pointing to the end of the binary input files list.
+	 * @return The requested iterator.
+	 */
+	inline std::list<std::string>::const_iterator
+		endBinaries() const											{ return mBinaries.end(); }
+
+	/**
+	 * @brief Gets the number of configured binary input files.
+	 * @return The number of binary input files.
+	 */
+	inline size_t binaries() const									{ return mBinaries.size(); }
+
+	/**
+	 * @brief Attempts to add a query file to the list.
+	 * Each query is translated separately and solved against the program without retranslating it.
+	 * @param file The query file to add.
+	 * @return True if the file could be resolved, false otherwise.
+	 */
+	bool addQuery(std::string const& file);
+
+	/**
+	 * @brief Gets an iterator pointing to the beginning of the query files list.
+	 * @return The requested iterator.
+	 */
+	inline std::list<std::string>::const_iterator
+		beginQueries() const										{ return mQueries.begin(); }
+
+	/**
+	 * @brief Gets an iterator pointing to the end of the query files list.
+	 * @return The requested iterator.
+	 */
+	inline std::list<std::string>::const_iterator
+		endQueries() const											{ return mQueries.end(); }
+
+	/**
+	 * @brief Gets the number of configured query files.
+	 * @return The number of query files.
+	 */
+	inline size_t queries() const									{ return mQueries.size(); }
+
+	/**
+	 * @brief Gets the name a file is displayed by in output and errors.
+	 * @param file The path of the file.
+	 * @return The name the file was given, or its path if it wasn't given one.
+	 */
+	std::string const& name(std::string const& file) const;
+
+	/**
+	 * @brief Sets the name a file is displayed by in output and errors, such as '-' for a file standing in for a program fragment.
+	 * @param file The path of the file.
+	 * @param display The name to display it by.
+	 */
+	inline void name(std::string const& file, std::string const& display)	{ mNames[file] = display; }
+
+	/**
+	 * @brief Replaces the path of a file at the start of a message (such as a parser's error) with the name the file is displayed by.
+	 * @param message The message.
+	 * @return The message as it's displayed.
+	 */
+	std::string named(std::string const& message) const;
+
+	/**
+	 * @brief Gets the name of the currently configured output file.
+	 * @return The name of the output file.
+	 */
+	inline std::string const& output() const						{ return mOutput; }
+
+	/**
+	 * @brief Sets the name of the file to write output to.
+	 * @param file The new output file.
+	 * @param user Whether this is a user-issued configuration or not.
+	 * @return The number of times the user has changed the output file previously.
+	 */
+	inline int output(std::string const& file, bool user = true)	{ mOutput = file; return (user) ? mOutputModified++ : mOutputModified; }
+
+	/**
+	 * @brief Gets the Unix socket to serve requests on.
+	 * @return The socket path, or the empty string if we aren't running as a server.
+	 */
+	inline std::string const& serve() const							{ return mServe; }
+
+	/**
+	 * @brief Sets the Unix socket to serve requests on.
+	 * @param path The new socket path.
+	 * @param user Whether this is a user-issued configuration or not.
+	 * @return The number of times the user has changed the socket previously.
+	 */
+	inline int serve(std::string const& path, bool user = true)		{ mServe = path; return (user) ? mServeModified++ : mServeModified; }
+
+	/**
+	 * @brief Gets the directory translations are cached in.
+	 * @return The cache directory, or the empty string if translations aren't cached.
+	 */
+	inline std::string const& cache() const							{ return mCache; }
+
+	/**
+	 * @brief Sets the directory to cache translations in.
+	 * @param dir The new cache directory.
+	 * @param user Whether this is a user-issued configuration or not.
+	 * @return The number of times the user has changed the cache directory previously.
+	 */
+	inline int cache(std::string const& dir, bool user = true)		{ mCache = dir; return (user) ? mCacheModified++ : mCacheModified; }
+
+	/**
+	 * @brief Gets the DIMACS program whose SAT solver's answer should be decoded.
+	 * @return The DIMACS file, or the empty string if we aren't decoding.
+	 */
+	inline std::string const& decode() const						{ return mDecode; }
+
+	/**
+	 * @brief Sets the DIMACS program whose SAT solver's answer should be decoded.
+	 * @param file The new DIMACS file.
+	 * @param user Whether this is a user-issued configuration or not.
+	 * @return The number of times the user has changed the DIMACS file previously.
+	 */
+	inline int decode(std::string const& file, bool user = true)	{ mDecode = file; return (user) ? mDecodeModified++ : mDecodeModified; }
+
+	/**
+	 * @brief Gets the number of configured input files.
+	 * @return The number of input files.
+	 */
+	inline size_t inputs() const									{ return mInputs.size(); }
+
+	/**
+	 * Opens each configured input file and produces a compound input stream.
+	 * @return A compound input stream for all input files or NULL if one or more input file cannot be opened or there are no input files.
+	 */
+	std::istream* openInputs();
+
+	/**
+	 * Opens the configured output file.
+	 * If no output file has been configured, a stream writing to the standard output is returned instead.
+	 * The file is opened in binary mode when a binary program is being written.
+	 * @return The output stream corresponding to the output file or NULL if the output file cannot be opened.
+	 */
+	std::ostream* openOutput() const;
+
+
+};
+
+
+
+#endif
@@ -0,0 +1,649 @@
+#include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "DimacsWriter.h"
+
+using namespace elements;
+
+/// The amount of output to accumulate before writing it to the stream.
+#define BUFFER_SIZE (1 << 20)
+
+/// The most values of a function for which at most one is required pairwise, rather than through a sequential counter.
+#define PAIRWISE_LIMIT 6
+
+namespace {
+
+// Appends a number followed by a separator.
+void appendNumber(std::string& out, long value, char sep) {
+	char buf[24];
+	char* p = buf + sizeof(buf);
+	*--p = sep;
+	unsigned long v = (value < 0) ? 0 - (unsigned long)value : (unsigned long)value;
+	do {
+		*--p = (char)('0' + v % 10);
+		v /= 10;
+	} while (v);
+	if (value < 0) *--p = '-';
+	out.append(p, buf + sizeof(buf) - p);
+}
+
+// Gets how an element is displayed.
+std::string display(Symbol const* object, long value) {
+	if (object) return object->name();
+	std::ostringstream s;
+	s << value;
+	return s.str();
+}
+
+}
+
+// Constructor
+DimacsWriter::DimacsWriter(std::ostream& out)
+	: mOut(out), mWritten(0), mSymbols(NULL), mTrue(0), mVars(0), mCount(0), mFailed(false) {
+	/* Intentionally Left Blank */
+}
+
+// Destructor
+DimacsWriter::~DimacsWriter() {
+	flush(true);
+}
+
+// Declares the program's symbols.
+bool DimacsWriter::declare(SymbolTable const& symbols) {
+	mSymbols = &symbols;
+	mTrue = ++mVars;
+	mClauses.push_back(mTrue);
+	mClauses.push_back(0);
+	mCount++;
+
+	for (size_t i = 0; i < symbols.size(); i++) {
+		Symbol const* s = symbols[i];
+		if (!s->constant()) continue;
+
+		// Each argument, and the value of a function, must come from a finite domain.
+		bool finite = s->type() == Symbol::PREDICATE || (s->sort() != symbols.integer() && s->sort() != symbols.boolean());
+		for (size_t a = 0; finite && a < s->args().size(); a++) {
+			finite = s->args()[a] != symbols.integer() && s->args()[a] != symbols.boolean();
+		}
+		if (!finite) {
+			std::ostringstream what;
+			what << "'" << s->name() << "/" << s->arity() << "' doesn't range over finite domains";
+			unsupported(what.str());
+			return false;
+		}
+
+		std::vector<Symbol const*> sorts(s->args().begin(), s->args().end());
+		if (s->type() == Symbol::FUNCTION) sorts.push_back(s->sort());
+		for (std::vector<Symbol const*>::const_iterator it = sorts.begin(); it != sorts.end(); it++) {
+			Symbol::DomainList const& domain = (*it)->domain();
+			for (size_t d = 0; d < domain.size(); d++) {
+				mPositions.insert(PositionMap::value_type(std::make_pair(*it, Value(domain[d].object, (domain[d].object) ? 0 : domain[d].value)), d));
+			}
+		}
+
+		Constant c;
+		c.base = mVars + 1;
+		c.width = (s->type() == Symbol::FUNCTION) ? s->sort()->domain().size() : 1;
+		mConstants[s] = c;
+
+		// Instances are numbered with the first argument changing fastest, which is the order they're displayed in.
+		size_t instances = 1;
+		for (size_t a = 0; a < s->args().size(); a++) instances *= s->args()[a]->domain().size();
+		std::vector<size_t> pos(s->args().size(), 0);
+		for (size_t n = 0; n < instances; n++) {
+			std::string label = s->name();
+			for (size_t a = 0; a < pos.size(); a++) {
+				Symbol::Element const& e = s->args()[a]->domain()[pos[a]];
+				label += (a) ? "," : "(";
+				label += display(e.object, e.value);
+			}
+			if (pos.size()) label += ")";
+
+			if (s->type() == Symbol::PREDICATE) {
+				mLabels.push_back(std::make_pair(++mVars, label));
+			} else {
+				Symbol::DomainList const& values = s->sort()->domain();
+				for (size_t v = 0; v < values.size(); v++) {
+					mLabels.push_back(std::make_pair(++mVars, label + "=" + display(values[v].object, values[v].value)));
+				}
+			}
+
+			size_t a = 0;
+			while (a < pos.size() && ++pos[a] == s->args()[a]->domain().size()) pos[a++] = 0;
+		}
+
+		// The variables of the instances follow each other, so a function only takes exactly one value once they're all numbered.
+		if (s->type() == Symbol::FUNCTION) {
+			for (size_t n = 0; n < instances; n++) {
+				std::vector<Literal> vars;
+				for (size_t v = 0; v < c.width; v++) vars.push_back(c.base + (Literal)(n * c.width + v));
+				exactlyOne(vars);
+			}
+		}
+	}
+	return true;
+}
+
+// Adds a formula.
+bool DimacsWriter::add(Node const* formula) {
+	// Conjunctions at the top of a formula are added one conjunct at a time, and disjunctions as clauses.
+	if (formula->type() == Node::AND) {
+		for (size_t i = 0; i < formula->arity(); i++) {
+			if (!add(formula->arg(i))) return false;
+		}
+		return true;
+	}
+
+	std::vector<Literal> lits;
+	if (formula->type() == Node::OR) {
+		for (size_t i = 0; i < formula->arity(); i++) lits.push_back(literal(formula->arg(i)));
+	} else {
+		lits.push_back(literal(formula));
+	}
+	if (std::find(lits.begin(), lits.end(), 0) != lits.end()) return false;
+	clause(lits);
+	return true;
+}
+
+// Writes the program.
+bool DimacsWriter::finish() {
+	if (mFailed) return false;
+
+	mBuffer += "c Written by aspmt2smt. The atom or function value of each variable is:\n";
+	for (std::vector<std::pair<Literal, std::string> >::const_iterator it = mLabels.begin(); it != mLabels.end(); it++) {
+		mBuffer += "c ";
+		appendNumber(mBuffer, it->first, ' ');
+		mBuffer += it->second;
+		mBuffer += "\n";
+		flush();
+	}
+
+	mBuffer += "p cnf ";
+	appendNumber(mBuffer, mVars, ' ');
+	appendNumber(mBuffer, (long)mCount, '\n');
+	for (size_t i = 0; i < mClauses.size(); i++) {
+		appendNumber(mBuffer, mClauses[i], (mClauses[i]) ? ' ' : '\n');
+		if (!mClauses[i]) flush();
+	}
+	return flush(true);
+}
+
+// Opens a scope.
+bool DimacsWriter::push(std::string const& name, Symbol::SymbolList const& symbols) {
+	std::cerr << "Error: Queries can't be written as DIMACS.\n";
+	return false;
+}
+
+// Checks the formulas so far.
+bool DimacsWriter::check() {
+	std::cerr << "Error: Queries can't be written as DIMACS.\n";
+	return false;
+}
+
+// Closes a scope.
+bool DimacsWriter::pop() {
+	std::cerr << "Error: Queries can't be written as DIMACS.\n";
+	return false;
+}
+
+// Lets go of the nodes added so far.
+bool DimacsWriter::release() {
+	// Gates are kept, since they're keyed by literals rather than nodes.
+	mLiterals.clear();
+	mValues.clear();
+	return true;
+}
+
+// Counts the bytes written.
+size_t DimacsWriter::written() const {
+	return mWritten + mBuffer.size();
+}
+
+// Displays a SAT solver's answer.
+bool DimacsWriter::decode(std::string const& cnf, std::istream& answer, std::ostream& out) {
+	std::ifstream in(cnf.c_str());
+	if (!in.good()) {
+		std::cerr << "Error: Couldn't open the DIMACS file '" << cnf << "'.\n";
+		return false;
+	}
+
+	// The labels are listed in the comments ahead of the problem line.
+	std::vector<std::pair<long, std::string> > labels;
+	std::string line;
+	bool problem = false;
+	while (!problem && std::getline(in, line)) {
+		problem = !line.empty() && line[0] == 'p';
+		if (line.size() < 3 || line[0] != 'c' || line[1] != ' ') continue;
+		char* end;
+		long var = strtol(line.c_str() + 2, &end, 10);
+		if (var > 0 && *end == ' ') labels.push_back(std::make_pair(var, std::string(end + 1)));
+	}
+	if (!problem) {
+		std::cerr << "Error: '" << cnf << "' isn't a DIMACS file written by aspmt2smt.\n";
+		return false;
+	}
+
+	// Either "s <status>" followed by "v <literals>" lines, or MiniSat's status followed by a line of literals.
+	std::string status;
+	std::vector<bool> values;
+	while (std::getline(answer, line)) {
+		std::istringstream words(line);
+		std::string word;
+		if (!(words >> word) || word == "c") continue;
+		if (word == "s") {
+			words >> status;
+			continue;
+		}
+		if (word == "SAT" || word == "UNSAT" || word == "INDET") {
+			status = (word == "SAT") ? "SATISFIABLE" : (word == "UNSAT") ? "UNSATISFIABLE" : "UNKNOWN";
+			continue;
+		}
+		if (word != "v") words.seekg(0);
+
+		long lit;
+		while (words >> lit) {
+			size_t var = (size_t)((lit < 0) ? -lit : lit);
+			if (var >= values.size()) values.resize(var + 1, false);
+			values[var] = lit > 0;
+		}
+	}
+	if (answer.bad()) {
+		std::cerr << "Error: Couldn't read the SAT solver's answer.\n";
+		return false;
+	}
+
+	if (status == "SATISFIABLE") {
+		std::string model;
+		for (std::vector<std::pair<long, std::string> >::const_iterator it = labels.begin(); it != labels.end(); it++) {
+			if ((size_t)it->first >= values.size() || !values[it->first]) continue;
+			if (!model.empty()) model += " ";
+			model += it->second;
+		}
+		out << "Answer: 1\n" << model << "\nSATISFIABLE\n";
+	} else if (status == "UNSATISFIABLE") {
+		out << "UNSATISFIABLE\n";
+	} else {
+		out << "UNKNOWN\n";
+	}
+	return out.good();
+}
+
+// Reports something outside of the fragment.
+DimacsWriter::Literal DimacsWriter::unsupported(std::string const& what) {
+	if (!mFailed) {
+		std::cerr << "Error: " << what << ", so the program isn't propositional or finite-domain and can't be written as DIMACS.\n";
+		mFailed = true;
+	}
+	return 0;
+}
+
+// Gets the literal of a formula.
+DimacsWriter::Literal DimacsWriter::literal(Node const* formula) {
+	LiteralMap::const_iterator found = mLiterals.find(formula);
+	if (found != mLiterals.end()) return found->second;
+
+	Literal l = 0;
+	switch (formula->type()) {
+	case Node::TRUE:		l = mTrue; break;
+	case Node::FALSE:		l = -mTrue; break;
+	case Node::NOT:			l = -literal(formula->arg(0)); break;
+
+	case Node::AND:
+	case Node::OR:
+	case Node::IMPLIES:
+		{
+			std::vector<Literal> lits;
+			for (size_t i = 0; i < formula->arity(); i++) {
+				lits.push_back(literal(formula->arg(i)));
+				if (!lits.back()) return 0;
+			}
+			if (formula->type() == Node::IMPLIES) lits[0] = -lits[0];
+			l = (formula->type() == Node::AND) ? conjoin(lits) : disjoin(lits);
+			break;
+		}
+
+	case Node::IFF:
+		{
+			Literal a = literal(formula->arg(0));
+			Literal b = literal(formula->arg(1));
+			if (a && b) l = equivalent(a, b);
+			break;
+		}
+
+	case Node::APPLY:
+		{
+			// An atom holds if it refers to an instance which holds.
+			InstanceList refs;
+			if (formula->symbol()->type() != Symbol::PREDICATE || !instances(formula, refs)) break;
+			Literal base = mConstants[formula->symbol()].base;
+			std::vector<Literal> lits;
+			for (InstanceList::const_iterator it = refs.begin(); it != refs.end(); it++) lits.push_back(conjoin(it->second, base + (Literal)it->first));
+			l = disjoin(lits);
+			break;
+		}
+
+	case Node::EQ:
+	case Node::LT:
+	case Node::LE:
+	case Node::GT:
+	case Node::GE:
+		l = compare(formula);
+		break;
+
+	default:
+		break;
+	}
+
+	if (!l) {
+		std::ostringstream what;
+		what << "'" << *formula << "' can't be encoded";
+		return unsupported(what.str());
+	}
+	mLiterals[formula] = l;
+	return l;
+}
+
+// Gets the values of a term.
+DimacsWriter::ValueList const* DimacsWriter::values(Node const* term) {
+	ValueMap::const_iterator found = mValues.find(term);
+	if (found != mValues.end()) return &found->second;
+
+	ValueList choices;
+	bool ok = true, overflow = false;
+	switch (term->type()) {
+	case Node::INTEGER:
+		choices.push_back(std::make_pair(Value(NULL, term->value()), mTrue));
+		break;
+
+	case Node::APPLY:
+		if (term->symbol()->type() == Symbol::OBJECT) {
+			choices.push_back(std::make_pair(Value(term->symbol(), 0), mTrue));
+		} else if (term->symbol()->type() == Symbol::FUNCTION) {
+			// A function takes a value whenever it refers to an instance which takes it.
+			InstanceList refs;
+			if (!(ok = instances(term, refs))) break;
+			Constant const& c = mConstants[term->symbol()];
+			Symbol::DomainList const& domain = term->symbol()->sort()->domain();
+			for (InstanceList::const_iterator it = refs.begin(); it != refs.end(); it++) {
+				for (size_t v = 0; v < domain.size(); v++) {
+					Literal var = c.base + (Literal)(it->first * c.width + v);
+					choices.push_back(std::make_pair(Value(domain[v].object, (domain[v].object) ? 0 : domain[v].value), conjoin(it->second, var)));
+				}
+			}
+		} else {
+			ok = false;
+		}
+		break;
+
+	case Node::PLUS:
+	case Node::MINUS:
+	case Node::TIMES:
+	case Node::DIVIDE:
+		{
+			ValueList const* a = values(term->arg(0));
+			ValueList const* b = (a) ? values(term->arg(1)) : NULL;
+			if (!a || !b) return NULL;
+			for (ValueList::const_iterator x = a->begin(); ok && x != a->end(); x++) {
+				for (ValueList::const_iterator y = b->begin(); ok && y != b->end(); y++) {
+					long p = x->first.second;
+					long q = y->first.second;
+					if (x->first.first || y->first.first || (term->type() == Node::DIVIDE && !q)) {
+						ok = false;
+						break;
+					}
+
+					// Values which overflow can't be represented, unlike in SMT-LIB.
+					long r;
+					switch (term->type()) {
+					case Node::PLUS:		overflow = __builtin_add_overflow(p, q, &r); break;
+					case Node::MINUS:		overflow = __builtin_sub_overflow(p, q, &r); break;
+					case Node::TIMES:		overflow = __builtin_mul_overflow(p, q, &r); break;
+					default:
+						// Division rounds so that the remainder isn't negative, as it does in SMT-LIB.
+						// Dividing by -1 is negation, since LONG_MIN / -1 overflows.
+						if (q == -1) {
+							overflow = __builtin_sub_overflow(0L, p, &r);
+						} else {
+							r = p / q;
+							if (p % q < 0) r += (q > 0) ? -1 : 1;
+						}
+						break;
+					}
+					if (overflow) {
+						ok = false;
+						break;
+					}
+					choices.push_back(std::make_pair(Value(NULL, r), conjoin(x->second, y->second)));
+				}
+			}
+			break;
+		}
+
+	case Node::NEGATE:
+		{
+			ValueList const* a = values(term->arg(0));
+			if (!a) return NULL;
+			for (ValueList::const_iterator x = a->begin(); ok && x != a->end(); x++) {
+				long r;
+				overflow = __builtin_sub_overflow(0L, x->first.second, &r);
+				ok = !x->first.first && !overflow;
+				choices.push_back(std::make_pair(Value(NULL, r), x->second));
+			}
+			break;
+		}
+
+	default:
+		ok = false;
+		break;
+	}
+
+	if (!ok) {
+		std::ostringstream what;
+		what << "The term '" << *term << "' can't be encoded" << ((overflow) ? ", as one of its values is out of range" : "");
+		unsupported(what.str());
+		return NULL;
+	}
+	return &(mValues[term] = merge(choices));
+}
+
+// Gets the instances an application refers to.
+bool DimacsWriter::instances(Node const* node, InstanceList& out) {
+	Symbol const* s = node->symbol();
+	out.assign(1, std::make_pair((size_t)0, mTrue));
+
+	size_t stride = 1;
+	for (size_t a = 0; a < node->arity(); a++) {
+		ValueList const* args = values(node->arg(a));
+		if (!args) return false;
+
+		InstanceList next;
+		for (InstanceList::const_iterator it = out.begin(); it != out.end(); it++) {
+			for (ValueList::const_iterator v = args->begin(); v != args->end(); v++) {
+				// An argument outside of the domain of its sort refers to a value the program says nothing about.
+				PositionMap::const_iterator pos = mPositions.find(std::make_pair(s->args()[a], v->first));
+				if (pos == mPositions.end()) {
+					std::ostringstream what;
+					what << "'" << *node << "' is applied outside of the domain of '" << s->args()[a]->name() << "'";
+					unsupported(what.str());
+					return false;
+				}
+				next.push_back(std::make_pair(it->first + pos->second * stride, conjoin(it->second, v->second)));
+			}
+		}
+		out.swap(next);
+		stride *= s->args()[a]->domain().size();
+	}
+	return true;
+}
+
+// Compares two terms.
+DimacsWriter::Literal DimacsWriter::compare(Node const* node) {
+	ValueList const* a = values(node->arg(0));
+	ValueList const* b = (a) ? values(node->arg(1)) : NULL;
+	if (!a || !b) return 0;
+
+	std::vector<Literal> lits;
+	for (ValueList::const_iterator x = a->begin(); x != a->end(); x++) {
+		for (ValueList::const_iterator y = b->begin(); y != b->end(); y++) {
+			// Objects can only be compared for equality.
+			if (node->type() != Node::EQ && (x->first.first || y->first.first)) return 0;
+
+			long p = x->first.second;
+			long q = y->first.second;
+			bool holds;
+			switch (node->type()) {
+			case Node::EQ:		holds = x->first == y->first; break;
+			case Node::LT:		holds = p < q; break;
+			case Node::LE:		holds = p <= q; break;
+			case Node::GT:		holds = p > q; break;
+			default:			holds = p >= q; break;
+			}
+			if (holds) lits.push_back(conjoin(x->second, y->second));
+		}
+	}
+	return disjoin(lits);
+}
+
+// Gets the literal of a conjunction.
+DimacsWriter::Literal DimacsWriter::conjoin(std::vector<Literal> lits) {
+	// TRUE is dropped, FALSE (or a literal along with its negation) absorbs the rest, and the rest are shared regardless of their order.
+	std::sort(lits.begin(), lits.end());
+	lits.erase(std::unique(lits.begin(), lits.end()), lits.end());
+	lits.erase(std::remove(lits.begin(), lits.end(), mTrue), lits.end());
+	for (std::vector<Literal>::const_iterator it = lits.begin(); it != lits.end(); it++) {
+		if (*it == -mTrue || std::binary_search(lits.begin(), lits.end(), -*it)) return -mTrue;
+	}
+	if (lits.empty()) return mTrue;
+	if (lits.size() == 1) return lits[0];
+
+	GateMap::const_iterator found = mGates.find(lits);
+	if (found != mGates.end()) return found->second;
+
+	// g <-> (a & b & ...)
+	Literal g = ++mVars;
+	std::vector<Literal> all(1, g);
+	for (std::vector<Literal>::const_iterator it = lits.begin(); it != lits.end(); it++) {
+		std::vector<Literal> c(1, -g);
+		c.push_back(*it);
+		clause(c);
+		all.push_back(-*it);
+	}
+	clause(all);
+
+	mGates[lits] = g;
+	return g;
+}
+
+// Gets the literal of a disjunction.
+DimacsWriter::Literal DimacsWriter::disjoin(std::vector<Literal> const& lits) {
+	std::vector<Literal> negated;
+	for (std::vector<Literal>::const_iterator it = lits.begin(); it != lits.end(); it++) negated.push_back(-*it);
+	return -conjoin(negated);
+}
+
+// Gets the literal of the conjunction of two literals.
+DimacsWriter::Literal DimacsWriter::conjoin(Literal a, Literal b) {
+	if (a == mTrue) return b;
+	if (b == mTrue) return a;
+	std::vector<Literal> lits(1, a);
+	lits.push_back(b);
+	return conjoin(lits);
+}
+
+// Gets the literal of an equivalence.
+DimacsWriter::Literal DimacsWriter::equivalent(Literal a, Literal b) {
+	if (a == b) return mTrue;
+	if (a == -b) return -mTrue;
+	if (a == mTrue || a == -mTrue) return (a == mTrue) ? b : -b;
+	if (b == mTrue || b == -mTrue) return (b == mTrue) ? a : -a;
+
+	// a <-> b is (a & b) | (-a & -b).
+	std::vector<Literal> lits(1, conjoin(a, b));
+	lits.push_back(conjoin(-a, -b));
+	return disjoin(lits);
+}
+
+// Adds a clause.
+void DimacsWriter::clause(std::vector<Literal> lits) {
+	std::sort(lits.begin(), lits.end());
+	lits.erase(std::unique(lits.begin(), lits.end()), lits.end());
+	for (std::vector<Literal>::const_iterator it = lits.begin(); it != lits.end(); it++) {
+		if (*it == mTrue || std::binary_search(lits.begin(), lits.end(), -*it)) return;
+	}
+	lits.erase(std::remove(lits.begin(), lits.end(), -mTrue), lits.end());
+
+	mClauses.insert(mClauses.end(), lits.begin(), lits.end());
+	mClauses.push_back(0);
+	mCount++;
+}
+
+// Requires exactly one of some literals.
+void DimacsWriter::exactlyOne(std::vector<Literal> const& lits) {
+	if (lits.size() <= PAIRWISE_LIMIT) {
+		clause(lits);
+		for (size_t i = 0; i < lits.size(); i++) {
+			for (size_t j = i + 1; j < lits.size(); j++) {
+				std::vector<Literal> c(1, -lits[i]);
+				c.push_back(-lits[j]);
+				clause(c);
+			}
+		}
+		return;
+	}
+
+	// At least one, and at most one through a sequential counter: s[i] holds once any of the first i + 1 literals does.
+	clause(lits);
+	Literal prev = 0;
+	for (size_t i = 0; i + 1 < lits.size(); i++) {
+		Literal s = ++mVars;
+		std::vector<Literal> c(1, -lits[i]);
+		c.push_back(s);
+		clause(c);
+		if (prev) {
+			std::vector<Literal> carry(1, -prev);
+			carry.push_back(s);
+			clause(carry);
+			std::vector<Literal> once(1, -lits[i]);
+			once.push_back(-prev);
+			clause(once);
+		}
+		prev = s;
+	}
+	std::vector<Literal> last(1, -lits.back());
+	last.push_back(-prev);
+	clause(last);
+}
+
+// Merges the values listed more than once.
+DimacsWriter::ValueList DimacsWriter::merge(ValueList const& choices) {
+	std::vector<Value> order;
+	boost::unordered_map<Value, std::vector<Literal> > conditions;
+	for (ValueList::const_iterator it = choices.begin(); it != choices.end(); it++) {
+		std::vector<Literal>& c = conditions[it->first];
+		if (c.empty()) order.push_back(it->first);
+		c.push_back(it->second);
+	}
+
+	ValueList out;
+	for (std::vector<Value>::const_iterator it = order.begin(); it != order.end(); it++) {
+		Literal l = disjoin(conditions[*it]);
+		if (l != -mTrue) out.push_back(std::make_pair(*it, l));
+	}
+	return out;
+}
+
+// Writes out the buffer.
+bool DimacsWriter::flush(bool force) {
+	if (force || mBuffer.size() >= BUFFER_SIZE) {
+		mOut.write(mBuffer.data(), mBuffer.size());
+		mWritten += mBuffer.size();
+		mBuffer.clear();
+		if (force) mOut.flush();
+	}
+	return mOut.good();
+}
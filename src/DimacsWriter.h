@@ -0,0 +1,181 @@
+#ifndef __H_DIMACS_WRITER__
+#define __H_DIMACS_WRITER__
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+
+#include <boost/unordered_map.hpp>
+
+#include "SMTWriter.h"
+
+/**
+ * @brief Writes the translated program as CNF in the DIMACS format, for SAT solvers.
+ * Only programs in the propositional or finite-domain fragment can be written: every constant must take
+ * arguments from, and (for functions) a value in, a sort with a finite domain, and every ground formula
+ * must be free of quantifiers. Whether a program is in the fragment is only known once its symbols have been
+ * declared and its formulas added, so nothing is written until it's finished, and an error is reported for the
+ * first symbol or formula outside of the fragment instead.
+ *
+ * Each atom is a variable, as is each value of each function applied to its arguments, along with clauses saying
+ * that the function takes exactly one of its values. Comparisons and arithmetic over functions are expanded over
+ * the values their operands can take. The formulas are then given the Tseitin encoding: each connective becomes a
+ * variable equivalent to it, shared between every occurrence of the same node, and of the same connective over the
+ * same literals. Conjunctions and disjunctions at the top of a formula become clauses directly.
+ *
+ * The variable of every atom and function value is listed in comments ahead of the problem line, so that
+ * a SAT solver's answer can be displayed in terms of the program's constants again (see decode()).
+ */
+class DimacsWriter : public SMTWriter {
+
+private:
+	/***********************************************************************/
+	/* Private Types */
+	/***********************************************************************/
+
+	/// A literal: a variable, or the negation of one.
+	typedef int Literal;
+
+	/// A value of a term: an object, or an integer if the object is NULL.
+	typedef std::pair<elements::Symbol const*, long> Value;
+
+	/// The values a term can take, each along with the literal which holds whenever the term takes it.
+	typedef std::vector<std::pair<Value, Literal> > ValueList;
+
+	/// The instances of a constant an application may refer to, each along with the literal which holds whenever it does.
+	typedef std::vector<std::pair<size_t, Literal> > InstanceList;
+
+	/**
+	 * @brief The variables of a constant.
+	 */
+	struct Constant {
+		Literal base;							///< The variable of the first value of the constant's first instance.
+		size_t width;							///< The number of variables of each instance: 1 for predicates, and the number of values for functions.
+	};
+
+	typedef boost::unordered_map<elements::Symbol const*, Constant> ConstantMap;
+	typedef boost::unordered_map<std::pair<elements::Symbol const*, Value>, size_t> PositionMap;
+	typedef boost::unordered_map<elements::Node const*, Literal> LiteralMap;
+	typedef boost::unordered_map<elements::Node const*, ValueList> ValueMap;
+	typedef boost::unordered_map<std::vector<Literal>, Literal> GateMap;
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	std::ostream& mOut;						///< The stream we're writing to.
+	std::string mBuffer;					///< The output which hasn't been flushed to the stream yet.
+	size_t mWritten;						///< The number of bytes flushed to the stream so far.
+
+	elements::SymbolTable const* mSymbols;	///< The symbols of the program.
+	ConstantMap mConstants;					///< The variables of each constant.
+	PositionMap mPositions;					///< The position of each value within the domain of each sort.
+	std::vector<std::pair<Literal, std::string> > mLabels;	///< The atom or function value of each variable, as it's displayed.
+
+	Literal mTrue;							///< The variable which is always true.
+	Literal mVars;							///< The number of variables so far.
+	std::vector<Literal> mClauses;			///< The clauses so far, each followed by a 0.
+	size_t mCount;							///< The number of clauses so far.
+	GateMap mGates;							///< The variable equivalent to the conjunction of each (sorted) set of literals.
+	LiteralMap mLiterals;					///< The literal equivalent to each formula added so far.
+	ValueMap mValues;						///< The values of each term added so far.
+	bool mFailed;							///< Whether something outside of the fragment has been reported.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param out The stream to write to, which should outlive the writer.
+	 */
+	DimacsWriter(std::ostream& out);
+
+	/**
+	 * @brief Basic Destructor.
+	 * Flushes any buffered output.
+	 */
+	virtual ~DimacsWriter();
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	virtual bool declare(elements::SymbolTable const& symbols);
+	virtual bool add(elements::Node const* formula);
+	virtual bool finish();
+
+	/**
+	 * @brief Scopes can't be written as DIMACS, so this always fails.
+	 */
+	virtual bool push(std::string const& name, elements::Symbol::SymbolList const& symbols);
+
+	/**
+	 * @brief Scopes can't be written as DIMACS, so this always fails.
+	 */
+	virtual bool check();
+
+	/**
+	 * @brief Scopes can't be written as DIMACS, so this always fails.
+	 */
+	virtual bool pop();
+
+	virtual bool release();
+	virtual size_t written() const;
+
+	/**
+	 * @brief Displays a SAT solver's answer for a program written as DIMACS in terms of the program's constants.
+	 * The answer may either be in the format of the SAT competitions (an "s" line and "v" lines) or in that of
+	 * MiniSat's result file. It's displayed as the in-process solver would display it.
+	 * @param cnf The file the program was written to.
+	 * @param answer The stream to read the answer from.
+	 * @param out The stream to display the answer on.
+	 * @return True if successful, false if either file couldn't be read. Errors are reported to the standard error.
+	 */
+	static bool decode(std::string const& cnf, std::istream& answer, std::ostream& out);
+
+private:
+
+	/// Reports a symbol or formula outside of the fragment, unless something else already has been. Returns 0.
+	Literal unsupported(std::string const& what);
+
+	/// Gets the literal equivalent to a formula, or 0 if it's outside of the fragment.
+	Literal literal(elements::Node const* formula);
+
+	/// Gets the values a term can take, or NULL if it's outside of the fragment.
+	ValueList const* values(elements::Node const* term);
+
+	/// Gets the instances an application of a constant may refer to, depending on the values of its arguments. Returns false if it's outside of the fragment.
+	bool instances(elements::Node const* node, InstanceList& out);
+
+	/// Gets the literal equivalent to a comparison between two terms, or 0 if it's outside of the fragment.
+	Literal compare(elements::Node const* node);
+
+	/// Gets the literal equivalent to the conjunction of some literals, creating a gate for it if there isn't already one.
+	Literal conjoin(std::vector<Literal> lits);
+
+	/// Gets the literal equivalent to the disjunction of some literals.
+	Literal disjoin(std::vector<Literal> const& lits);
+
+	/// Gets the literal equivalent to the conjunction of two literals.
+	Literal conjoin(Literal a, Literal b);
+
+	/// Gets the literal equivalent to two literals being equivalent.
+	Literal equivalent(Literal a, Literal b);
+
+	/// Adds a clause, unless it's always satisfied.
+	void clause(std::vector<Literal> lits);
+
+	/// Adds clauses saying that exactly one of some literals holds.
+	void exactlyOne(std::vector<Literal> const& lits);
+
+	/// Combines the literals of each value listed more than once, keeping the values in the order they were first listed.
+	ValueList merge(ValueList const& choices);
+
+	/// Writes out the buffer if it's grown large enough, or always if forced.
+	bool flush(bool force = false);
+
+};
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef __H_SMT_WRITER__
+#define __H_SMT_WRITER__
+
+#include <string>
+
+#include "elements/Symbol.h"
+#include "elements/Node.h"
+#include "elements/Program.h"
+#include "elements/Spill.h"
+#include "utilities/Stats.h"
+
+/**
+ * @brief An interface for the backends which receive the translated program.
+ * A writer is given the program's declarations once and then each ground formula as soon as
+ * it's finalized, so that a backend can stream its output rather than building it up in memory.
+ *
+ * When solving incrementally, the program is added once and each query is then added within its
+ * own scope and checked, so the solver can reuse its work on the program from one query to the next.
+ *
+ * Writing a complete theory is measured as two stages, write (everything up to finishing) and solve.
+ *
+ * The formulas of a theory which didn't fit in memory are given a partition at a time (see elements::Spill),
+ * and the writer is told to let go of each partition's nodes before the next is read into their place.
+ */
+class SMTWriter {
+
+protected:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	utils::Stats* mStats;					///< The stats to record writing the theory in, or NULL.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 */
+	inline SMTWriter() : mStats(NULL) { /* Intentionally Left Blank */ }
+
+	/**
+	 * @brief Basic Destructor.
+	 * Does nothing.
+	 */
+	virtual inline ~SMTWriter() { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Declares the sorts, objects and constants of the program.
+	 * Must be called once before any formulas are added.
+	 * @param symbols The symbols of the program, which should outlive the writer.
+	 * @return True if successful, false otherwise.
+	 */
+	virtual bool declare(elements::SymbolTable const& symbols) = 0;
+
+	/**
+	 * @brief Adds a formula to the program.
+	 * @param formula The formula, which should remain valid until the writer has finished.
+	 * @return True if successful, false otherwise.
+	 */
+	virtual bool add(elements::Node const* formula) = 0;
+
+	/**
+	 * @brief Finishes the program once every formula has been added.
+	 * @return True if successful, false otherwise.
+	 */
+	virtual bool finish() = 0;
+
+	/**
+	 * @brief Opens a scope, which holds the formulas added until the matching pop().
+	 * Formulas added before the scope was opened are kept, along with whatever the solver has learned from them,
+	 * and may be freed once the scope is open.
+	 * @param name A name identifying the scope, which is reported along with its result.
+	 * @param symbols The symbols to declare within the scope, ordered by id. Should outlive the scope.
+	 * @return True if successful, false otherwise.
+	 */
+	virtual bool push(std::string const& name, elements::Symbol::SymbolList const& symbols) = 0;
+
+	/**
+	 * @brief Checks the formulas added so far and reports the result, without finishing the program.
+	 * @return True if successful, false otherwise.
+	 */
+	virtual bool check() = 0;
+
+	/**
+	 * @brief Closes the innermost scope, discarding its declarations and formulas.
+	 * @return True if successful, false otherwise.
+	 */
+	virtual bool pop() = 0;
+
+	/**
+	 * @brief Prepares to write a complete theory (or a partition of one) before its formulas are added. Does nothing by default.
+	 * @param theory The theory which is about to be written.
+	 * @return True if successful, false otherwise.
+	 */
+	virtual bool prepare(elements::Theory const& theory) { return true; }
+
+	/**
+	 * @brief Forgets every node added so far, so that they can be freed before the program is finished. Does nothing by default.
+	 * Whatever has been written or asserted for the nodes is kept.
+	 * @return True if successful, false otherwise.
+	 */
+	virtual bool release() { return true; }
+
+	/**
+	 * @brief Gets the number of bytes of text written so far, or UNKNOWN if the writer doesn't write text.
+	 */
+	virtual size_t written() const { return utils::Stats::UNKNOWN; }
+
+	/**
+	 * @brief Writes a complete theory: declares its symbols, adds each of its formulas and finishes.
+	 * @param symbols The symbols of the theory.
+	 * @param theory The theory, whose formulas must be ground (up to quantifiers over built in sorts).
+	 * @param spill The formulas which come before the theory's own, or NULL if there are none.
+	 * @return True if successful, false otherwise.
+	 */
+	bool write(elements::SymbolTable const& symbols, elements::Theory const& theory, elements::Spill* spill = NULL) {
+		utils::Stats::Timer writing(mStats, "write");
+		if (spill && spill->parts()) {
+			if (!declare(symbols) || !add(*spill) || !prepare(theory)) return false;
+		} else if (!prepare(theory) || !declare(symbols)) {
+			return false;
+		}
+		for (elements::Theory::FormulaList::const_iterator it = theory.formulas().begin(); it != theory.formulas().end(); it++) {
+			if (!add(*it)) return false;
+		}
+		writing.formulas(((spill) ? spill->formulas() : 0) + theory.formulas().size());
+		writing.bytes(written());
+		writing.stop();
+
+		utils::Stats::Timer solving(mStats, "solve");
+		return finish();
+	}
+
+	/**
+	 * @brief Adds the formulas of each partition of a spill in turn, once the symbols have been declared.
+	 * Each partition is prepared for and added as a whole, and then released and freed before the next is read.
+	 * @param spill The spill.
+	 * @return True if successful, false if a partition couldn't be read or added.
+	 */
+	bool add(elements::Spill& spill) {
+		for (size_t i = 0; i < spill.parts(); i++) {
+			elements::Theory part;
+			if (!spill.read(i, part) || !prepare(part)) return false;
+			for (elements::Theory::FormulaList::const_iterator it = part.formulas().begin(); it != part.formulas().end(); it++) {
+				if (!add(*it)) return false;
+			}
+			if (!release()) return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Sets the stats to record writing complete theories in.
+	 * @param stats The stats, which should outlive the writer, or NULL to record nothing.
+	 */
+	inline void stats(utils::Stats* stats) { mStats = stats; }
+
+};
+
+#endif
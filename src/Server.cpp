@@ -0,0 +1,270 @@
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/iostreams/device/file_descriptor.hpp>
+
+#include "utilities/Stats.h"
+#include "elements/Binary.h"
+#include "Config.h"
+#include "Translator.h"
+#include "Z3Solver.h"
+#include "Server.h"
+
+using namespace elements;
+
+/// The number of connections which may wait to be accepted.
+#define SERVER_BACKLOG 64
+
+/// The size of the chunks requests are read in.
+#define SERVER_CHUNK (1 << 16)
+
+/// The largest request which is read, in bytes.
+#define SERVER_REQUEST_LIMIT (64 << 20)
+
+namespace {
+
+// Set once the server has been asked to stop.
+volatile sig_atomic_t stopping = 0;
+
+// The pipe the server is woken through once it's been asked to stop, or -1s.
+int wake[2] = { -1, -1 };
+
+// Asks the server to stop.
+void stop(int) {
+	stopping = 1;
+	if (wake[1] >= 0) {
+		ssize_t n = write(wake[1], "", 1);
+		(void)n;
+	}
+}
+
+}
+
+// Constructor
+Server::Server(Config const& config, ArgParser parse)
+	: mConfig(config), mParse(parse), mSessions(0) {
+	/* Intentionally Left Blank */
+}
+
+// Loads the background.
+bool Server::load() {
+	// The background is parsed once and kept as it was parsed...
+	Config parsed(mConfig);
+	parsed.intOpt(Config::OPT_WRITE_BINARY, Binary::PARSED, false);
+
+	std::ostringstream out;
+	Translator p(parsed);
+	if (!p.translate(out)) return false;
+	mParsed = out.str();
+
+	// ... and is translated from that, rather than from the input files again.
+	Config ground;
+	ground.intOpt(Config::OPT_THREADS, mConfig.intOpt(Config::OPT_THREADS), false);
+	ground.intOpt(Config::OPT_WRITE_BINARY, Binary::GROUND, false);
+
+	out.str("");
+	Translator g(ground);
+	g.preload(mParsed);
+	if (!g.translate(out)) return false;
+	mGround = out.str();
+	return true;
+}
+
+// Serves requests.
+bool Server::run() {
+	std::string const& path = mConfig.serve();
+
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	if (path.size() >= sizeof(addr.sun_path)) {
+		std::cerr << "Error: The socket path '" << path << "' is too long.\n";
+		return false;
+	}
+	addr.sun_family = AF_UNIX;
+	memcpy(addr.sun_path, path.c_str(), path.size());
+
+	// A socket left behind by a server which didn't stop cleanly is replaced.
+	struct stat st;
+	if (!lstat(path.c_str(), &st) && S_ISSOCK(st.st_mode)) unlink(path.c_str());
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || bind(fd, (sockaddr const*)&addr, sizeof(addr)) || listen(fd, SERVER_BACKLOG)) {
+		std::cerr << "Error: Couldn't listen on the socket '" << path << "': " << strerror(errno) << ".\n";
+		if (fd >= 0) close(fd);
+		return false;
+	}
+
+	// Interrupting or terminating the server wakes it through a pipe, since the signal may be delivered to any thread.
+	if (pipe2(wake, O_CLOEXEC | O_NONBLOCK)) {
+		std::cerr << "Error: Couldn't set up the server: " << strerror(errno) << ".\n";
+		close(fd);
+		return false;
+	}
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stop;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	// Z3 would otherwise replace the handler with its own while solving.
+	Z3Solver::interrupts(false);
+
+	// Clients which disconnect early show up as failed writes instead.
+	signal(SIGPIPE, SIG_IGN);
+
+	std::cerr << "Serving requests on '" << path << "'.\n";
+
+	bool ok = true;
+	while (!stopping) {
+		struct pollfd p[2] = { { fd, POLLIN, 0 }, { wake[0], POLLIN, 0 } };
+		int n = poll(p, 2, -1);
+		if (n < 0 && errno != EINTR) {
+			std::cerr << "Error: Couldn't wait for a connection: " << strerror(errno) << ".\n";
+			ok = false;
+			break;
+		}
+		if (n <= 0 || !(p[0].revents & POLLIN)) continue;
+
+		int client = accept(fd, NULL, NULL);
+		if (client < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+			std::cerr << "Error: Couldn't accept a connection: " << strerror(errno) << ".\n";
+			ok = false;
+			break;
+		}
+
+		boost::unique_lock<boost::mutex> lock(mLock);
+		try {
+			boost::thread(boost::bind(&Server::session, this, client)).detach();
+			mSessions++;
+		} catch (boost::thread_resource_error& e) {
+			close(client);
+		}
+	}
+
+	close(fd);
+	unlink(path.c_str());
+	int w = wake[1];
+	wake[1] = -1;
+	close(w);
+	close(wake[0]);
+
+	boost::unique_lock<boost::mutex> lock(mLock);
+	while (mSessions) mIdle.wait(lock);
+	return ok;
+}
+
+// Serves a client.
+void Server::session(int fd) {
+	// The request ends when the client shuts down its end of the connection, unless it's too large to be read.
+	std::string request;
+	std::vector<char> chunk(SERVER_CHUNK);
+	ssize_t n;
+	bool large = false;
+	while ((n = read(fd, &chunk[0], chunk.size())) != 0) {
+		if (n > 0 && request.size() + (size_t)n > SERVER_REQUEST_LIMIT) {
+			large = true;
+			break;
+		}
+		if (n > 0) request.append(&chunk[0], (size_t)n);
+		else if (errno != EINTR) break;
+	}
+
+	if (!n || large) {
+		boost::iostreams::stream<boost::iostreams::file_descriptor_sink> out(fd, boost::iostreams::never_close_handle);
+		if (large) out << "Error: Requests can't be larger than " << (SERVER_REQUEST_LIMIT >> 20) << " megabytes.\n";
+		else serve(request, out);
+		out.flush();
+	}
+	close(fd);
+
+	boost::unique_lock<boost::mutex> lock(mLock);
+	if (!--mSessions) mIdle.notify_all();
+}
+
+// Serves a request.
+bool Server::serve(std::string const& request, std::ostream& out) {
+	size_t eol = request.find('\n');
+	std::string fragment = (eol != std::string::npos) ? request.substr(eol + 1) : "";
+
+	// The first argument stands in for the name of the program.
+	std::vector<std::string> args(1);
+	std::istringstream line(request.substr(0, eol));
+	for (std::string arg; line >> arg; ) args.push_back(arg);
+
+	// The parser reads files, so the fragment is written to a file of its own.
+	std::string file;
+	bool referenced = false;
+	for (size_t i = 1; i < args.size(); i++) referenced = referenced || args[i] == "-";
+
+	if (referenced || fragment.find_first_not_of(" \t\r\n") != std::string::npos) {
+		try {
+			file = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("aspmt-%%%%-%%%%-%%%%-%%%%.lp")).string();
+		} catch (boost::filesystem::filesystem_error& e) {
+			out << "Error: Couldn't find a place to store the program fragment.\n";
+			return false;
+		}
+
+		std::ofstream f(file.c_str());
+		f << fragment;
+		f.close();
+		if (f.fail()) {
+			out << "Error: Couldn't store the program fragment.\n";
+			boost::system::error_code ec;
+			boost::filesystem::remove(file, ec);
+			return false;
+		}
+
+		for (size_t i = 1; i < args.size(); i++) {
+			if (args[i] == "-") args[i] = file;
+		}
+		if (!referenced) args.push_back(file);
+	}
+
+	std::vector<char*> argv;
+	for (size_t i = 0; i < args.size(); i++) argv.push_back(&args[i][0]);
+
+	Config config;
+	bool ok = mParse((int)argv.size(), &argv[0], config, out);
+	if (ok && (!config.serve().empty() || !config.cache().empty() || !config.output().empty() || config.boolOpt(Config::OPT_WATCH)
+			|| !config.decode().empty())) {
+		out << "Error: Requests can't start a server, use a cache, write to a file, watch files or decode an answer.\n";
+		ok = false;
+	}
+
+	// The fragment is displayed as it was referred to, rather than by the file it was stored in.
+	if (!file.empty()) config.name(file, "-");
+
+	if (ok) {
+		// Requests with files of their own have to translate the background along with them.
+		Translator translator(config, out);
+		translator.preload((config.inputs() || config.binaries()) ? mParsed : mGround);
+		ok = translator.translate(out);
+		translator.stats().write(out, (utils::Stats::Format)config.intOpt(Config::OPT_STATS));
+	}
+
+	if (!file.empty()) {
+		boost::system::error_code ec;
+		boost::filesystem::remove(file, ec);
+	}
+	return ok;
+}
@@ -0,0 +1,117 @@
+#ifndef __H_SERVER__
+#define __H_SERVER__
+
+#include <string>
+#include <iostream>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+class Config;
+
+/**
+ * @brief Serves translation requests on a Unix socket, keeping a shared background program in memory.
+ * The background (the input files the server was started with) is parsed and translated once, and is
+ * kept in both forms as binary programs (see elements::Binary). Each request is then run by a translator
+ * of its own on a thread of its own, starting from a private copy of the background, so requests are
+ * isolated from each other and from the background while being served concurrently.
+ *
+ * A request is everything a client writes before shutting down its end of the connection. The first
+ * line holds options and files just like the command line, and anything after it is a program fragment,
+ * which can be referred to as '-' (as an input file or a query), and is otherwise added as an input file.
+ * Requests without input files of their own start from the translated background, so that their queries
+ * are solved without translating anything but the queries themselves. Requests with input files start
+ * from the background as it was parsed, and translate it along with their own files. The output and
+ * errors of the request are written back to the client, which is then disconnected. Requests larger than
+ * 64 megabytes are refused.
+ */
+class Server {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief Parses the arguments of a request into a configuration.
+	 * @param argc The number of arguments.
+	 * @param argv The arguments, the first of which is skipped.
+	 * @param config The configuration to populate.
+	 * @param errors The stream to report errors to.
+	 * @return True if the arguments were valid, false otherwise.
+	 */
+	typedef bool (*ArgParser)(int argc, char** argv, Config& config, std::ostream& errors);
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	Config const& mConfig;					///< The configuration the server was started with, whose inputs are the background.
+	ArgParser mParse;						///< Parses the arguments of each request.
+
+	std::string mParsed;					///< The background as it was parsed, as a binary program.
+	std::string mGround;					///< The translated background, as a binary program.
+
+	boost::mutex mLock;						///< Guards the number of sessions.
+	boost::condition_variable mIdle;		///< Signalled when the last session finishes.
+	size_t mSessions;						///< The number of requests being served.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param config The configuration to serve with, whose inputs are the background. Should outlive the server.
+	 * @param parse Parses the arguments of each request.
+	 */
+	Server(Config const& config, ArgParser parse);
+
+	/**
+	 * @brief Basic Destructor.
+	 * Does nothing.
+	 */
+	virtual inline ~Server() { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Parses and translates the background.
+	 * Errors are reported to the standard error.
+	 * @return True if successful, false otherwise.
+	 */
+	bool load();
+
+	/**
+	 * @brief Serves requests until the server is interrupted or terminated, then waits for the requests being served.
+	 * Errors are reported to the standard error.
+	 * @return True if the server stopped cleanly, false if the socket couldn't be set up or accepting failed.
+	 */
+	bool run();
+
+private:
+
+	/**
+	 * @brief Reads a request from a client, serves it and disconnects the client.
+	 * @param fd The client's connection, which is closed once the request is served.
+	 */
+	void session(int fd);
+
+	/**
+	 * @brief Serves a single request.
+	 * @param request Everything the client sent.
+	 * @param out The stream to write the output and errors to.
+	 * @return True if successful, false otherwise.
+	 */
+	bool serve(std::string const& request, std::ostream& out);
+
+	/// Servers aren't copyable.
+	Server(Server const&);
+	Server& operator=(Server const&);
+
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "SortEncoding.h"
+
+using namespace elements;
+
+// Gets the way a sort is represented.
+SortEncoding::Kind SortEncoding::kind(SymbolTable const& symbols, Symbol const* sort) {
+	if (sort == symbols.boolean()) return BOOLEAN;
+	if (sort == symbols.integer()) return INTEGER;
+	if (!sort->hasObjects()) return INTEGER;
+	return (sort->hasIntegers()) ? MIXED : ENUMERATION;
+}
+
+// Gets the sort a node is represented in.
+Symbol const* SortEncoding::sort(SymbolTable const& symbols, Node const* node) {
+	if (node->formula()) return symbols.boolean();
+
+	Symbol const* s = symbols.integer();
+	if (node->type() == Node::VARIABLE || node->type() == Node::APPLY) s = node->symbol()->sort();
+	return (kind(symbols, s) == INTEGER) ? symbols.integer() : s;
+}
+
+// Determines how an argument has to be converted.
+SortEncoding::Coercion SortEncoding::coercion(SymbolTable const& symbols, Node const* node, size_t arg, Symbol const*& mixed) {
+	Symbol const* has = sort(symbols, node->arg(arg));
+	Symbol const* wants = has;
+
+	switch (node->type()) {
+	case Node::APPLY:
+		wants = node->symbol()->args()[arg];
+		if (kind(symbols, wants) == INTEGER) wants = symbols.integer();
+		break;
+
+	case Node::PLUS:
+	case Node::MINUS:
+	case Node::TIMES:
+	case Node::DIVIDE:
+	case Node::NEGATE:
+	case Node::LT:
+	case Node::LE:
+	case Node::GT:
+	case Node::GE:
+		wants = symbols.integer();
+		break;
+
+	case Node::EQ:
+		{
+			// An integer is compared with a term of a mixed sort as a value of that sort, but two mixed sorts
+			// only have integers in common.
+			Symbol const* other = sort(symbols, node->arg(1 - arg));
+			if (kind(symbols, has) != MIXED) wants = other;
+			else if (kind(symbols, other) == MIXED && other != has) wants = symbols.integer();
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	if (has == wants) return NONE;
+	Kind from = kind(symbols, has), to = kind(symbols, wants);
+	if (from == BOOLEAN || to == BOOLEAN) return NONE;
+	if (from == ENUMERATION || to == ENUMERATION) return NEVER;
+	if (from == INTEGER && to == MIXED) {
+		mixed = wants;
+		return WRAP;
+	}
+	if (from == MIXED && to == INTEGER) {
+		mixed = has;
+		return UNWRAP;
+	}
+	return NONE;
+}
+
+// Collects the terms which are unwrapped within an atom.
+bool SortEncoding::guards(SymbolTable const& symbols, Node const* atom, GuardList& out) {
+	for (size_t i = 0; i < atom->arity(); i++) {
+		Node const* arg = atom->arg(i);
+		if (arg->formula()) continue;
+
+		Symbol const* mixed = NULL;
+		switch (coercion(symbols, atom, i, mixed)) {
+		case NEVER:		return false;
+		case UNWRAP:	out.push_back(Guard(arg, mixed)); break;
+		default:		break;
+		}
+		if (!guards(symbols, arg, out)) return false;
+	}
+	return true;
+}
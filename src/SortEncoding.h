@@ -0,0 +1,108 @@
+#ifndef __H_SORT_ENCODING__
+#define __H_SORT_ENCODING__
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "elements/Symbol.h"
+#include "elements/Node.h"
+
+/**
+ * @brief Decides how the program's sorts are represented in SMT-LIB, so that Z3Writer and Z3Solver agree.
+ * Sorts of integers alone become Int and sorts of objects alone become enumerations of their objects.
+ * A sort of both objects and integers becomes a datatype with a constructor for each of its objects and one
+ * more which wraps an integer, whose name and accessor are given by wrapper() and accessor().
+ *
+ * Integers (and arithmetic) are always Int, so a term of a mixed sort has to be converted wherever it
+ * meets one: integers are wrapped where a function expects an argument of a mixed sort, or where they're
+ * compared for equality with a term of a mixed sort, and terms of a mixed sort are unwrapped where
+ * arithmetic or an ordering expects an integer. Since each object belongs to a single sort, terms of two
+ * different mixed sorts are compared for equality by unwrapping both of them.
+ *
+ * Only integers can be unwrapped, so an atom which unwraps a term only holds if the term is an integer
+ * (see guards()). An atom which takes an object of a sort without integers as an integer, or which compares
+ * terms of sorts without any elements in common, never holds.
+ */
+class SortEncoding {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief An enumeration of the ways a sort can be represented.
+	 */
+	enum Kind {
+		BOOLEAN,				///< The built in boolean sort, which becomes Bool.
+		INTEGER,				///< A sort of integers alone (including the built in one), which becomes Int.
+		ENUMERATION,			///< A sort of objects alone, which becomes an enumeration of them.
+		MIXED					///< A sort of objects and integers, which becomes a datatype wrapping its integers.
+	};
+
+	/**
+	 * @brief An enumeration of the conversions an argument may need.
+	 */
+	enum Coercion {
+		NONE,					///< The argument is used as it is.
+		WRAP,					///< The argument is an integer which has to be wrapped into a mixed sort.
+		UNWRAP,					///< The argument is of a mixed sort, and its integer has to be taken out.
+		NEVER					///< The argument can't be converted, as none of its values are of the sort expected.
+	};
+
+	/**
+	 * @brief A term of a mixed sort which has to be an integer, along with that sort.
+	 */
+	typedef std::pair<elements::Node const*, elements::Symbol const*> Guard;
+
+	/**
+	 * @brief The type of a list of guards.
+	 */
+	typedef std::vector<Guard> GuardList;
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Gets the way a sort is represented.
+	 */
+	static Kind kind(elements::SymbolTable const& symbols, elements::Symbol const* sort);
+
+	/**
+	 * @brief Gets the sort a term or formula is represented in.
+	 * @return The boolean or integer sort if it's represented as Bool or Int, or its own sort otherwise.
+	 */
+	static elements::Symbol const* sort(elements::SymbolTable const& symbols, elements::Node const* node);
+
+	/**
+	 * @brief Determines how an argument of a node has to be converted to the sort the node expects of it.
+	 * @param symbols The symbols of the program.
+	 * @param node The node.
+	 * @param arg The index of the argument.
+	 * @param mixed Set to the mixed sort it's wrapped into or unwrapped from, if it has to be converted.
+	 * @return The conversion.
+	 */
+	static Coercion coercion(elements::SymbolTable const& symbols, elements::Node const* node, size_t arg, elements::Symbol const*& mixed);
+
+	/**
+	 * @brief Collects the terms which are unwrapped within an atom, each of which has to be an integer for the atom to hold.
+	 * @param symbols The symbols of the program.
+	 * @param atom The atom, or any other formula (whose formulas aren't looked into).
+	 * @param out Appended with the terms and their mixed sorts.
+	 * @return False if the atom never holds, since one of its arguments can't be converted at all.
+	 */
+	static bool guards(elements::SymbolTable const& symbols, elements::Node const* atom, GuardList& out);
+
+	/// Gets the name of the constructor which wraps an integer into a mixed sort.
+	static inline std::string wrapper(elements::Symbol const* sort)		{ return sort->name() + "!int"; }
+
+	/// Gets the name of the tester which determines whether a value of a mixed sort is an integer.
+	static inline std::string tester(elements::Symbol const* sort)		{ return "is-" + wrapper(sort); }
+
+	/// Gets the name of the accessor which takes the integer out of a mixed sort.
+	static inline std::string accessor(elements::Symbol const* sort)	{ return sort->name() + "!val"; }
+
+};
+
+#endif
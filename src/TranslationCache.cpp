@@ -0,0 +1,174 @@
+#include <ctime>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/uuid/detail/sha1.hpp>
+
+#include "elements/Binary.h"
+#include "Config.h"
+#include "TranslationCache.h"
+
+using namespace elements;
+
+/// The version of the translation, which is part of every key so that entries from older translators are never used.
+#define CACHE_VERSION 3
+
+/// The extension given to entries.
+#define CACHE_EXTENSION ".bin"
+
+/// The size of the chunks inputs are read in while they're hashed.
+#define CACHE_CHUNK (1 << 16)
+
+namespace {
+
+// An entry along with the time it was last used and its size, as found while evicting.
+struct Entry {
+	std::time_t used;
+	boost::uintmax_t size;
+	boost::filesystem::path path;
+
+	inline bool operator<(Entry const& other) const		{ return used < other.used; }
+};
+
+// Hashes an integer.
+inline void hash(boost::uuids::detail::sha1& sha, long value) {
+	sha.process_bytes(&value, sizeof(value));
+}
+
+// Hashes the canonical path and contents of a file.
+bool hashFile(boost::uuids::detail::sha1& sha, std::string const& file, std::vector<char>& chunk) {
+	std::string resolved;
+	try {
+		resolved = boost::filesystem::canonical(file).string();
+	} catch (boost::filesystem::filesystem_error& e) {
+		return false;
+	}
+
+	std::ifstream in(resolved.c_str(), std::ios::in | std::ios::binary);
+	if (!in.good()) return false;
+
+	hash(sha, (long)resolved.size());
+	sha.process_bytes(resolved.data(), resolved.size());
+	long size = 0;
+	while (in) {
+		in.read(&chunk[0], chunk.size());
+		sha.process_bytes(&chunk[0], (size_t)in.gcount());
+		size += (long)in.gcount();
+	}
+	if (in.bad()) return false;
+	hash(sha, size);
+	return true;
+}
+
+}
+
+// Computes a key.
+std::string TranslationCache::key(Config const& config) {
+	boost::uuids::detail::sha1 sha;
+	hash(sha, CACHE_VERSION);
+
+	// Only options which can change the translated program are part of the key.
+	hash(sha, config.boolOpt(Config::OPT_PARALLEL_PARSE));
+
+	std::vector<char> chunk(CACHE_CHUNK);
+	hash(sha, (long)config.binaries());
+	for (std::list<std::string>::const_iterator it = config.beginBinaries(); it != config.endBinaries(); it++) {
+		if (!hashFile(sha, *it, chunk)) return "";
+	}
+	hash(sha, (long)config.inputs());
+	for (std::list<std::string>::const_iterator it = config.beginInputs(); it != config.endInputs(); it++) {
+		if (!hashFile(sha, *it, chunk)) return "";
+	}
+
+	boost::uuids::detail::sha1::digest_type digest;
+	sha.get_digest(digest);
+
+	std::ostringstream key;
+	for (size_t i = 0; i < sizeof(digest) / sizeof(digest[0]); i++) key << std::hex << std::setfill('0') << std::setw(8) << digest[i];
+	return key.str();
+}
+
+// Reads an entry.
+bool TranslationCache::load(std::string const& key, Program& program) {
+	std::string file = path(key);
+
+	try {
+		if (!boost::filesystem::is_regular_file(file)) return false;
+	} catch (boost::filesystem::filesystem_error& e) {
+		return false;
+	}
+
+	// The entry is mapped and read in place, which leaves the program untouched if the entry is corrupt.
+	Binary::Kind kind;
+	if (!Binary::load(file, program, &kind) || kind != Binary::GROUND) {
+		boost::system::error_code ec;
+		boost::filesystem::remove(file, ec);
+		return false;
+	}
+
+	boost::system::error_code ec;
+	boost::filesystem::last_write_time(file, std::time(NULL), ec);
+	return true;
+}
+
+// Writes an entry.
+bool TranslationCache::store(std::string const& key, SymbolTable const& symbols, Theory const& theory) {
+	try {
+		boost::filesystem::create_directories(mDir);
+		boost::filesystem::path tmp = boost::filesystem::path(mDir) / boost::filesystem::unique_path("%%%%-%%%%-%%%%-%%%%.tmp");
+
+		std::ofstream out(tmp.string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		bool ok = Binary::write(out, Binary::GROUND, symbols, theory);
+		out.close();
+		if (!ok || out.fail()) {
+			boost::system::error_code ec;
+			boost::filesystem::remove(tmp, ec);
+			return false;
+		}
+
+		boost::filesystem::rename(tmp, path(key));
+		evict();
+	} catch (boost::filesystem::filesystem_error& e) {
+		return false;
+	}
+	return true;
+}
+
+// Gets the path of an entry.
+std::string TranslationCache::path(std::string const& key) const {
+	return (boost::filesystem::path(mDir) / (key + CACHE_EXTENSION)).string();
+}
+
+// Evicts the least recently used entries.
+void TranslationCache::evict() {
+	std::vector<Entry> entries;
+	boost::uintmax_t total = 0;
+
+	for (boost::filesystem::directory_iterator it(mDir); it != boost::filesystem::directory_iterator(); it++) {
+		if (it->path().extension() != CACHE_EXTENSION || !boost::filesystem::is_regular_file(it->status())) continue;
+
+		// Entries may be removed by another run at any point.
+		boost::system::error_code ec;
+		Entry e;
+		e.path = it->path();
+		e.used = boost::filesystem::last_write_time(e.path, ec);
+		if (!ec) e.size = boost::filesystem::file_size(e.path, ec);
+		if (ec) continue;
+		entries.push_back(e);
+		total += e.size;
+	}
+	if (total <= mLimit) return;
+
+	std::sort(entries.begin(), entries.end());
+	for (std::vector<Entry>::const_iterator it = entries.begin(); it != entries.end() && total > mLimit; it++) {
+		boost::system::error_code ec;
+		if (boost::filesystem::remove(it->path, ec)) total -= it->size;
+	}
+}
@@ -0,0 +1,92 @@
+#ifndef __H_TRANSLATION_CACHE__
+#define __H_TRANSLATION_CACHE__
+
+#include <string>
+
+#include <boost/cstdint.hpp>
+
+#include "elements/Symbol.h"
+#include "elements/Program.h"
+
+class Config;
+
+/**
+ * @brief An on-disk cache of translated programs, addressed by the content of their inputs.
+ * Each entry holds the ground theory produced by the last phase of the translation, along with its
+ * symbols, in the compact binary form written by elements::Binary. Entries are keyed by a hash of
+ * each input's canonical path and contents together with the options which affect the translation,
+ * so an entry can only be found again for exactly the same program.
+ *
+ * The total size of the entries is bounded. Whenever an entry is written, the least recently used
+ * entries are evicted until the cache fits again, using each entry's modification time (which is
+ * updated whenever the entry is used) as the time it was last used. Entries are written to a temporary
+ * file and renamed into place, so concurrent runs sharing a cache never see a partial entry.
+ */
+class TranslationCache {
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	std::string mDir;						///< The directory holding the entries.
+	boost::uintmax_t mLimit;				///< The maximum total size of the entries, in bytes.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param dir The directory holding the entries, which is created when the first entry is written.
+	 * @param limit The maximum total size of the entries, in bytes.
+	 */
+	inline TranslationCache(std::string const& dir, boost::uintmax_t limit)
+		: mDir(dir), mLimit(limit) { /* Intentionally Left Blank */ }
+
+	/**
+	 * @brief Basic Destructor.
+	 * Does nothing.
+	 */
+	virtual inline ~TranslationCache() { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Computes the key of the entry for the configured program.
+	 * @param config The configuration, whose inputs and translation options are hashed.
+	 * @return The key as a string of hex digits, or the empty string if an input can't be read.
+	 */
+	static std::string key(Config const& config);
+
+	/**
+	 * @brief Reads an entry into an empty program, marking it as the most recently used.
+	 * An entry which can't be read is removed.
+	 * @param key The key of the entry.
+	 * @param program The program to read the translated theory and its symbols into, which is left untouched on a miss.
+	 * @return True if the entry was found and read, false otherwise.
+	 */
+	bool load(std::string const& key, elements::Program& program);
+
+	/**
+	 * @brief Writes an entry and evicts the least recently used entries until the cache is within its limit.
+	 * @param key The key of the entry.
+	 * @param symbols The symbols of the translated theory.
+	 * @param theory The translated theory.
+	 * @return True if successful, false otherwise.
+	 */
+	bool store(std::string const& key, elements::SymbolTable const& symbols, elements::Theory const& theory);
+
+private:
+
+	/// Gets the path of an entry.
+	std::string path(std::string const& key) const;
+
+	/// Evicts the least recently used entries until the cache is within its limit.
+	void evict();
+
+};
+
+#endif
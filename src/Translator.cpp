@@ -0,0 +1,494 @@
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "utilities/CompoundFileSource.h"
+#include "elements/Binary.h"
+#include "parser/ParallelParser.h"
+#include "translator/DependencyGraph.h"
+#include "translator/Simplification.h"
+#include "translator/ClarkNormalForm.h"
+#include "translator/Completion.h"
+#include "translator/VariableElimination.h"
+#include "Config.h"
+#include "TranslationCache.h"
+#include "Z3Writer.h"
+#include "DimacsWriter.h"
+#include "Z3Solver.h"
+#include "Translator.h"
+
+using namespace elements;
+
+/// The number of components which aren't tight (and of the constants in each) to list before the rest are only counted.
+#define TIGHTNESS_REPORT 10
+
+/// The number of input files to read ahead of the one being parsed, if they're read ahead at all.
+#define PREFETCH_DEPTH 2
+
+namespace {
+
+// Orders symbols by id.
+bool lessId(Symbol const* a, Symbol const* b) {
+	return a->id() < b->id();
+}
+
+}
+
+// Constructor
+Translator::Translator(Config const& config, std::ostream& errors)
+	: mConfig(config), mErrors(errors), mImage(NULL), mCurrent(NULL), mSpill(NULL), mBase(0), mTranslated(false) {
+	/* Intentionally Left Blank */
+}
+
+// Destructor
+Translator::~Translator() {
+	delete mCurrent;
+	delete mSpill;
+}
+
+// Reads the program.
+bool Translator::load() {
+	bool ok = true;
+	size_t binaries = mConfig.binaries();
+	utils::Stats::Timer loading((mImage || binaries) ? &mStats : NULL, "load");
+
+	if (mImage) {
+		Binary::Kind kind;
+		if (!Binary::read(mImage->data(), mImage->size(), mParser.program(), &kind)) {
+			mErrors << "Error: Couldn't read the preloaded program.\n";
+			return false;
+		}
+		mTranslated = (kind == Binary::GROUND);
+		binaries++;
+	}
+
+	for (std::list<std::string>::const_iterator it = mConfig.beginBinaries(); it != mConfig.endBinaries(); it++) {
+		Binary::Kind kind;
+		if (!Binary::load(*it, mParser.program(), &kind)) {
+			mErrors << "Error: Couldn't read the binary input file '" << *it << "'.\n";
+			ok = false;
+		} else if (kind == Binary::GROUND) {
+			mTranslated = true;
+		}
+	}
+	if (mTranslated && binaries + mConfig.inputs() > 1) {
+		mErrors << "Error: A translated binary program can't be combined with other input files.\n";
+		return false;
+	}
+	loading.nodes(mParser.nodes().size());
+	loading.stop();
+	if (!ok || !mConfig.inputs()) return ok;
+
+	utils::Stats::Timer parsing(&mStats, "parse");
+	if (mConfig.boolOpt(Config::OPT_PARALLEL_PARSE) && mConfig.inputs() > 1) {
+		parser::ParallelParser<parser::Parser> pp(mConfig.intOpt(Config::OPT_THREADS));
+		ok = pp.parse(mConfig.beginInputs(), mConfig.endInputs(), mParser);
+	} else {
+		// A file given more than once (perhaps through a link) would only declare everything again.
+		// Files which are read ahead have to be buffered, as the prefetcher leaves mapped files alone.
+		size_t prefetch = (size_t)mConfig.intOpt(Config::OPT_PREFETCH) << 20;
+		utils::CompoundFileSource source((prefetch) ? utils::CompoundFileSource::BUFFERED : utils::CompoundFileSource::MAPPED);
+		source.once(true);
+		if (prefetch) source.prefetch(PREFETCH_DEPTH, prefetch);
+		for (std::list<std::string>::const_iterator it = mConfig.beginInputs(); it != mConfig.endInputs(); it++) {
+			size_t skipped = source.skipped();
+			if (!source.append(*it)) {
+				mErrors << "Error: Couldn't open input file '" << mConfig.name(*it) << "'.\n";
+				ok = false;
+			} else if (source.skipped() != skipped) {
+				mErrors << "Warning: The input file '" << mConfig.name(*it) << "' has already been given, and is only read once.\n";
+			}
+		}
+		ok = ok && mParser.parse(source);
+	}
+	parsing.rules(mParser.program().rules().size());
+	parsing.nodes(mParser.nodes().size());
+	parsing.bytes(mParser.bytes());
+	parsing.hits(mParser.resolutionHits());
+	parsing.misses(mParser.resolutionMisses());
+	parsing.stop();
+
+	for (parser::Parser::ErrorList::const_iterator it = mParser.errors().begin(); it != mParser.errors().end(); it++) {
+		mErrors << mConfig.named(*it) << "\n";
+	}
+	return ok && !mParser.failed();
+}
+
+// Checks the program.
+bool Translator::check() {
+	utils::Stats::Timer timer(&mStats, "check");
+	bool ok = declared(symbols(), 0);
+
+	CheckedSet checked;
+	Theory const& theory = current();
+	for (Theory::RuleList::const_iterator it = theory.rules().begin(); it != theory.rules().end(); it++) {
+		// Heads are restricted to atoms and assignments to functions.
+		Node const* h = it->head;
+		if (h->type() == Node::EQ && (h->arg(0)->type() != Node::APPLY || h->arg(0)->symbol()->type() != Symbol::FUNCTION)) {
+			mErrors << "Error: The head '" << *h << "' doesn't assign a value to a function constant.\n";
+			ok = false;
+		}
+		ok = check(it->head, true, checked) && ok;
+		ok = check(it->body, true, checked) && ok;
+	}
+	for (Theory::FormulaList::const_iterator it = theory.formulas().begin(); it != theory.formulas().end(); it++) {
+		ok = check(*it, true, checked) && ok;
+	}
+	return ok;
+}
+
+// Reports undeclared symbols.
+bool Translator::declared(SymbolTable const& symbols, size_t first) {
+	bool ok = true;
+
+	for (size_t i = first; i < symbols.size(); i++) {
+		Symbol const* s = symbols[i];
+		if (s->declared()) continue;
+
+		mErrors << "Error: " << ((s->type() == Symbol::SORT) ? "The sort '" : "'") << s->name();
+		if (s->arity()) mErrors << "/" << s->arity();
+		mErrors << "' is used but never declared.\n";
+		ok = false;
+	}
+	return ok;
+}
+
+// Checks a single node.
+bool Translator::check(Node const* node, bool formula, CheckedSet& checked) {
+	if (!checked.insert(std::make_pair(node, formula)).second) return true;
+
+	bool ok = true;
+	bool args = false;
+
+	switch (node->type()) {
+	case Node::APPLY:
+		// Undeclared symbols have already been reported.
+		if (!node->symbol()->declared()) return false;
+		if (formula && node->symbol()->type() != Symbol::PREDICATE) {
+			mErrors << "Error: '" << *node << "' is used as an atom, but isn't a boolean constant.\n";
+			ok = false;
+		} else if (!formula && node->symbol()->type() != Symbol::OBJECT && node->symbol()->type() != Symbol::FUNCTION) {
+			mErrors << "Error: '" << *node << "' is used as a term, but isn't an object or non-boolean constant.\n";
+			ok = false;
+		}
+		break;
+
+	case Node::VARIABLE:
+	case Node::INTEGER:
+	case Node::PLUS:
+	case Node::MINUS:
+	case Node::TIMES:
+	case Node::DIVIDE:
+	case Node::NEGATE:
+		if (formula) {
+			mErrors << "Error: Expected a formula, but found the term '" << *node << "'.\n";
+			ok = false;
+		}
+		break;
+
+	case Node::TRUE:
+	case Node::FALSE:
+	case Node::EQ:
+	case Node::LT:
+	case Node::LE:
+	case Node::GT:
+	case Node::GE:
+		if (!formula) {
+			mErrors << "Error: Expected a term, but found the formula '" << *node << "'.\n";
+			ok = false;
+		}
+		break;
+
+	case Node::NOT:
+	case Node::AND:
+	case Node::OR:
+	case Node::IMPLIES:
+	case Node::IFF:
+	case Node::EXISTS:
+	case Node::FORALL:
+		// The children of a connective are formulas.
+		args = true;
+		break;
+	}
+
+	for (size_t i = 0; i < node->arity(); i++) {
+		ok = check(node->arg(i), args, checked) && ok;
+	}
+	return ok;
+}
+
+// Runs the translation.
+bool Translator::translate(std::ostream& out) {
+	// A cached translation of the same inputs skips parsing and every phase.
+	TranslationCache cache(mConfig.cache(), (boost::uintmax_t)mConfig.intOpt(Config::OPT_CACHE_SIZE) << 20);
+	std::string key = (mConfig.cache().empty()) ? "" : TranslationCache::key(mConfig);
+
+	// The cache only holds translated programs.
+	int binary = mConfig.intOpt(Config::OPT_WRITE_BINARY);
+	if (binary == Binary::PARSED) key = "";
+
+	bool cached = false;
+	if (!key.empty()) {
+		utils::Stats::Timer timer(&mStats, "cache");
+		cached = cache.load(key, mParser.program());
+	}
+
+	if (!cached) {
+		if (!load()) return false;
+
+		if (mTranslated && binary == Binary::PARSED) {
+			mErrors << "Error: The input has already been translated, so it can't be written as it was parsed.\n";
+			return false;
+		} else if (!mTranslated) {
+			if (!check()) return false;
+			if (binary == Binary::PARSED) return write(out, Binary::PARSED);
+			run(NULL);
+
+			utils::Stats::Timer timer((key.empty()) ? NULL : &mStats, "store");
+			if (!key.empty() && !cache.store(key, symbols(), current())) {
+				mErrors << "Warning: Couldn't write to the translation cache '" << mConfig.cache() << "'.\n";
+			}
+		}
+	}
+	if (binary) return write(out, Binary::GROUND);
+	mBase = symbols().size();
+
+	SMTWriter* writer = this->writer(out);
+	writer->stats(&mStats);
+	bool ok;
+	if (!mConfig.queries()) {
+		ok = writer->write(symbols(), current(), mSpill);
+	} else {
+		// The program is only added once, and each query is then solved on top of it.
+		utils::Stats::Timer timer(&mStats, "write");
+		ok = writer->declare(symbols()) && add(*writer);
+		timer.formulas(((mSpill) ? mSpill->formulas() : 0) + current().formulas().size());
+		timer.stop();
+		for (std::list<std::string>::const_iterator it = mConfig.beginQueries(); ok && it != mConfig.endQueries(); it++) {
+			ok = query(*it, *writer);
+		}
+	}
+	delete writer;
+	return ok;
+}
+
+// Reports the components which aren't tight.
+bool Translator::tight(translator::DependencyGraph const& graph) {
+	if (graph.tight()) return true;
+
+	// Dependencies are only tracked between constants rather than their instances, so this may be a false alarm.
+	mErrors << "Warning: The program may not be tight, in which case its completion may have models which aren't stable. "
+		<< "The constants in each of these sets depend positively on each other:\n";
+
+	size_t shown = 0;
+	size_t hidden = 0;
+	for (size_t c = 0; c < graph.components(); c++) {
+		if (graph.tight(c)) continue;
+		if (shown == TIGHTNESS_REPORT) {
+			hidden++;
+			continue;
+		}
+
+		mErrors << "  {";
+		size_t members = 0;
+		for (translator::DependencyGraph::VertexIterator it = graph.beginMembers(c); it != graph.endMembers(c); it++, members++) {
+			if (members == TIGHTNESS_REPORT) {
+				mErrors << ", ... " << (graph.endMembers(c) - it) << " more";
+				break;
+			}
+			Symbol const* s = graph.constant(*it);
+			mErrors << ((members) ? ", " : "") << s->name() << "/" << s->arity();
+		}
+		mErrors << "}\n";
+		shown++;
+	}
+	if (hidden) mErrors << "  ... and " << hidden << " more sets.\n";
+	return false;
+}
+
+// Reports how much the program shrank.
+void Translator::shrank(translator::Simplification const& simplification) {
+	if (!simplification.shrank()) return;
+
+	mErrors << "Simplified the program from " << simplification.rulesBefore() << " rules (" << simplification.nodesBefore()
+		<< " nodes) to " << simplification.rulesAfter() << " rules (" << simplification.nodesAfter() << " nodes), dropping "
+		<< simplification.never() << " which could never apply, " << simplification.duplicates() << " duplicates and "
+		<< simplification.subsumed() << " subsumed rules after propagating " << simplification.facts() << " facts in "
+		<< simplification.rounds() << " rounds.\n";
+}
+
+// Reports how much of the ground program was spilled.
+void Translator::spilled(translator::VariableElimination const& elimination) {
+	if (!mSpill) return;
+
+	if (mSpill->failed()) {
+		mErrors << "Warning: Couldn't spill the ground program to a temporary file, so the rest of it is kept in memory regardless of the memory budget.\n";
+	}
+	if (!mSpill->parts()) return;
+
+	mErrors << "Spilled " << mSpill->formulas() << " of " << (mSpill->formulas() + current().formulas().size()) << " ground formulas ("
+		<< mSpill->bytes() << " bytes) to disk in " << mSpill->parts() << ((mSpill->parts() == 1) ? " partition" : " partitions") << " to stay within the memory budget of "
+		<< mConfig.intOpt(Config::OPT_MEMORY_BUDGET) << " megabytes. The working set peaked at " << elimination.peak() << " bytes.\n";
+}
+
+// Adds the formulas of the latest phase to a writer.
+bool Translator::add(SMTWriter& writer) {
+	if (mSpill && !writer.add(*mSpill)) return false;
+	for (Theory::FormulaList::const_iterator it = current().formulas().begin(); it != current().formulas().end(); it++) {
+		if (!writer.add(*it)) return false;
+	}
+	return true;
+}
+
+// Creates the writer.
+SMTWriter* Translator::writer(std::ostream& out) const {
+	// The text writer is kept for debugging, otherwise the program is solved in-process.
+	if (mConfig.boolOpt(Config::OPT_WRITE_SMT)) return new Z3Writer(out);
+	if (mConfig.boolOpt(Config::OPT_WRITE_DIMACS)) return new DimacsWriter(out);
+	return new Z3Solver(out, mConfig.intOpt(Config::OPT_THREADS), mConfig.intOpt(Config::OPT_MODELS), mConfig.intOpt(Config::OPT_PORTFOLIO));
+}
+
+// Writes the current theory in binary form.
+bool Translator::write(std::ostream& out, Binary::Kind kind) {
+	utils::Stats::Timer timer(&mStats, "write");
+	timer.rules(current().rules().size());
+	timer.formulas(current().formulas().size());
+
+	std::streampos start = out.tellp();
+	if (Binary::write(out, kind, symbols(), current())) {
+		if (start != std::streampos(-1)) timer.bytes((size_t)(out.tellp() - start));
+		return true;
+	}
+	mErrors << "Error: Couldn't write the binary program.\n";
+	return false;
+}
+
+// Solves a query against the program.
+bool Translator::query(std::string const& file, SMTWriter& writer) {
+	// The previous theory has already been written, so start over from the (empty) program.
+	advance(NULL);
+
+	// The query is parsed on top of the program's symbols, so that the ones it declares itself can be told apart.
+	utils::Stats::Timer parsing(&mStats, "parse");
+	parser::Parser qp;
+	bool ok = true;
+	for (size_t i = 0; i < mBase; i++) qp.program().symbols().import(symbols()[i], ok);
+	size_t seeded = qp.program().symbols().size();
+
+	ok = qp.parse(file);
+	parsing.rules(qp.program().rules().size());
+	parsing.nodes(qp.nodes().size());
+	parsing.bytes(qp.bytes());
+	parsing.hits(qp.resolutionHits());
+	parsing.misses(qp.resolutionMisses());
+	parsing.stop();
+	for (parser::Parser::ErrorList::const_iterator it = qp.errors().begin(); it != qp.errors().end(); it++) {
+		mErrors << mConfig.named(*it) << "\n";
+	}
+	if (!ok || qp.failed() || !declared(qp.program().symbols(), seeded)) return false;
+
+	std::vector<size_t> domains;
+	for (size_t i = 0; i < mBase; i++) domains.push_back(symbols()[i]->domain().size());
+
+	// The query's own symbols may have been declared by an earlier query, in which case they must agree.
+	Symbol::SymbolList own;
+	Symbol::SymbolList constants;
+	for (size_t i = seeded; i < qp.program().symbols().size(); i++) {
+		bool same = true;
+		Symbol const* s = symbols().import(qp.program().symbols()[i], same);
+		if (!same) {
+			mErrors << "Error: '" << s->name() << "' has already been declared differently by an earlier query.\n";
+			ok = false;
+		}
+		own.push_back(s);
+		if (s->constant()) constants.push_back(s);
+	}
+	mParser.program().merge(qp.program());
+	size_t merged = symbols().size();
+
+	// The program's translation depends on the domains of its sorts and on the rules for its constants, so neither can change.
+	for (size_t i = 0; i < mBase; i++) {
+		if (symbols()[i]->domain().size() == domains[i]) continue;
+		mErrors << "Error: The query '" << mConfig.name(file) << "' adds elements to the sort '" << symbols()[i]->name() << "', which belongs to the program.\n";
+		ok = false;
+	}
+	for (Theory::RuleList::const_iterator it = current().rules().begin(); it != current().rules().end(); it++) {
+		Node const* h = (it->head->type() == Node::EQ) ? it->head->arg(0) : it->head;
+		if (h->type() != Node::APPLY || h->symbol()->id() >= mBase) continue;
+		mErrors << "Error: The query '" << mConfig.name(file) << "' has a rule for '" << *h << "', which is defined by the program.\n";
+		ok = false;
+	}
+	if (!check() || !ok) return false;
+
+	std::sort(constants.begin(), constants.end(), lessId);
+	run(&constants);
+
+	// Symbols created by the translation of the query belong to it as well.
+	for (size_t i = merged; i < symbols().size(); i++) own.push_back(symbols()[i]);
+	std::sort(own.begin(), own.end(), lessId);
+
+	utils::Stats::Timer writing(&mStats, "write");
+	ok = writer.push(mConfig.name(file), own) && add(writer);
+	writing.formulas(((mSpill) ? mSpill->formulas() : 0) + current().formulas().size());
+	writing.stop();
+
+	utils::Stats::Timer solving(&mStats, "solve");
+	return ok && writer.check() && writer.pop();
+}
+
+// Runs each phase of the translation.
+void Translator::run(Symbol::SymbolList const* constants) {
+	utils::Stats::Timer analyzing(&mStats, "analyze");
+	translator::DependencyGraph graph(symbols());
+	graph.add(current());
+	graph.analyze();
+	tight(graph);
+	analyzing.stop();
+
+	utils::Stats::Timer simplifying(&mStats, "simplify");
+	translator::Simplification simplification(symbols(), constants);
+	advance(simplification.translate(current()));
+	measure(simplifying);
+	shrank(simplification);
+
+	utils::Stats::Timer normalizing(&mStats, "cnf");
+	translator::ClarkNormalForm cnf(symbols());
+	advance(cnf.translate(current()));
+	measure(normalizing);
+
+	utils::Stats::Timer completing(&mStats, "completion");
+	translator::Completion completion(symbols(), mConfig.intOpt(Config::OPT_THREADS), constants);
+	advance(completion.translate(current()));
+	measure(completing);
+
+	// The ground program can only be spilled if it goes straight to the writer.
+	utils::Stats::Timer eliminating(&mStats, "elimination");
+	size_t budget = (mConfig.cache().empty() && !mConfig.intOpt(Config::OPT_WRITE_BINARY)) ? (size_t)mConfig.intOpt(Config::OPT_MEMORY_BUDGET) << 20 : 0;
+	Spill* spill = (budget) ? new Spill(symbols()) : NULL;
+	translator::VariableElimination elimination(symbols(), mConfig.intOpt(Config::OPT_THREADS), budget);
+	advance(elimination.translate(current(), spill));
+	mSpill = spill;
+	measure(eliminating);
+	spilled(elimination);
+}
+
+// Measures the result of a phase.
+void Translator::measure(utils::Stats::Timer& timer) {
+	timer.rules(current().rules().size());
+	timer.formulas(current().formulas().size());
+	timer.nodes(current().nodes().size());
+	timer.bytes(current().nodes().bytes());
+	timer.stop();
+}
+
+// Moves on to the result of the next phase.
+void Translator::advance(Theory* next) {
+	if (mCurrent) delete mCurrent;
+	else mParser.program().clear();
+	mCurrent = next;
+
+	delete mSpill;
+	mSpill = NULL;
+}
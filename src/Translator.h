@@ -0,0 +1,219 @@
+#ifndef __H_TRANSLATOR__
+#define __H_TRANSLATOR__
+
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include <boost/unordered_set.hpp>
+
+#include "elements/Program.h"
+#include "elements/Binary.h"
+#include "elements/Spill.h"
+#include "parser/Parser.h"
+#include "utilities/Stats.h"
+
+class Config;
+class SMTWriter;
+
+namespace translator { class DependencyGraph; class Simplification; class VariableElimination; }
+
+/**
+ * @brief Drives the translation of an ASPMT program into SMT.
+ * The translation proceeds in phases, each of which builds its result as a new theory (with its own
+ * node arena) from the result of the previous phase. Once a phase is done with its input, the input
+ * is freed all at once. Symbols are shared by every phase and live as long as the translator.
+ *
+ * Before the first phase, the positive dependencies of the program are analyzed (see
+ * translator::DependencyGraph), and a warning is reported for every component which isn't tight,
+ * since completion may then admit models which aren't stable. The program is then simplified (see
+ * translator::Simplification), and how much smaller it became is reported.
+ *
+ * When there are queries, the program is translated and given to the solver once. Each query is then
+ * translated on its own and solved within a scope on top of the program, which is possible as long as
+ * the query only adds constraints, and rules for constants the program doesn't declare.
+ *
+ * Given a memory budget, the ground formulas which don't fit within it are spilled to disk as they're
+ * produced (see translator::VariableElimination), and are read back a partition at a time as they're
+ * given to the writer. Spilling is only done when the ground program goes straight to the writer, rather
+ * than being cached or written in binary form.
+ */
+class Translator {
+
+	friend class Watcher;
+
+private:
+	/***********************************************************************/
+	/* Private Types */
+	/***********************************************************************/
+
+	/// The nodes which have already been checked, along with whether they appeared as formulas.
+	typedef boost::unordered_set<std::pair<elements::Node const*, bool> > CheckedSet;
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	Config const& mConfig;					///< The configuration we're running with.
+	std::ostream& mErrors;					///< The stream errors are reported to.
+	std::string const* mImage;				///< A binary program to read before the input files, or NULL.
+	parser::Parser mParser;					///< The parser, which holds the program that was read.
+	elements::Theory* mCurrent;				///< The result of the latest phase, or NULL if it's the program itself.
+	elements::Spill* mSpill;				///< The ground formulas which come before those of the latest phase, or NULL if none were spilled.
+	size_t mBase;							///< The number of symbols belonging to the program, rather than to a query.
+	bool mTranslated;						///< Whether the program was read already translated, in which case none of the phases run.
+	utils::Stats mStats;					///< The time and memory taken by each stage.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param config The configuration to run with. Should outlive the translator.
+	 * @param errors The stream to report errors to.
+	 */
+	Translator(Config const& config, std::ostream& errors = std::cerr);
+
+	/**
+	 * @brief Basic Destructor.
+	 * Frees the result of the latest phase, along with whatever was spilled.
+	 */
+	virtual ~Translator();
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Provides a binary program (see elements::Binary) to read before any of the input files.
+	 * Allows a program which is already in memory to be shared by several translators without parsing it again.
+	 * @param image The binary program, which must outlive the translator and be aligned to 8 bytes.
+	 */
+	inline void preload(std::string const& image)		{ mImage = &image; }
+
+	/**
+	 * @brief Reads the configured input files into the program.
+	 * Binary programs (starting with the preloaded one) are read first, and the text input files are parsed on top of them. A binary
+	 * program which has already been translated can't be combined with any other input.
+	 * Errors are reported to the translator's error stream.
+	 * @return True if successful, false otherwise.
+	 */
+	bool load();
+
+	/**
+	 * @brief Checks that every symbol used by the program has been declared and is used appropriately.
+	 * Errors are reported to the translator's error stream.
+	 * @return True if successful, false otherwise.
+	 */
+	bool check();
+
+	/**
+	 * @brief Loads the program, runs each phase of the translation and either solves the result or writes it as SMT-LIB.
+	 * Alternatively, the program is written in binary form as it was parsed or once it's translated.
+	 * If there are queries, each is solved in turn against the program.
+	 * @param out The stream to write to.
+	 * @return True if successful, false otherwise.
+	 */
+	bool translate(std::ostream& out);
+
+	/// Gets the time and memory taken by each stage so far.
+	inline utils::Stats const& stats() const			{ return mStats; }
+
+	/// Gets the program's symbol table.
+	inline elements::SymbolTable& symbols()				{ return mParser.program().symbols(); }
+
+	/// Gets the result of the latest phase.
+	inline elements::Theory& current()					{ return (mCurrent) ? *mCurrent : mParser.program(); }
+
+private:
+
+	/**
+	 * @brief Runs each phase of the translation on the current theory.
+	 * @param constants The only constants to complete, ordered by id, or NULL to complete every constant.
+	 */
+	void run(elements::Symbol::SymbolList const* constants);
+
+	/**
+	 * @brief Reports the components of an analyzed dependency graph which aren't tight, as a warning.
+	 * @param graph The graph.
+	 * @return True if every component is tight, false otherwise.
+	 */
+	bool tight(translator::DependencyGraph const& graph);
+
+	/**
+	 * @brief Reports how much the program shrank when it was simplified, if it did.
+	 * @param simplification The simplification which was run.
+	 */
+	void shrank(translator::Simplification const& simplification);
+
+	/**
+	 * @brief Reports how much of the ground program was spilled to disk to keep within the memory budget, if any was.
+	 * @param elimination The elimination which was run.
+	 */
+	void spilled(translator::VariableElimination const& elimination);
+
+	/**
+	 * @brief Adds the formulas of the latest phase to a writer, after any which were spilled.
+	 * @param writer The writer, whose symbols must already be declared.
+	 * @return True if successful, false otherwise.
+	 */
+	bool add(SMTWriter& writer);
+
+	/**
+	 * @brief Creates the configured writer for the translated program.
+	 * @param out The stream the writer writes to.
+	 * @return The writer, which the caller takes ownership of.
+	 */
+	SMTWriter* writer(std::ostream& out) const;
+
+	/**
+	 * @brief Writes the current theory and its symbols in binary form.
+	 * Errors are reported to the translator's error stream.
+	 * @param out The stream to write to.
+	 * @param kind What the current theory is.
+	 * @return True if successful, false otherwise.
+	 */
+	bool write(std::ostream& out, elements::Binary::Kind kind);
+
+	/**
+	 * @brief Translates a query and solves it within its own scope, once the program has been added to the writer.
+	 * Errors are reported to the translator's error stream.
+	 * @param file The query file.
+	 * @param writer The writer the program has been added to.
+	 * @return True if successful, false otherwise.
+	 */
+	bool query(std::string const& file, SMTWriter& writer);
+
+	/**
+	 * @brief Reports the symbols which are used but never declared.
+	 * @param symbols The symbols to check.
+	 * @param first The id of the first symbol to check.
+	 * @return True if every symbol checked was declared, false otherwise.
+	 */
+	bool declared(elements::SymbolTable const& symbols, size_t first);
+
+	/**
+	 * @brief Replaces the result of the latest phase, freeing the previous result's nodes in bulk along with whatever was spilled.
+	 * @param next The result of the phase which just finished. The translator takes ownership.
+	 */
+	void advance(elements::Theory* next);
+
+	/**
+	 * @brief Gives a timer the counts of the result of the latest phase, and stops it.
+	 * @param timer The timer of the phase.
+	 */
+	void measure(utils::Stats::Timer& timer);
+
+	/**
+	 * @brief Checks the use of symbols within a single node.
+	 * @param node The node to check.
+	 * @param formula Whether the node appears where a formula is expected.
+	 * @param checked The nodes which have already been checked.
+	 * @return True if successful, false otherwise.
+	 */
+	bool check(elements::Node const* node, bool formula, CheckedSet& checked);
+
+};
+
+#endif
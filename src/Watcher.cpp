@@ -0,0 +1,470 @@
+#include <ctime>
+#include <list>
+#include <utility>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "translator/DependencyGraph.h"
+#include "translator/Simplification.h"
+#include "translator/ClarkNormalForm.h"
+#include "translator/Completion.h"
+#include "translator/VariableElimination.h"
+#include "Config.h"
+#include "SMTWriter.h"
+#include "Translator.h"
+#include "Watcher.h"
+
+using namespace elements;
+
+namespace {
+
+// Gets the canonical name of a file, or the name itself if it doesn't exist.
+std::string canonical(std::string const& file) {
+	boost::system::error_code ec;
+	boost::filesystem::path path = boost::filesystem::canonical(file, ec);
+	return (ec) ? file : path.string();
+}
+
+}
+
+// Constructor
+Watcher::Watcher(Config const& config)
+	: mConfig(config), mTranslator(NULL), mSimplified(NULL), mGround(NULL), mStale(true) {
+	/* Intentionally Left Blank */
+}
+
+// Destructor
+Watcher::~Watcher() {
+	for (UnitList::iterator it = mUnits.begin(); it != mUnits.end(); it++) delete it->parser;
+	delete mSimplified;
+	delete mGround;
+	delete mTranslator;
+}
+
+// Watches the files.
+bool Watcher::run() {
+	if (!mMonitor.good()) {
+		std::cerr << "Error: Couldn't watch the input files.\n";
+		return false;
+	}
+
+	for (std::list<std::string>::const_iterator it = mConfig.beginInputs(); it != mConfig.endInputs(); it++) {
+		Unit u;
+		u.file = *it;
+		u.parser = NULL;
+		mUnits.push_back(u);
+	}
+
+	std::vector<size_t> changed;
+	for (;;) {
+		boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+		mStats.clear();
+
+		// Every unit which changed since the program was rebuilt has to be parsed again anyway.
+		bool ok;
+		if (mStale) {
+			for (std::vector<size_t>::const_iterator it = changed.begin(); it != changed.end(); it++) {
+				delete mUnits[*it].parser;
+				mUnits[*it].parser = NULL;
+			}
+			ok = rebuild();
+		} else {
+			ok = update(changed);
+		}
+		boost::posix_time::ptime translated = boost::posix_time::microsec_clock::universal_time();
+		ok = ok && emit();
+
+		boost::posix_time::ptime written = boost::posix_time::microsec_clock::universal_time();
+		if (ok) {
+			std::cerr << "Updated the program in " << (written - start).total_microseconds() / 1e3 << " ms, of which "
+				<< (written - translated).total_microseconds() / 1e3 << " ms were spent writing it.\n";
+		} else {
+			std::cerr << "The program wasn't updated.\n";
+		}
+		mStats.write(std::cerr, (utils::Stats::Format)mConfig.intOpt(Config::OPT_STATS));
+
+		// A unit changes when any of the files read for it does. Files which are no longer read are still watched.
+		changed.clear();
+		while (changed.empty()) {
+			utils::FileMonitor::FileSet files;
+			if (!mMonitor.wait(files)) {
+				std::cerr << "Error: Couldn't watch the input files.\n";
+				return false;
+			}
+
+			for (size_t i = 0; i < mUnits.size(); i++) {
+				bool hit = files.count(canonical(mUnits[i].file)) > 0;
+				for (std::list<std::string>::const_iterator it = mUnits[i].files.begin(); !hit && it != mUnits[i].files.end(); it++) {
+					hit = files.count(*it) > 0;
+				}
+				if (hit) changed.push_back(i);
+			}
+		}
+	}
+}
+
+// Translates everything from scratch.
+bool Watcher::rebuild() {
+	mStale = true;
+
+	bool ok = true;
+	for (UnitList::iterator it = mUnits.begin(); it != mUnits.end(); it++) {
+		if (!it->parser) it->parser = parse(*it);
+		ok = ok && it->parser;
+	}
+	if (!ok) return false;
+	mOrder = order();
+
+	mConstants.clear();
+	mConstraints.assign(mUnits.size(), Theory::FormulaList());
+
+	// The units are merged in order, just as they would be by a parallel parse.
+	delete mTranslator;
+	mTranslator = new Translator(mConfig);
+
+	for (size_t i = 0; i < mUnits.size(); i++) {
+		ok = merge(mUnits[i]) && ok;
+		mUnits[i].signature = signature(mUnits[i].parser->program().symbols());
+	}
+	if (!ok || !check()) return false;
+	analyze();
+
+	delete mSimplified;
+	mSimplified = new Theory();
+	std::vector<size_t> owners;
+	simplify(owners);
+
+	translate(*mSimplified, owners, NULL);
+	mStale = false;
+	return true;
+}
+
+// Retranslates the changed units.
+bool Watcher::update(std::vector<size_t> const& changed) {
+	bool ok = true;
+	bool stable = true;
+	for (std::vector<size_t>::const_iterator it = changed.begin(); it != changed.end(); it++) {
+		Unit& u = mUnits[*it];
+		parser::Parser* p = parse(u);
+		if (p) stable = stable && signature(p->program().symbols()) == u.signature;
+		else ok = false;
+
+		delete u.parser;
+		u.parser = p;
+	}
+
+	// Units which failed to parse are parsed again along with everything else once they're fixed.
+	if (!ok) {
+		mStale = true;
+		return false;
+	}
+	if (!stable || order() != mOrder) return rebuild();
+
+	SymbolTable const& symbols = mTranslator->symbols();
+	std::vector<Theory::RuleList> old(mUnits.size());
+	for (size_t i = 0; i < mUnits.size(); i++) old[i].swap(mUnits[i].simplified);
+
+	// Only the new rules are left in the translator's program, so that only they are checked.
+	Program& program = mTranslator->mParser.program();
+	program.rules().clear();
+	for (std::vector<size_t>::const_iterator it = changed.begin(); it != changed.end(); it++) {
+		ok = merge(mUnits[*it]) && ok;
+	}
+	if (!ok || !check()) {
+		mStale = true;
+		return false;
+	}
+	analyze();
+
+	std::vector<size_t> owners;
+	simplify(owners);
+
+	// Rules which simplify the same way are the same nodes, so a constant is affected when its rules in some unit differ.
+	std::vector<bool> affected(symbols.size(), false);
+	std::vector<bool> dirty(mUnits.size(), false);
+	for (size_t i = 0; i < mUnits.size(); i++) {
+		if (same(old[i], mUnits[i].simplified)) continue;
+
+		RuleMap before;
+		RuleMap now;
+		index(old[i], before);
+		index(mUnits[i].simplified, now);
+
+		for (RuleMap::const_iterator it = before.begin(); it != before.end(); it++) {
+			RuleMap::const_iterator other = now.find(it->first);
+			if (other != now.end() && same(it->second, other->second)) continue;
+			if (it->first) affected[it->first->id()] = true;
+			else dirty[i] = true;
+		}
+		for (RuleMap::const_iterator it = now.begin(); it != now.end(); it++) {
+			if (before.count(it->first)) continue;
+			if (it->first) affected[it->first->id()] = true;
+			else dirty[i] = true;
+		}
+	}
+
+	Symbol::SymbolList constants;
+	for (size_t i = 0; i < affected.size(); i++) {
+		if (!affected[i]) continue;
+		constants.push_back(symbols[i]);
+		if (i < mConstants.size()) mConstants[i].clear();
+	}
+	for (size_t i = 0; i < mUnits.size(); i++) {
+		if (dirty[i]) mConstraints[i].clear();
+	}
+
+	// Every rule for the affected constants is needed to complete them, but only the constraints of the changed units.
+	Theory part;
+	std::vector<size_t> parts;
+	NodeFactory::ImportMap memo;
+	for (size_t i = 0; i < mUnits.size(); i++) {
+		for (Theory::RuleList::const_iterator r = mUnits[i].simplified.begin(); r != mUnits[i].simplified.end(); r++) {
+			Symbol const* h = head(*r);
+			if ((h) ? !affected[h->id()] : !dirty[i]) continue;
+
+			part.add(part.nodes().import(r->head, memo), part.nodes().import(r->body, memo), r->choice);
+			parts.push_back(i);
+		}
+	}
+
+	translate(part, parts, &constants);
+	return true;
+}
+
+// Parses a unit.
+parser::Parser* Watcher::parse(Unit& unit) {
+	// The unit's file is watched before it's read, so that nothing written to it from then on is missed.
+	watch(unit.file, 0);
+	std::time_t since = std::time(NULL);
+
+	utils::Stats::Timer timer(&mStats, "parse");
+	parser::Parser* p = new parser::Parser();
+	bool ok = p->parse(unit.file);
+	timer.rules(p->program().rules().size());
+	timer.nodes(p->nodes().size());
+	timer.bytes(p->bytes());
+	timer.hits(p->resolutionHits());
+	timer.misses(p->resolutionMisses());
+	timer.stop();
+
+	for (parser::Parser::ErrorList::const_iterator it = p->errors().begin(); it != p->errors().end(); it++) {
+		std::cerr << *it << "\n";
+	}
+	unit.files = p->files();
+	for (std::list<std::string>::const_iterator it = unit.files.begin(); it != unit.files.end(); it++) watch(*it, since);
+
+	if (!ok || p->failed()) {
+		delete p;
+		return NULL;
+	}
+	return p;
+}
+
+// Merges a unit into the translator's program.
+bool Watcher::merge(Unit& unit) {
+	Program& program = mTranslator->mParser.program();
+	size_t first = program.rules().size();
+
+	bool ok = program.merge(unit.parser->program());
+	unit.rules.assign(program.rules().begin() + first, program.rules().end());
+
+	if (!ok) std::cerr << "Error: A symbol in '" << unit.file << "' was declared differently in another file.\n";
+	return ok;
+}
+
+// Checks the translator's program.
+bool Watcher::check() {
+	utils::Stats::Timer timer(&mStats, "check");
+	return mTranslator->check();
+}
+
+// Analyzes the dependencies.
+void Watcher::analyze() {
+	utils::Stats::Timer timer(&mStats, "analyze");
+	translator::DependencyGraph graph(mTranslator->symbols());
+	for (UnitList::const_iterator u = mUnits.begin(); u != mUnits.end(); u++) {
+		for (Theory::RuleList::const_iterator it = u->rules.begin(); it != u->rules.end(); it++) graph.add(*it);
+	}
+	graph.analyze();
+	mTranslator->tight(graph);
+}
+
+// Simplifies every unit.
+void Watcher::simplify(std::vector<size_t>& owners) {
+	// The program is simplified as a whole, in the same order a full translation would see its rules.
+	Program& program = mTranslator->mParser.program();
+	std::vector<size_t> units;
+	program.rules().clear();
+	for (size_t i = 0; i < mUnits.size(); i++) {
+		program.rules().insert(program.rules().end(), mUnits[i].rules.begin(), mUnits[i].rules.end());
+		units.insert(units.end(), mUnits[i].rules.size(), i);
+	}
+
+	utils::Stats::Timer timer(&mStats, "simplify");
+	translator::Simplification simplification(mTranslator->symbols());
+	mSimplified->rules().clear();
+	simplification.translate(program, *mSimplified);
+	timer.rules(mSimplified->rules().size());
+	timer.nodes(mSimplified->nodes().size());
+	timer.bytes(mSimplified->nodes().bytes());
+	timer.stop();
+	mTranslator->shrank(simplification);
+
+	owners.clear();
+	for (UnitList::iterator it = mUnits.begin(); it != mUnits.end(); it++) it->simplified.clear();
+	for (size_t i = 0; i < simplification.sources().size(); i++) {
+		size_t u = units[simplification.sources()[i]];
+		mUnits[u].simplified.push_back(mSimplified->rules()[i]);
+		owners.push_back(u);
+	}
+}
+
+// Translates a theory.
+void Watcher::translate(Theory const& theory, std::vector<size_t> const& owners, Symbol::SymbolList const* constants) {
+	SymbolTable& symbols = mTranslator->symbols();
+	size_t threads = mConfig.intOpt(Config::OPT_THREADS);
+
+	utils::Stats::Timer normalizing(&mStats, "cnf");
+	translator::ClarkNormalForm cnf(symbols);
+	Theory* normal = cnf.translate(theory);
+	measure(normalizing, *normal);
+
+	utils::Stats::Timer completing(&mStats, "completion");
+	translator::Completion completion(symbols, threads, constants);
+	Theory* completed = completion.translate(*normal);
+	delete normal;
+	measure(completing, *completed);
+
+	utils::Stats::Timer eliminating(&mStats, "elimination");
+	translator::VariableElimination elimination(symbols, threads);
+	Theory* ground = elimination.translate(*completed);
+	delete completed;
+	measure(eliminating, *ground);
+
+	// A full translation is kept as it is, while the result of a partial one is merged into it.
+	bool whole = !constants;
+	if (whole) {
+		delete mGround;
+		mGround = ground;
+	}
+	mConstants.resize(symbols.size());
+
+	// Each formula of the completion grounds to a contiguous range of formulas, which go to its constant or unit.
+	NodeFactory::ImportMap memo;
+	size_t constraint = 0;
+	size_t begin = 0;
+	for (size_t i = 0; i < completion.sources().size(); i++) {
+		Symbol const* s = completion.sources()[i];
+		Theory::FormulaList& g = (s) ? mConstants[s->id()] : mConstraints[owners[completion.constraints()[constraint++]]];
+
+		size_t end = elimination.ends()[i];
+		for (; begin < end; begin++) {
+			Node const* f = ground->formulas()[begin];
+			g.push_back((whole) ? f : mGround->nodes().import(f, memo));
+		}
+	}
+	if (!whole) delete ground;
+}
+
+// Writes the program.
+bool Watcher::emit() {
+	std::ostream* out = mConfig.openOutput();
+	if (!out) {
+		std::cerr << "Error: Couldn't open the output file '" << mConfig.output() << "'.\n";
+		return false;
+	}
+
+	// The formulas are written in the same order as a full translation produces them.
+	mGround->formulas().clear();
+	for (GroundList::const_iterator it = mConstants.begin(); it != mConstants.end(); it++) {
+		mGround->formulas().insert(mGround->formulas().end(), it->begin(), it->end());
+	}
+	for (GroundList::const_iterator it = mConstraints.begin(); it != mConstraints.end(); it++) {
+		mGround->formulas().insert(mGround->formulas().end(), it->begin(), it->end());
+	}
+
+	SMTWriter* writer = mTranslator->writer(*out);
+	writer->stats(&mStats);
+	bool ok = writer->write(mTranslator->symbols(), *mGround);
+	delete writer;
+	out->flush();
+	delete out;
+	return ok;
+}
+
+// Watches a file.
+void Watcher::watch(std::string const& file, std::time_t since) {
+	if (!mMonitor.watch(file, since)) std::cerr << "Warning: Couldn't watch the file '" << file << "'.\n";
+}
+
+// Measures the result of a phase.
+void Watcher::measure(utils::Stats::Timer& timer, Theory const& theory) {
+	timer.rules(theory.rules().size());
+	timer.formulas(theory.formulas().size());
+	timer.nodes(theory.nodes().size());
+	timer.bytes(theory.nodes().bytes());
+	timer.stop();
+}
+
+// Gets the constant a rule defines.
+Symbol const* Watcher::head(Rule const& rule) {
+	Node const* h = rule.head;
+	if (h->type() == Node::EQ) h = h->arg(0);
+	return (h->type() == Node::APPLY) ? h->symbol() : NULL;
+}
+
+// Indexes rules by the constant they define.
+void Watcher::index(Theory::RuleList const& rules, RuleMap& out) {
+	for (Theory::RuleList::const_iterator it = rules.begin(); it != rules.end(); it++) out[head(*it)].push_back(*it);
+}
+
+// Compares two lists of rules.
+bool Watcher::same(Theory::RuleList const& a, Theory::RuleList const& b) {
+	if (a.size() != b.size()) return false;
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i].head != b[i].head || a[i].body != b[i].body || a[i].choice != b[i].choice) return false;
+	}
+	return true;
+}
+
+// Describes the order of the symbols.
+std::string Watcher::order() const {
+	std::ostringstream out;
+	boost::unordered_set<std::pair<std::string, size_t> > seen;
+
+	// Sorts are named separately from everything else.
+	for (UnitList::const_iterator u = mUnits.begin(); u != mUnits.end(); u++) {
+		SymbolTable const& symbols = u->parser->program().symbols();
+		for (size_t i = 0; i < symbols.size(); i++) {
+			Symbol const* s = symbols[i];
+			size_t arity = (s->type() == Symbol::SORT) ? (size_t)-1 : s->arity();
+			if (seen.insert(std::make_pair(s->name(), arity)).second) out << s->name() << "/" << arity << "\n";
+		}
+	}
+	return out.str();
+}
+
+// Describes the declarations in a symbol table.
+std::string Watcher::signature(SymbolTable const& symbols) {
+	std::ostringstream out;
+	for (size_t i = 0; i < symbols.size(); i++) {
+		Symbol const* s = symbols[i];
+		if (!s->declared()) continue;
+
+		out << s->type() << " " << s->name() << "/" << s->arity();
+		if (s->sort()) out << " : " << s->sort()->name();
+		for (Symbol::SortList::const_iterator it = s->args().begin(); it != s->args().end(); it++) out << " " << (*it)->name();
+		for (Symbol::DomainList::const_iterator it = s->domain().begin(); it != s->domain().end(); it++) {
+			if (it->object) out << " #" << it->object->name();
+			else out << " " << it->value;
+		}
+		out << "\n";
+	}
+	return out.str();
+}
@@ -0,0 +1,214 @@
+#ifndef __H_WATCHER__
+#define __H_WATCHER__
+
+#include <ctime>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include "elements/Program.h"
+#include "parser/Parser.h"
+#include "utilities/FileMonitor.h"
+#include "utilities/Stats.h"
+
+class Config;
+class Translator;
+
+/**
+ * @brief Watches the input files and writes the program again each time they change.
+ * Each input file (along with the files it includes) is a unit which is parsed on its own and merged
+ * into a translator's program, as with parallel parsing. The ground formulas are kept for each constant,
+ * and for the constraints of each unit, so that when some of the files change only their units are parsed
+ * again. Since nodes are hash-consed, rules which weren't edited are merged back as the very same nodes.
+ * The whole program is simplified again (which is cheap, and may change rules in any unit), and only the
+ * constants whose simplified rules differ (and the constraints of a unit, if any of them differ) are
+ * completed and have their variables eliminated again. The formulas of every other constant are reused.
+ *
+ * A unit whose declarations change, or which changes the order the program's symbols are first used in (and
+ * so their ids), may change the meaning of every other unit, in which case everything is translated again.
+ * Either way, the program which is written is the same as the one a full translation would produce. The
+ * nodes of rules and formulas which have been replaced are only freed when everything is translated again.
+ */
+class Watcher {
+
+private:
+	/***********************************************************************/
+	/* Private Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief An input file along with everything that was read for it.
+	 */
+	struct Unit {
+		std::string file;						///< The input file.
+		parser::Parser* parser;					///< The unit as it was last parsed, or NULL if it has to be parsed again.
+		std::list<std::string> files;			///< The absolute name of every file read for the unit when it was last parsed.
+		std::string signature;					///< A description of the symbols the unit declares.
+		elements::Theory::RuleList rules;		///< The unit's rules within the translator's program.
+		elements::Theory::RuleList simplified;	///< The unit's rules once the program has been simplified.
+	};
+
+	typedef std::vector<Unit> UnitList;
+	typedef std::vector<elements::Theory::FormulaList> GroundList;
+	typedef boost::unordered_map<elements::Symbol const*, elements::Theory::RuleList> RuleMap;
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	Config const& mConfig;					///< The configuration we're running with.
+	Translator* mTranslator;				///< The translator holding the symbols and the rules of every unit.
+	UnitList mUnits;						///< The units, in the order of the input files.
+	elements::Theory* mSimplified;			///< The theory every simplified rule belongs to, so that rules which simplify the same way are the same nodes.
+	elements::Theory* mGround;				///< The theory every ground formula belongs to, so that equal nodes are shared by all of them.
+	GroundList mConstants;					///< The ground formulas of each constant, indexed by id.
+	GroundList mConstraints;				///< The ground formulas of the constraints of each unit.
+	std::string mOrder;						///< The symbols in the order the units first use them, which determines their ids.
+	bool mStale;							///< Whether the translator's program is inconsistent with the units, and has to be rebuilt.
+	utils::FileMonitor mMonitor;			///< Waits for the files of the units to change.
+	utils::Stats mStats;					///< The time and memory taken by each stage of the latest update.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param config The configuration to run with, whose input files are watched. Should outlive the watcher.
+	 */
+	Watcher(Config const& config);
+
+	/**
+	 * @brief Basic Destructor.
+	 * Frees the units, the simplified and ground theories and the translator.
+	 */
+	virtual ~Watcher();
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Translates and writes the program, and then does so again each time the files change, until interrupted.
+	 * The output is opened again for each update. Errors in the files are reported to the standard error, and the
+	 * program is written again once they have been fixed. If asked to, the stats of each update are reported as well.
+	 * @return False if the files can't be watched.
+	 */
+	bool run();
+
+private:
+
+	/**
+	 * @brief Parses every unit which hasn't been parsed yet, and translates the whole program from scratch.
+	 * @return True if successful, false if a unit couldn't be parsed or the program is invalid.
+	 */
+	bool rebuild();
+
+	/**
+	 * @brief Parses some of the units again and retranslates the constants they define.
+	 * Falls back to rebuild() if the symbols of any of the units changed.
+	 * @param changed The indices of the units to parse again, in order.
+	 * @return True if successful, false if a unit couldn't be parsed or the program is invalid.
+	 */
+	bool update(std::vector<size_t> const& changed);
+
+	/**
+	 * @brief Parses a unit on its own, recording the files which were read for it.
+	 * Errors are reported to the standard error.
+	 * @param unit The unit to parse.
+	 * @return The parser holding the unit, or NULL if it couldn't be parsed.
+	 */
+	parser::Parser* parse(Unit& unit);
+
+	/**
+	 * @brief Merges a unit's program into the translator's, and takes the rules it adds as the unit's rules.
+	 * @param unit The unit to merge, which must have been parsed.
+	 * @return True if successful, false if a symbol was declared differently by the unit.
+	 */
+	bool merge(Unit& unit);
+
+	/**
+	 * @brief Checks the translator's program, reporting errors to the standard error.
+	 * @return True if successful, false otherwise.
+	 */
+	bool check();
+
+	/**
+	 * @brief Analyzes the positive dependencies of every unit's rules, warning about the components which aren't tight.
+	 */
+	void analyze();
+
+	/**
+	 * @brief Simplifies the rules of every unit together, replacing the rules of the simplified theory.
+	 * @param owners Set to the unit each simplified rule belongs to.
+	 */
+	void simplify(std::vector<size_t>& owners);
+
+	/**
+	 * @brief Translates a theory and takes each ground formula it produces as the formula of its constant or unit.
+	 * @param theory The simplified theory to translate.
+	 * @param owners The unit each of the theory's rules belongs to.
+	 * @param constants The only constants to complete, ordered by id, or NULL to complete every constant.
+	 * The ground formulas of each of these constants must have been dropped.
+	 */
+	void translate(elements::Theory const& theory, std::vector<size_t> const& owners, elements::Symbol::SymbolList const* constants);
+
+	/**
+	 * @brief Writes the program from the current ground formulas.
+	 * @return True if successful, false otherwise.
+	 */
+	bool emit();
+
+	/**
+	 * @brief Watches a file read for one of the units, unless it's already watched. Files stay watched from then on.
+	 * Files which can't be watched are reported to the standard error.
+	 * @param file The file.
+	 * @param since The time the file was read, or 0 if it's about to be (see utils::FileMonitor::watch()).
+	 */
+	void watch(std::string const& file, std::time_t since);
+
+	/**
+	 * @brief Gives a timer the counts of the result of a phase, and stops it.
+	 * @param timer The timer of the phase.
+	 * @param theory The result of the phase.
+	 */
+	static void measure(utils::Stats::Timer& timer, elements::Theory const& theory);
+
+	/**
+	 * @brief Gets the constant a rule defines.
+	 * @return The constant, or NULL if the rule is a constraint.
+	 */
+	static elements::Symbol const* head(elements::Rule const& rule);
+
+	/**
+	 * @brief Indexes rules by the constant they define, keeping their order.
+	 * @param rules The rules to index.
+	 * @param out The rules for each constant, with the constraints under NULL.
+	 */
+	static void index(elements::Theory::RuleList const& rules, RuleMap& out);
+
+	/**
+	 * @brief Determines whether two lists of rules are the same, which for rules in the same factory means their nodes are.
+	 */
+	static bool same(elements::Theory::RuleList const& a, elements::Theory::RuleList const& b);
+
+	/**
+	 * @brief Describes the symbols of the units in the order they're first used in, as they would be merged.
+	 * Every unit must have been parsed.
+	 */
+	std::string order() const;
+
+	/**
+	 * @brief Describes the symbols declared in a table, in order.
+	 */
+	static std::string signature(elements::SymbolTable const& symbols);
+
+	/// Watchers aren't copyable.
+	Watcher(Watcher const&);
+	Watcher& operator=(Watcher const&);
+
+};
+
+#endif
@@ -0,0 +1,771 @@
+#include <cstdlib>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <iostream>
+
+#include <boost/bind/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/locks.hpp>
+
+#include "utilities/ThreadPool.h"
+#include "SortEncoding.h"
+#include "Z3Solver.h"
+
+using namespace elements;
+
+/// The number of cubes to split the search space into per worker thread, to keep the workers evenly loaded.
+#define CUBES_PER_THREAD 4
+
+/// The number of milliseconds between interrupts of the cubes or racers which are still checking after they've been stopped.
+#define INTERRUPT_INTERVAL 10
+
+namespace {
+
+// A configuration which can be raced in the portfolio.
+struct Configuration {
+	char const* name;			// The name of the configuration.
+	char const* tactics;		// The tactics to build the solver from, separated by spaces, or NULL for the default solver.
+	char const* params;			// The (unsigned) parameters to set, as key=value separated by spaces, or NULL.
+};
+
+// The configurations which can be raced.
+Configuration const CONFIGURATIONS[] = {
+	{ "default", NULL, NULL },
+	{ "random", NULL, "random_seed=7 smt.phase_selection=5" },
+	{ "simplex", NULL, "smt.arith.solver=2" },
+	{ "preprocess", "simplify propagate-values solve-eqs elim-uncnstr smt", NULL },
+	{ NULL, NULL, NULL }
+};
+
+// Whether Z3 handles SIGINT while checking.
+bool interruptible = true;
+
+// Stops Z3 from handling SIGINT while a solver checks, unless it's allowed to.
+void guard(z3::solver& solver) {
+	if (interruptible) return;
+	z3::params p(solver.ctx());
+	p.set("ctrl_c", false);
+	solver.set(p);
+}
+
+// Builds a solver according to a configuration.
+z3::solver configure(z3::context& context, Configuration const& c) {
+	z3::solver solver(context);
+
+	if (c.tactics) {
+		std::istringstream in(c.tactics);
+		std::string name;
+		in >> name;
+		z3::tactic t(context, name.c_str());
+		while (in >> name) t = t & z3::tactic(context, name.c_str());
+		solver = t.mk_solver();
+	}
+
+	if (c.params) {
+		z3::params p(context);
+		std::istringstream in(c.params);
+		std::string param;
+		while (in >> param) {
+			size_t eq = param.find('=');
+			p.set(param.substr(0, eq).c_str(), (unsigned)strtoul(param.c_str() + eq + 1, NULL, 10));
+		}
+		solver.set(p);
+	}
+	guard(solver);
+	return solver;
+}
+
+}
+
+// Constructor
+Z3Solver::Z3Solver(std::ostream& out, size_t threads, size_t models, int portfolio)
+	: mOut(out), mThreads(threads), mModels(models), mPortfolio(portfolio), mSolver(mContext), mResult(z3::unknown),
+	  mSymbols(NULL), mStopped(false), mWinner(NULL) {
+	guard(mSolver);
+}
+
+// Gets the name of a configuration.
+char const* Z3Solver::configuration(size_t configuration) {
+	for (size_t i = 0; CONFIGURATIONS[i].name; i++) {
+		if (i == configuration) return CONFIGURATIONS[i].name;
+	}
+	return NULL;
+}
+
+// Parses a list of configurations.
+int Z3Solver::portfolio(std::string const& names) {
+	int mask = 0;
+
+	std::istringstream in(names);
+	std::string name;
+	while (std::getline(in, name, ',')) {
+		bool found = false;
+		for (size_t i = 0; CONFIGURATIONS[i].name; i++) {
+			if (name != "all" && name != CONFIGURATIONS[i].name) continue;
+			mask |= 1 << i;
+			found = true;
+		}
+		if (!found) return -1;
+	}
+	return mask;
+}
+
+// Sets whether Z3 handles SIGINT.
+void Z3Solver::interrupts(bool enabled) {
+	interruptible = enabled;
+}
+
+// Sets up a configuration.
+Z3Solver::Racer::Racer(Z3Solver* owner, size_t configuration, z3::expr_vector const& terms)
+	: owner(owner), name(CONFIGURATIONS[configuration].name), solver(configure(context, CONFIGURATIONS[configuration])),
+	  terms(context, terms), result(z3::unknown), seconds(0), checking(false) {
+	owner->copy(solver);
+}
+
+// Runs a configuration.
+void Z3Solver::Racer::run() {
+	// Interrupting a context only affects a check which is already running, so the owner keeps interrupting it until it's done.
+	if (!owner->begin(checking)) return;
+	boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+
+	try {
+		result = solver.check();
+		owner->end(checking);
+		if (result == z3::sat) {
+			z3::model model = solver.get_model();
+			for (unsigned i = 0; i < terms.size(); i++) owner->print(line, i, model.eval(terms[i], true));
+		} else if (result == z3::unknown) {
+			reason = solver.reason_unknown();
+		}
+	} catch (z3::exception& e) {
+		owner->end(checking);
+		result = z3::unknown;
+		error = e.msg();
+	}
+
+	seconds = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / 1e6;
+	if (result != z3::unknown) owner->win(this);
+}
+
+// Copies the solver into a cube.
+Z3Solver::Cube::Cube(Z3Solver* owner, z3::expr_vector const& terms, z3::expr_vector const& literals)
+	: owner(owner), solver(context), terms(context, terms), result(z3::unknown), checking(false) {
+	guard(solver);
+	owner->copy(solver);
+
+	z3::expr_vector cube(context, literals);
+	for (unsigned i = 0; i < cube.size(); i++) solver.add(cube[i]);
+}
+
+// Enumerates a cube.
+void Z3Solver::Cube::run() {
+	try {
+		while (owner->begin(checking)) {
+			result = solver.check();
+			owner->end(checking);
+			if (result != z3::sat) {
+				if (result == z3::unknown) reason = solver.reason_unknown();
+				return;
+			}
+
+			// Models which display the same way are the same model, so block each one in terms of what's displayed.
+			z3::model model = solver.get_model();
+			z3::expr_vector block(context);
+			std::string line;
+			for (unsigned i = 0; i < terms.size(); i++) {
+				z3::expr value = model.eval(terms[i], true);
+				owner->print(line, i, value);
+				block.push_back(terms[i] != value);
+			}
+
+			if (!owner->report(line)) return;
+			solver.add(z3::mk_or(block));
+		}
+	} catch (z3::exception& e) {
+		owner->end(checking);
+		error = e.msg();
+	}
+}
+
+// Declares the program's symbols.
+bool Z3Solver::declare(SymbolTable const& symbols) {
+	mSymbols = &symbols;
+
+	Symbol::SymbolList all;
+	for (size_t i = 0; i < symbols.size(); i++) all.push_back(symbols[i]);
+
+	try {
+		declare(all);
+	} catch (z3::exception& e) {
+		std::cerr << "Error: Z3: " << e.msg() << "\n";
+		return false;
+	}
+	return true;
+}
+
+// Declares some symbols.
+void Z3Solver::declare(Symbol::SymbolList const& symbols) {
+	// Sorts of objects become enumerations, with another constructor for the integers of mixed sorts.
+	for (Symbol::SymbolList::const_iterator it = symbols.begin(); it != symbols.end(); it++) {
+		Symbol const* s = *it;
+		if (s->type() != Symbol::SORT) continue;
+		SortEncoding::Kind kind = SortEncoding::kind(*mSymbols, s);
+		if (kind != SortEncoding::ENUMERATION && kind != SortEncoding::MIXED) continue;
+
+		std::vector<Symbol const*> objects;
+		std::vector<char const*> names;
+		for (Symbol::DomainList::const_iterator d = s->domain().begin(); d != s->domain().end(); d++) {
+			if (!d->object) continue;
+			objects.push_back(d->object);
+			names.push_back(d->object->name().c_str());
+		}
+
+		// A sort may be declared again by a later scope, in which case it replaces the earlier declaration.
+		z3::func_decl_vector constructors(mContext);
+		z3::func_decl_vector testers(mContext);
+		mSorts.erase(s);
+		if (kind == SortEncoding::MIXED) {
+			mSorts.insert(SortMap::value_type(s, datatype(s, names, constructors)));
+		} else {
+			mSorts.insert(SortMap::value_type(s, mContext.enumeration_sort(s->name().c_str(), (unsigned)names.size(), &names[0], constructors, testers)));
+		}
+		for (size_t o = 0; o < objects.size(); o++) {
+			mDecls.erase(objects[o]);
+			mDecls.insert(DeclMap::value_type(objects[o], constructors[(unsigned)o]));
+			mObjects[constructors[(unsigned)o].name().str()] = objects[o];
+		}
+	}
+
+	for (Symbol::SymbolList::const_iterator it = symbols.begin(); it != symbols.end(); it++) {
+		Symbol const* s = *it;
+		if (!s->constant()) continue;
+
+		z3::sort_vector domain(mContext);
+		for (Symbol::SortList::const_iterator a = s->args().begin(); a != s->args().end(); a++) domain.push_back(sort(*a));
+		z3::func_decl decl = mContext.function(s->name().c_str(), domain, sort(s->sort()));
+		mDecls.erase(s);
+		mDecls.insert(DeclMap::value_type(s, decl));
+		mShown.push_back(s);
+
+		// Restrict the values of functions to sorts of integers to the sort's domain.
+		if (s->type() != Symbol::FUNCTION || s->sort() == mSymbols->integer()) continue;
+		SortEncoding::Kind kind = SortEncoding::kind(*mSymbols, s->sort());
+		if (kind != SortEncoding::INTEGER && kind != SortEncoding::MIXED) continue;
+
+		// Finite arguments are enumerated, while integer arguments are quantified (as Z3Writer does).
+		bool enumerated = finite(s);
+		z3::expr_vector bound(mContext);
+		if (!enumerated) {
+			for (size_t a = 0; a < s->args().size(); a++) {
+				std::ostringstream name;
+				name << "x!" << a;
+				bound.push_back(mContext.constant(name.str().c_str(), sort(s->args()[a])));
+			}
+		}
+
+		std::vector<size_t> pos(s->args().size(), 0);
+		for (;;) {
+			z3::expr_vector args(mContext);
+			for (size_t a = 0; a < pos.size(); a++) args.push_back((enumerated) ? element(s->args()[a], s->args()[a]->domain()[pos[a]]) : bound[(unsigned)a]);
+			z3::expr app = decl(args);
+
+			z3::expr_vector values(mContext);
+			for (Symbol::DomainList::const_iterator d = s->sort()->domain().begin(); d != s->sort()->domain().end(); d++) {
+				values.push_back(app == element(s->sort(), *d));
+			}
+			z3::expr restriction = z3::mk_or(values);
+			mSolver.add((enumerated) ? restriction : z3::forall(bound, restriction));
+
+			if (!enumerated) break;
+			size_t a = 0;
+			while (a < pos.size() && ++pos[a] == s->args()[a]->domain().size()) pos[a++] = 0;
+			if (a == pos.size()) break;
+		}
+	}
+}
+
+// Adds a formula.
+bool Z3Solver::add(Node const* formula) {
+	try {
+		mSolver.add(expr(formula));
+	} catch (z3::exception& e) {
+		std::cerr << "Error: Z3: " << e.msg() << "\n";
+		return false;
+	}
+	return true;
+}
+
+// Solves the program.
+bool Z3Solver::finish() {
+	return check();
+}
+
+// Opens a scope.
+bool Z3Solver::push(std::string const& name, Symbol::SymbolList const& symbols) {
+	try {
+		mSolver.push();
+		mScopes.push_back(Scope(name, mShown.size()));
+		declare(symbols);
+	} catch (z3::exception& e) {
+		std::cerr << "Error: Z3: " << e.msg() << "\n";
+		return false;
+	}
+
+	// The nodes built so far may be freed now.
+	mExprs.clear();
+	return true;
+}
+
+// Checks the formulas so far.
+bool Z3Solver::check() {
+	if (!mScopes.empty()) mOut << "Query: " << mScopes.back().first << "\n";
+	if (mModels != 1) return enumerate();
+	if (mPortfolio) return race();
+
+	try {
+		mResult = mSolver.check();
+		switch (mResult) {
+		case z3::sat:
+			mOut << "Answer: 1\n";
+			display(mSolver.get_model(), mOut);
+			mOut << "SATISFIABLE\n";
+			break;
+		case z3::unsat:
+			mOut << "UNSATISFIABLE\n";
+			break;
+		default:
+			mOut << "UNKNOWN (" << mSolver.reason_unknown() << ")\n";
+			break;
+		}
+	} catch (z3::exception& e) {
+		std::cerr << "Error: Z3: " << e.msg() << "\n";
+		return false;
+	}
+	return mOut.good();
+}
+
+// Closes a scope.
+bool Z3Solver::pop() {
+	try {
+		mSolver.pop();
+	} catch (z3::exception& e) {
+		std::cerr << "Error: Z3: " << e.msg() << "\n";
+		return false;
+	}
+
+	mShown.resize(mScopes.back().second);
+	mScopes.pop_back();
+	mExprs.clear();
+	return true;
+}
+
+// Lets go of the nodes added so far.
+bool Z3Solver::release() {
+	mExprs.clear();
+	return true;
+}
+
+// Displays a model.
+void Z3Solver::display(z3::model const& model, std::ostream& out) {
+	z3::expr_vector terms(mContext);
+	shown(terms);
+
+	std::string line;
+	for (unsigned i = 0; i < terms.size(); i++) print(line, i, model.eval(terms[i], true));
+	out << line << "\n";
+}
+
+// Gets the displayed terms.
+void Z3Solver::shown(z3::expr_vector& terms) {
+	mTerms.clear();
+
+	for (Symbol::SymbolList::const_iterator it = mShown.begin(); it != mShown.end(); it++) {
+		Symbol const* s = *it;
+		if (!finite(s)) continue;
+
+		z3::func_decl decl = mDecls.find(s)->second;
+		std::vector<size_t> pos(s->args().size(), 0);
+		for (;;) {
+			z3::expr_vector args(mContext);
+			Term t;
+			t.constant = s;
+			t.label = s->name();
+			for (size_t a = 0; a < pos.size(); a++) {
+				Symbol::Element const& e = s->args()[a]->domain()[pos[a]];
+				args.push_back(element(s->args()[a], e));
+
+				t.label += (a) ? "," : "(";
+				if (e.object) {
+					t.label += e.object->name();
+				} else {
+					std::ostringstream v;
+					v << e.value;
+					t.label += v.str();
+				}
+			}
+			if (pos.size()) t.label += ")";
+
+			terms.push_back(decl(args));
+			mTerms.push_back(t);
+
+			size_t a = 0;
+			while (a < pos.size() && ++pos[a] == s->args()[a]->domain().size()) pos[a++] = 0;
+			if (a == pos.size()) break;
+		}
+	}
+}
+
+// Appends a term's value.
+void Z3Solver::print(std::string& line, size_t term, z3::expr const& value) const {
+	Term const& t = mTerms[term];
+	bool function = t.constant->type() == Symbol::FUNCTION;
+	if (!function && !value.is_true()) return;
+
+	if (!line.empty()) line += " ";
+	line += t.label;
+	if (function) {
+		ObjectMap::const_iterator o = (value.is_app() && !value.is_numeral()) ? mObjects.find(value.decl().name().str()) : mObjects.end();
+		line += "=";
+		if (o != mObjects.end()) line += o->second->name();
+		else if (value.is_app() && value.num_args() == 1) line += value.arg(0).to_string();
+		else line += value.to_string();
+	}
+}
+
+// Enumerates models in parallel.
+bool Z3Solver::enumerate() {
+	bool ok = true;
+
+	try {
+		z3::expr_vector terms(mContext);
+		shown(terms);
+
+		// Split the search space in two on each of the first few atoms and function values...
+		size_t threads = utils::ThreadPool::threads(mThreads);
+		z3::expr_vector splits(mContext);
+		for (unsigned i = 0; i < terms.size() && threads > 1 && ((size_t)1 << splits.size()) < threads * CUBES_PER_THREAD; i++) {
+			Symbol const* c = mTerms[i].constant;
+			if (c->type() == Symbol::PREDICATE) splits.push_back(terms[i]);
+			else if (c->sort() != mSymbols->integer() && !c->sort()->domain().empty()) splits.push_back(terms[i] == element(c->sort(), c->sort()->domain().front()));
+		}
+
+		// ... each combination of which is enumerated on its own.
+		size_t n = (size_t)1 << splits.size();
+		mFound.clear();
+		mStopped = false;
+		for (size_t c = 0; c < n; c++) {
+			z3::expr_vector literals(mContext);
+			for (unsigned i = 0; i < splits.size(); i++) literals.push_back(((c >> i) & 1) ? !splits[i] : splits[i]);
+			mCubes.push_back(new Cube(this, terms, literals));
+		}
+	} catch (z3::exception& e) {
+		std::cerr << "Error: Z3: " << e.msg() << "\n";
+		ok = false;
+	}
+
+	if (ok && (utils::ThreadPool::threads(mThreads) <= 1 || mCubes.size() <= 1)) {
+		for (size_t c = 0; c < mCubes.size(); c++) mCubes[c]->run();
+	} else if (ok) {
+		size_t threads = utils::ThreadPool::threads(mThreads);
+		utils::ThreadPool pool((threads < mCubes.size()) ? threads : mCubes.size());
+		for (size_t c = 0; c < mCubes.size(); c++) pool.post(boost::bind(&Cube::run, mCubes[c]));
+		wait(pool);
+	}
+
+	// Any model means the program is satisfiable, otherwise it's unsatisfiable unless a cube is unknown.
+	std::string reason;
+	bool unknown = false;
+	for (size_t c = 0; c < mCubes.size(); c++) {
+		if (!mCubes[c]->error.empty() && !mStopped) {
+			std::cerr << "Error: Z3: " << mCubes[c]->error << "\n";
+			ok = false;
+		}
+		if (mCubes[c]->result == z3::unknown && !unknown && mCubes[c]->error.empty()) {
+			reason = mCubes[c]->reason;
+			unknown = true;
+		}
+		delete mCubes[c];
+	}
+	mCubes.clear();
+	if (!ok) return false;
+
+	if (!mFound.empty()) {
+		mResult = z3::sat;
+		mOut << "SATISFIABLE\nModels: " << mFound.size() << ((mStopped) ? "+" : "") << "\n";
+	} else if (unknown) {
+		mResult = z3::unknown;
+		mOut << "UNKNOWN (" << reason << ")\n";
+	} else {
+		mResult = z3::unsat;
+		mOut << "UNSATISFIABLE\n";
+	}
+	return mOut.good();
+}
+
+// Displays a model found while enumerating.
+bool Z3Solver::report(std::string const& line) {
+	boost::lock_guard<boost::mutex> guard(mLock);
+	if (mStopped) return false;
+	if (!mFound.insert(line).second) return true;
+
+	mOut << "Answer: " << mFound.size() << "\n" << line << "\n";
+	if (!mModels || mFound.size() < mModels) return true;
+
+	// Stop the other cubes as soon as possible.
+	mStopped = true;
+	for (std::vector<Cube*>::const_iterator it = mCubes.begin(); it != mCubes.end(); it++) (*it)->context.interrupt();
+	return false;
+}
+
+// Marks a cube or racer as checking.
+bool Z3Solver::begin(bool& checking) {
+	boost::lock_guard<boost::mutex> guard(mLock);
+	checking = !mStopped;
+	return checking;
+}
+
+// Marks a cube or racer as done checking.
+void Z3Solver::end(bool& checking) {
+	boost::lock_guard<boost::mutex> guard(mLock);
+	checking = false;
+}
+
+// Interrupts the cubes and racers which are still checking.
+void Z3Solver::interrupt() {
+	boost::lock_guard<boost::mutex> guard(mLock);
+	if (!mStopped) return;
+	for (std::vector<Cube*>::const_iterator it = mCubes.begin(); it != mCubes.end(); it++) {
+		if ((*it)->checking) (*it)->context.interrupt();
+	}
+	for (std::vector<Racer*>::const_iterator it = mRacers.begin(); it != mRacers.end(); it++) {
+		if ((*it)->checking) (*it)->context.interrupt();
+	}
+}
+
+// Waits for the cubes or racers.
+void Z3Solver::wait(utils::ThreadPool& pool) {
+	// One which started checking just after it was stopped missed the interrupt, so it's interrupted again until it returns.
+	while (!pool.wait(boost::posix_time::milliseconds(INTERRUPT_INTERVAL))) interrupt();
+}
+
+// Races the portfolio.
+bool Z3Solver::race() {
+	bool ok = true;
+
+	try {
+		z3::expr_vector terms(mContext);
+		shown(terms);
+
+		mWinner = NULL;
+		mStopped = false;
+		for (size_t i = 0; CONFIGURATIONS[i].name; i++) {
+			if (mPortfolio & (1 << i)) mRacers.push_back(new Racer(this, i, terms));
+		}
+	} catch (z3::exception& e) {
+		std::cerr << "Error: Z3: " << e.msg() << "\n";
+		ok = false;
+	}
+
+	// Every configuration gets a thread of its own, since the first to finish decides.
+	if (ok) {
+		utils::ThreadPool pool(mRacers.size());
+		for (size_t r = 0; r < mRacers.size(); r++) pool.post(boost::bind(&Racer::run, mRacers[r]));
+		wait(pool);
+	}
+
+	if (ok && mWinner) {
+		mResult = mWinner->result;
+		if (mResult == z3::sat) mOut << "Answer: 1\n" << mWinner->line << "\nSATISFIABLE\n";
+		else mOut << "UNSATISFIABLE\n";
+	} else if (ok) {
+		// Without a winner, report the first configuration's reason, or its error.
+		mResult = z3::unknown;
+		if (!mRacers.front()->error.empty()) {
+			std::cerr << "Error: Z3: " << mRacers.front()->error << "\n";
+			ok = false;
+		} else {
+			mOut << "UNKNOWN (" << mRacers.front()->reason << ")\n";
+		}
+	}
+
+	if (ok) {
+		mOut << "Portfolio:\n";
+		for (size_t r = 0; r < mRacers.size(); r++) {
+			Racer const* racer = mRacers[r];
+			mOut << "  " << std::left << std::setw(12) << racer->name << std::right << std::fixed << std::setprecision(3)
+				<< racer->seconds << "s  ";
+			if (racer == mWinner) mOut << "won\n";
+			else if (mWinner && racer->result == z3::unknown) mOut << "cancelled\n";
+			else if (racer->result == z3::unknown) mOut << "unknown (" << ((racer->error.empty()) ? racer->reason : racer->error) << ")\n";
+			else mOut << "finished\n";
+		}
+		mOut.unsetf(std::ios::floatfield);
+	}
+
+	for (size_t r = 0; r < mRacers.size(); r++) delete mRacers[r];
+	mRacers.clear();
+	return ok && mOut.good();
+}
+
+// Claims the win for a racer.
+void Z3Solver::win(Racer* racer) {
+	boost::lock_guard<boost::mutex> guard(mLock);
+	if (mWinner) return;
+
+	mWinner = racer;
+	mStopped = true;
+	for (std::vector<Racer*>::const_iterator it = mRacers.begin(); it != mRacers.end(); it++) {
+		if (*it != racer) (*it)->context.interrupt();
+	}
+}
+
+// Copies the formulas so far.
+void Z3Solver::copy(z3::solver& to) {
+	// Solvers with open scopes can't be translated directly, so their assertions are copied instead.
+	z3::expr_vector assertions(to.ctx(), mSolver.assertions());
+	for (unsigned i = 0; i < assertions.size(); i++) to.add(assertions[i]);
+}
+
+// Gets the Z3 sort for a sort.
+z3::sort Z3Solver::sort(Symbol const* s) {
+	switch (SortEncoding::kind(*mSymbols, s)) {
+	case SortEncoding::BOOLEAN:	return mContext.bool_sort();
+	case SortEncoding::INTEGER:	return mContext.int_sort();
+	default:					return mSorts.find(s)->second;
+	}
+}
+
+// Declares the datatype for a mixed sort.
+z3::sort Z3Solver::datatype(Symbol const* s, std::vector<char const*> const& names, z3::func_decl_vector& constructors) {
+	// The C++ API has no datatypes of its own, so the constructors are made through the C API.
+	std::string wrapper = SortEncoding::wrapper(s);
+	Z3_symbol field = Z3_mk_string_symbol(mContext, SortEncoding::accessor(s).c_str());
+	Z3_sort integer = mContext.int_sort();
+	unsigned ref = 0;
+
+	std::vector<Z3_constructor> cons;
+	for (size_t o = 0; o < names.size(); o++) {
+		std::string tester = std::string("is-") + names[o];
+		cons.push_back(Z3_mk_constructor(mContext, Z3_mk_string_symbol(mContext, names[o]), Z3_mk_string_symbol(mContext, tester.c_str()), 0, NULL, NULL, NULL));
+	}
+	cons.push_back(Z3_mk_constructor(mContext, Z3_mk_string_symbol(mContext, wrapper.c_str()), Z3_mk_string_symbol(mContext, SortEncoding::tester(s).c_str()), 1, &field, &integer, &ref));
+
+	Z3_sort sort = Z3_mk_datatype(mContext, Z3_mk_string_symbol(mContext, s->name().c_str()), (unsigned)cons.size(), &cons[0]);
+	z3::sort result(mContext, sort);
+	for (size_t c = 0; c < cons.size(); c++) {
+		Z3_func_decl decl, tester, accessor;
+		Z3_query_constructor(mContext, cons[c], (c < names.size()) ? 0 : 1, &decl, &tester, &accessor);
+		if (c < names.size()) {
+			constructors.push_back(z3::func_decl(mContext, decl));
+		} else {
+			mWrappers.erase(s);
+			mWrappers.insert(DeclMap::value_type(s, z3::func_decl(mContext, decl)));
+			mAccessors.erase(s);
+			mAccessors.insert(DeclMap::value_type(s, z3::func_decl(mContext, accessor)));
+			mTesters.erase(s);
+			mTesters.insert(DeclMap::value_type(s, z3::func_decl(mContext, tester)));
+		}
+		Z3_del_constructor(mContext, cons[c]);
+	}
+	mContext.check_error();
+	return result;
+}
+
+// Gets the expression for an element.
+z3::expr Z3Solver::element(Symbol const* sort, Symbol::Element const& e) {
+	if (e.object) return mDecls.find(e.object)->second();
+	z3::expr value = mContext.int_val((int64_t)e.value);
+	if (SortEncoding::kind(*mSymbols, sort) == SortEncoding::MIXED) return mWrappers.find(sort)->second(value);
+	return value;
+}
+
+// Builds the expression for an argument of a node.
+z3::expr Z3Solver::argument(Node const* node, size_t arg) {
+	z3::expr e = expr(node->arg(arg));
+	Symbol const* mixed = NULL;
+	switch (SortEncoding::coercion(*mSymbols, node, arg, mixed)) {
+	case SortEncoding::WRAP:	return mWrappers.find(mixed)->second(e);
+	case SortEncoding::UNWRAP:	return mAccessors.find(mixed)->second(e);
+	default:					return e;
+	}
+}
+
+// Builds the expression for a node.
+z3::expr Z3Solver::expr(Node const* node) {
+	ExprMap::const_iterator it = mExprs.find(node);
+	if (it != mExprs.end()) return it->second;
+
+	// Atoms which take terms of mixed sorts as integers only hold if they are.
+	SortEncoding::GuardList guards;
+	if (node->formula() && !SortEncoding::guards(*mSymbols, node, guards)) {
+		z3::expr never = mContext.bool_val(false);
+		mExprs.insert(ExprMap::value_type(node, never));
+		return never;
+	}
+
+	z3::expr_vector args(mContext);
+	if (!node->quantifier()) {
+		for (size_t i = 0; i < node->arity(); i++) args.push_back(argument(node, i));
+	}
+
+	z3::expr e(mContext);
+	switch (node->type()) {
+	case Node::VARIABLE:
+		e = mContext.constant(node->symbol()->name().c_str(), sort(node->symbol()->sort()));
+		break;
+
+	case Node::APPLY:
+		e = mDecls.find(node->symbol())->second(args);
+		break;
+
+	case Node::INTEGER:		e = mContext.int_val((int64_t)node->value()); break;
+	case Node::PLUS:		e = args[0] + args[1]; break;
+	case Node::MINUS:		e = args[0] - args[1]; break;
+	case Node::TIMES:		e = args[0] * args[1]; break;
+	case Node::DIVIDE:		e = args[0] / args[1]; break;
+	case Node::NEGATE:		e = -args[0]; break;
+	case Node::TRUE:		e = mContext.bool_val(true); break;
+	case Node::FALSE:		e = mContext.bool_val(false); break;
+	case Node::EQ:			e = args[0] == args[1]; break;
+	case Node::LT:			e = args[0] < args[1]; break;
+	case Node::LE:			e = args[0] <= args[1]; break;
+	case Node::GT:			e = args[0] > args[1]; break;
+	case Node::GE:			e = args[0] >= args[1]; break;
+	case Node::NOT:			e = !args[0]; break;
+	case Node::AND:			e = z3::mk_and(args); break;
+	case Node::OR:			e = z3::mk_or(args); break;
+	case Node::IMPLIES:		e = z3::implies(args[0], args[1]); break;
+	case Node::IFF:			e = args[0] == args[1]; break;
+
+	case Node::EXISTS:
+	case Node::FORALL:
+		{
+			z3::expr v = mContext.constant(node->symbol()->name().c_str(), sort(node->symbol()->sort()));
+			z3::expr body = expr(node->arg(0));
+			e = (node->type() == Node::EXISTS) ? z3::exists(v, body) : z3::forall(v, body);
+		}
+		break;
+	}
+
+	if (!guards.empty()) {
+		z3::expr_vector conjuncts(mContext);
+		for (SortEncoding::GuardList::const_iterator g = guards.begin(); g != guards.end(); g++) {
+			conjuncts.push_back(mTesters.find(g->second)->second(expr(g->first)));
+		}
+		conjuncts.push_back(e);
+		e = z3::mk_and(conjuncts);
+	}
+
+	mExprs.insert(ExprMap::value_type(node, e));
+	return e;
+}
+
+// Determines whether a constant's arguments are finite.
+bool Z3Solver::finite(Symbol const* constant) const {
+	for (Symbol::SortList::const_iterator it = constant->args().begin(); it != constant->args().end(); it++) {
+		if (*it == mSymbols->integer() || *it == mSymbols->boolean()) return false;
+	}
+	return true;
+}
@@ -0,0 +1,294 @@
+#ifndef __H_Z3_SOLVER__
+#define __H_Z3_SOLVER__
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <iostream>
+
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <z3++.h>
+
+#include "utilities/ThreadPool.h"
+#include "SMTWriter.h"
+
+/**
+ * @brief Solves the translated program in-process using the Z3 C++ API.
+ * Rather than printing the program for Z3 to parse again, each formula is built directly as a
+ * Z3 expression. Expressions are cached by node, so a subterm shared within the DAG is built once
+ * and shared by handle. Once every formula has been added the solver is run and the model is read
+ * back through the API and displayed.
+ *
+ * Sorts are mapped as they are by Z3Writer (see SortEncoding): object sorts become enumerations,
+ * integer sorts become Int and sorts of both become datatypes wrapping their integers, with the value
+ * of each function restricted to the domain of its sort.
+ *
+ * Scopes map onto the solver's own push and pop, so whatever it learns from the formulas outside
+ * a scope is kept from one query to the next. Only the constants declared outside of any scope
+ * or within the innermost one are displayed.
+ *
+ * When more than one model is wanted, the search space is split into cubes over the first few
+ * displayed atoms and function values. Each cube is given its own copy of the solver (in its own
+ * context, since contexts can't be shared between threads) and enumerated on a pool of worker threads,
+ * blocking each model in terms of the displayed values. Models are displayed as they're found, skipping
+ * duplicates, and the workers are interrupted as soon as the limit is reached.
+ *
+ * When a single model is wanted and a portfolio of configurations is given, each configuration gets
+ * its own copy of the solver in the same way and they're raced on their own threads. The first to
+ * reach a definitive answer wins and the rest are interrupted, after which the time each configuration
+ * took is reported.
+ */
+class Z3Solver : public SMTWriter {
+
+private:
+	/***********************************************************************/
+	/* Private Types */
+	/***********************************************************************/
+
+	typedef boost::unordered_map<elements::Symbol const*, z3::sort> SortMap;
+	typedef boost::unordered_map<elements::Symbol const*, z3::func_decl> DeclMap;
+	typedef boost::unordered_map<elements::Node const*, z3::expr> ExprMap;
+	typedef boost::unordered_map<std::string, elements::Symbol const*> ObjectMap;
+
+	/// The name of an open scope, along with the number of constants shown when it was opened.
+	typedef std::pair<std::string, size_t> Scope;
+
+	/**
+	 * @brief A ground application of a displayed constant.
+	 */
+	struct Term {
+		elements::Symbol const* constant;		///< The constant being applied.
+		std::string label;						///< The application as it's displayed.
+	};
+
+	/// The type of a list of terms.
+	typedef std::vector<Term> TermList;
+
+	/**
+	 * @brief A part of the search space whose models are enumerated by its own solver.
+	 */
+	struct Cube {
+		Z3Solver* owner;						///< The solver being enumerated.
+		z3::context context;					///< The context of the cube's solver, which belongs to one thread.
+		z3::solver solver;						///< A solver for the formulas so far, restricted to the cube.
+		z3::expr_vector terms;					///< The displayed terms, within the cube's context.
+		z3::check_result result;				///< The result of the cube's last check.
+		std::string reason;						///< The reason the result is unknown, if it is.
+		std::string error;						///< The error which occurred, if any.
+		bool checking;							///< Whether the cube's solver is checking, or about to (guarded by the owner's lock).
+
+		/**
+		 * @brief Copies the solver and restricts it to a cube. Must be called by the thread which owns the solver.
+		 * @param owner The solver being enumerated.
+		 * @param terms The displayed terms.
+		 * @param literals The literals making up the cube.
+		 */
+		Cube(Z3Solver* owner, z3::expr_vector const& terms, z3::expr_vector const& literals);
+
+		/// Enumerates the cube's models until there are no more or the limit has been reached.
+		void run();
+	};
+
+	/**
+	 * @brief A solver configuration, raced against the others in the portfolio on its own copy of the solver.
+	 */
+	struct Racer {
+		Z3Solver* owner;						///< The solver whose formulas are being raced.
+		char const* name;						///< The name of the configuration.
+		z3::context context;					///< The context of the configuration's solver, which belongs to one thread.
+		z3::solver solver;						///< A solver for the formulas so far, set up according to the configuration.
+		z3::expr_vector terms;					///< The displayed terms, within the racer's context.
+		z3::check_result result;				///< The result of the check.
+		std::string reason;						///< The reason the result is unknown, if it is.
+		std::string error;						///< The error which occurred, if any.
+		std::string line;						///< The model found, as it's displayed.
+		double seconds;							///< The time the check took.
+		bool checking;							///< Whether the configuration's solver is checking, or about to (guarded by the owner's lock).
+
+		/**
+		 * @brief Sets up a solver according to a configuration. Must be called by the thread which owns the solver.
+		 * @param owner The solver whose formulas are being raced.
+		 * @param configuration The index of the configuration.
+		 * @param terms The displayed terms.
+		 */
+		Racer(Z3Solver* owner, size_t configuration, z3::expr_vector const& terms);
+
+		/// Runs the check and claims the win if the answer is definitive.
+		void run();
+	};
+
+	typedef boost::unordered_set<std::string> ModelSet;
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	std::ostream& mOut;						///< The stream to display results on.
+	size_t mThreads;						///< The number of worker threads to enumerate models on, or 0 for one per hardware thread.
+	size_t mModels;							///< The maximum number of models to display, or 0 for every model.
+	int mPortfolio;							///< The configurations to race, a bit for each, or 0 to use the solver directly.
+
+	z3::context mContext;					///< The context every expression belongs to.
+	z3::solver mSolver;						///< The solver the formulas are asserted in.
+	z3::check_result mResult;				///< The result of the last check, or unknown.
+
+	elements::SymbolTable const* mSymbols;	///< The symbols of the program.
+	SortMap mSorts;							///< The Z3 sort for each of the program's sorts.
+	DeclMap mDecls;							///< The declaration of each object and constant.
+	DeclMap mWrappers;						///< The constructor wrapping the integers of each mixed sort.
+	DeclMap mAccessors;						///< The accessor taking the integer out of each mixed sort.
+	DeclMap mTesters;						///< The tester determining whether a value of each mixed sort is an integer.
+	ObjectMap mObjects;						///< The objects, indexed by the name of their Z3 constructor.
+	ExprMap mExprs;							///< The expression built for each node.
+	elements::Symbol::SymbolList mShown;	///< The constants to display models in terms of, in order.
+	std::vector<Scope> mScopes;				///< The open scopes, innermost last.
+	TermList mTerms;						///< The terms whose values are displayed, as of the last check.
+
+	boost::mutex mLock;						///< Guards the output and the models found while enumerating.
+	std::vector<Cube*> mCubes;				///< The cubes being enumerated.
+	ModelSet mFound;						///< The models displayed so far, as they were displayed.
+	bool mStopped;							///< Whether the limit has been reached, or a racer has won.
+	std::vector<Racer*> mRacers;			///< The configurations being raced.
+	Racer* mWinner;							///< The first configuration to reach a definitive answer, if any.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param out The stream to display the results on, which should outlive the solver.
+	 * @param threads The number of worker threads to enumerate models on, or 0 for one per hardware thread.
+	 * @param models The maximum number of models to display, or 0 to display every model.
+	 * @param portfolio The configurations to race when a single model is wanted, a bit for each, or 0 to use the solver directly.
+	 */
+	Z3Solver(std::ostream& out, size_t threads = 0, size_t models = 1, int portfolio = 0);
+
+	/**
+	 * @brief Basic Destructor.
+	 * Does nothing.
+	 */
+	virtual inline ~Z3Solver() { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	virtual bool declare(elements::SymbolTable const& symbols);
+	virtual bool add(elements::Node const* formula);
+
+	virtual bool finish();
+	virtual bool push(std::string const& name, elements::Symbol::SymbolList const& symbols);
+
+	/**
+	 * @brief Runs the solver and displays the result, along with up to the configured number of models.
+	 * @return True if the solver ran, whatever its answer, false if an error occurred.
+	 */
+	virtual bool check();
+
+	virtual bool pop();
+	virtual bool release();
+
+	/// Gets the result of the last check.
+	inline z3::check_result result() const			{ return mResult; }
+
+	/// Gets the underlying solver.
+	inline z3::solver& solver()						{ return mSolver; }
+
+	/**
+	 * @brief Gets the name of one of the configurations which can be raced.
+	 * @param configuration The index of the configuration.
+	 * @return The name, or NULL if there's no such configuration.
+	 */
+	static char const* configuration(size_t configuration);
+
+	/**
+	 * @brief Parses a comma separated list of configuration names.
+	 * @param names The names, or "all" for every configuration.
+	 * @return The configurations, a bit for each, or -1 if a name isn't recognized.
+	 */
+	static int portfolio(std::string const& names);
+
+	/**
+	 * @brief Sets whether Z3 handles SIGINT while checking, by interrupting the check, for every solver created from then on.
+	 * Z3 installs a handler of its own for the duration of each check, in place of the program's. It's on by default.
+	 * @param enabled Whether to let Z3 handle SIGINT.
+	 */
+	static void interrupts(bool enabled);
+
+	/**
+	 * @brief Displays a model in terms of the program's constants.
+	 * Each true atom and each function's value is listed for every shown constant and combination of (finite) arguments.
+	 * @param model The model to display.
+	 * @param out The stream to display it on.
+	 */
+	void display(z3::model const& model, std::ostream& out);
+
+private:
+
+	/// Declares some symbols, replacing any earlier declarations of them. Throws z3::exception on errors.
+	void declare(elements::Symbol::SymbolList const& symbols);
+
+	/// Gets the terms whose values are displayed, filling mTerms with how each is displayed.
+	void shown(z3::expr_vector& terms);
+
+	/// Appends the display of a term's value to a model's line.
+	void print(std::string& line, size_t term, z3::expr const& value) const;
+
+	/// Enumerates the models of the formulas so far in parallel, displaying them as they're found.
+	bool enumerate();
+
+	/// Displays a model, unless it's a duplicate. Returns false once the limit has been reached.
+	bool report(std::string const& line);
+
+	/// Marks a cube or racer as checking, unless the limit has been reached or a racer has won. Returns false if it shouldn't check.
+	bool begin(bool& checking);
+
+	/// Marks a cube or racer as no longer checking.
+	void end(bool& checking);
+
+	/// Interrupts every cube and racer which is still checking, once the limit has been reached or a racer has won.
+	void interrupt();
+
+	/// Waits for the cubes or racers posted to a pool, interrupting those which keep checking after they've been stopped.
+	void wait(utils::ThreadPool& pool);
+
+	/// Races the configurations in the portfolio on the formulas so far, displaying the winner's answer.
+	bool race();
+
+	/// Claims the win for a racer unless another has already won, interrupting the rest.
+	void win(Racer* racer);
+
+	/// Adds the formulas so far to a solver in another context.
+	void copy(z3::solver& to);
+
+	/// Gets the Z3 sort corresponding to a sort.
+	z3::sort sort(elements::Symbol const* sort);
+
+	/**
+	 * @brief Declares the datatype for a sort of both objects and integers (see SortEncoding).
+	 * @param sort The sort.
+	 * @param names The names of the sort's objects.
+	 * @param constructors Set to the constructor of each object, in the same order.
+	 * @return The datatype.
+	 */
+	z3::sort datatype(elements::Symbol const* sort, std::vector<char const*> const& names, z3::func_decl_vector& constructors);
+
+	/// Gets the expression for an element of a sort.
+	z3::expr element(elements::Symbol const* sort, elements::Symbol::Element const& e);
+
+	/// Gets (or builds) the expression for a node.
+	z3::expr expr(elements::Node const* node);
+
+	/// Gets the expression for an argument of a node, converted to the sort the node expects (see SortEncoding).
+	z3::expr argument(elements::Node const* node, size_t arg);
+
+	/// Determines whether every argument sort of a constant has a finite domain.
+	bool finite(elements::Symbol const* constant) const;
+
+};
+
+#endif
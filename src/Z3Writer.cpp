@@ -0,0 +1,437 @@
+#include <cstring>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <vector>
+
+#include "SortEncoding.h"
+#include "Z3Writer.h"
+
+using namespace elements;
+
+/// The amount of output to accumulate before writing it to the stream.
+#define BUFFER_SIZE (1 << 20)
+
+/// The prefix of the names bound to shared nodes.
+#define DEF_PREFIX "def!"
+
+namespace {
+
+// Words which can't be used as the names of symbols.
+char const* const RESERVED[] = {
+	"and", "or", "not", "xor", "=>", "=", "distinct", "ite", "let", "forall", "exists", "match", "par", "as",
+	"true", "false", "div", "mod", "abs", "select", "store", "Int", "Bool", "Real", "Array", NULL
+};
+
+// Determines whether a character can appear in a simple SMT-LIB symbol.
+inline bool simple(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || (c && strchr("~!@$%^&*_-+=<>.?/", c));
+}
+
+// Appends an integer literal.
+void appendInteger(std::string& out, long value) {
+	std::ostringstream s;
+	if (value < 0) s << "(- " << (0 - (unsigned long)value) << ")";
+	else s << value;
+	out += s.str();
+}
+
+}
+
+// Constructor
+Z3Writer::Z3Writer(std::ostream& out)
+	: mOut(out), mWritten(0), mSymbols(NULL), mCounted(false), mNext(0) {
+	mBuffer.reserve(BUFFER_SIZE + (BUFFER_SIZE >> 2));
+}
+
+// Destructor
+Z3Writer::~Z3Writer() {
+	flush(true);
+}
+
+// Gets the name of a symbol.
+std::string Z3Writer::quote(std::string const& name) {
+	for (char const* const* r = RESERVED; *r; r++) {
+		if (name == *r) return name + "!";
+	}
+
+	bool ok = !name.empty() && !(name[0] >= '0' && name[0] <= '9');
+	for (size_t i = 0; ok && i < name.size(); i++) ok = simple(name[i]);
+	return (ok) ? name : "|" + name + "|";
+}
+
+// Declares the program's symbols.
+bool Z3Writer::declare(SymbolTable const& symbols) {
+	mSymbols = &symbols;
+	name();
+
+	mBuffer += "(set-option :produce-models true)\n";
+
+	Symbol::SymbolList all;
+	for (size_t i = 0; i < symbols.size(); i++) all.push_back(symbols[i]);
+	declare(all);
+	return flush();
+}
+
+// Names the symbols which haven't been named yet.
+void Z3Writer::name() {
+	// Names are shared by every arity in SMT-LIB, so constants which share a name get their arity appended.
+	boost::unordered_map<std::string, size_t> uses;
+	for (size_t i = 0; i < mSymbols->size(); i++) {
+		if ((*mSymbols)[i]->type() != Symbol::SORT) uses[(*mSymbols)[i]->name()]++;
+	}
+	for (size_t i = 0; i < mSymbols->size(); i++) {
+		Symbol const* s = (*mSymbols)[i];
+		if (mNames.count(s)) continue;
+
+		if (s->type() != Symbol::SORT && uses[s->name()] > 1) {
+			std::ostringstream name;
+			name << s->name() << "/" << s->arity();
+			mNames[s] = quote(name.str());
+		} else {
+			mNames[s] = quote(s->name());
+		}
+	}
+}
+
+// Declares some symbols.
+void Z3Writer::declare(Symbol::SymbolList const& symbols) {
+	// Sorts of objects become enumerations, with another constructor for the integers of mixed sorts.
+	for (Symbol::SymbolList::const_iterator it = symbols.begin(); it != symbols.end(); it++) {
+		Symbol const* s = *it;
+		if (s->type() != Symbol::SORT) continue;
+		SortEncoding::Kind kind = SortEncoding::kind(*mSymbols, s);
+		if (kind != SortEncoding::ENUMERATION && kind != SortEncoding::MIXED) continue;
+
+		mBuffer += "(declare-datatypes ((" + mNames[s] + " 0)) ((";
+		for (Symbol::DomainList::const_iterator d = s->domain().begin(); d != s->domain().end(); d++) {
+			if (d->object) mBuffer += "(" + mNames[d->object] + ")";
+		}
+		if (kind == SortEncoding::MIXED) mBuffer += "(" + quote(SortEncoding::wrapper(s)) + " (" + quote(SortEncoding::accessor(s)) + " Int))";
+		mBuffer += ")))\n";
+	}
+
+	for (Symbol::SymbolList::const_iterator it = symbols.begin(); it != symbols.end(); it++) {
+		Symbol const* s = *it;
+		if (!s->constant()) continue;
+
+		mBuffer += "(declare-fun " + mNames[s] + " (";
+		for (size_t a = 0; a < s->args().size(); a++) mBuffer += ((a) ? " " : "") + sort(s->args()[a]);
+		mBuffer += ") " + sort(s->sort()) + ")\n";
+
+		// Functions to sorts of integers could otherwise take any integer.
+		if (s->type() != Symbol::FUNCTION || s->sort() == mSymbols->integer()) continue;
+		SortEncoding::Kind kind = SortEncoding::kind(*mSymbols, s->sort());
+		if (kind == SortEncoding::INTEGER || kind == SortEncoding::MIXED) restrict(s);
+	}
+}
+
+// Restricts the value of a function to its sort.
+void Z3Writer::restrict(Symbol const* constant) {
+	Symbol::SortList const& args = constant->args();
+	Symbol::DomainList const& values = constant->sort()->domain();
+
+	// Finite arguments are enumerated, while integer arguments are quantified.
+	bool finite = true;
+	for (size_t a = 0; a < args.size(); a++) finite = finite && args[a] != mSymbols->integer() && args[a] != mSymbols->boolean();
+
+	std::vector<size_t> pos(args.size(), 0);
+	for (;;) {
+		std::string term = (args.empty()) ? mNames[constant] : "(" + mNames[constant];
+		for (size_t a = 0; a < args.size(); a++) {
+			term += " ";
+			if (!finite) {
+				std::ostringstream v;
+				v << "x!" << a;
+				term += v.str();
+			} else {
+				element(term, args[a], args[a]->domain()[pos[a]]);
+			}
+		}
+		if (!args.empty()) term += ")";
+
+		mBuffer += "(assert ";
+		if (!finite) {
+			mBuffer += "(forall (";
+			for (size_t a = 0; a < args.size(); a++) {
+				std::ostringstream v;
+				v << "(x!" << a << " " << sort(args[a]) << ")";
+				mBuffer += v.str();
+			}
+			mBuffer += ") ";
+		}
+		if (values.empty()) {
+			mBuffer += "false";
+		} else {
+			mBuffer += "(or";
+			for (Symbol::DomainList::const_iterator it = values.begin(); it != values.end(); it++) {
+				mBuffer += " (= " + term + " ";
+				element(mBuffer, constant->sort(), *it);
+				mBuffer += ")";
+			}
+			mBuffer += ")";
+		}
+		mBuffer += (finite) ? ")\n" : "))\n";
+
+		// Move on to the next tuple of arguments.
+		if (!finite) break;
+		size_t a = 0;
+		while (a < args.size() && ++pos[a] == args[a]->domain().size()) pos[a++] = 0;
+		if (a == args.size()) break;
+	}
+}
+
+// Adds a formula.
+bool Z3Writer::add(Node const* formula) {
+	if (!mCounted) {
+		mRefs.clear();
+		mVisited.clear();
+		count(formula);
+	}
+
+	define(formula);
+	mBuffer += "(assert ";
+	print(formula);
+	mBuffer += ")\n";
+	return flush();
+}
+
+// Finishes the program.
+bool Z3Writer::finish() {
+	return check();
+}
+
+// Opens a scope.
+bool Z3Writer::push(std::string const& name, Symbol::SymbolList const& symbols) {
+	Z3Writer::name();
+	mBuffer += "; " + name + "\n(push 1)\n";
+	declare(symbols);
+	forget();
+	return flush();
+}
+
+// Checks the formulas so far.
+bool Z3Writer::check() {
+	mBuffer += "(check-sat)\n(get-model)\n";
+	return flush(true);
+}
+
+// Closes a scope.
+bool Z3Writer::pop() {
+	mBuffer += "(pop 1)\n";
+	forget();
+	return flush();
+}
+
+// Lets go of the nodes written so far.
+bool Z3Writer::release() {
+	// Definitions keep being numbered from where they were, so later ones never clash with those already written.
+	forget();
+	return flush();
+}
+
+// Forgets the nodes written so far.
+void Z3Writer::forget() {
+	mRefs.clear();
+	mCounted = false;
+	mDefs.clear();
+	mVisited.clear();
+	mOpen.clear();
+}
+
+// Counts the references across a whole theory.
+bool Z3Writer::prepare(Theory const& theory) {
+	for (Theory::FormulaList::const_iterator it = theory.formulas().begin(); it != theory.formulas().end(); it++) {
+		count(*it);
+	}
+	mCounted = true;
+	return true;
+}
+
+// Counts the bytes written.
+size_t Z3Writer::written() const {
+	return mWritten + mBuffer.size();
+}
+
+// Writes out the buffer.
+bool Z3Writer::flush(bool force) {
+	if (force || mBuffer.size() >= BUFFER_SIZE) {
+		mOut.write(mBuffer.data(), mBuffer.size());
+		mWritten += mBuffer.size();
+		mBuffer.clear();
+		if (force) mOut.flush();
+	}
+	return mOut.good();
+}
+
+// Gets the SMT-LIB sort for a sort.
+std::string Z3Writer::sort(Symbol const* s) const {
+	switch (SortEncoding::kind(*mSymbols, s)) {
+	case SortEncoding::BOOLEAN:	return "Bool";
+	case SortEncoding::INTEGER:	return "Int";
+	default:					return mNames.find(s)->second;
+	}
+}
+
+// Gets the SMT-LIB sort of a node.
+std::string Z3Writer::sort(Node const* node) const {
+	return sort(SortEncoding::sort(*mSymbols, node));
+}
+
+// Appends an element of a sort.
+void Z3Writer::element(std::string& out, Symbol const* sort, Symbol::Element const& e) {
+	if (e.object) {
+		out += mNames[e.object];
+	} else if (SortEncoding::kind(*mSymbols, sort) == SortEncoding::MIXED) {
+		out += "(" + quote(SortEncoding::wrapper(sort)) + " ";
+		appendInteger(out, e.value);
+		out += ")";
+	} else {
+		appendInteger(out, e.value);
+	}
+}
+
+// Counts references.
+void Z3Writer::count(Node const* node) {
+	if (mRefs[node]++) return;
+
+	bool open = node->type() == Node::VARIABLE || node->quantifier();
+	for (size_t i = 0; i < node->arity(); i++) {
+		count(node->arg(i));
+		open = open || mOpen.count(node->arg(i));
+	}
+	if (open) mOpen.insert(node);
+}
+
+// Defines shared nodes.
+void Z3Writer::define(Node const* node) {
+	if (!mVisited.insert(node).second || mDefs.count(node)) return;
+
+	// The terms of an atom which never holds are never written.
+	SortEncoding::GuardList guards;
+	if (node->formula() && !SortEncoding::guards(*mSymbols, node, guards)) return;
+	for (size_t i = 0; i < node->arity(); i++) define(node->arg(i));
+
+	// Applications and leaves are as short as their names would be.
+	if (mRefs[node] < 2 || !node->arity() || node->type() == Node::APPLY || mOpen.count(node)) return;
+
+	std::ostringstream name;
+	name << DEF_PREFIX << mNext++;
+
+	mBuffer += "(define-fun " + name.str() + " () " + sort(node) + " ";
+	print(node);
+	mBuffer += ")\n";
+	mDefs[node] = name.str();
+	flush();
+}
+
+// Prints a node.
+void Z3Writer::print(Node const* node) {
+	NameMap::const_iterator def = mDefs.find(node);
+	if (def != mDefs.end()) {
+		mBuffer += def->second;
+		return;
+	}
+
+	// Atoms which take terms of mixed sorts as integers only hold if they are.
+	SortEncoding::GuardList guards;
+	if (node->formula() && !SortEncoding::guards(*mSymbols, node, guards)) {
+		mBuffer += "false";
+		return;
+	}
+	if (guards.empty()) {
+		expression(node);
+		return;
+	}
+
+	mBuffer += "(and";
+	for (SortEncoding::GuardList::const_iterator it = guards.begin(); it != guards.end(); it++) {
+		mBuffer += " ((_ is " + quote(SortEncoding::wrapper(it->second)) + ") ";
+		print(it->first);
+		mBuffer += ")";
+	}
+	mBuffer += " ";
+	expression(node);
+	mBuffer += ")";
+}
+
+// Prints a node without its guards.
+void Z3Writer::expression(Node const* node) {
+	char const* op = NULL;
+	switch (node->type()) {
+	case Node::VARIABLE:
+		mBuffer += mNames[node->symbol()];
+		return;
+
+	case Node::APPLY:
+		if (!node->arity()) {
+			mBuffer += mNames[node->symbol()];
+			return;
+		}
+		mBuffer += "(" + mNames[node->symbol()];
+		for (size_t i = 0; i < node->arity(); i++) {
+			mBuffer += " ";
+			argument(node, i);
+		}
+		mBuffer += ")";
+		return;
+
+	case Node::INTEGER:		appendInteger(mBuffer, node->value()); return;
+	case Node::TRUE:		mBuffer += "true"; return;
+	case Node::FALSE:		mBuffer += "false"; return;
+
+	case Node::EXISTS:
+	case Node::FORALL:
+		mBuffer += (node->type() == Node::EXISTS) ? "(exists ((" : "(forall ((";
+		mBuffer += mNames[node->symbol()] + " " + sort(node->symbol()->sort()) + ")) ";
+		print(node->arg(0));
+		mBuffer += ")";
+		return;
+
+	case Node::PLUS:		op = "+"; break;
+	case Node::MINUS:		op = "-"; break;
+	case Node::TIMES:		op = "*"; break;
+	case Node::DIVIDE:		op = "div"; break;
+	case Node::NEGATE:		op = "-"; break;
+	case Node::EQ:			op = "="; break;
+	case Node::LT:			op = "<"; break;
+	case Node::LE:			op = "<="; break;
+	case Node::GT:			op = ">"; break;
+	case Node::GE:			op = ">="; break;
+	case Node::NOT:			op = "not"; break;
+	case Node::AND:			op = "and"; break;
+	case Node::OR:			op = "or"; break;
+	case Node::IMPLIES:		op = "=>"; break;
+	case Node::IFF:			op = "="; break;
+	}
+
+	mBuffer += "(";
+	mBuffer += op;
+	for (size_t i = 0; i < node->arity(); i++) {
+		mBuffer += " ";
+		argument(node, i);
+	}
+	mBuffer += ")";
+}
+
+// Prints an argument of a node.
+void Z3Writer::argument(Node const* node, size_t arg) {
+	Symbol const* mixed = NULL;
+	switch (SortEncoding::coercion(*mSymbols, node, arg, mixed)) {
+	case SortEncoding::NONE:
+	case SortEncoding::NEVER:
+		// Atoms with arguments which can never be converted are written as false instead.
+		print(node->arg(arg));
+		return;
+
+	case SortEncoding::WRAP:
+		mBuffer += "(" + quote(SortEncoding::wrapper(mixed)) + " ";
+		break;
+
+	case SortEncoding::UNWRAP:
+		mBuffer += "(" + quote(SortEncoding::accessor(mixed)) + " ";
+		break;
+	}
+	print(node->arg(arg));
+	mBuffer += ")";
+}
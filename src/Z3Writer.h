@@ -0,0 +1,135 @@
+#ifndef __H_Z3_WRITER__
+#define __H_Z3_WRITER__
+
+#include <string>
+#include <iostream>
+
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "SMTWriter.h"
+
+/**
+ * @brief Writes the translated program as SMT-LIB 2 text, as accepted by Z3.
+ * Sorts whose domains are integers become Int, while other sorts become enumeration datatypes
+ * of their objects, with one more constructor wrapping the integers of sorts which have both (see
+ * SortEncoding). Output is accumulated in a large buffer which is flushed to the stream as it
+ * fills, so formulas are written out as they're added.
+ *
+ * Since formulas are DAGs, non-trivial subformulas and subterms which are referenced more than once are
+ * bound with define-fun the first time they're needed and referred to by name afterwards, which keeps
+ * the output linear in the size of the DAG. When the whole theory is written at once the references
+ * are counted across every formula. Otherwise they're counted within each formula as it's added.
+ *
+ * Scopes become push and pop commands. Definitions made within a scope are discarded along with it,
+ * and those made before it are forgotten as it's opened, since their nodes may be freed by then.
+ */
+class Z3Writer : public SMTWriter {
+
+private:
+	/***********************************************************************/
+	/* Private Types */
+	/***********************************************************************/
+
+	typedef boost::unordered_map<elements::Node const*, size_t> CountMap;
+	typedef boost::unordered_map<elements::Node const*, std::string> NameMap;
+	typedef boost::unordered_set<elements::Node const*> NodeSet;
+	typedef boost::unordered_map<elements::Symbol const*, std::string> SymbolNameMap;
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	std::ostream& mOut;						///< The stream we're writing to.
+	std::string mBuffer;					///< The output which hasn't been flushed to the stream yet.
+	size_t mWritten;						///< The number of bytes flushed to the stream so far.
+
+	elements::SymbolTable const* mSymbols;	///< The symbols of the program.
+	SymbolNameMap mNames;					///< The name each symbol is written as.
+
+	CountMap mRefs;							///< The number of references to each node.
+	bool mCounted;							///< Whether mRefs already covers every formula.
+	NameMap mDefs;							///< The name each defined node is bound to.
+	NodeSet mVisited;						///< The nodes which have already been checked for definitions.
+	NodeSet mOpen;							///< The nodes which contain variables and so can't be defined.
+	size_t mNext;							///< The number of the next definition.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param out The stream to write to, which should outlive the writer.
+	 */
+	Z3Writer(std::ostream& out);
+
+	/**
+	 * @brief Basic Destructor.
+	 * Flushes any buffered output.
+	 */
+	virtual ~Z3Writer();
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	virtual bool declare(elements::SymbolTable const& symbols);
+	virtual bool add(elements::Node const* formula);
+	virtual bool finish();
+	virtual bool push(std::string const& name, elements::Symbol::SymbolList const& symbols);
+	virtual bool check();
+	virtual bool pop();
+	virtual bool prepare(elements::Theory const& theory);
+	virtual bool release();
+	virtual size_t written() const;
+
+	/**
+	 * @brief Gets the name of a symbol in SMT-LIB syntax, quoting or renaming it if necessary.
+	 */
+	static std::string quote(std::string const& name);
+
+private:
+
+	/// Names each symbol which hasn't been named yet.
+	void name();
+
+	/// Appends the declarations of some symbols, which must have been named already.
+	void declare(elements::Symbol::SymbolList const& symbols);
+
+	/// Forgets the references to and definitions of the nodes written so far.
+	void forget();
+
+	/// Writes out the buffer if it's grown large enough, or always if forced.
+	bool flush(bool force = false);
+
+	/// Gets the name of the SMT-LIB sort corresponding to a sort.
+	std::string sort(elements::Symbol const* sort) const;
+
+	/// Gets the name of the SMT-LIB sort of a term or formula.
+	std::string sort(elements::Node const* node) const;
+
+	/// Appends an element of a sort to a string.
+	void element(std::string& out, elements::Symbol const* sort, elements::Symbol::Element const& e);
+
+	/// Counts the references to a node and its descendants, and determines which contain variables.
+	void count(elements::Node const* node);
+
+	/// Writes definitions for the shared descendants of a node (and the node itself) which haven't been defined yet.
+	void define(elements::Node const* node);
+
+	/// Appends a node to the buffer, referring to defined descendants by name.
+	void print(elements::Node const* node);
+
+	/// Appends a node to the buffer without the guards its terms of mixed sorts need (see SortEncoding::guards()).
+	void expression(elements::Node const* node);
+
+	/// Appends an argument of a node to the buffer, converted to the sort the node expects (see SortEncoding).
+	void argument(elements::Node const* node, size_t arg);
+
+	/// Appends an assertion restricting the value of a function to the domain of its sort.
+	void restrict(elements::Symbol const* constant);
+
+};
+
+#endif
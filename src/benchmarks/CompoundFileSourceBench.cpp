@@ -0,0 +1,155 @@
+#include <string>
+#include <list>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstdio>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "utilities/CompoundFileSource.h"
+
+/**
+ * @file CompoundFileSourceBench.cpp
+ * @brief Microbenchmark comparing the throughput of the CompoundFileSource read modes.
+ * The results are written as CSV, one read mode to a line, always in the same order.
+ * Usage: CompoundFileSourceBench [files [megabytes-per-file [directory]]]
+ */
+
+using utils::CompoundFileSource;
+using utils::CompoundFileStream;
+
+/// A sink for checksums so that the reading loops can't be optimized away.
+volatile size_t gSink;
+
+/**
+ * @brief Writes a file of pseudo ASPMT text of (roughly) the provided size.
+ * @param path The file to write.
+ * @param bytes The number of bytes to write.
+ * @param seed A seed used to vary the contents between files.
+ */
+void generate(std::string const& path, size_t bytes, unsigned int seed) {
+	std::ofstream out(path.c_str(), std::ios::binary);
+	char line[128];
+	size_t written = 0;
+	srand(seed);
+
+	while (written < bytes) {
+		int len = sprintf(line, "loc(b%d, %d) = l%d <- loc(b%d, %d) = l%d, not moved(b%d, %d). %% fact\n",
+			rand() % 100, rand() % 50, rand() % 10, rand() % 100, rand() % 50, rand() % 10, rand() % 100, rand() % 50);
+		out.write(line, len);
+		written += len;
+	}
+}
+
+/**
+ * @brief Places each of the files on the source in the provided mode.
+ */
+void place(CompoundFileSource& source, std::vector<std::string> const& files, CompoundFileSource::mode_t mode) {
+	for (std::vector<std::string>::const_iterator it = files.begin(); it != files.end(); it++) {
+		if (!source.append(*it, NULL, mode)) {
+			std::cerr << "Couldn't open " << *it << ".\n";
+			exit(1);
+		}
+	}
+}
+
+/// Reads everything one character at a time through the stream wrapper.
+size_t readStream(std::vector<std::string> const& files, CompoundFileSource::mode_t mode) {
+	CompoundFileStream stream;
+	stream.open(CompoundFileSource(mode));
+	place(*stream, files, CompoundFileSource::DEFAULT);
+
+	size_t count = 0, sum = 0;
+	int c;
+	while ((c = stream.get()) != EOF) {
+		sum += c;
+		count++;
+	}
+	stream.close();
+	gSink = sum;
+	return count;
+}
+
+/// Reads everything in blocks directly from the device.
+size_t readDevice(std::vector<std::string> const& files, CompoundFileSource::mode_t mode) {
+	CompoundFileSource source;
+	place(source, files, mode);
+
+	std::vector<char> buf(65536);
+	size_t count = 0;
+	std::streamsize n;
+	while ((n = source.read(&buf[0], (std::streamsize)buf.size())) > 0) count += (size_t)n;
+	source.close();
+	return count;
+}
+
+/// Walks everything in place using span().
+size_t readSpan(std::vector<std::string> const& files, CompoundFileSource::mode_t mode) {
+	CompoundFileSource source;
+	place(source, files, mode);
+
+	size_t count = 0, sum = 0;
+	std::streamsize n;
+	char const* p;
+	while ((p = source.span(n))) {
+		for (std::streamsize i = 0; i < n; i++) sum += p[i];
+		count += (size_t)n;
+		source.consume(n);
+	}
+	source.close();
+	gSink = sum;
+	return count;
+}
+
+/**
+ * @brief Times a single configuration and prints its throughput.
+ * @return True if everything was read, false otherwise.
+ */
+bool run(char const* name, size_t (*fn)(std::vector<std::string> const&, CompoundFileSource::mode_t),
+		std::vector<std::string> const& files, CompoundFileSource::mode_t mode, size_t expected) {
+	boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+	size_t count = fn(files, mode);
+	double secs = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / 1e6;
+
+	std::cout << name << "," << files.size() << "," << count << "," << std::fixed << std::setprecision(3) << secs * 1e3
+		<< "," << (count / (1024.0 * 1024.0)) / secs << "\n";
+	if (count == expected) return true;
+	std::cerr << "Error: Only read " << count << " of " << expected << " bytes with " << name << ".\n";
+	return false;
+}
+
+/**
+ * @brief Generates the input files and runs each configuration over them.
+ */
+int main(int argc, char** argv) {
+	size_t nfiles = (argc > 1) ? (size_t)atoi(argv[1]) : 8;
+	size_t mb = (argc > 2) ? (size_t)atoi(argv[2]) : 16;
+	boost::filesystem::path dir = (argc > 3) ? boost::filesystem::path(argv[3]) : boost::filesystem::temp_directory_path();
+
+	std::vector<std::string> files;
+	size_t expected = 0;
+	for (size_t i = 0; i < nfiles; i++) {
+		std::string path = (dir / boost::filesystem::unique_path("cfs-bench-%%%%%%%%.in")).string();
+		generate(path, mb * 1024 * 1024, (unsigned int)i);
+		expected += (size_t)boost::filesystem::file_size(path);
+		files.push_back(path);
+	}
+
+	std::cout << "mode,files,bytes,wall_ms,mb_per_s\n";
+	bool ok = run("stream-get-streamed", readStream, files, CompoundFileSource::STREAMED, expected);
+	ok = run("stream-get-buffered", readStream, files, CompoundFileSource::BUFFERED, expected) && ok;
+	ok = run("device-read-streamed", readDevice, files, CompoundFileSource::STREAMED, expected) && ok;
+	ok = run("device-read-buffered", readDevice, files, CompoundFileSource::BUFFERED, expected) && ok;
+	ok = run("device-read-mapped", readDevice, files, CompoundFileSource::MAPPED, expected) && ok;
+	ok = run("device-span-buffered", readSpan, files, CompoundFileSource::BUFFERED, expected) && ok;
+	ok = run("device-span-mapped", readSpan, files, CompoundFileSource::MAPPED, expected) && ok;
+
+	for (std::vector<std::string>::const_iterator it = files.begin(); it != files.end(); it++) {
+		boost::filesystem::remove(*it);
+	}
+	return (ok) ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+#include <string>
+#include <list>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "benchmarks/ProgramGenerator.h"
+
+// Constructor
+ProgramGenerator::ProgramGenerator(Parameters const& params)
+	: mParams(params), mRandom(params.seed) {
+	if (!mParams.files) mParams.files = 1;
+	if (!mParams.functions) mParams.functions = 1;
+	if (!mParams.domain) mParams.domain = 1;
+}
+
+// Writes the program.
+bool ProgramGenerator::write(boost::filesystem::path const& dir, std::vector<std::string>& files, std::list<std::string>& searchPath) {
+	std::vector<boost::filesystem::path> levels(1, dir);
+	for (size_t i = 1; i <= mParams.depth; i++) {
+		char name[32];
+		sprintf(name, "d%u", (unsigned int)i);
+		levels.push_back(levels.back() / name);
+		boost::system::error_code err;
+		boost::filesystem::create_directory(levels.back(), err);
+		if (err) return false;
+	}
+	for (size_t i = 0; i < levels.size(); i++) searchPath.push_back(levels[i].string());
+
+	size_t next = 0;
+	for (size_t i = 0; i < mParams.files; i++) {
+		char name[32];
+		sprintf(name, "part%03u.lp", (unsigned int)i);
+		std::string path = (levels[i * levels.size() / mParams.files] / name).string();
+
+		std::ofstream out(path.c_str(), std::ios::binary);
+		if (!out.good()) return false;
+		if (!i) declarations(out);
+		for (size_t end = (i + 1) * mParams.rules / mParams.files; next < end; next++) rule(out, next);
+		out.close();
+		if (out.fail()) return false;
+		files.push_back(path);
+	}
+	return true;
+}
+
+// Writes the declarations.
+void ProgramGenerator::declarations(std::ostream& out) const {
+	out << "% " << mParams.rules << " rules over " << mParams.functions << " functions of arity " << mParams.arity
+		<< ", in " << mParams.files << " files " << mParams.depth << " directories deep (seed " << mParams.seed << ").\n"
+		<< ":- sorts s.\n"
+		<< ":- objects 0.." << (mParams.domain - 1) << " :: s.\n"
+		<< ":- variables ";
+	for (size_t i = 1; i <= mParams.arity; i++) out << ((i > 1) ? ", " : "") << "X" << i;
+	out << ((mParams.arity) ? " :: s; " : "") << "V :: integer.\n"
+		<< ":- constants ";
+
+	for (size_t f = 0; f < mParams.functions; f++) {
+		out << ((f) ? "; " : "") << "f" << f;
+		for (size_t i = 0; i < mParams.arity; i++) out << ((i) ? ", s" : "(s");
+		out << ((mParams.arity) ? ")" : "") << ((predicate(f)) ? " :: boolean" : " :: integer");
+	}
+	out << ".\n";
+}
+
+// Writes a rule.
+void ProgramGenerator::rule(std::ostream& out, size_t index) {
+	// Each function is given the freedom of a choice rule before anything else is said about it.
+	if (index < mParams.functions) {
+		out << "{";
+		term(out, index, false);
+		out << ((predicate(index)) ? "}.\n" : " = V}.\n");
+		return;
+	}
+
+	size_t head = below(mParams.functions);
+	size_t kind = below(4);
+
+	// A constraint over any of the functions.
+	if (!kind) {
+		out << "<- ";
+		literal(out, mParams.functions);
+		out << ", ";
+		literal(out, mParams.functions);
+		out << ".\n";
+		return;
+	}
+
+	// A fact, as is every rule for the first function, since there's nothing before it to depend on.
+	if (kind == 1 || !head) {
+		term(out, head, true);
+		if (!predicate(head)) out << " = " << below(mParams.domain * 2);
+		out << ".\n";
+		return;
+	}
+
+	// A rule whose body depends on the functions before its head.
+	size_t from = below(head);
+	term(out, head, false);
+	if (!predicate(head) && !predicate(from)) {
+		out << " = ";
+		term(out, from, false);
+		out << " + " << (1 + below(mParams.domain));
+	} else if (!predicate(head)) {
+		out << " = " << below(mParams.domain * 2);
+	}
+
+	out << " <- ";
+	literal(out, head);
+	for (size_t n = below(3); n; n--) {
+		out << ", ";
+		literal(out, head);
+	}
+	out << ".\n";
+}
+
+// Writes a literal.
+void ProgramGenerator::literal(std::ostream& out, size_t before) {
+	static char const* const ops[] = { " = ", " != ", " < ", " > " };
+
+	size_t f = below(before);
+	if (predicate(f)) {
+		if (below(2)) out << "not ";
+		term(out, f, false);
+	} else {
+		term(out, f, false);
+		out << ops[below(4)] << below(mParams.domain * 2);
+	}
+}
+
+// Writes a term.
+void ProgramGenerator::term(std::ostream& out, size_t function, bool ground) {
+	out << "f" << function;
+	for (size_t i = 0; i < mParams.arity; i++) {
+		out << ((i) ? ", " : "(");
+		if (ground) out << below(mParams.domain);
+		else out << "X" << (i + 1);
+	}
+	if (mParams.arity) out << ")";
+}
@@ -0,0 +1,127 @@
+#ifndef __H_PROGRAM_GENERATOR__
+#define __H_PROGRAM_GENERATOR__
+
+#include <string>
+#include <list>
+#include <vector>
+#include <iostream>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/filesystem/path.hpp>
+
+/**
+ * @brief Generates synthetic ASPMT programs for benchmarking, shaped by a handful of parameters.
+ * A program declares a single sort of objects and a number of intensional functions over it, alternating
+ * between integer valued functions and predicates, and then gives each of them a choice rule followed by
+ * rules, constraints and facts chosen at random. The body of a rule only refers to functions declared
+ * before its head, so that every program is tight and its completion is exact.
+ *
+ * The rules are divided between a number of files, the first of which also holds the declarations. Since
+ * the language has no include statement, the files are instead spread across a chain of nested directories
+ * as deep as the include depth, with later files deeper in the chain, and they're found through a search
+ * path which lists the directories from the top down, as includes would be.
+ *
+ * The same parameters always generate the same program, on any platform.
+ */
+class ProgramGenerator {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief The shape of a program.
+	 */
+	struct Parameters {
+		size_t rules;						///< The number of rules, including the choice rule of each function.
+		size_t arity;						///< The number of arguments each function takes.
+		size_t functions;					///< The number of intensional functions.
+		size_t files;						///< The number of files the rules are divided between.
+		size_t depth;						///< The number of nested directories the files are spread across.
+		size_t domain;						///< The number of objects of the sort.
+		unsigned int seed;					///< The seed of the random choices.
+	};
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	Parameters mParams;						///< The shape of the program.
+	boost::mt19937 mRandom;					///< The source of the random choices.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param params The shape of the program. Zero files or functions are taken as one.
+	 */
+	ProgramGenerator(Parameters const& params);
+
+	/**
+	 * @brief Basic Destructor.
+	 * Does nothing.
+	 */
+	virtual inline ~ProgramGenerator() { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/// Gets the shape of the program.
+	inline Parameters const& parameters() const		{ return mParams; }
+
+	/**
+	 * @brief Writes the program to a directory.
+	 * @param dir The directory to write to, which must exist.
+	 * @param files The path of each file written, in the order they should be read.
+	 * @param searchPath Each directory the files were written to, from the top down.
+	 * @return True if successful, false if a file couldn't be written.
+	 */
+	bool write(boost::filesystem::path const& dir, std::vector<std::string>& files, std::list<std::string>& searchPath);
+
+private:
+
+	/**
+	 * @brief Writes the declarations of the program.
+	 */
+	void declarations(std::ostream& out) const;
+
+	/**
+	 * @brief Writes a rule chosen at random.
+	 * @param out The stream to write to.
+	 * @param index The index of the rule within the program.
+	 */
+	void rule(std::ostream& out, size_t index);
+
+	/**
+	 * @brief Writes a literal over a function chosen at random from those declared before another.
+	 * @param out The stream to write to.
+	 * @param before The function whose predecessors can be chosen from, which must not be the first.
+	 */
+	void literal(std::ostream& out, size_t before);
+
+	/**
+	 * @brief Writes a function applied to the variables, or to objects chosen at random.
+	 * @param out The stream to write to.
+	 * @param function The function.
+	 * @param ground Whether to apply it to objects rather than variables.
+	 */
+	void term(std::ostream& out, size_t function, bool ground);
+
+	/**
+	 * @brief Determines whether a function is a predicate rather than integer valued.
+	 */
+	static inline bool predicate(size_t function)	{ return function % 2; }
+
+	/**
+	 * @brief Chooses a number below a bound at random.
+	 */
+	inline size_t below(size_t n)					{ return (size_t)(mRandom() % n); }
+
+};
+
+#endif
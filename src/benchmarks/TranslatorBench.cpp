@@ -0,0 +1,329 @@
+#include <string>
+#include <list>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/iostreams/device/null.hpp>
+
+#include "Config.h"
+#include "Translator.h"
+#include "utilities/CompoundFileSource.h"
+#include "utilities/Stats.h"
+#include "benchmarks/ProgramGenerator.h"
+
+/**
+ * @file TranslatorBench.cpp
+ * @brief Benchmark timing each stage of the translation of synthetic programs (see ProgramGenerator).
+ * Each case is generated into a temporary directory, read through a CompoundFileSource on its own to measure
+ * its throughput (the "source" stage), and then translated to SMT-LIB as by --smt, several times over. The
+ * median time, CPU time and growth of the peak RSS of each stage is written, along with what it produced,
+ * either as CSV (one stage to a line) or as JSON (one case to a line). Columns, keys and stages always come
+ * in the same order, so results from different commits can be compared line by line.
+ *
+ * Usage: TranslatorBench [options]
+ *   --rules=<n> --arity=<n> --functions=<n> --files=<n> --depth=<n> --domain=<n> --seed=<n>
+ *                        Run a single case of this shape instead of the built in suite.
+ *   --name=<name>        The name of the single case (default: custom).
+ *   --repeat=<n>         Translate each case <n> times (default: 3).
+ *   --format=<format>    Write csv or json (default: csv).
+ *   -j <n>               Use <n> worker threads (default: one per hardware thread).
+ *   --generate=<dir>     Just write the single case's program to <dir>, listing its files in order.
+ */
+
+using utils::CompoundFileSource;
+using utils::Stats;
+
+/// The shapes of program in the built in suite.
+struct Case {
+	char const* name;
+	ProgramGenerator::Parameters params;
+};
+
+static Case const gSuite[] = {
+	{ "small",		{ 1000,		1,	50,		1,	0,	4,	1 } },
+	{ "medium",		{ 10000,	2,	500,	4,	1,	4,	1 } },
+	{ "wide",		{ 2000,		3,	100,	1,	0,	4,	1 } },
+	{ "many-files",	{ 20000,	1,	1000,	64,	0,	4,	1 } },
+	{ "deep",		{ 20000,	1,	1000,	64,	16,	4,	1 } }
+};
+
+/// A sink for checksums so that the reading loop can't be optimized away.
+volatile size_t gSink;
+
+/**
+ * @brief Reads a program through a compound file source, placing each file through the search path.
+ * @return The number of bytes read, or Stats::UNKNOWN if a file couldn't be found.
+ */
+size_t source(std::vector<std::string> const& files, std::list<std::string> const& searchPath) {
+	CompoundFileSource source(CompoundFileSource::MAPPED);
+	for (std::vector<std::string>::const_iterator it = files.begin(); it != files.end(); it++) {
+		if (!source.append(boost::filesystem::path(*it).filename().string(), &searchPath)) return Stats::UNKNOWN;
+	}
+
+	size_t count = 0, sum = 0;
+	std::streamsize n;
+	char const* p;
+	while ((p = source.span(n))) {
+		for (std::streamsize i = 0; i < n; i++) sum += p[i];
+		count += (size_t)n;
+		source.consume(n);
+	}
+	source.close();
+	gSink = sum;
+	return count;
+}
+
+/**
+ * @brief Reads and translates a program once.
+ * @param files The files of the program.
+ * @param searchPath The directories the files are in.
+ * @param threads The number of worker threads.
+ * @param stages The stages which ran.
+ * @return True if successful, false otherwise.
+ */
+bool run(std::vector<std::string> const& files, std::list<std::string> const& searchPath, int threads, Stats::StageList& stages) {
+	Stats stats;
+	Stats::Timer reading(&stats, "source");
+	size_t bytes = source(files, searchPath);
+	if (bytes == Stats::UNKNOWN) {
+		std::cerr << "Error: Couldn't find the generated files through the search path.\n";
+		return false;
+	}
+	reading.bytes(bytes);
+	reading.stop();
+
+	Config config;
+	config.boolOpt(Config::OPT_WRITE_SMT, true);
+	config.intOpt(Config::OPT_THREADS, threads);
+	for (std::vector<std::string>::const_iterator it = files.begin(); it != files.end(); it++) config.addInput(*it);
+
+	// Warnings aren't interesting here, but errors are.
+	std::ostringstream errors;
+	boost::iostreams::stream<boost::iostreams::null_sink> out((boost::iostreams::null_sink()));
+	Translator translator(config, errors);
+	if (!translator.translate(out)) {
+		std::cerr << errors.str();
+		return false;
+	}
+
+	stages = stats.stages();
+	stages.insert(stages.end(), translator.stats().stages().begin(), translator.stats().stages().end());
+	return true;
+}
+
+/**
+ * @brief Gets the median of some measurements, which are reordered.
+ */
+template <typename T>
+T median(std::vector<T>& values) {
+	std::sort(values.begin(), values.end());
+	return values[values.size() / 2];
+}
+
+/**
+ * @brief Combines the runs of a case into the median of each stage.
+ * Stages which didn't run every time are left out, so the same stages are written for every run of the case.
+ */
+void combine(std::vector<Stats::StageList> const& runs, Stats::StageList& out) {
+	Stats::StageList const& first = runs.front();
+	for (Stats::StageList::const_iterator it = first.begin(); it != first.end(); it++) {
+		std::vector<double> wall, cpu;
+		std::vector<long> rss;
+		for (std::vector<Stats::StageList>::const_iterator run = runs.begin(); run != runs.end(); run++) {
+			for (Stats::StageList::const_iterator s = run->begin(); s != run->end(); s++) {
+				if (s->name != it->name) continue;
+				wall.push_back(s->wall);
+				cpu.push_back(s->cpu);
+				rss.push_back(s->rss);
+			}
+		}
+		if (wall.size() != runs.size()) continue;
+
+		Stats::Stage s = *it;
+		s.wall = median(wall);
+		s.cpu = median(cpu);
+		s.rss = median(rss);
+		out.push_back(s);
+	}
+}
+
+/// Writes a count as a CSV column.
+void column(std::ostream& out, size_t n) {
+	out << ",";
+	if (n != Stats::UNKNOWN) out << n;
+}
+
+/// Writes a count as a JSON value.
+void value(std::ostream& out, char const* name, size_t n) {
+	out << ", \"" << name << "\": ";
+	if (n == Stats::UNKNOWN) out << "null";
+	else out << n;
+}
+
+/**
+ * @brief Writes the results of a case.
+ */
+void write(std::ostream& out, bool json, std::string const& name, ProgramGenerator::Parameters const& p, size_t repeat,
+		Stats::StageList const& stages) {
+	if (json) {
+		out << "{\"case\": \"" << name << "\", \"rules\": " << p.rules << ", \"arity\": " << p.arity << ", \"functions\": " << p.functions
+			<< ", \"files\": " << p.files << ", \"depth\": " << p.depth << ", \"domain\": " << p.domain << ", \"seed\": " << p.seed
+			<< ", \"repeat\": " << repeat << ", \"stages\": [";
+		for (Stats::StageList::const_iterator it = stages.begin(); it != stages.end(); it++) {
+			out << ((it == stages.begin()) ? "" : ", ") << "{\"name\": \"" << it->name << "\", \"runs\": " << it->runs
+				<< ", \"wall_ms\": " << it->wall * 1e3 << ", \"cpu_ms\": " << it->cpu * 1e3 << ", \"rss_kb\": " << it->rss;
+			value(out, "rules", it->rules);
+			value(out, "formulas", it->formulas);
+			value(out, "nodes", it->nodes);
+			value(out, "bytes", it->bytes);
+			value(out, "hits", it->hits);
+			value(out, "misses", it->misses);
+			out << "}";
+		}
+		out << "]}\n";
+		return;
+	}
+
+	for (Stats::StageList::const_iterator it = stages.begin(); it != stages.end(); it++) {
+		out << name << "," << p.rules << "," << p.arity << "," << p.functions << "," << p.files << "," << p.depth << "," << p.domain
+			<< "," << p.seed << "," << repeat << "," << it->name << "," << it->runs << "," << it->wall * 1e3 << "," << it->cpu * 1e3
+			<< "," << it->rss;
+		column(out, it->rules);
+		column(out, it->formulas);
+		column(out, it->nodes);
+		column(out, it->bytes);
+		column(out, it->hits);
+		column(out, it->misses);
+		out << "\n";
+	}
+}
+
+/**
+ * @brief Generates a program into a new temporary directory.
+ * @return The directory, or an empty path if it couldn't be written.
+ */
+boost::filesystem::path generate(ProgramGenerator::Parameters const& params, std::vector<std::string>& files, std::list<std::string>& searchPath) {
+	boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("aspmt-bench-%%%%%%%%");
+	boost::system::error_code err;
+	boost::filesystem::create_directory(dir, err);
+
+	ProgramGenerator generator(params);
+	if (!err && generator.write(dir, files, searchPath)) return dir;
+	boost::filesystem::remove_all(dir, err);
+	return boost::filesystem::path();
+}
+
+/**
+ * @brief Reads a numeric option of the form --<name>=<n>.
+ * @return True if the argument is the option, in which case errors are reported and exit the benchmark.
+ */
+bool number(char const* arg, char const* name, size_t& out) {
+	size_t len = strlen(name);
+	if (strncmp(arg, "--", 2) || strncmp(arg + 2, name, len) || arg[len + 2] != '=') return false;
+
+	char* end;
+	long n = strtol(arg + len + 3, &end, 10);
+	if (!arg[len + 3] || *end || n < 0) {
+		std::cerr << "Error: Expected a non-negative number in '" << arg << "'.\n";
+		exit(1);
+	}
+	out = (size_t)n;
+	return true;
+}
+
+/**
+ * @brief Runs the suite, or a single case, and writes the results to the standard output.
+ */
+int main(int argc, char** argv) {
+	ProgramGenerator::Parameters params = { 1000, 1, 50, 1, 0, 4, 1 };
+	std::string name = "custom";
+	std::string generated;
+	size_t repeat = 3, seed = params.seed;
+	size_t threads = 0;
+	bool single = false, json = false;
+
+	for (int i = 1; i < argc; i++) {
+		char const* arg = argv[i];
+		if (number(arg, "rules", params.rules) || number(arg, "arity", params.arity) || number(arg, "functions", params.functions)
+				|| number(arg, "files", params.files) || number(arg, "depth", params.depth) || number(arg, "domain", params.domain)
+				|| number(arg, "seed", seed)) {
+			single = true;
+		} else if (number(arg, "repeat", repeat)) {
+			if (!repeat) repeat = 1;
+		} else if (!strcmp(arg, "-j") && i + 1 < argc) {
+			threads = (size_t)atoi(argv[++i]);
+		} else if (!strncmp(arg, "--name=", 7)) {
+			name = arg + 7;
+			single = true;
+		} else if (!strcmp(arg, "--format=csv") || !strcmp(arg, "--format=json")) {
+			json = !strcmp(arg + 9, "json");
+		} else if (!strncmp(arg, "--generate=", 11) && arg[11]) {
+			generated = arg + 11;
+		} else {
+			std::cerr << "Error: Unrecognized option '" << arg << "'. See the top of TranslatorBench.cpp for usage.\n";
+			return 1;
+		}
+	}
+	params.seed = (unsigned int)seed;
+
+	if (!generated.empty()) {
+		std::vector<std::string> files;
+		std::list<std::string> searchPath;
+		boost::system::error_code err;
+		boost::filesystem::create_directories(generated, err);
+		ProgramGenerator generator(params);
+		if (err || !generator.write(generated, files, searchPath)) {
+			std::cerr << "Error: Couldn't write the program to '" << generated << "'.\n";
+			return 1;
+		}
+		for (std::vector<std::string>::const_iterator it = files.begin(); it != files.end(); it++) std::cout << *it << "\n";
+		return 0;
+	}
+
+	std::vector<Case> cases;
+	if (single) {
+		Case c = { name.c_str(), params };
+		cases.push_back(c);
+	} else {
+		cases.assign(gSuite, gSuite + sizeof(gSuite) / sizeof(gSuite[0]));
+	}
+
+	std::cout << std::fixed << std::setprecision(3);
+	if (!json) {
+		std::cout << "case,rules,arity,functions,files,depth,domain,seed,repeat,stage,runs,wall_ms,cpu_ms,rss_kb,"
+			<< "out_rules,out_formulas,out_nodes,out_bytes,out_hits,out_misses\n";
+	}
+
+	for (std::vector<Case>::const_iterator it = cases.begin(); it != cases.end(); it++) {
+		std::vector<std::string> files;
+		std::list<std::string> searchPath;
+		boost::filesystem::path dir = generate(it->params, files, searchPath);
+		if (dir.empty()) {
+			std::cerr << "Error: Couldn't write the program for case '" << it->name << "'.\n";
+			return 1;
+		}
+
+		std::vector<Stats::StageList> runs(repeat);
+		bool ok = true;
+		for (size_t i = 0; ok && i < repeat; i++) ok = run(files, searchPath, (int)threads, runs[i]);
+		boost::system::error_code err;
+		boost::filesystem::remove_all(dir, err);
+		if (!ok) {
+			std::cerr << "Error: Couldn't translate case '" << it->name << "'.\n";
+			return 1;
+		}
+
+		Stats::StageList stages;
+		combine(runs, stages);
+		write(std::cout, json, it->name, it->params, repeat, stages);
+		std::cout.flush();
+	}
+	return 0;
+}
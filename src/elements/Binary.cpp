@@ -0,0 +1,499 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <iostream>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "elements/Binary.h"
+
+/// The bytes identifying the format.
+#define BINARY_MAGIC "ASPMTBIN"
+
+/// The version of the format, which is incremented whenever it changes.
+#define BINARY_VERSION 2
+
+/// The index used in place of a missing symbol or object.
+#define BINARY_NONE 0xFFFFFFFFu
+
+/// The alignment of each section within a file.
+#define BINARY_ALIGN 8
+
+namespace elements {
+
+namespace {
+
+// The sections of a file, in the order they're written.
+enum SectionId {
+	SYMBOLS,
+	ELEMENTS,
+	SORTS,
+	NODES,
+	ARGS,
+	RULES,
+	FORMULAS,
+	NAMES,
+	_SECTIONS
+};
+
+// Where a section is within a file.
+struct Section {
+	boost::uint64_t offset;			// The offset of the section from the start of the file.
+	boost::uint64_t count;			// The number of records in the section.
+};
+
+// The start of every file.
+struct Header {
+	char magic[8];
+	boost::uint32_t version;
+	boost::uint32_t kind;
+	Section sections[_SECTIONS];
+};
+
+// A symbol.
+struct SymbolRecord {
+	boost::uint32_t name;			// The offset of the name within NAMES.
+	boost::uint32_t length;			// The length of the name.
+	boost::uint32_t arity;
+	boost::uint32_t sort;			// The symbol's sort, or BINARY_NONE.
+	boost::uint32_t args;			// The index of the first of the symbol's argument sorts within SORTS.
+	boost::uint32_t nargs;
+	boost::uint32_t domain;			// The index of the first element of the symbol's domain within ELEMENTS.
+	boost::uint32_t ndomain;
+	boost::uint8_t type;
+	boost::uint8_t declared;
+	boost::uint8_t pad[6];
+};
+
+// An element of a sort's domain.
+struct ElementRecord {
+	boost::int64_t value;
+	boost::uint32_t object;			// The object, or BINARY_NONE for integers.
+	boost::uint32_t pad;
+};
+
+// A node.
+struct NodeRecord {
+	boost::int64_t value;
+	boost::uint32_t symbol;			// The node's symbol, or BINARY_NONE.
+	boost::uint32_t args;			// The index of the first of the node's children within ARGS.
+	boost::uint32_t arity;
+	boost::uint8_t type;
+	boost::uint8_t pad[3];
+};
+
+// A rule.
+struct RuleRecord {
+	boost::uint32_t head;
+	boost::uint32_t body;
+	boost::uint32_t choice;
+};
+
+// The contents of a file as it's being put together.
+struct Image {
+	std::vector<SymbolRecord> symbols;
+	std::vector<ElementRecord> elements;
+	std::vector<boost::uint32_t> sorts;
+	std::vector<NodeRecord> nodes;
+	std::vector<boost::uint32_t> args;
+	std::vector<RuleRecord> rules;
+	std::vector<boost::uint32_t> formulas;
+	std::string names;
+};
+
+typedef boost::unordered_map<Node const*, boost::uint32_t> IndexMap;
+
+// Gets the index of a symbol.
+inline boost::uint32_t index(Symbol const* s) {
+	return (s) ? (boost::uint32_t)s->id() : BINARY_NONE;
+}
+
+// Appends a node after its descendants, numbering each node as it's appended.
+void putNode(Image& image, Node const* node, IndexMap& indices) {
+	if (indices.count(node)) return;
+	for (size_t i = 0; i < node->arity(); i++) putNode(image, node->arg(i), indices);
+
+	NodeRecord r;
+	memset(&r, 0, sizeof(r));
+	r.value = (boost::int64_t)node->value();
+	r.symbol = index(node->symbol());
+	r.args = (boost::uint32_t)image.args.size();
+	r.arity = (boost::uint32_t)node->arity();
+	r.type = (boost::uint8_t)node->type();
+	for (size_t i = 0; i < node->arity(); i++) image.args.push_back(indices[node->arg(i)]);
+
+	indices[node] = (boost::uint32_t)image.nodes.size();
+	image.nodes.push_back(r);
+}
+
+// Appends a section, padded to the alignment, and records where it is.
+template <typename T>
+void putSection(std::string& buf, Section& section, T const* data, size_t count) {
+	buf.append((BINARY_ALIGN - buf.size() % BINARY_ALIGN) % BINARY_ALIGN, '\0');
+	section.offset = buf.size();
+	section.count = count;
+	if (count) buf.append((char const*)data, count * sizeof(T));
+}
+
+// Gets the records of a section, or NULL if they aren't entirely within the data.
+template <typename T>
+T const* getSection(char const* data, size_t size, Section const& section) {
+	if (section.offset % BINARY_ALIGN || section.offset > size || section.count > (size - section.offset) / sizeof(T)) return NULL;
+	return (T const*)(data + section.offset);
+}
+
+// Writes the sections of a file, each padded to the alignment, after a header saying where they are.
+bool putImage(std::ostream& out, Binary::Kind kind, Image const& image) {
+	// The header is filled in once every section has been placed.
+	Header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, BINARY_MAGIC, sizeof(h.magic));
+	h.version = BINARY_VERSION;
+	h.kind = (boost::uint32_t)kind;
+
+	std::string buf(sizeof(Header), '\0');
+	putSection(buf, h.sections[SYMBOLS], image.symbols.empty() ? NULL : &image.symbols[0], image.symbols.size());
+	putSection(buf, h.sections[ELEMENTS], image.elements.empty() ? NULL : &image.elements[0], image.elements.size());
+	putSection(buf, h.sections[SORTS], image.sorts.empty() ? NULL : &image.sorts[0], image.sorts.size());
+	putSection(buf, h.sections[NODES], image.nodes.empty() ? NULL : &image.nodes[0], image.nodes.size());
+	putSection(buf, h.sections[ARGS], image.args.empty() ? NULL : &image.args[0], image.args.size());
+	putSection(buf, h.sections[RULES], image.rules.empty() ? NULL : &image.rules[0], image.rules.size());
+	putSection(buf, h.sections[FORMULAS], image.formulas.empty() ? NULL : &image.formulas[0], image.formulas.size());
+	putSection(buf, h.sections[NAMES], image.names.data(), image.names.size());
+	memcpy(&buf[0], &h, sizeof(h));
+
+	out.write(buf.data(), buf.size());
+	return out.good();
+}
+
+// Gets the number of children a kind of node must have, or -1 if it can have any number of them.
+int arity(Node::Type type) {
+	switch (type) {
+	case Node::VARIABLE:
+	case Node::INTEGER:
+	case Node::TRUE:
+	case Node::FALSE:
+		return 0;
+
+	case Node::NEGATE:
+	case Node::NOT:
+	case Node::EXISTS:
+	case Node::FORALL:
+		return 1;
+
+	case Node::PLUS:
+	case Node::MINUS:
+	case Node::TIMES:
+	case Node::DIVIDE:
+	case Node::EQ:
+	case Node::LT:
+	case Node::LE:
+	case Node::GT:
+	case Node::GE:
+	case Node::IMPLIES:
+	case Node::IFF:
+		return 2;
+
+	default:
+		return -1;
+	}
+}
+
+// Gets what a symbol has been declared as. Sorts are always sorts, even before they're declared.
+inline Symbol::Type declaredType(SymbolRecord const& r) {
+	return (r.declared || r.type == Symbol::SORT) ? (Symbol::Type)r.type : Symbol::UNDECLARED;
+}
+
+// Determines whether a kind of node can refer to a kind of symbol. Nodes which don't refer to a symbol accept any.
+bool refersTo(Node::Type type, Symbol::Type symbol) {
+	switch (type) {
+	case Node::APPLY:
+		return symbol == Symbol::OBJECT || symbol == Symbol::PREDICATE || symbol == Symbol::FUNCTION;
+
+	case Node::VARIABLE:
+	case Node::EXISTS:
+	case Node::FORALL:
+		return symbol == Symbol::VARIABLE;
+
+	default:
+		return true;
+	}
+}
+
+}
+
+// Writes a theory.
+bool Binary::write(std::ostream& out, Kind kind, SymbolTable const& symbols, Theory const& theory) {
+	Image image;
+
+	image.symbols.resize(symbols.size());
+	for (size_t i = 0; i < symbols.size(); i++) {
+		Symbol const* s = symbols[i];
+		SymbolRecord& r = image.symbols[i];
+		memset(&r, 0, sizeof(r));
+
+		r.name = (boost::uint32_t)image.names.size();
+		r.length = (boost::uint32_t)s->name().size();
+		image.names += s->name();
+		r.arity = (boost::uint32_t)s->arity();
+		r.sort = index(s->sort());
+		r.type = (boost::uint8_t)s->type();
+		r.declared = (boost::uint8_t)s->declared();
+
+		r.args = (boost::uint32_t)image.sorts.size();
+		r.nargs = (boost::uint32_t)s->args().size();
+		for (Symbol::SortList::const_iterator it = s->args().begin(); it != s->args().end(); it++) image.sorts.push_back(index(*it));
+
+		r.domain = (boost::uint32_t)image.elements.size();
+		r.ndomain = (boost::uint32_t)s->domain().size();
+		for (Symbol::DomainList::const_iterator it = s->domain().begin(); it != s->domain().end(); it++) {
+			ElementRecord e;
+			memset(&e, 0, sizeof(e));
+			e.value = (boost::int64_t)it->value;
+			e.object = index(it->object);
+			image.elements.push_back(e);
+		}
+	}
+
+	IndexMap indices;
+	for (Theory::RuleList::const_iterator it = theory.rules().begin(); it != theory.rules().end(); it++) {
+		putNode(image, it->head, indices);
+		putNode(image, it->body, indices);
+
+		RuleRecord r;
+		r.head = indices[it->head];
+		r.body = indices[it->body];
+		r.choice = (boost::uint32_t)it->choice;
+		image.rules.push_back(r);
+	}
+	for (Theory::FormulaList::const_iterator it = theory.formulas().begin(); it != theory.formulas().end(); it++) {
+		putNode(image, *it, indices);
+		image.formulas.push_back(indices[*it]);
+	}
+
+	return putImage(out, kind, image);
+}
+
+// Reads a theory.
+bool Binary::read(char const* data, size_t size, Program& program, Kind* kind) {
+	if ((size_t)data % BINARY_ALIGN || size < sizeof(Header)) return false;
+
+	Header const* h = (Header const*)data;
+	if (memcmp(h->magic, BINARY_MAGIC, sizeof(h->magic)) || h->version != BINARY_VERSION) return false;
+	if (h->kind != PARSED && h->kind != GROUND) return false;
+	if (!program.rules().empty() || !program.formulas().empty()) return false;
+
+	SymbolRecord const* symbols = getSection<SymbolRecord>(data, size, h->sections[SYMBOLS]);
+	ElementRecord const* elements = getSection<ElementRecord>(data, size, h->sections[ELEMENTS]);
+	boost::uint32_t const* sorts = getSection<boost::uint32_t>(data, size, h->sections[SORTS]);
+	NodeRecord const* nodes = getSection<NodeRecord>(data, size, h->sections[NODES]);
+	boost::uint32_t const* args = getSection<boost::uint32_t>(data, size, h->sections[ARGS]);
+	RuleRecord const* rules = getSection<RuleRecord>(data, size, h->sections[RULES]);
+	boost::uint32_t const* formulas = getSection<boost::uint32_t>(data, size, h->sections[FORMULAS]);
+	char const* names = getSection<char>(data, size, h->sections[NAMES]);
+	if (!symbols || !elements || !sorts || !nodes || !args || !rules || !formulas || !names) return false;
+
+	size_t nsymbols = (size_t)h->sections[SYMBOLS].count;
+	size_t nelements = (size_t)h->sections[ELEMENTS].count;
+	size_t nsorts = (size_t)h->sections[SORTS].count;
+	size_t nnodes = (size_t)h->sections[NODES].count;
+	size_t nargs = (size_t)h->sections[ARGS].count;
+	size_t nrules = (size_t)h->sections[RULES].count;
+	size_t nformulas = (size_t)h->sections[FORMULAS].count;
+	size_t nnames = (size_t)h->sections[NAMES].count;
+
+	// Everything is checked before the program is touched. The program's own symbols must be the first of ours.
+	SymbolTable& table = program.symbols();
+	if (table.size() > nsymbols) return false;
+
+	boost::unordered_set<std::pair<std::string, size_t> > seen;
+	for (size_t i = 0; i < nsymbols; i++) {
+		SymbolRecord const& r = symbols[i];
+		if (r.type > Symbol::VARIABLE || r.name > nnames || r.length > nnames - r.name) return false;
+		if ((r.sort != BINARY_NONE && r.sort >= nsymbols) || r.args > nsorts || r.nargs > nsorts - r.args) return false;
+		if (r.domain > nelements || r.ndomain > nelements - r.domain) return false;
+
+		// Symbols must refer to sorts as sorts and to objects as objects.
+		if (r.sort != BINARY_NONE && symbols[r.sort].type != Symbol::SORT) return false;
+		for (size_t a = 0; a < r.nargs; a++) {
+			if (sorts[r.args + a] >= nsymbols || symbols[sorts[r.args + a]].type != Symbol::SORT) return false;
+		}
+		for (size_t d = 0; d < r.ndomain; d++) {
+			boost::uint32_t o = elements[r.domain + d].object;
+			if (o != BINARY_NONE && (o >= nsymbols || declaredType(symbols[o]) != Symbol::OBJECT)) return false;
+		}
+
+		// Sorts and other symbols live in different namespaces.
+		bool sort = (r.type == Symbol::SORT);
+		if (sort && r.arity) return false;
+		std::string name(names + r.name, r.length);
+		if (!seen.insert(std::make_pair(name, (sort) ? (size_t)-1 : (size_t)r.arity)).second) return false;
+
+		if (i < table.size()) {
+			Symbol const* s = table[i];
+			if (s->name() != name || (s->type() == Symbol::SORT) != sort || s->arity() != r.arity) return false;
+			if (s->declared() && (!r.declared || s->type() != r.type || index(s->sort()) != r.sort || s->args().size() != r.nargs)) return false;
+			for (size_t a = 0; s->declared() && a < r.nargs; a++) {
+				if (index(s->args()[a]) != sorts[r.args + a]) return false;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < nnodes; i++) {
+		NodeRecord const& r = nodes[i];
+		if (r.type > Node::FORALL || (r.symbol != BINARY_NONE && r.symbol >= nsymbols)) return false;
+		if (r.args > nargs || r.arity > nargs - r.args) return false;
+		for (size_t a = 0; a < r.arity; a++) {
+			if (args[r.args + a] >= i) return false;
+		}
+
+		Node::Type type = (Node::Type)r.type;
+		int expected = (type == Node::APPLY && r.symbol != BINARY_NONE) ? (int)symbols[r.symbol].arity : arity(type);
+		if (expected >= 0 && r.arity != (boost::uint32_t)expected) return false;
+		if ((type == Node::VARIABLE || type == Node::APPLY || type == Node::EXISTS || type == Node::FORALL) && r.symbol == BINARY_NONE) return false;
+		if (r.symbol != BINARY_NONE && !refersTo(type, declaredType(symbols[r.symbol]))) return false;
+	}
+	for (size_t i = 0; i < nrules; i++) {
+		if (rules[i].head >= nnodes || rules[i].body >= nnodes) return false;
+	}
+	for (size_t i = 0; i < nformulas; i++) {
+		if (formulas[i] >= nnodes) return false;
+	}
+
+	// The symbols are interned first, so that they can refer to each other by id while they're declared.
+	std::vector<Symbol*> created(nsymbols);
+	for (size_t i = 0; i < nsymbols; i++) {
+		SymbolRecord const& r = symbols[i];
+		std::string name(names + r.name, r.length);
+		created[i] = (r.type == Symbol::SORT) ? table.sort(name) : table.symbol(name, r.arity);
+	}
+
+	for (size_t i = 0; i < nsymbols; i++) {
+		SymbolRecord const& r = symbols[i];
+		if (r.declared) {
+			Symbol::SortList sortArgs;
+			for (size_t a = 0; a < r.nargs; a++) sortArgs.push_back(created[sorts[r.args + a]]);
+			created[i]->declare((Symbol::Type)r.type, (r.sort != BINARY_NONE) ? created[r.sort] : NULL, sortArgs);
+		}
+		for (size_t d = 0; d < r.ndomain; d++) {
+			ElementRecord const& e = elements[r.domain + d];
+			created[i]->addElement((e.object != BINARY_NONE) ? created[e.object] : NULL, (long)e.value);
+		}
+	}
+
+	// The nodes are created as a single batch, with their children taken straight from the data.
+	std::vector<NodeFactory::Batched> batch(nnodes);
+	for (size_t i = 0; i < nnodes; i++) {
+		NodeRecord const& r = nodes[i];
+		batch[i].type = (Node::Type)r.type;
+		batch[i].symbol = (r.symbol != BINARY_NONE) ? created[r.symbol] : NULL;
+		batch[i].value = (long)r.value;
+		batch[i].args = args + r.args;
+		batch[i].arity = r.arity;
+	}
+	NodeFactory::NodeList made;
+	program.nodes().adopt(batch.empty() ? NULL : &batch[0], batch.size(), made);
+
+	program.rules().reserve(nrules);
+	for (size_t i = 0; i < nrules; i++) program.add(made[rules[i].head], made[rules[i].body], rules[i].choice != 0);
+	program.formulas().reserve(nformulas);
+	for (size_t i = 0; i < nformulas; i++) program.add(made[formulas[i]]);
+
+	if (kind) *kind = (Kind)h->kind;
+	return true;
+}
+
+// Writes the formulas of a theory.
+bool Binary::write(std::ostream& out, Theory const& theory) {
+	Image image;
+	IndexMap indices;
+	for (Theory::FormulaList::const_iterator it = theory.formulas().begin(); it != theory.formulas().end(); it++) {
+		putNode(image, *it, indices);
+		image.formulas.push_back(indices[*it]);
+	}
+	return putImage(out, PARTITION, image);
+}
+
+// Reads formulas.
+bool Binary::read(char const* data, size_t size, SymbolTable const& symbols, Theory& theory) {
+	if ((size_t)data % BINARY_ALIGN || size < sizeof(Header)) return false;
+
+	Header const* h = (Header const*)data;
+	if (memcmp(h->magic, BINARY_MAGIC, sizeof(h->magic)) || h->version != BINARY_VERSION || h->kind != PARTITION) return false;
+
+	NodeRecord const* nodes = getSection<NodeRecord>(data, size, h->sections[NODES]);
+	boost::uint32_t const* args = getSection<boost::uint32_t>(data, size, h->sections[ARGS]);
+	boost::uint32_t const* formulas = getSection<boost::uint32_t>(data, size, h->sections[FORMULAS]);
+	if (!nodes || !args || !formulas) return false;
+
+	size_t nnodes = (size_t)h->sections[NODES].count;
+	size_t nargs = (size_t)h->sections[ARGS].count;
+	size_t nformulas = (size_t)h->sections[FORMULAS].count;
+
+	for (size_t i = 0; i < nnodes; i++) {
+		NodeRecord const& r = nodes[i];
+		if (r.type > Node::FORALL || (r.symbol != BINARY_NONE && r.symbol >= symbols.size())) return false;
+		if (r.args > nargs || r.arity > nargs - r.args) return false;
+		for (size_t a = 0; a < r.arity; a++) {
+			if (args[r.args + a] >= i) return false;
+		}
+
+		Node::Type type = (Node::Type)r.type;
+		int expected = (type == Node::APPLY && r.symbol != BINARY_NONE) ? (int)symbols[r.symbol]->arity() : arity(type);
+		if (expected >= 0 && r.arity != (boost::uint32_t)expected) return false;
+		if ((type == Node::VARIABLE || type == Node::APPLY || type == Node::EXISTS || type == Node::FORALL) && r.symbol == BINARY_NONE) return false;
+		if (r.symbol != BINARY_NONE && !refersTo(type, symbols[r.symbol]->type())) return false;
+	}
+	for (size_t i = 0; i < nformulas; i++) {
+		if (formulas[i] >= nnodes) return false;
+	}
+
+	std::vector<NodeFactory::Batched> batch(nnodes);
+	for (size_t i = 0; i < nnodes; i++) {
+		NodeRecord const& r = nodes[i];
+		batch[i].type = (Node::Type)r.type;
+		batch[i].symbol = (r.symbol != BINARY_NONE) ? symbols[r.symbol] : NULL;
+		batch[i].value = (long)r.value;
+		batch[i].args = args + r.args;
+		batch[i].arity = r.arity;
+	}
+	NodeFactory::NodeList made;
+	theory.nodes().adopt(batch.empty() ? NULL : &batch[0], batch.size(), made);
+
+	theory.formulas().reserve(theory.formulas().size() + nformulas);
+	for (size_t i = 0; i < nformulas; i++) theory.add(made[formulas[i]]);
+	return true;
+}
+
+// Maps and reads a file.
+bool Binary::load(std::string const& file, Program& program, Kind* kind) {
+	boost::iostreams::mapped_file_source map;
+	try {
+		map.open(file);
+	} catch (std::exception& e) {
+		// Empty files can't be mapped, but they aren't binary files anyways.
+		return false;
+	}
+	if (!map.is_open()) return false;
+
+	// The file is read in place whenever the program's symbols are the first of the file's.
+	if (program.rules().empty() && program.formulas().empty() && read(map.data(), map.size(), program, kind)) return true;
+
+	Program other;
+	return read(map.data(), map.size(), other, kind) && program.merge(other);
+}
+
+// Checks the start of a file.
+bool Binary::recognize(std::string const& file) {
+	char magic[sizeof(BINARY_MAGIC) - 1];
+	std::ifstream in(file.c_str(), std::ios::in | std::ios::binary);
+	in.read(magic, sizeof(magic));
+	return in.good() && !memcmp(magic, BINARY_MAGIC, sizeof(magic));
+}
+
+}
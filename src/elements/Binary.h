@@ -0,0 +1,110 @@
+#ifndef __H_BINARY__
+#define __H_BINARY__
+
+#include <cstddef>
+#include <string>
+#include <iostream>
+
+#include "elements/Symbol.h"
+#include "elements/Program.h"
+
+namespace elements {
+
+/**
+ * @brief Reads and writes programs and translated theories in a compact, versioned binary form.
+ * A file is a fixed header followed by sections of fixed size records, each aligned to 8 bytes, so
+ * that a mapped file can be read in place. The header gives the offset and length of each section:
+ *	- The interned symbols, in id order, each referring to its name, sort, arguments and domain by index.
+ *	- The elements of every sort's domain, and the argument sorts of every symbol.
+ *	- The nodes of the theory as a single array in which each node's children precede it, so that
+ *	  nodes shared within the DAG are stored once. Children are referred to through a separate array
+ *	  of node indices, at an offset given by the node.
+ *	- The rules and formulas, referring to the nodes by index.
+ *	- The names of the symbols.
+ *
+ * Reading a file interns its symbols and then creates every node in a single batch (see
+ * NodeFactory::adopt()), without parsing or allocating nodes one at a time. Everything is written in
+ * the host's byte order.
+ */
+class Binary {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief What a file holds.
+	 */
+	enum Kind {
+		PARSED = 1,				///< A program as it was parsed, which still has to be translated.
+		GROUND = 2,				///< The ground theory produced by the last phase of the translation.
+		PARTITION = 3			///< Only the formulas of a theory, whose symbols are those of the table it's read with.
+	};
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Writes a theory along with the symbols it uses.
+	 * @param out The stream to write to, which should be opened in binary mode.
+	 * @param kind What the theory is.
+	 * @param symbols The symbols of the theory.
+	 * @param theory The theory.
+	 * @return True if successful, false otherwise.
+	 */
+	static bool write(std::ostream& out, Kind kind, SymbolTable const& symbols, Theory const& theory);
+
+	/**
+	 * @brief Reads a theory and its symbols in place into an empty program.
+	 * The data is checked in full before anything is added, so the program is left untouched on failure.
+	 * @param data The data that was written, which must be aligned to 8 bytes.
+	 * @param size The size of the data in bytes.
+	 * @param program The program to read into, which mustn't have any symbols beyond the built in sorts, nor any rules or formulas.
+	 * @param kind Set to what the theory is, if provided.
+	 * @return True if successful, false if the data is truncated, corrupt or from another version.
+	 */
+	static bool read(char const* data, size_t size, Program& program, Kind* kind = NULL);
+
+	/**
+	 * @brief Writes the formulas of a theory alone, referring to symbols by id rather than writing them.
+	 * Meant for data which is read back by the same process (see Spill), whose symbol table can only grow.
+	 * @param out The stream to write to, which should be opened in binary mode.
+	 * @param theory The theory, whose rules are ignored.
+	 * @return True if successful, false otherwise.
+	 */
+	static bool write(std::ostream& out, Theory const& theory);
+
+	/**
+	 * @brief Reads formulas written on their own in place into a theory.
+	 * The data is checked in full before anything is added, so the theory is left untouched on failure.
+	 * @param data The data that was written, which must be aligned to 8 bytes.
+	 * @param size The size of the data in bytes.
+	 * @param symbols The symbols the formulas refer to.
+	 * @param theory The theory to add the formulas to.
+	 * @return True if successful, false if the data is truncated, corrupt, from another version or refers to a symbol that doesn't exist.
+	 */
+	static bool read(char const* data, size_t size, SymbolTable const& symbols, Theory& theory);
+
+	/**
+	 * @brief Maps a file into memory and reads it into a program.
+	 * The file is read in place if the program is empty, and is otherwise read on its own and merged into the program.
+	 * @param file The file to read.
+	 * @param program The program to read into.
+	 * @param kind Set to what the theory is, if provided.
+	 * @return True if successful, false if the file can't be mapped or read, or declares a symbol differently than the program.
+	 */
+	static bool load(std::string const& file, Program& program, Kind* kind = NULL);
+
+	/**
+	 * @brief Determines whether a file starts like a binary file, without checking anything else about it.
+	 * @param file The file to check.
+	 * @return True if the file can be opened and starts with the bytes identifying the format, false otherwise.
+	 */
+	static bool recognize(std::string const& file);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,263 @@
+#include <iostream>
+#include <algorithm>
+
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "elements/Node.h"
+
+namespace elements {
+
+/*****************************************************************************************/
+/* Node */
+/*****************************************************************************************/
+
+// Prints a node.
+std::ostream& operator<<(std::ostream& out, Node const& node) {
+	char const* op = NULL;
+
+	switch (node.type()) {
+	case Node::VARIABLE:
+		return out << node.symbol()->name();
+
+	case Node::APPLY:
+		out << node.symbol()->name();
+		if (node.arity()) {
+			out << "(";
+			for (size_t i = 0; i < node.arity(); i++) out << ((i) ? ", " : "") << *node.arg(i);
+			out << ")";
+		}
+		return out;
+
+	case Node::INTEGER:		return out << node.value();
+	case Node::TRUE:		return out << "true";
+	case Node::FALSE:		return out << "false";
+	case Node::NEGATE:		return out << "-" << *node.arg(0);
+	case Node::NOT:			return out << "not " << *node.arg(0);
+
+	case Node::EXISTS:
+	case Node::FORALL:
+		return out << ((node.type() == Node::EXISTS) ? "exists " : "forall ") << node.symbol()->name() << " (" << *node.arg(0) << ")";
+
+	case Node::PLUS:		op = " + "; break;
+	case Node::MINUS:		op = " - "; break;
+	case Node::TIMES:		op = " * "; break;
+	case Node::DIVIDE:		op = " / "; break;
+	case Node::EQ:			op = " = "; break;
+	case Node::LT:			op = " < "; break;
+	case Node::LE:			op = " <= "; break;
+	case Node::GT:			op = " > "; break;
+	case Node::GE:			op = " >= "; break;
+	case Node::AND:			op = " & "; break;
+	case Node::OR:			op = " | "; break;
+	case Node::IMPLIES:		op = " -> "; break;
+	case Node::IFF:			op = " <-> "; break;
+	}
+
+	out << "(";
+	for (size_t i = 0; i < node.arity(); i++) out << ((i) ? op : "") << *node.arg(i);
+	return out << ")";
+}
+
+namespace {
+
+// Collects the free variables of a node, given the variables which are bound above it.
+void collect(Node const* node, Symbol::SymbolList& bound, boost::unordered_set<Symbol const*>& found, boost::unordered_set<Node const*>& visited) {
+	// Nodes outside of any quantifier only need to be visited once.
+	if (bound.empty() && !visited.insert(node).second) return;
+
+	if (node->type() == Node::VARIABLE) {
+		if (std::find(bound.begin(), bound.end(), node->symbol()) == bound.end()) found.insert(node->symbol());
+		return;
+	}
+
+	if (node->quantifier()) bound.push_back(node->symbol());
+	for (size_t i = 0; i < node->arity(); i++) collect(node->arg(i), bound, found, visited);
+	if (node->quantifier()) bound.pop_back();
+}
+
+// Orders symbols by id.
+bool lessId(Symbol const* a, Symbol const* b) {
+	return a->id() < b->id();
+}
+
+}
+
+// Collects the free variables of a node.
+void freeVariables(Node const* node, Symbol::SymbolList& out) {
+	Symbol::SymbolList bound;
+	boost::unordered_set<Symbol const*> found(out.begin(), out.end());
+	boost::unordered_set<Node const*> visited;
+
+	collect(node, bound, found, visited);
+
+	out.assign(found.begin(), found.end());
+	std::sort(out.begin(), out.end(), lessId);
+}
+
+/*****************************************************************************************/
+/* Node Factory */
+/*****************************************************************************************/
+
+// Compares two nodes whose children are shared.
+bool NodeFactory::NodeEqual::operator()(Node const* a, Node const* b) const {
+	if (a->type() != b->type() || a->symbol() != b->symbol() || a->value() != b->value() || a->arity() != b->arity()) return false;
+	for (size_t i = 0; i < a->arity(); i++) {
+		if (a->arg(i) != b->arg(i)) return false;
+	}
+	return true;
+}
+
+// Constructor
+NodeFactory::NodeFactory() {
+	init();
+}
+
+// Creates the shared constants.
+void NodeFactory::init() {
+	mLookups = 0;
+	mTrue = make(Node::TRUE, NULL, 0, NULL, 0);
+	mFalse = make(Node::FALSE, NULL, 0, NULL, 0);
+}
+
+// Gets (or creates) a node.
+Node const* NodeFactory::make(Node::Type type, Symbol const* symbol, long value, Node const* const* args, size_t n) {
+	mLookups++;
+
+	// Look for an existing node first...
+	Node probe;
+	probe.mType = type;
+	probe.mArity = (unsigned int)n;
+	probe.mSymbol = symbol;
+	probe.mValue = value;
+	probe.mArgs = args;
+	probe.mId = 0;
+
+	probe.mHash = hash(type, symbol, value, args, n);
+
+	NodeSet::const_iterator it = mNodes.find(&probe);
+	if (it != mNodes.end()) return *it;
+
+	// ... and create it if there isn't one.
+	Node* node = (Node*)mArena.alloc(sizeof(Node));
+	*node = probe;
+	node->mId = mNodes.size();
+	if (n) {
+		Node const** copy = (Node const**)mArena.alloc(n * sizeof(Node const*));
+		for (size_t i = 0; i < n; i++) copy[i] = args[i];
+		node->mArgs = copy;
+	} else {
+		node->mArgs = NULL;
+	}
+
+	mNodes.insert(node);
+	return node;
+}
+
+// Creates a batch of nodes.
+void NodeFactory::adopt(Batched const* batch, size_t n, NodeList& out) {
+	size_t total = 0;
+	for (size_t i = 0; i < n; i++) total += batch[i].arity;
+
+	Node* nodes = (n) ? (Node*)mArena.alloc(n * sizeof(Node)) : NULL;
+	Node const** args = (total) ? (Node const**)mArena.alloc(total * sizeof(Node const*)) : NULL;
+	mNodes.reserve(mNodes.size() + n);
+	out.resize(n);
+
+	for (size_t i = 0; i < n; i++) {
+		Batched const& b = batch[i];
+		for (size_t a = 0; a < b.arity; a++) args[a] = out[b.args[a]];
+
+		Node* node = nodes + i;
+		node->mType = b.type;
+		node->mArity = (unsigned int)b.arity;
+		node->mSymbol = b.symbol;
+		node->mValue = b.value;
+		node->mArgs = (b.arity) ? args : NULL;
+		node->mHash = hash(b.type, b.symbol, b.value, args, b.arity);
+		node->mId = mNodes.size();
+		args += b.arity;
+
+		// A node which is already shared (such as TRUE) is used instead, leaving its copy unused in the arena.
+		mLookups++;
+		out[i] = *mNodes.insert(node).first;
+	}
+}
+
+// Copies a node from another factory.
+Node const* NodeFactory::import(Node const* node, ImportMap& memo, SymbolMap const* symbols) {
+	ImportMap::const_iterator it = memo.find(node);
+	if (it != memo.end()) return it->second;
+
+	NodeList args(node->arity());
+	for (size_t i = 0; i < node->arity(); i++) args[i] = import(node->arg(i), memo, symbols);
+
+	Symbol const* symbol = node->symbol();
+	if (symbol && symbols) {
+		SymbolMap::const_iterator s = symbols->find(symbol);
+		if (s != symbols->end()) symbol = s->second;
+	}
+
+	Node const* copy = make(node->type(), symbol, node->value(), args.size() ? &args[0] : NULL, args.size());
+	memo[node] = copy;
+	return copy;
+}
+
+// Replaces variables.
+Node const* NodeFactory::substitute(Node const* node, SubstitutionMap const& map, ImportMap& memo) {
+	if (node->type() == Node::VARIABLE) {
+		SubstitutionMap::const_iterator s = map.find(node->symbol());
+		return (s != map.end()) ? s->second : node;
+	}
+	if (!node->arity()) return node;
+
+	ImportMap::const_iterator it = memo.find(node);
+	if (it != memo.end()) return it->second;
+
+	bool changed = false;
+	NodeList args(node->arity());
+	for (size_t i = 0; i < node->arity(); i++) {
+		args[i] = substitute(node->arg(i), map, memo);
+		changed = changed || (args[i] != node->arg(i));
+	}
+
+	Node const* copy = (changed) ? make(node->type(), node->symbol(), node->value(), &args[0], args.size()) : node;
+	memo[node] = copy;
+	return copy;
+}
+
+// Combines formulas.
+Node const* NodeFactory::junction(Node::Type type, NodeList const& args) {
+	Node const* unit = truth(type == Node::AND);
+	Node const* zero = truth(type != Node::AND);
+
+	NodeList flat;
+	for (NodeList::const_iterator it = args.begin(); it != args.end(); it++) {
+		if (*it == zero) return zero;
+		if (*it == unit) continue;
+		if ((*it)->type() == type) flat.insert(flat.end(), (*it)->args(), (*it)->args() + (*it)->arity());
+		else flat.push_back(*it);
+	}
+
+	if (flat.empty()) return unit;
+	if (flat.size() == 1) return flat.front();
+	return make(type, flat);
+}
+
+// Hashes a node.
+size_t NodeFactory::hash(Node::Type type, Symbol const* symbol, long value, Node const* const* args, size_t n) {
+	size_t hash = (size_t)type;
+	boost::hash_combine(hash, symbol ? symbol->id() : (size_t)-1);
+	boost::hash_combine(hash, value);
+	for (size_t i = 0; i < n; i++) boost::hash_combine(hash, args[i]->hash());
+	return hash;
+}
+
+// Frees everything.
+void NodeFactory::clear() {
+	mNodes.clear();
+	mArena.clear();
+	init();
+}
+
+}
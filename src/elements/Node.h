@@ -0,0 +1,331 @@
+#ifndef __H_NODE__
+#define __H_NODE__
+
+#include <vector>
+#include <iostream>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "utilities/Arena.h"
+#include "elements/Symbol.h"
+
+namespace elements {
+
+class NodeFactory;
+
+/**
+ * @brief A single term or formula within a hash-consed DAG.
+ * Nodes are immutable and are only created by a NodeFactory, which ensures that structurally equal
+ * nodes are shared. Two nodes from the same factory are equal if and only if they're at the same address.
+ */
+class Node {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief An enumeration of the kinds of nodes.
+	 */
+	enum Type {
+		// Terms
+		VARIABLE,				///< A variable. symbol() is the variable.
+		APPLY,					///< An object, function or predicate applied to its arguments. symbol() is the object or constant.
+		INTEGER,				///< An integer literal. value() is the integer.
+		PLUS,					///< The sum of two terms.
+		MINUS,					///< The difference of two terms.
+		TIMES,					///< The product of two terms.
+		DIVIDE,					///< The quotient of two terms.
+		NEGATE,					///< The negation of a term.
+
+		// Formulas
+		TRUE,					///< The formula which is always true.
+		FALSE,					///< The formula which is always false.
+		EQ,						///< Equality between two terms.
+		LT,						///< The first term is less than the second.
+		LE,						///< The first term is less than or equal to the second.
+		GT,						///< The first term is greater than the second.
+		GE,						///< The first term is greater than or equal to the second.
+		NOT,					///< The negation of a formula.
+		AND,					///< The conjunction of any number of formulas.
+		OR,						///< The disjunction of any number of formulas.
+		IMPLIES,				///< The first formula implies the second.
+		IFF,					///< The two formulas are equivalent.
+		EXISTS,					///< Existential quantification. symbol() is the bound variable and arg(0) the body.
+		FORALL					///< Universal quantification. symbol() is the bound variable and arg(0) the body.
+	};
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	Type mType;							///< The kind of node.
+	unsigned int mArity;				///< The number of children.
+	Symbol const* mSymbol;				///< The symbol associated with the node, or NULL.
+	long mValue;						///< The value of the node for integer literals.
+	size_t mHash;						///< The structural hash of the node.
+	size_t mId;							///< The order in which the node was created within its factory.
+	Node const* const* mArgs;			///< The children of the node.
+
+	friend class NodeFactory;
+
+public:
+	/***********************************************************************/
+	/* Accessors */
+	/***********************************************************************/
+
+	/// Gets the kind of node.
+	inline Type type() const							{ return mType; }
+
+	/// Gets the number of children.
+	inline size_t arity() const							{ return mArity; }
+
+	/// Gets the symbol associated with the node, or NULL.
+	inline Symbol const* symbol() const					{ return mSymbol; }
+
+	/// Gets the value of an integer literal.
+	inline long value() const							{ return mValue; }
+
+	/// Gets the structural hash of the node.
+	inline size_t hash() const							{ return mHash; }
+
+	/// Gets the order in which the node was created within its factory. Stable across runs.
+	inline size_t id() const							{ return mId; }
+
+	/// Gets a child of the node.
+	inline Node const* arg(size_t i) const				{ return mArgs[i]; }
+
+	/// Gets the children of the node.
+	inline Node const* const* args() const				{ return mArgs; }
+
+	/// Determines whether the node is a formula (including atoms) rather than a term.
+	inline bool formula() const {
+		return mType >= TRUE || (mType == APPLY && mSymbol->type() == Symbol::PREDICATE);
+	}
+
+	/// Determines whether the node is an atom.
+	inline bool atom() const							{ return mType == APPLY && mSymbol->type() == Symbol::PREDICATE; }
+
+	/// Determines whether the node is a quantifier.
+	inline bool quantifier() const						{ return mType == EXISTS || mType == FORALL; }
+
+};
+
+/**
+ * @brief Prints a node (and its children) in a human readable, infix form.
+ */
+std::ostream& operator<<(std::ostream& out, Node const& node);
+
+/**
+ * @brief Collects the free variables of a node.
+ * @param node The node to inspect.
+ * @param out The list to append the variables to. Each variable is added once, and the list is kept ordered by id.
+ */
+void freeVariables(Node const* node, Symbol::SymbolList& out);
+
+/**
+ * @brief Creates and hash-conses nodes, allocating them from an arena.
+ * Each phase of the translation builds its output in its own factory, so that the nodes
+ * of the previous phase can be freed all at once when it's no longer needed. Children
+ * passed to a factory must have been created by the same factory.
+ */
+class NodeFactory {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief A list of nodes.
+	 */
+	typedef std::vector<Node const*> NodeList;
+
+	/**
+	 * @brief A mapping from the nodes of another factory to the corresponding nodes of this one.
+	 */
+	typedef boost::unordered_map<Node const*, Node const*> ImportMap;
+
+	/**
+	 * @brief A mapping from the symbols of another table to the corresponding symbols of this one.
+	 */
+	typedef boost::unordered_map<Symbol const*, Symbol const*> SymbolMap;
+
+	/**
+	 * @brief A mapping from variables to the terms which should replace them.
+	 */
+	typedef boost::unordered_map<Symbol const*, Node const*> SubstitutionMap;
+
+	/**
+	 * @brief A node to be created as part of a batch, whose children are referred to by their position within the batch.
+	 */
+	struct Batched {
+		Node::Type type;					///< The kind of node.
+		Symbol const* symbol;				///< The symbol associated with the node, or NULL.
+		long value;							///< The value of the node, for integers.
+		boost::uint32_t const* args;		///< The positions of the node's children, each of which must be before the node's own.
+		size_t arity;						///< The number of children.
+	};
+
+private:
+	/***********************************************************************/
+	/* Private Types */
+	/***********************************************************************/
+
+	/// Hashes a node structurally.
+	struct NodeHash {
+		inline size_t operator()(Node const* n) const { return n->hash(); }
+	};
+
+	/// Compares two nodes structurally, assuming their children are already shared.
+	struct NodeEqual {
+		bool operator()(Node const* a, Node const* b) const;
+	};
+
+	typedef boost::unordered_set<Node const*, NodeHash, NodeEqual> NodeSet;
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	utils::Arena mArena;				///< The memory the nodes are allocated from.
+	NodeSet mNodes;						///< Every node we've created.
+	size_t mLookups;					///< The number of nodes that have been requested.
+
+	Node const* mTrue;					///< The shared TRUE node.
+	Node const* mFalse;					///< The shared FALSE node.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 */
+	NodeFactory();
+
+	/**
+	 * @brief Basic Destructor.
+	 * Frees all nodes.
+	 */
+	virtual inline ~NodeFactory() { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Gets the node with the provided structure, creating it if it doesn't already exist.
+	 * @param type The kind of node.
+	 * @param symbol The symbol associated with the node, or NULL.
+	 * @param value The value of the node, for integers.
+	 * @param args The children of the node, which must belong to this factory.
+	 * @param n The number of children.
+	 * @return The shared node.
+	 */
+	Node const* make(Node::Type type, Symbol const* symbol, long value, Node const* const* args, size_t n);
+
+	/// Gets a node without a symbol from its children.
+	inline Node const* make(Node::Type type, NodeList const& args)				{ return make(type, NULL, 0, args.size() ? &args[0] : NULL, args.size()); }
+
+	/// Gets a node without a symbol with a single child.
+	inline Node const* make(Node::Type type, Node const* a)						{ return make(type, NULL, 0, &a, 1); }
+
+	/// Gets a node without a symbol with two children.
+	inline Node const* make(Node::Type type, Node const* a, Node const* b)		{ Node const* args[2] = { a, b }; return make(type, NULL, 0, args, 2); }
+
+	/// Gets a symbol applied to its arguments.
+	inline Node const* apply(Symbol const* s, NodeList const& args)				{ return make(Node::APPLY, s, 0, args.size() ? &args[0] : NULL, args.size()); }
+
+	/// Gets a symbol without any arguments.
+	inline Node const* apply(Symbol const* s)									{ return make(Node::APPLY, s, 0, NULL, 0); }
+
+	/// Gets a variable.
+	inline Node const* variable(Symbol const* v)								{ return make(Node::VARIABLE, v, 0, NULL, 0); }
+
+	/// Gets an integer literal.
+	inline Node const* integer(long value)										{ return make(Node::INTEGER, NULL, value, NULL, 0); }
+
+	/// Gets a quantified formula.
+	inline Node const* quantify(Node::Type type, Symbol const* v, Node const* body)	{ return make(type, v, 0, &body, 1); }
+
+	/// Gets TRUE or FALSE.
+	inline Node const* truth(bool value) const									{ return value ? mTrue : mFalse; }
+
+	/**
+	 * @brief Creates a batch of nodes at once, such as those read from a file.
+	 * Storage for every node in the batch is taken from the arena in one piece, and each node is shared
+	 * without building a probe for it first. Nodes which are already in the factory are shared as usual.
+	 * @param batch The nodes to create, each of which must come after its children.
+	 * @param n The number of nodes in the batch.
+	 * @param out Set to the shared node for each node in the batch.
+	 */
+	void adopt(Batched const* batch, size_t n, NodeList& out);
+
+	/**
+	 * @brief Rebuilds a node created by another factory within this one.
+	 * @param node The node to copy.
+	 * @param memo The nodes which have already been copied. Ensures shared children are copied once.
+	 * @param symbols If provided, the symbols to use in place of those in the original nodes.
+	 * @return The corresponding node in this factory.
+	 */
+	Node const* import(Node const* node, ImportMap& memo, SymbolMap const* symbols = NULL);
+
+	/**
+	 * @brief Replaces the free occurrences of variables within a node.
+	 * None of the variables being replaced may be bound within the node.
+	 * @param node The node, which must belong to this factory.
+	 * @param map The terms to replace each variable with, which must belong to this factory.
+	 * @param memo The nodes which have already been rewritten with the same map.
+	 * @return The rewritten node.
+	 */
+	Node const* substitute(Node const* node, SubstitutionMap const& map, ImportMap& memo);
+
+	/**
+	 * @brief Gets the conjunction (or disjunction) of a list of formulas, flattening nested connectives of the same kind.
+	 * TRUE and FALSE are simplified away.
+	 * @param type Either AND or OR.
+	 * @param args The formulas to combine.
+	 * @return The combined formula. An empty conjunction is TRUE and an empty disjunction is FALSE.
+	 */
+	Node const* junction(Node::Type type, NodeList const& args);
+
+	/**
+	 * @brief Frees every node created by the factory at once.
+	 * Any outstanding pointers to the factory's nodes become invalid.
+	 */
+	void clear();
+
+	/// Gets the number of distinct nodes in the factory.
+	inline size_t size() const						{ return mNodes.size(); }
+
+	/// Gets the number of nodes that have been requested, including those that were already shared.
+	inline size_t lookups() const					{ return mLookups; }
+
+	/// Gets the number of bytes of node storage taken up by the factory's nodes.
+	inline size_t bytes() const						{ return mArena.used(); }
+
+	/// Gets the number of bytes of node storage held by the factory, including what hasn't been handed out yet.
+	inline size_t reserved() const					{ return mArena.reserved(); }
+
+private:
+
+	/// Creates the shared constants.
+	void init();
+
+	/// Computes the structural hash of a node from its parts.
+	static size_t hash(Node::Type type, Symbol const* symbol, long value, Node const* const* args, size_t n);
+
+	/// Node factories aren't copyable.
+	NodeFactory(NodeFactory const&);
+	NodeFactory& operator=(NodeFactory const&);
+
+};
+
+}
+
+#endif
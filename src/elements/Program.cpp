@@ -0,0 +1,61 @@
+#include <iostream>
+
+#include "elements/Program.h"
+
+namespace elements {
+
+/*****************************************************************************************/
+/* Rule */
+/*****************************************************************************************/
+
+// Prints a rule.
+std::ostream& operator<<(std::ostream& out, Rule const& rule) {
+	if (rule.choice) out << "{" << *rule.head << "}";
+	else out << *rule.head;
+	if (rule.body->type() != Node::TRUE) out << " <- " << *rule.body;
+	return out << ".";
+}
+
+/*****************************************************************************************/
+/* Theory */
+/*****************************************************************************************/
+
+// Copies another theory into this one.
+void Theory::merge(Theory const& other, NodeFactory::SymbolMap const* symbols) {
+	NodeFactory::ImportMap memo;
+
+	for (RuleList::const_iterator it = other.rules().begin(); it != other.rules().end(); it++) {
+		add(mNodes.import(it->head, memo, symbols), mNodes.import(it->body, memo, symbols), it->choice);
+	}
+	for (FormulaList::const_iterator it = other.formulas().begin(); it != other.formulas().end(); it++) {
+		add(mNodes.import(*it, memo, symbols));
+	}
+}
+
+// Frees everything.
+void Theory::clear() {
+	mRules.clear();
+	mFormulas.clear();
+	mNodes.clear();
+}
+
+/*****************************************************************************************/
+/* Program */
+/*****************************************************************************************/
+
+// Merges another program into this one.
+bool Program::merge(Program const& other) {
+	bool ok = true;
+
+	// Map each of their symbols onto ours first, in order so that our ids are deterministic.
+	NodeFactory::SymbolMap symbols;
+	for (size_t i = 0; i < other.symbols().size(); i++) {
+		Symbol const* s = other.symbols()[i];
+		symbols[s] = mSymbols.import(s, ok);
+	}
+
+	Theory::merge(other, &symbols);
+	return ok;
+}
+
+}
@@ -0,0 +1,168 @@
+#ifndef __H_PROGRAM__
+#define __H_PROGRAM__
+
+#include <vector>
+#include <iostream>
+
+#include "elements/Symbol.h"
+#include "elements/Node.h"
+
+namespace elements {
+
+/**
+ * @brief A single rule of the form head <- body.
+ */
+struct Rule {
+	Node const* head;					///< An atom, an assignment f(t) = v, or FALSE for constraints.
+	Node const* body;					///< A formula, or TRUE for facts.
+	bool choice;						///< Whether the head is a choice {head}.
+};
+
+/**
+ * @brief Prints a rule in a human readable form.
+ */
+std::ostream& operator<<(std::ostream& out, Rule const& rule);
+
+/**
+ * @brief A set of rules and formulas along with the factory their nodes belong to.
+ * Each phase of the translation produces its result as a theory, which can be freed
+ * all at once when the following phase is done with it.
+ */
+class Theory {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	typedef std::vector<Rule> RuleList;
+	typedef std::vector<Node const*> FormulaList;
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	NodeFactory mNodes;					///< The factory every node in the theory belongs to.
+	RuleList mRules;					///< The rules in the theory.
+	FormulaList mFormulas;				///< The formulas in the theory.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 */
+	inline Theory() { /* Intentionally Left Blank */ }
+
+	/**
+	 * @brief Basic Destructor.
+	 * Frees all nodes.
+	 */
+	virtual inline ~Theory() { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/* Accessors / Mutators */
+	/***********************************************************************/
+
+	/// Gets the factory the theory's nodes belong to.
+	inline NodeFactory& nodes()							{ return mNodes; }
+
+	/// Gets the factory the theory's nodes belong to.
+	inline NodeFactory const& nodes() const				{ return mNodes; }
+
+	/// Gets the rules in the theory.
+	inline RuleList& rules()							{ return mRules; }
+
+	/// Gets the rules in the theory.
+	inline RuleList const& rules() const				{ return mRules; }
+
+	/// Gets the formulas in the theory.
+	inline FormulaList& formulas()						{ return mFormulas; }
+
+	/// Gets the formulas in the theory.
+	inline FormulaList const& formulas() const			{ return mFormulas; }
+
+	/**
+	 * @brief Adds a rule, whose nodes must belong to this theory's factory.
+	 */
+	inline void add(Node const* head, Node const* body, bool choice = false) {
+		Rule r;
+		r.head = head;
+		r.body = body;
+		r.choice = choice;
+		mRules.push_back(r);
+	}
+
+	/**
+	 * @brief Adds a formula, which must belong to this theory's factory.
+	 */
+	inline void add(Node const* formula)				{ mFormulas.push_back(formula); }
+
+	/**
+	 * @brief Copies the rules and formulas of another theory into this one.
+	 * @param other The theory to copy.
+	 * @param symbols If provided, the symbols to use in place of those in the other theory.
+	 */
+	void merge(Theory const& other, NodeFactory::SymbolMap const* symbols = NULL);
+
+	/**
+	 * @brief Frees every rule, formula and node at once.
+	 */
+	void clear();
+
+private:
+
+	/// Theories aren't copyable.
+	Theory(Theory const&);
+	Theory& operator=(Theory const&);
+
+};
+
+/**
+ * @brief A complete program: its symbols along with the rules that were read for it.
+ */
+class Program : public Theory {
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	SymbolTable mSymbols;				///< The symbols in the program.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 */
+	inline Program() { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/* Accessors / Mutators */
+	/***********************************************************************/
+
+	/// Gets the program's symbol table.
+	inline SymbolTable& symbols()						{ return mSymbols; }
+
+	/// Gets the program's symbol table.
+	inline SymbolTable const& symbols() const			{ return mSymbols; }
+
+	/**
+	 * @brief Merges the symbols and rules of another program (with its own symbol table) into this one.
+	 * @param other The program to merge.
+	 * @return True if successful, false if a symbol was declared differently by each program.
+	 * Everything is merged regardless.
+	 */
+	bool merge(Program const& other);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <boost/cstdint.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "elements/Binary.h"
+#include "elements/Spill.h"
+
+namespace elements {
+
+// Destructor
+Spill::~Spill() {
+	mFile.close();
+}
+
+// Writes a partition.
+bool Spill::write(Theory const& theory) {
+	if (mFailed) return false;
+
+	if (mPath.empty()) {
+		try {
+			mPath = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("aspmt-%%%%-%%%%-%%%%-%%%%.spill")).string();
+		} catch (boost::filesystem::filesystem_error& e) {
+			mFailed = true;
+			return false;
+		}
+		mFile.open(mPath.c_str(), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+
+		// The file stays around for as long as it's open, and is gone once it's closed, even if we're killed.
+		boost::system::error_code ec;
+		boost::filesystem::remove(mPath, ec);
+	}
+
+	// Partitions are written one after another, so each starts where the last one ended.
+	boost::uint64_t offset = bytes();
+	mFile.seekp((std::streamoff)offset);
+	if (!mFile.good() || !Binary::write(mFile, theory) || !mFile.flush()) {
+		mFailed = true;
+		return false;
+	}
+
+	mParts.push_back(std::make_pair(offset, (boost::uint64_t)mFile.tellp() - offset));
+	mFormulas += theory.formulas().size();
+	return true;
+}
+
+// Reads a partition.
+bool Spill::read(size_t part, Theory& theory) {
+	if (part >= mParts.size()) return false;
+
+	// The data is read into 8 byte words, so that it's aligned as it would be if it were mapped.
+	size_t size = (size_t)mParts[part].second;
+	std::vector<boost::uint64_t> data((size + sizeof(boost::uint64_t) - 1) / sizeof(boost::uint64_t));
+	mFile.clear();
+	mFile.seekg((std::streamoff)mParts[part].first);
+	if (size && !mFile.read((char*)&data[0], size)) return false;
+	return Binary::read((char const*)((data.empty()) ? NULL : &data[0]), size, mSymbols, theory);
+}
+
+}
@@ -0,0 +1,97 @@
+#ifndef __H_SPILL__
+#define __H_SPILL__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <boost/cstdint.hpp>
+
+#include "elements/Symbol.h"
+#include "elements/Program.h"
+
+namespace elements {
+
+/**
+ * @brief Holds the formulas of a theory which is too large to keep in memory, as a sequence of partitions on disk.
+ * Each partition is the formulas of a theory, written in binary form (see Binary) to a temporary file as soon as it's
+ * complete, after which the theory can be freed. The partitions are read back one at a time, in the order they were
+ * written, so that only one of them has to be in memory at once. The temporary file is unlinked as soon as it's created,
+ * so it's gone once the spill is freed (or the process exits).
+ */
+class Spill {
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	SymbolTable const& mSymbols;		///< The symbols the formulas refer to.
+	std::string mPath;					///< The name the temporary file was created with, or empty if nothing has been written yet.
+	std::fstream mFile;					///< The open temporary file.
+	std::vector<std::pair<boost::uint64_t, boost::uint64_t> > mParts;	///< The offset and size of each partition within the file.
+	size_t mFormulas;					///< The total number of formulas written.
+	bool mFailed;						///< Whether a partition couldn't be written.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * The temporary file isn't created until the first partition is written.
+	 * @param symbols The symbols the formulas refer to, which should outlive the spill.
+	 */
+	inline Spill(SymbolTable const& symbols)
+		: mSymbols(symbols), mFormulas(0), mFailed(false) { /* Intentionally Left Blank */ }
+
+	/**
+	 * @brief Basic Destructor.
+	 * Closes the temporary file, which frees it.
+	 */
+	virtual ~Spill();
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Writes the formulas of a theory as the next partition.
+	 * @param theory The theory, which may be freed afterwards.
+	 * @return True if successful, false if the temporary file couldn't be created or written.
+	 * Once a partition couldn't be written, the spill is failed and nothing more is written.
+	 */
+	bool write(Theory const& theory);
+
+	/**
+	 * @brief Reads a partition back into a theory.
+	 * @param part The index of the partition.
+	 * @param theory The theory to add the partition's formulas to.
+	 * @return True if successful, false otherwise.
+	 */
+	bool read(size_t part, Theory& theory);
+
+	/// Gets the number of partitions written.
+	inline size_t parts() const							{ return mParts.size(); }
+
+	/// Gets the total number of formulas written.
+	inline size_t formulas() const						{ return mFormulas; }
+
+	/// Gets the total number of bytes written.
+	inline size_t bytes() const							{ return (mParts.empty()) ? 0 : (size_t)(mParts.back().first + mParts.back().second); }
+
+	/// Determines whether a partition couldn't be written.
+	inline bool failed() const							{ return mFailed; }
+
+private:
+
+	/// Spills aren't copyable.
+	Spill(Spill const&);
+	Spill& operator=(Spill const&);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,112 @@
+#include <string>
+#include <vector>
+
+#include "elements/Symbol.h"
+
+namespace elements {
+
+/*****************************************************************************************/
+/* Symbol */
+/*****************************************************************************************/
+
+// Declares the symbol.
+bool Symbol::declare(Type type, Symbol const* sort, SortList const& args) {
+	if (mDeclared) return mType == type && mSort == sort && mArgs == args;
+
+	// Sorts and other symbols live in different namespaces, so they can't become one another.
+	if ((mType == SORT) != (type == SORT)) return false;
+
+	mType = type;
+	mSort = sort;
+	mArgs = args;
+	mDeclared = true;
+	return true;
+}
+
+// Adds an element to the domain.
+void Symbol::addElement(Symbol const* object, long value) {
+	if (object ? !mObjects.insert(object).second : !mIntegers.insert(value).second) return;
+
+	Element e;
+	e.object = object;
+	e.value = object ? 0 : value;
+	mDomain.push_back(e);
+}
+
+/*****************************************************************************************/
+/* Symbol Table */
+/*****************************************************************************************/
+
+// Constructor
+SymbolTable::SymbolTable() {
+	mBoolean = sort("boolean");
+	mBoolean->declare(Symbol::SORT, NULL);
+	mInteger = sort("integer");
+	mInteger->declare(Symbol::SORT, NULL);
+}
+
+// Destructor
+SymbolTable::~SymbolTable() {
+	for (std::vector<Symbol*>::iterator it = mSymbols.begin(); it != mSymbols.end(); it++) {
+		delete *it;
+	}
+}
+
+// Interns a symbol.
+Symbol* SymbolTable::symbol(std::string const& name, size_t arity) {
+	std::pair<SymbolMap::iterator, bool> r = mNames.insert(SymbolMap::value_type(std::make_pair(name, arity), (Symbol*)NULL));
+	if (r.second) {
+		r.first->second = new Symbol(name, arity, mSymbols.size());
+		mSymbols.push_back(r.first->second);
+	}
+	return r.first->second;
+}
+
+// Interns a sort.
+Symbol* SymbolTable::sort(std::string const& name) {
+	std::pair<SortMap::iterator, bool> r = mSorts.insert(SortMap::value_type(name, (Symbol*)NULL));
+	if (r.second) {
+		r.first->second = new Symbol(name, 0, mSymbols.size(), Symbol::SORT);
+		mSymbols.push_back(r.first->second);
+	}
+	return r.first->second;
+}
+
+// Finds a symbol.
+Symbol const* SymbolTable::find(std::string const& name, size_t arity) const {
+	SymbolMap::const_iterator it = mNames.find(std::make_pair(name, arity));
+	return (it != mNames.end()) ? it->second : NULL;
+}
+
+// Finds a sort.
+Symbol const* SymbolTable::findSort(std::string const& name) const {
+	SortMap::const_iterator it = mSorts.find(name);
+	return (it != mSorts.end()) ? it->second : NULL;
+}
+
+// Imports a symbol from another table.
+Symbol* SymbolTable::import(Symbol const* other, bool& ok) {
+	Symbol* s = (other->type() == Symbol::SORT) ? sort(other->name()) : symbol(other->name(), other->arity());
+
+	if (other->declared()) {
+		Symbol const* sort = other->sort() ? import(other->sort(), ok) : NULL;
+		Symbol::SortList args;
+		for (Symbol::SortList::const_iterator it = other->args().begin(); it != other->args().end(); it++) {
+			args.push_back(import(*it, ok));
+		}
+		if (!s->declare(other->type(), sort, args)) ok = false;
+	}
+
+	// Objects are declared directly, since importing them would import their sort (this one) again.
+	for (Symbol::DomainList::const_iterator it = other->domain().begin(); it != other->domain().end(); it++) {
+		Symbol* o = NULL;
+		if (it->object) {
+			o = symbol(it->object->name());
+			if (!o->declare(Symbol::OBJECT, s)) ok = false;
+		}
+		s->addElement(o, it->value);
+	}
+	return s;
+}
+
+}
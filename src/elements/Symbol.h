@@ -0,0 +1,241 @@
+#ifndef __H_SYMBOL__
+#define __H_SYMBOL__
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+namespace elements {
+
+/**
+ * @brief An interned name appearing within a program, along with everything that has been declared about it.
+ * Symbols are unique within their SymbolTable, so two symbols are the same if and only if they're at the same address.
+ */
+class Symbol {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief An enumeration of the kinds of symbols.
+	 */
+	enum Type {
+		UNDECLARED,				///< A name that has been used but hasn't been declared (yet).
+		SORT,					///< A sort, whose domain is a set of objects or integers. Sorts are always of this type, even before they're declared.
+		OBJECT,					///< An object belonging to a sort.
+		PREDICATE,				///< An intensional constant of sort boolean.
+		FUNCTION,				///< An intensional constant of any other sort.
+		VARIABLE				///< A variable ranging over a sort.
+	};
+
+	/**
+	 * @brief An element of a sort's domain, which is either a named object or an integer.
+	 */
+	struct Element {
+		Symbol const* object;	///< The object, or NULL if the element is an integer.
+		long value;				///< The value of the element if it's an integer.
+	};
+
+	/**
+	 * @brief The type of a list of domain elements.
+	 */
+	typedef std::vector<Element> DomainList;
+
+	/**
+	 * @brief The type of a list of argument sorts.
+	 */
+	typedef std::vector<Symbol const*> SortList;
+
+	/**
+	 * @brief The type of a list of symbols.
+	 */
+	typedef std::vector<Symbol const*> SymbolList;
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	std::string mName;					///< The name of the symbol.
+	size_t mArity;						///< The number of arguments the symbol takes.
+	size_t mId;							///< A dense index of the symbol within its table.
+	Type mType;							///< What has been declared about the symbol.
+	bool mDeclared;						///< Whether the symbol has been declared.
+	Symbol const* mSort;				///< The sort of the symbol (or of its value, for constants), or NULL.
+	SortList mArgs;						///< The sorts of each of the symbol's arguments.
+	DomainList mDomain;					///< The domain of the symbol, if it's a sort.
+	boost::unordered_set<Symbol const*> mObjects;	///< The objects in the domain, so that they're only added once.
+	boost::unordered_set<long> mIntegers;			///< The integers in the domain, so that they're only added once.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Initializes an undeclared symbol (or sort).
+	 */
+	inline Symbol(std::string const& name, size_t arity, size_t id, Type type = UNDECLARED)
+		: mName(name), mArity(arity), mId(id), mType(type), mDeclared(false), mSort(NULL) { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/* Accessors / Mutators */
+	/***********************************************************************/
+
+	/// Gets the name of the symbol.
+	inline std::string const& name() const				{ return mName; }
+
+	/// Gets the number of arguments the symbol takes.
+	inline size_t arity() const							{ return mArity; }
+
+	/// Gets the index of the symbol within its table.
+	inline size_t id() const							{ return mId; }
+
+	/// Gets what has been declared about the symbol.
+	inline Type type() const							{ return mType; }
+
+	/// Determines whether the symbol has been declared.
+	inline bool declared() const						{ return mDeclared; }
+
+	/// Gets the sort of the symbol (or of its value, for constants), or NULL.
+	inline Symbol const* sort() const					{ return mSort; }
+
+	/// Gets the sorts of the symbol's arguments.
+	inline SortList const& args() const					{ return mArgs; }
+
+	/// Gets the domain of the symbol, if it's a sort.
+	inline DomainList const& domain() const				{ return mDomain; }
+
+	/// Determines whether the domain of the sort has any objects.
+	inline bool hasObjects() const						{ return !mObjects.empty(); }
+
+	/// Determines whether the domain of the sort has any integers.
+	inline bool hasIntegers() const						{ return !mIntegers.empty(); }
+
+	/// Determines whether the symbol is a predicate or function constant.
+	inline bool constant() const						{ return mType == PREDICATE || mType == FUNCTION; }
+
+	/**
+	 * @brief Declares the symbol.
+	 * Redeclaring a symbol the same way is harmless.
+	 * @param type The kind of symbol being declared.
+	 * @param sort The sort of the symbol (or its value).
+	 * @param args The sorts of the symbol's arguments.
+	 * @return True if successful, false if the symbol has already been declared differently.
+	 */
+	bool declare(Type type, Symbol const* sort, SortList const& args = SortList());
+
+	/**
+	 * @brief Adds an element to the domain of a sort, unless it is already there.
+	 * @param object The object to add, or NULL to add an integer.
+	 * @param value The integer to add if object is NULL.
+	 */
+	void addElement(Symbol const* object, long value = 0);
+
+};
+
+/**
+ * @brief An interning table for the symbols of a program.
+ * Sorts occupy their own namespace, while every other symbol is identified by its name and arity.
+ * Variables are distinguished from other symbols lexically, so they share the namespace.
+ */
+class SymbolTable {
+
+private:
+	/***********************************************************************/
+	/* Private Types */
+	/***********************************************************************/
+
+	typedef boost::unordered_map<std::pair<std::string, size_t>, Symbol*> SymbolMap;
+	typedef boost::unordered_map<std::string, Symbol*> SortMap;
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	std::vector<Symbol*> mSymbols;			///< Every symbol in the table, indexed by id.
+	SymbolMap mNames;						///< The symbols, indexed by name and arity.
+	SortMap mSorts;							///< The sorts, indexed by name.
+
+	Symbol* mBoolean;						///< The built in boolean sort.
+	Symbol* mInteger;						///< The built in integer sort.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * Creates the built in sorts.
+	 */
+	SymbolTable();
+
+	/**
+	 * @brief Basic Destructor.
+	 * Frees all symbols.
+	 */
+	virtual ~SymbolTable();
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Gets the symbol with the provided name and arity, creating it if it doesn't exist.
+	 */
+	Symbol* symbol(std::string const& name, size_t arity = 0);
+
+	/**
+	 * @brief Gets the sort with the provided name, creating it if it doesn't exist.
+	 * Sorts created this way aren't declared() until they are explicitly declared.
+	 */
+	Symbol* sort(std::string const& name);
+
+	/**
+	 * @brief Finds the symbol with the provided name and arity.
+	 * @return The symbol, or NULL if it doesn't exist.
+	 */
+	Symbol const* find(std::string const& name, size_t arity = 0) const;
+
+	/**
+	 * @brief Finds the sort with the provided name.
+	 * @return The sort, or NULL if it doesn't exist.
+	 */
+	Symbol const* findSort(std::string const& name) const;
+
+	/**
+	 * @brief Gets the symbol in this table corresponding to a symbol from another table, merging what has been declared about it.
+	 * @param other The symbol to import.
+	 * @param ok Set to false if the symbol has been declared differently in each table.
+	 * @return The corresponding symbol in this table.
+	 */
+	Symbol* import(Symbol const* other, bool& ok);
+
+	/// Gets the built in boolean sort.
+	inline Symbol const* boolean() const				{ return mBoolean; }
+
+	/// Gets the built in integer sort.
+	inline Symbol const* integer() const				{ return mInteger; }
+
+	/// Gets the number of symbols in the table.
+	inline size_t size() const							{ return mSymbols.size(); }
+
+	/// Gets the symbol with the provided id.
+	inline Symbol const* operator[](size_t id) const	{ return mSymbols[id]; }
+
+private:
+
+	/// Symbol tables aren't copyable.
+	SymbolTable(SymbolTable const&);
+	SymbolTable& operator=(SymbolTable const&);
+
+};
+
+}
+
+#endif
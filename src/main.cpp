@@ -1,69 +1,344 @@
-
-
-//#include "Translator.h"
-//#include "SMTWriter.h"
-//#include "Config.h"
-
-#include "utilities/CompoundFileSource.h"
-
-/**
- * @brief Test function for the compound file source.
- */
-void testCompoundFileSource(void);
-
-/**
- * @brief Main driver routine for the ASPMT2SMT system.
- * Performs command line parsing and configuration setup and then transfers control to the Translator.
- */
-int main(int argc, char** argv) {
-	// TODO: Command line parsing
-
-	for (;;) { }
-
-	// TODO:
-	return 0;
-}
-
-
-// Test function for the compound file source.
-// TODO: Remove this (eventually)
-void testCompoundFileSource() {
-	
-	utils::CompoundFileStream fstream;
-	fstream.open(NULL);
-
-	if (!fstream->append("F:/users/jbabb.ORIGIN/tmp/one.in")) {
-		std::cout << "Couldn't find one.in.\n";
-	}
-	if (!fstream->append("F:/users/jbabb.ORIGIN/tmp/two.in")) {
-		std::cout << "Couldn't find two.in.\n";
-	}
-	if (!fstream->append("F:/users/jbabb.ORIGIN/tmp/three.in")) {
-		std::cout << "Couldnt find three.in.\n";
-	}
-
-	char c;
-
-	do {
-		fstream >> c;
-		std::cout << "File: " << *fstream->filename() << ": Got '" << c << "'\n";
-	} while (c != 'x' && fstream.good());
-
-	// test putback...
-	fstream->putback("xkcd",4);
-
-	// insert!
-	if (!fstream->insert("F:/users/jbabb.ORIGIN/tmp/four.in")) {
-		std::cout << "Couldn't find four.in.\n";
-	}
-
-
-	do {
-		fstream >> c;
-		std::cout << "File: " << *fstream->filename() << ": Got '" << c << "'\n";
-	} while (fstream.good());
-
-
-	fstream.close();
-
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <iostream>
+
+#include "Translator.h"
+#include "Server.h"
+#include "Watcher.h"
+#include "Config.h"
+#include "Z3Solver.h"
+#include "DimacsWriter.h"
+
+#include "elements/Binary.h"
+
+#include "utilities/CompoundFileSource.h"
+#include "utilities/Stats.h"
+
+/**
+ * @brief Test function for the compound file source.
+ */
+void testCompoundFileSource(void);
+
+/**
+ * @brief Prints the command line usage to the provided stream.
+ * @param out The stream to write to.
+ * @param exe The name the program was invoked with.
+ */
+void printUsage(std::ostream& out, char const* exe);
+
+/**
+ * @brief Parses the command line (or the arguments of a request to the server) into the provided configuration.
+ * @param argc The number of arguments.
+ * @param argv The arguments, the first of which is skipped.
+ * @param config The configuration to populate.
+ * @param errors The stream to report errors to.
+ * @return True if the command line was valid, false otherwise.
+ */
+bool parseArgs(int argc, char** argv, Config& config, std::ostream& errors);
+
+/**
+ * @brief Main driver routine for the ASPMT2SMT system.
+ * Performs command line parsing and configuration setup and then transfers control to the Translator.
+ */
+int main(int argc, char** argv) {
+	Config config;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+			printUsage(std::cout, argv[0]);
+			return 0;
+		}
+	}
+
+	if (!parseArgs(argc, argv, config, std::cerr)) {
+		printUsage(std::cerr, argv[0]);
+		return 1;
+	}
+
+	// Decoding an answer doesn't involve the program itself.
+	if (!config.decode().empty()) {
+		std::ostream* out = config.openOutput();
+		if (!out) {
+			std::cerr << "Error: Couldn't open the output file '" << config.output() << "'.\n";
+			return 1;
+		}
+		bool ok = DimacsWriter::decode(config.decode(), std::cin, *out);
+		delete out;
+		return (ok) ? 0 : 1;
+	}
+
+	// The inputs given to a server are its background, which may well be empty.
+	if (!config.serve().empty()) {
+		Server server(config, parseArgs);
+		return (server.load() && server.run()) ? 0 : 1;
+	}
+	if (!config.inputs() && !config.binaries()) {
+		std::cerr << "Error: No input files were provided.\n";
+		printUsage(std::cerr, argv[0]);
+		return 1;
+	}
+
+	// The output is written again each time the inputs change.
+	if (config.boolOpt(Config::OPT_WATCH)) {
+		Watcher watcher(config);
+		return (watcher.run()) ? 0 : 1;
+	}
+
+	std::ostream* out = config.openOutput();
+	if (!out) {
+		std::cerr << "Error: Couldn't open the output file '" << config.output() << "'.\n";
+		return 1;
+	}
+
+	Translator translator(config);
+	bool ok = translator.translate(*out);
+	delete out;
+	translator.stats().write(std::cerr, (utils::Stats::Format)config.intOpt(Config::OPT_STATS));
+	return (ok) ? 0 : 1;
+}
+
+// Prints the usage.
+void printUsage(std::ostream& out, char const* exe) {
+	out << "Usage: " << exe << " [options] <input files...>\n"
+		<< "Input files compressed with gzip or zstd are decompressed as they're read.\n"
+		<< "Options:\n"
+		<< "  -o <file>            Write the output to <file> instead of the standard output.\n"
+		<< "  -j <n>, --threads=<n>\n"
+		<< "                       Use <n> worker threads (default: one per hardware thread).\n"
+		<< "  --parallel-parse     Parse each input file independently and merge the results.\n"
+		<< "  --smt                Write the translated program as SMT-LIB instead of solving it.\n"
+		<< "  --dimacs             Write the translated program as DIMACS CNF for a SAT solver instead of solving\n"
+		<< "                       it. Only possible if every constant ranges over finite domains. The atom or\n"
+		<< "                       function value of each variable is listed in comments.\n"
+		<< "  --decode=<file>      Read a SAT solver's answer for the DIMACS program <file> from the standard\n"
+		<< "                       input, and display it in terms of the program's constants.\n"
+		<< "  --binary[=<kind>]    Write the program in binary form instead of solving it, either as it was\n"
+		<< "                       parsed or once it's translated (<kind> is parsed or ground, default: ground).\n"
+		<< "                       Binary programs can be given as input files in place of text.\n"
+		<< "  -n <n>, --models=<n>\n"
+		<< "                       Display at most <n> models, or every model if <n> is 0 (default: 1).\n"
+		<< "                       Models are enumerated in parallel. Has no effect with --smt.\n"
+		<< "  --portfolio[=<names>]\n"
+		<< "                       Race several solver configurations and take the first answer,\n"
+		<< "                       reporting the time each took. <names> is a comma separated list of\n"
+		<< "                       configurations from:";
+	for (size_t i = 0; Z3Solver::configuration(i); i++) out << " " << Z3Solver::configuration(i);
+	out << " (default: all).\n"
+		<< "                       Only used when a single model is wanted.\n"
+		<< "  --cache=<dir>        Cache translated programs in <dir>, keyed by the contents of the inputs.\n"
+		<< "  --cache-size=<n>     Keep the cache within <n> megabytes (default: 256).\n"
+		<< "  --memory-budget=<n>  Keep the ground program within about <n> megabytes of memory while it's being\n"
+		<< "                       translated, spilling the rest to a temporary file until it's written or\n"
+		<< "                       solved (default: no limit). Ignored with --binary, --cache and --watch.\n"
+		<< "  --prefetch=<n>       Read the following input files ahead, into at most <n> megabytes of memory,\n"
+		<< "                       while each one is parsed. Ignored with --parallel-parse.\n"
+		<< "  -q <file>, --query=<file>\n"
+		<< "                       Solve the program together with <file>, without retranslating the\n"
+		<< "                       program for each query. May be given more than once.\n"
+		<< "  --serve=<socket>     Run as a server listening on the Unix socket <socket>. The input files are\n"
+		<< "                       parsed and translated once and shared by every request. Each request is\n"
+		<< "                       a line of options and files, as on the command line, followed by a program\n"
+		<< "                       fragment (referred to as '-'), and is answered with its output and errors.\n"
+		<< "  --watch              Keep watching the input files, and write the program again whenever they\n"
+		<< "                       change. Only the files which changed are parsed again, and only the\n"
+		<< "                       constants whose rules changed are retranslated. Implies --parallel-parse.\n"
+		<< "  --stats[=<format>]   Report the time, CPU time, memory and output of each stage to the standard\n"
+		<< "                       error once done, either as a table or as a line of JSON (<format> is text\n"
+		<< "                       or json, default: text). With --watch, they're reported for each update.\n"
+		<< "  -h, --help           Display this message.\n";
+}
+
+// Parses the command line.
+bool parseArgs(int argc, char** argv, Config& config, std::ostream& errors) {
+	for (int i = 1; i < argc; i++) {
+		char const* arg = argv[i];
+
+		if (!strcmp(arg, "-o")) {
+			if (++i >= argc) {
+				errors << "Error: Expected an output file after '-o'.\n";
+				return false;
+			}
+			if (config.output(argv[i])) {
+				errors << "Error: The output file has been specified more than once.\n";
+				return false;
+			}
+		} else if (!strcmp(arg, "-j") || !strncmp(arg, "--threads=", 10)) {
+			char const* val = (arg[1] == 'j') ? ((++i < argc) ? argv[i] : NULL) : arg + 10;
+			char* end;
+			long n = val ? strtol(val, &end, 10) : -1;
+			if (!val || !*val || *end || n < 0) {
+				errors << "Error: Expected a non-negative number of threads.\n";
+				return false;
+			}
+			config.intOpt(Config::OPT_THREADS, (int)n);
+		} else if (!strcmp(arg, "-n") || !strncmp(arg, "--models=", 9)) {
+			char const* val = (arg[1] == 'n') ? ((++i < argc) ? argv[i] : NULL) : arg + 9;
+			char* end;
+			long n = val ? strtol(val, &end, 10) : -1;
+			if (!val || !*val || *end || n < 0) {
+				errors << "Error: Expected a non-negative number of models.\n";
+				return false;
+			}
+			config.intOpt(Config::OPT_MODELS, (int)n);
+		} else if (!strcmp(arg, "--portfolio") || !strncmp(arg, "--portfolio=", 12)) {
+			int mask = Z3Solver::portfolio((arg[11]) ? arg + 12 : "all");
+			if (mask <= 0) {
+				errors << "Error: Unrecognized solver configuration in '" << arg << "'.\n";
+				return false;
+			}
+			config.intOpt(Config::OPT_PORTFOLIO, mask);
+		} else if (!strncmp(arg, "--cache=", 8)) {
+			if (!arg[8]) {
+				errors << "Error: Expected a cache directory.\n";
+				return false;
+			}
+			if (config.cache(arg + 8)) {
+				errors << "Error: The cache directory has been specified more than once.\n";
+				return false;
+			}
+		} else if (!strncmp(arg, "--serve=", 8)) {
+			if (!arg[8]) {
+				errors << "Error: Expected a socket path.\n";
+				return false;
+			}
+			if (config.serve(arg + 8)) {
+				errors << "Error: The socket has been specified more than once.\n";
+				return false;
+			}
+		} else if (!strncmp(arg, "--cache-size=", 13)) {
+			char* end;
+			long n = strtol(arg + 13, &end, 10);
+			if (!arg[13] || *end || n <= 0) {
+				errors << "Error: Expected a positive cache size.\n";
+				return false;
+			}
+			config.intOpt(Config::OPT_CACHE_SIZE, (int)n);
+		} else if (!strncmp(arg, "--memory-budget=", 16)) {
+			char* end;
+			long n = strtol(arg + 16, &end, 10);
+			if (!arg[16] || *end || n <= 0) {
+				errors << "Error: Expected a positive memory budget.\n";
+				return false;
+			}
+			config.intOpt(Config::OPT_MEMORY_BUDGET, (int)n);
+		} else if (!strncmp(arg, "--prefetch=", 11)) {
+			char* end;
+			long n = strtol(arg + 11, &end, 10);
+			if (!arg[11] || *end || n <= 0) {
+				errors << "Error: Expected a positive prefetch budget.\n";
+				return false;
+			}
+			config.intOpt(Config::OPT_PREFETCH, (int)n);
+		} else if (!strcmp(arg, "--parallel-parse")) {
+			config.boolOpt(Config::OPT_PARALLEL_PARSE, true);
+		} else if (!strcmp(arg, "--watch")) {
+			config.boolOpt(Config::OPT_WATCH, true);
+		} else if (!strcmp(arg, "--smt")) {
+			config.boolOpt(Config::OPT_WRITE_SMT, true);
+		} else if (!strcmp(arg, "--dimacs")) {
+			config.boolOpt(Config::OPT_WRITE_DIMACS, true);
+		} else if (!strncmp(arg, "--decode=", 9)) {
+			if (!arg[9]) {
+				errors << "Error: Expected a DIMACS file to decode an answer for.\n";
+				return false;
+			}
+			if (config.decode(arg + 9)) {
+				errors << "Error: The DIMACS file to decode an answer for has been specified more than once.\n";
+				return false;
+			}
+		} else if (!strcmp(arg, "--binary") || !strncmp(arg, "--binary=", 9)) {
+			char const* kind = (arg[8]) ? arg + 9 : "ground";
+			if (!strcmp(kind, "parsed")) config.intOpt(Config::OPT_WRITE_BINARY, elements::Binary::PARSED);
+			else if (!strcmp(kind, "ground")) config.intOpt(Config::OPT_WRITE_BINARY, elements::Binary::GROUND);
+			else {
+				errors << "Error: Unrecognized binary program kind in '" << arg << "'.\n";
+				return false;
+			}
+		} else if (!strcmp(arg, "--stats") || !strncmp(arg, "--stats=", 8)) {
+			char const* format = (arg[7]) ? arg + 8 : "text";
+			if (!strcmp(format, "text")) config.intOpt(Config::OPT_STATS, utils::Stats::TEXT);
+			else if (!strcmp(format, "json")) config.intOpt(Config::OPT_STATS, utils::Stats::JSON);
+			else {
+				errors << "Error: Unrecognized stats format in '" << arg << "'.\n";
+				return false;
+			}
+		} else if (!strcmp(arg, "-q") || !strncmp(arg, "--query=", 8)) {
+			char const* file = (arg[1] == 'q') ? ((++i < argc) ? argv[i] : NULL) : arg + 8;
+			if (!file || !*file) {
+				errors << "Error: Expected a query file.\n";
+				return false;
+			}
+			if (!config.addQuery(file)) {
+				errors << "Error: Couldn't find query file '" << file << "'.\n";
+				return false;
+			}
+		} else if (arg[0] == '-' && arg[1]) {
+			errors << "Error: Unrecognized option '" << arg << "'.\n";
+			return false;
+		} else {
+			if (!config.addInput(arg)) {
+				errors << "Error: Couldn't find input file '" << arg << "'.\n";
+				return false;
+			}
+		}
+	}
+
+	if (config.intOpt(Config::OPT_WRITE_BINARY) && config.queries()) {
+		errors << "Error: Queries can't be solved while writing a binary program.\n";
+		return false;
+	}
+	if (config.boolOpt(Config::OPT_WRITE_DIMACS) && (config.queries() || config.boolOpt(Config::OPT_WRITE_SMT))) {
+		errors << "Error: A DIMACS program can't be written along with queries or SMT-LIB.\n";
+		return false;
+	}
+	if (config.boolOpt(Config::OPT_WATCH) && (config.queries() || config.binaries() || config.intOpt(Config::OPT_WRITE_BINARY)
+			|| !config.cache().empty() || !config.serve().empty())) {
+		errors << "Error: Only text input files can be watched, without queries, binary output, a cache or a server.\n";
+		return false;
+	}
+	return true;
+}
+
+// Test function for the compound file source.
+// TODO: Remove this (eventually)
+void testCompoundFileSource() {
+	
+	utils::CompoundFileStream fstream;
+	fstream.open(utils::CompoundFileSource());
+
+	if (!fstream->append("F:/users/jbabb.ORIGIN/tmp/one.in")) {
+		std::cout << "Couldn't find one.in.\n";
+	}
+	if (!fstream->append("F:/users/jbabb.ORIGIN/tmp/two.in")) {
+		std::cout << "Couldn't find two.in.\n";
+	}
+	if (!fstream->append("F:/users/jbabb.ORIGIN/tmp/three.in")) {
+		std::cout << "Couldnt find three.in.\n";
+	}
+
+	char c;
+
+	do {
+		fstream >> c;
+		std::cout << "File: " << *fstream->filename() << ": Got '" << c << "'\n";
+	} while (c != 'x' && fstream.good());
+
+	// test putback...
+	fstream->putback("xkcd",4);
+
+	// insert!
+	if (!fstream->insert("F:/users/jbabb.ORIGIN/tmp/four.in")) {
+		std::cout << "Couldn't find four.in.\n";
+	}
+
+
+	do {
+		fstream >> c;
+		std::cout << "File: " << *fstream->filename() << ": Got '" << c << "'\n";
+	} while (fstream.good());
+
+
+	fstream.close();
+
 }
\ No newline at end of file
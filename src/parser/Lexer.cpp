@@ -0,0 +1,361 @@
+#include <string>
+#include <cstring>
+
+#include "parser/Lexer.h"
+#include "parser/parser.h"
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define LEXER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define LEXER_SSE2
+#endif
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+namespace parser {
+
+/*****************************************************************************************/
+/* Scanning Kernels */
+/*****************************************************************************************/
+
+namespace {
+
+/// Counts the number of set bits.
+inline unsigned int popcount(unsigned int x) {
+#if defined(_MSC_VER)
+	return __popcnt(x);
+#else
+	return (unsigned int)__builtin_popcount(x);
+#endif
+}
+
+/// Finds the index of the lowest set bit. x must be non-zero.
+inline unsigned int lowest(unsigned int x) {
+#if defined(_MSC_VER)
+	unsigned long i;
+	_BitScanForward(&i, x);
+	return (unsigned int)i;
+#else
+	return (unsigned int)__builtin_ctz(x);
+#endif
+}
+
+/// Finds the index of the highest set bit. x must be non-zero.
+inline unsigned int highest(unsigned int x) {
+#if defined(_MSC_VER)
+	unsigned long i;
+	_BitScanReverse(&i, x);
+	return (unsigned int)i;
+#else
+	return 31 - (unsigned int)__builtin_clz(x);
+#endif
+}
+
+/// Scalar character classes.
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool isLower(char c) { return c >= 'a' && c <= 'z'; }
+inline bool isUpper(char c) { return c >= 'A' && c <= 'Z'; }
+inline bool isIdent(char c) { return isLower(c) || isUpper(c) || isDigit(c) || c == '_'; }
+
+#if defined(LEXER_AVX2) || defined(LEXER_SSE2)
+
+// A thin layer over whichever vector width we're targeting.
+#if defined(LEXER_AVX2)
+	typedef __m256i vec_t;
+	#define VEC_SIZE 32
+	#define VEC_FULL 0xFFFFFFFFu
+	inline vec_t vload(char const* p) { return _mm256_loadu_si256((__m256i const*)p); }
+	inline vec_t vset(char c) { return _mm256_set1_epi8(c); }
+	inline vec_t veq(vec_t a, vec_t b) { return _mm256_cmpeq_epi8(a, b); }
+	inline vec_t vlt(vec_t a, vec_t b) { return _mm256_cmpgt_epi8(b, a); }
+	inline vec_t vor(vec_t a, vec_t b) { return _mm256_or_si256(a, b); }
+	inline vec_t vadd(vec_t a, vec_t b) { return _mm256_add_epi8(a, b); }
+	inline unsigned int vmask(vec_t a) { return (unsigned int)_mm256_movemask_epi8(a); }
+#else
+	typedef __m128i vec_t;
+	#define VEC_SIZE 16
+	#define VEC_FULL 0xFFFFu
+	inline vec_t vload(char const* p) { return _mm_loadu_si128((__m128i const*)p); }
+	inline vec_t vset(char c) { return _mm_set1_epi8(c); }
+	inline vec_t veq(vec_t a, vec_t b) { return _mm_cmpeq_epi8(a, b); }
+	inline vec_t vlt(vec_t a, vec_t b) { return _mm_cmplt_epi8(a, b); }
+	inline vec_t vor(vec_t a, vec_t b) { return _mm_or_si128(a, b); }
+	inline vec_t vadd(vec_t a, vec_t b) { return _mm_add_epi8(a, b); }
+	inline unsigned int vmask(vec_t a) { return (unsigned int)_mm_movemask_epi8(a); }
+#endif
+
+/**
+ * @brief Determines which bytes of v fall within [lo, hi].
+ * SSE2 only has signed comparisons, so the range is shifted down to begin at -128 first.
+ */
+inline vec_t vrange(vec_t v, char lo, char hi) {
+	return vlt(vadd(v, vset((char)(-128 - lo))), vset((char)(-128 + (hi - lo) + 1)));
+}
+
+/// Determines which bytes of v are whitespace.
+inline unsigned int spaceMask(vec_t v) {
+	return vmask(vor(vor(veq(v, vset(' ')), veq(v, vset('\t'))), vor(veq(v, vset('\n')), veq(v, vset('\r')))));
+}
+
+/// Determines which bytes of v can appear within an identifier.
+inline unsigned int identMask(vec_t v) {
+	// Setting 0x20 folds the upper case letters onto the lower case ones without introducing anything else.
+	vec_t letters = vrange(vor(v, vset(0x20)), 'a', 'z');
+	return vmask(vor(vor(letters, vrange(v, '0', '9')), veq(v, vset('_'))));
+}
+
+/// Determines which bytes of v are digits.
+inline unsigned int digitMask(vec_t v) {
+	return vmask(vrange(v, '0', '9'));
+}
+
+#endif
+
+/**
+ * @brief Finds the first character which isn't whitespace.
+ * @param line Incremented for each newline skipped.
+ * @param lineStart Set to the character following the last newline skipped, if any.
+ */
+inline char const* skipSpace(char const* p, char const* end, int& line, char const*& lineStart) {
+#if defined(LEXER_AVX2) || defined(LEXER_SSE2)
+	while (p + VEC_SIZE <= end) {
+		vec_t v = vload(p);
+		unsigned int space = spaceMask(v);
+		unsigned int nl = vmask(veq(v, vset('\n')));
+
+		if (space != VEC_FULL) {
+			// Only count the newlines before the first non-whitespace character.
+			unsigned int stop = lowest(~space);
+			nl &= (1u << stop) - 1;
+			if (nl) {
+				line += (int)popcount(nl);
+				lineStart = p + highest(nl) + 1;
+			}
+			return p + stop;
+		}
+
+		if (nl) {
+			line += (int)popcount(nl);
+			lineStart = p + highest(nl) + 1;
+		}
+		p += VEC_SIZE;
+	}
+#endif
+	for (; p < end && isSpace(*p); p++) {
+		if (*p == '\n') {
+			line++;
+			lineStart = p + 1;
+		}
+	}
+	return p;
+}
+
+/// Finds the next newline, or end if there isn't one.
+inline char const* findNewline(char const* p, char const* end) {
+#if defined(LEXER_AVX2) || defined(LEXER_SSE2)
+	while (p + VEC_SIZE <= end) {
+		unsigned int nl = vmask(veq(vload(p), vset('\n')));
+		if (nl) return p + lowest(nl);
+		p += VEC_SIZE;
+	}
+#endif
+	while (p < end && *p != '\n') p++;
+	return p;
+}
+
+/// Finds the first character which can't appear in an identifier.
+inline char const* skipIdent(char const* p, char const* end) {
+#if defined(LEXER_AVX2) || defined(LEXER_SSE2)
+	while (p + VEC_SIZE <= end) {
+		unsigned int m = identMask(vload(p));
+		if (m != VEC_FULL) return p + lowest(~m);
+		p += VEC_SIZE;
+	}
+#endif
+	while (p < end && isIdent(*p)) p++;
+	return p;
+}
+
+/// Finds the first character which isn't a digit.
+inline char const* skipDigits(char const* p, char const* end) {
+#if defined(LEXER_AVX2) || defined(LEXER_SSE2)
+	while (p + VEC_SIZE <= end) {
+		unsigned int m = digitMask(vload(p));
+		if (m != VEC_FULL) return p + lowest(~m);
+		p += VEC_SIZE;
+	}
+#endif
+	while (p < end && isDigit(*p)) p++;
+	return p;
+}
+
+/// Determines whether the identifier is a reserved word, returning its token type if so.
+inline int keyword(char const* p, size_t len) {
+	switch (len) {
+	case 3:
+		if (!memcmp(p, "not", 3)) return T_NOT;
+		break;
+	case 4:
+		if (!memcmp(p, "true", 4)) return T_TRUE;
+		break;
+	case 5:
+		if (!memcmp(p, "false", 5)) return T_FALSE;
+		if (!memcmp(p, "sorts", 5)) return T_SORTS;
+		break;
+	case 7:
+		if (!memcmp(p, "objects", 7)) return T_OBJECTS;
+		break;
+	case 9:
+		if (!memcmp(p, "constants", 9)) return T_CONSTANTS;
+		if (!memcmp(p, "variables", 9)) return T_VARIABLES;
+		break;
+	default:
+		break;
+	}
+	return T_IDENTIFIER;
+}
+
+}
+
+/*****************************************************************************************/
+/* Lexer */
+/*****************************************************************************************/
+
+// Constructor
+Lexer::Lexer(utils::CompoundFileSource& source)
+	: mSource(source), mBegin(NULL), mPos(NULL), mEnd(NULL), mLineStart(NULL), mLine(1), mMapped(false), mStarted(false), mArrow(false) {
+	/* Intentionally Left Blank */
+}
+
+// Moves to the next buffer.
+bool Lexer::advance() {
+	// Let go of the last buffer.
+	if (mStarted) {
+		if (mMapped) mSource.consume(mEnd - mBegin);
+		else if (mSource.good()) mSource.nextFile();
+	}
+	mStarted = true;
+
+	// Scan the next file in place if it's mapped, otherwise read it into memory. Other spans are only one
+	// block of the file, which tokens and lines would run across.
+	std::streamsize n;
+	char const* p = mSource.span(n);
+	if (p && mSource.mapped()) {
+		mMapped = true;
+		mBegin = p;
+		mEnd = p + n;
+	} else if (mSource.good()) {
+		mMapped = false;
+		mCopy.clear();
+		if (!mSource.readFile(mCopy)) return false;
+		mBegin = mCopy.data();
+		mEnd = mBegin + mCopy.size();
+	} else {
+		return false;
+	}
+
+	mPos = mLineStart = mBegin;
+	mLine = 1;
+	mArrow = false;
+	mFiles.push_back(*mSource.filename());
+	return true;
+}
+
+// Skips whitespace and comments.
+void Lexer::skip() {
+	for (;;) {
+		mPos = skipSpace(mPos, mEnd, mLine, mLineStart);
+
+		// Comments run until the end of the line.
+		if (mPos < mEnd && *mPos == '%') mPos = findNewline(mPos, mEnd);
+		else break;
+	}
+}
+
+// Scans the next token.
+int Lexer::next(Token& token) {
+	// Find the beginning of the next token, moving through buffers as needed.
+	for (;;) {
+		if (mStarted) skip();
+		if (mPos < mEnd) break;
+
+		if (!advance()) {
+			token.type = 0;
+			token.text = mEnd;
+			token.length = 0;
+			token.loc.file = file();
+			token.loc.first_line = token.loc.last_line = mLine;
+			token.loc.first_column = token.loc.last_column = (int)(mPos - mLineStart) + 1;
+			return 0;
+		}
+	}
+
+	char const* start = mPos;
+	char c = *mPos;
+	int type;
+
+	if (isLower(c)) {
+		mPos = skipIdent(mPos + 1, mEnd);
+		type = keyword(start, mPos - start);
+	} else if (isUpper(c) || c == '_') {
+		mPos = skipIdent(mPos + 1, mEnd);
+		type = T_VARIABLE;
+	} else if (isDigit(c)) {
+		mPos = skipDigits(mPos + 1, mEnd);
+		type = T_INTEGER;
+	} else {
+		char d = (mPos + 1 < mEnd) ? mPos[1] : '\0';
+		mPos++;
+
+		switch (c) {
+		case ':':
+			if (d == '-') { type = T_ARROW; mPos++; }
+			else if (d == ':') { type = T_DCOLON; mPos++; }
+			else type = c;
+			break;
+		case '<':
+			// After the statement's arrow, '<-' is a comparison with a negative number.
+			if (d == '-' && !mArrow) { type = T_ARROW; mPos++; }
+			else if (d == '=') { type = T_LE; mPos++; }
+			else type = T_LT;
+			break;
+		case '>':
+			if (d == '=') { type = T_GE; mPos++; }
+			else type = T_GT;
+			break;
+		case '=':
+			if (d == '=') mPos++;
+			type = T_EQ;
+			break;
+		case '!':
+		case '\\':
+			if (d == '=') { type = T_NEQ; mPos++; }
+			else type = c;
+			break;
+		case '.':
+			if (d == '.') { type = T_DDOT; mPos++; }
+			else { type = '.'; mArrow = false; }
+			break;
+		default:
+			type = (unsigned char)c;
+			break;
+		}
+		if (type == T_ARROW) mArrow = true;
+	}
+
+	token.type = type;
+	token.text = start;
+	token.length = mPos - start;
+	token.loc.file = file();
+	token.loc.first_line = token.loc.last_line = mLine;
+	token.loc.first_column = (int)(start - mLineStart) + 1;
+	token.loc.last_column = (int)(mPos - mLineStart);
+	return type;
+}
+
+}
@@ -0,0 +1,115 @@
+#ifndef __H_LEXER__
+#define __H_LEXER__
+
+#include <string>
+#include <list>
+
+#include "utilities/CompoundFileSource.h"
+
+namespace parser {
+
+/**
+ * @brief The location of a token or grammar symbol within the input.
+ * Laid out to be used directly as the grammar's location type, which expects the line and column fields first.
+ */
+struct Location {
+	int first_line;							///< The line the location begins on.
+	int first_column;						///< The column the location begins on.
+	int last_line;							///< The line the location ends on.
+	int last_column;						///< The column the location ends on.
+	std::string const* file;				///< The name of the file, as given by the user, or NULL.
+};
+
+/**
+ * @brief A single token scanned from the input.
+ * The text of the token isn't copied, but refers directly to the buffer it was scanned from.
+ */
+struct Token {
+	int type;								///< The grammar's token number, or 0 at the end of the input.
+	char const* text;						///< The beginning of the token within the input buffer.
+	size_t length;							///< The number of characters in the token.
+	Location loc;							///< The location of the token.
+};
+
+/**
+ * @brief A hand written scanner which reads tokens for the grammar directly from a CompoundFileSource.
+ * Each file is scanned as one contiguous buffer: MAPPED files are scanned in place, while the
+ * contents of other files are read into memory first. Runs of whitespace, comments, identifiers
+ * and numbers are scanned a vector at a time using SSE2 or AVX2 when the compiler targets them.
+ *
+ * The text of a token remains valid until the scanner moves on to the next file. Since a statement
+ * can't span files, this is long enough for the grammar's actions to make use of it.
+ *
+ * A statement has at most one arrow, so once it has been scanned (up to the '.' ending the statement),
+ * '<-' is scanned as '<' followed by '-' instead. This lets bodies compare against negative numbers,
+ * as in 'p(X) :- X<-1.'.
+ */
+class Lexer {
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	utils::CompoundFileSource& mSource;		///< The source we're reading from.
+
+	std::list<std::string> mFiles;			///< The names of the files we've scanned, which token locations refer to.
+	std::string mCopy;						///< The contents of the current file, if it isn't being scanned in place.
+
+	char const* mBegin;						///< The beginning of the current buffer.
+	char const* mPos;						///< The next character to scan within the current buffer.
+	char const* mEnd;						///< One past the end of the current buffer.
+	char const* mLineStart;					///< The beginning of the current line within the current buffer.
+	int mLine;								///< The current line number.
+
+	bool mMapped;							///< Whether the current buffer is a MAPPED file, scanned in place through CompoundFileSource::span().
+	bool mStarted;							///< Whether we've obtained a buffer from the source yet.
+	bool mArrow;							///< Whether the current statement's arrow has been scanned.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param source The source to read from. Should outlive the lexer.
+	 */
+	Lexer(utils::CompoundFileSource& source);
+
+	/**
+	 * @brief Basic Destructor.
+	 * Does nothing.
+	 */
+	virtual inline ~Lexer() { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Scans the next token from the input.
+	 * Characters which don't begin any token are returned as their own (undefined) token type so that the grammar reports them.
+	 * @param token The token to populate.
+	 * @return The type of the token, or 0 at the end of the input.
+	 */
+	int next(Token& token);
+
+	/// Gets the name of the file currently being scanned, or NULL.
+	inline std::string const* file() const { return mFiles.size() ? &mFiles.back() : NULL; }
+
+private:
+
+	/**
+	 * @brief Moves on to the next buffer from the source.
+	 * @return True if there was another buffer, false if the input has been exhausted or an error occurred.
+	 */
+	bool advance();
+
+	/// Skips whitespace and comments within the current buffer, keeping track of lines.
+	void skip();
+
+};
+
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef __H_PARALLEL_PARSER__
+#define __H_PARALLEL_PARSER__
+
+#include <string>
+#include <vector>
+#include <exception>
+
+#include <boost/bind/bind.hpp>
+
+#include "utilities/ThreadPool.h"
+
+namespace parser {
+
+/**
+ * @brief Parses a number of independent input files concurrently and merges the results.
+ * Each file is parsed by its own instance of Unit on a pool of worker threads, producing a
+ * separate result per file. Once every file has been parsed the results are merged into a
+ * single unit in the order the files were given, so the outcome doesn't depend on scheduling.
+ * @param Unit The type of a single parser instance. Must be default constructible and provide:
+ *		bool parse(std::string const& file)	- Parses the file into the unit, returning false on failure.
+ *		void merge(Unit& other)				- Appends the contents of another unit to this one.
+ */
+template <typename Unit>
+class ParallelParser {
+
+private:
+	/***********************************************************************/
+	/* Private types */
+	/***********************************************************************/
+
+	/**
+	 * @brief The work and result for a single input file.
+	 */
+	struct Job {
+		std::string file;		///< The file to parse.
+		Unit unit;				///< The parser instance for this file.
+		bool ok;				///< Whether the file was parsed successfully.
+
+		/// Parses the file.
+		inline void run() {
+			try {
+				ok = unit.parse(file);
+			} catch (std::exception& e) {
+				ok = false;
+			}
+		}
+	};
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	size_t mThreads;				///< The number of worker threads to use.
+	std::string mFailed;			///< The first file (in input order) which couldn't be parsed.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param threads The number of worker threads to use, or 0 for one per hardware thread.
+	 */
+	inline ParallelParser(size_t threads = 0) : mThreads(threads) { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Parses each of the files and merges the results into out.
+	 * @param begin An iterator pointing to the first file name.
+	 * @param end An iterator pointing past the last file name.
+	 * @param out The unit to merge each file's results into.
+	 * @return True if every file was parsed successfully, false otherwise.
+	 * Results are merged even if some files failed so that each unit can carry its errors along.
+	 */
+	template <typename Iterator>
+	bool parse(Iterator begin, Iterator end, Unit& out) {
+		std::vector<Job*> jobs;
+		for (Iterator it = begin; it != end; it++) {
+			Job* job = new Job();
+			job->file = *it;
+			job->ok = false;
+			jobs.push_back(job);
+		}
+		mFailed.clear();
+
+		// Parse...
+		size_t threads = utils::ThreadPool::threads(mThreads);
+		if (threads > jobs.size()) threads = jobs.size();
+		if (threads <= 1) {
+			for (size_t i = 0; i < jobs.size(); i++) jobs[i]->run();
+		} else {
+			utils::ThreadPool pool(threads);
+			for (size_t i = 0; i < jobs.size(); i++) {
+				pool.post(boost::bind(&Job::run, jobs[i]));
+			}
+			pool.wait();
+		}
+
+		// ... and merge in input order.
+		for (size_t i = 0; i < jobs.size() && mFailed.empty(); i++) {
+			if (!jobs[i]->ok) mFailed = jobs[i]->file;
+		}
+		for (size_t i = 0; i < jobs.size(); i++) out.merge(jobs[i]->unit);
+
+		for (size_t i = 0; i < jobs.size(); i++) delete jobs[i];
+		return mFailed.empty();
+	}
+
+	/// Gets the first file which couldn't be parsed by the last call to parse(), or an empty string.
+	inline std::string const& failed() const { return mFailed; }
+
+};
+
+}
+
+#endif
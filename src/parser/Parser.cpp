@@ -0,0 +1,174 @@
+#include <string>
+#include <sstream>
+#include <limits>
+
+#include "utilities/CompoundFileSource.h"
+#include "parser/Lexer.h"
+#include "parser/Parser.h"
+#include "parser/parser.h"
+
+using namespace elements;
+
+namespace parser {
+
+// Parses a single file.
+bool Parser::parse(std::string const& file) {
+	utils::CompoundFileSource source(utils::CompoundFileSource::MAPPED);
+	if (!source.append(file)) {
+		mErrors.push_back(file + ": error: Couldn't open the file.");
+		return false;
+	}
+	return parse(source);
+}
+
+// Parses the rest of a source.
+bool Parser::parse(utils::CompoundFileSource& source) {
+	size_t errors = mErrors.size();
+	size_t bytes = source.bytes();
+	Lexer lexer(source);
+
+	yyparse(lexer, *this);
+	mFiles.insert(mFiles.end(), source.placed().begin(), source.placed().end());
+	mBytes += source.bytes() - bytes;
+	mHits += source.resolutionHits();
+	mMisses += source.resolutionMisses();
+
+	if (source.state() == utils::CompoundFileSource::ERROR) {
+		std::string const* file = (lexer.file()) ? lexer.file() : source.filename();
+		mErrors.push_back(((file) ? *file : std::string("<input>")) + ": error: An error occurred while reading the file.");
+	}
+	return mErrors.size() == errors;
+}
+
+// Merges another parser into this one.
+void Parser::merge(Parser& other) {
+	mErrors.insert(mErrors.end(), other.mErrors.begin(), other.mErrors.end());
+	mFiles.insert(mFiles.end(), other.mFiles.begin(), other.mFiles.end());
+	mBytes += other.mBytes;
+	mHits += other.mHits;
+	mMisses += other.mMisses;
+	if (!mProgram.merge(other.mProgram)) {
+		mErrors.push_back("error: A symbol was declared differently in separate files.");
+	}
+}
+
+// Records an error.
+void Parser::error(Location const& loc, std::string const& msg) {
+	std::ostringstream out;
+	out << ((loc.file) ? *loc.file : std::string("<input>")) << ":" << loc.first_line << ":" << loc.first_column << ": error: " << msg;
+	mErrors.push_back(out.str());
+}
+
+// Gets a sort.
+Symbol* Parser::sort(Token const& name) {
+	return mProgram.symbols().sort(text(name));
+}
+
+// Declares a sort.
+void Parser::declareSort(Token const& name) {
+	sort(name)->declare(Symbol::SORT, NULL);
+}
+
+// Declares some objects.
+void Parser::declareObjects(ObjectList const& objects, Token const& sortName) {
+	Symbol* s = sort(sortName);
+
+	for (ObjectList::const_iterator it = objects.begin(); it != objects.end(); it++) {
+		if (it->integer) {
+			if (it->lo > it->hi) {
+				error(it->name.loc, "The integer range is empty.");
+				continue;
+			}
+			for (long i = it->lo; ; i++) {
+				s->addElement(NULL, i);
+				if (i == it->hi) break;
+			}
+		} else {
+			Symbol* o = mProgram.symbols().symbol(text(it->name));
+			if (!o->declare(Symbol::OBJECT, s)) {
+				error(it->name.loc, "'" + o->name() + "' has already been declared differently.");
+				continue;
+			}
+			s->addElement(o);
+		}
+	}
+}
+
+// Declares some constants.
+void Parser::declareConstants(ConstantList const& constants, Token const& sortName) {
+	Symbol const* s = sort(sortName);
+	Symbol::Type type = (s == mProgram.symbols().boolean()) ? Symbol::PREDICATE : Symbol::FUNCTION;
+
+	for (ConstantList::const_iterator it = constants.begin(); it != constants.end(); it++) {
+		Symbol::SortList args;
+		for (TokenList::const_iterator a = it->args.begin(); a != it->args.end(); a++) args.push_back(sort(*a));
+
+		Symbol* c = mProgram.symbols().symbol(text(it->name), args.size());
+		if (!c->declare(type, s, args)) {
+			error(it->name.loc, "'" + c->name() + "' has already been declared differently.");
+		}
+	}
+}
+
+// Declares some variables.
+void Parser::declareVariables(TokenList const& variables, Token const& sortName) {
+	Symbol const* s = sort(sortName);
+
+	for (TokenList::const_iterator it = variables.begin(); it != variables.end(); it++) {
+		Symbol* v = mProgram.symbols().symbol(text(*it));
+		if (!v->declare(Symbol::VARIABLE, s)) {
+			error(it->loc, "'" + v->name() + "' has already been declared differently.");
+		}
+	}
+}
+
+// Gets an application.
+Node const* Parser::apply(Token const& name, NodeList const* args) {
+	Symbol const* s = mProgram.symbols().symbol(text(name), (args) ? args->size() : 0);
+	return (args) ? nodes().apply(s, *args) : nodes().apply(s);
+}
+
+// Gets a variable.
+Node const* Parser::variable(Token const& name) {
+	return nodes().variable(mProgram.symbols().symbol(text(name)));
+}
+
+// Reads an integer.
+bool Parser::integer(Token const& token, bool negative, long& value) {
+	unsigned long limit = (unsigned long)std::numeric_limits<long>::max() + ((negative) ? 1 : 0);
+	unsigned long v = 0;
+
+	for (size_t i = 0; i < token.length; i++) {
+		unsigned long d = (unsigned long)(token.text[i] - '0');
+		if (v > (limit - d) / 10) {
+			error(token.loc, "The integer '" + text(token) + "' is out of range.");
+			value = 0;
+			return false;
+		}
+		v = v * 10 + d;
+	}
+
+	value = (negative) ? (long)(0 - v) : (long)v;
+	return true;
+}
+
+// Checks an atom.
+Node const* Parser::atom(Node const* term, Location const& loc) {
+	if (term->type() != Node::APPLY) {
+		error(loc, "Expected an atom.");
+		return nodes().truth(false);
+	}
+	return term;
+}
+
+// Adds a rule.
+void Parser::rule(Node const* head, NodeList const* body, bool choice) {
+	Node const* b;
+	if (!body || body->empty()) b = nodes().truth(true);
+	else if (body->size() == 1) b = body->front();
+	else b = nodes().make(Node::AND, *body);
+
+	mProgram.add(head, b, choice);
+}
+
+}
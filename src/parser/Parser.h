@@ -0,0 +1,193 @@
+#ifndef __H_PARSER__
+#define __H_PARSER__
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "elements/Program.h"
+#include "parser/Lexer.h"
+
+namespace utils { class CompoundFileSource; }
+
+namespace parser {
+
+/**
+ * @brief Builds a program from the grammar's actions.
+ * A single parser may read any number of files in sequence, or several parsers may each read
+ * their own files concurrently (see ParallelParser) and then be merged together in order.
+ * Errors are collected rather than printed so that concurrent parsers don't interleave them.
+ */
+class Parser {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief An object (or range of integers) within an object declaration.
+	 */
+	struct ObjectSpec {
+		Token name;							///< The name of the object, if it isn't an integer.
+		bool integer;						///< Whether the object is a range of integers.
+		long lo;							///< The lowest integer in the range.
+		long hi;							///< The highest integer in the range.
+	};
+
+	/**
+	 * @brief A constant along with its argument sorts within a constant declaration.
+	 */
+	struct ConstantSpec {
+		Token name;							///< The name of the constant.
+		std::vector<Token> args;			///< The names of the sorts of its arguments.
+	};
+
+	typedef std::vector<Token> TokenList;
+	typedef std::vector<ObjectSpec> ObjectList;
+	typedef std::vector<ConstantSpec> ConstantList;
+	typedef elements::NodeFactory::NodeList NodeList;
+	typedef std::vector<std::string> ErrorList;
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	elements::Program mProgram;				///< The program we're building.
+	ErrorList mErrors;						///< The errors we've encountered, in order.
+	std::list<std::string> mFiles;			///< The absolute name of every file we've been given to read, in order.
+	size_t mBytes;							///< The number of characters read from every file.
+	size_t mHits;							///< The number of file names which were resolved as they had been before.
+	size_t mMisses;							///< The number of file names which had to be searched for.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 */
+	inline Parser() : mBytes(0), mHits(0), mMisses(0) { /* Intentionally Left Blank */ }
+
+	/**
+	 * @brief Basic Destructor.
+	 * Does nothing.
+	 */
+	virtual inline ~Parser() { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Parses a single file (memory mapped) into the program.
+	 * @param file The file to parse.
+	 * @return True if successful, false if any errors were encountered.
+	 */
+	bool parse(std::string const& file);
+
+	/**
+	 * @brief Parses everything remaining in a source into the program.
+	 * @param source The source to read from.
+	 * @return True if successful, false if any errors were encountered.
+	 */
+	bool parse(utils::CompoundFileSource& source);
+
+	/**
+	 * @brief Merges the program and errors of another parser into this one.
+	 * @param other The parser to merge, which is left untouched.
+	 */
+	void merge(Parser& other);
+
+	/// Gets the program that has been built.
+	inline elements::Program& program()					{ return mProgram; }
+
+	/// Gets the factory for the program's nodes.
+	inline elements::NodeFactory& nodes()				{ return mProgram.nodes(); }
+
+	/// Gets the errors which have been encountered.
+	inline ErrorList const& errors() const				{ return mErrors; }
+
+	/// Gets the absolute name of every file we've been given to read, including those inserted while reading.
+	inline std::list<std::string> const& files() const	{ return mFiles; }
+
+	/// Gets the number of characters read from every file, including those of merged parsers.
+	inline size_t bytes() const							{ return mBytes; }
+
+	/// Gets the number of file names which were resolved as they had been before (see utils::CompoundFileSource::resolutionHits()).
+	inline size_t resolutionHits() const				{ return mHits; }
+
+	/// Gets the number of file names which had to be searched for (see utils::CompoundFileSource::resolutionMisses()).
+	inline size_t resolutionMisses() const				{ return mMisses; }
+
+	/// Determines whether any errors have been encountered.
+	inline bool failed() const							{ return mErrors.size() > 0; }
+
+	/***********************************************************************/
+	/* Grammar Actions */
+	/***********************************************************************/
+
+	/**
+	 * @brief Records an error at the provided location.
+	 */
+	void error(Location const& loc, std::string const& msg);
+
+	/// Declares a sort.
+	void declareSort(Token const& name);
+
+	/// Declares a list of objects of the provided sort.
+	void declareObjects(ObjectList const& objects, Token const& sort);
+
+	/// Declares a list of constants of the provided sort.
+	void declareConstants(ConstantList const& constants, Token const& sort);
+
+	/// Declares a list of variables ranging over the provided sort.
+	void declareVariables(TokenList const& variables, Token const& sort);
+
+	/**
+	 * @brief Gets an object or constant applied to its arguments.
+	 * @param name The name of the object or constant.
+	 * @param args The arguments, or NULL.
+	 */
+	elements::Node const* apply(Token const& name, NodeList const* args);
+
+	/// Gets a variable.
+	elements::Node const* variable(Token const& name);
+
+	/**
+	 * @brief Reads an integer literal.
+	 * @param token The literal.
+	 * @param negative Whether the literal was preceded by a minus sign.
+	 * @param value Set to the value of the literal.
+	 * @return True if successful, false if the literal was out of range (which has been reported).
+	 */
+	bool integer(Token const& token, bool negative, long& value);
+
+	/**
+	 * @brief Checks that a term may be used as an atom.
+	 * @return The atom, or the FALSE node if the term can't be used as an atom (which has been reported).
+	 */
+	elements::Node const* atom(elements::Node const* term, Location const& loc);
+
+	/**
+	 * @brief Adds a rule to the program.
+	 * @param head The head of the rule.
+	 * @param body The literals of the body, or NULL for a fact.
+	 * @param choice Whether the head is a choice.
+	 */
+	void rule(elements::Node const* head, NodeList const* body, bool choice);
+
+private:
+
+	/// Gets the text of a token.
+	inline static std::string text(Token const& token)	{ return std::string(token.text, token.length); }
+
+	/// Gets the sort with the provided name.
+	elements::Symbol* sort(Token const& name);
+
+};
+
+}
+
+#endif
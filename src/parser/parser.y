@@ -0,0 +1,291 @@
+/*
+ * The grammar for ASPMT programs.
+ *
+ * Tokens are provided by the hand written parser::Lexer, which is bridged to the
+ * grammar by yylex() below. Token types are the T_* constants declared here, or the
+ * character itself for single character punctuation.
+ *
+ * Generate with: bison -o parser.cpp --defines=parser.h parser.y
+ */
+
+%code requires {
+#include <string>
+#include "elements/Node.h"
+#include "parser/Lexer.h"
+#include "parser/Parser.h"
+
+#define YYLTYPE parser::Location
+#define YYLTYPE_IS_DECLARED 1
+#define YYLTYPE_IS_TRIVIAL 1
+}
+
+%code {
+
+/**
+ * @brief Bridges the lexer to the grammar.
+ */
+int yylex(YYSTYPE* lval, YYLTYPE* lloc, parser::Lexer& lexer);
+
+/**
+ * @brief Reports a syntax error.
+ */
+void yyerror(YYLTYPE* lloc, parser::Lexer& lexer, parser::Parser& unit, char const* msg);
+
+/**
+ * @brief Builds a comparison between two terms.
+ * @param op The token type of the comparison operator.
+ */
+elements::Node const* compare(parser::Parser& unit, int op, elements::Node const* a, elements::Node const* b);
+
+// Propagate the file along with the line and column information.
+#define YYLLOC_DEFAULT(Cur, Rhs, N)											\
+	do {																	\
+		if (N) {															\
+			(Cur).file = YYRHSLOC(Rhs, 1).file;								\
+			(Cur).first_line = YYRHSLOC(Rhs, 1).first_line;					\
+			(Cur).first_column = YYRHSLOC(Rhs, 1).first_column;				\
+			(Cur).last_line = YYRHSLOC(Rhs, N).last_line;					\
+			(Cur).last_column = YYRHSLOC(Rhs, N).last_column;				\
+		} else {															\
+			(Cur).file = YYRHSLOC(Rhs, 0).file;								\
+			(Cur).first_line = (Cur).last_line = YYRHSLOC(Rhs, 0).last_line;	\
+			(Cur).first_column = (Cur).last_column = YYRHSLOC(Rhs, 0).last_column;	\
+		}																	\
+	} while (0)
+}
+
+%define api.pure full
+%define parse.error verbose
+%locations
+%lex-param { parser::Lexer& lexer }
+%parse-param { parser::Lexer& lexer }
+%parse-param { parser::Parser& unit }
+
+%union {
+	parser::Token token;
+	long integer;
+	int relop;
+	elements::Node const* node;
+	struct {
+		elements::Node const* node;
+		bool choice;
+	} head;
+	parser::Parser::NodeList* nodes;
+	parser::Parser::TokenList* tokens;
+	parser::Parser::ObjectSpec object;
+	parser::Parser::ObjectList* objects;
+	parser::Parser::ConstantSpec* constant;
+	parser::Parser::ConstantList* constants;
+}
+
+%token <token> T_IDENTIFIER		"identifier"
+%token <token> T_VARIABLE		"variable"
+%token <token> T_INTEGER		"integer"
+
+%token T_ARROW					":-"
+%token T_DCOLON					"::"
+%token T_DDOT					".."
+%token T_EQ						"="
+%token T_NEQ					"!="
+%token T_LT						"<"
+%token T_LE						"<="
+%token T_GT						">"
+%token T_GE						">="
+
+%token T_NOT					"not"
+%token T_TRUE					"true"
+%token T_FALSE					"false"
+%token T_SORTS					"sorts"
+%token T_OBJECTS				"objects"
+%token T_CONSTANTS				"constants"
+%token T_VARIABLES				"variables"
+
+%type <integer>		integer
+%type <relop>		relop
+%type <node>		term literal
+%type <head>		head
+%type <nodes>		terms body
+%type <tokens>		sort_args variable_list
+%type <object>		object
+%type <objects>		object_list
+%type <constant>	constant_sig
+%type <constants>	constant_list
+
+%destructor { delete $$; } <nodes> <tokens> <objects> <constant> <constants>
+
+%left '+' '-'
+%left '*' '/'
+%precedence UMINUS
+
+%%
+
+program
+	: %empty
+	| program statement
+	;
+
+statement
+	: rule '.'
+	| declaration '.'
+	| error '.'
+	;
+
+/* Declarations */
+
+declaration
+	: T_ARROW T_SORTS sort_list
+	| T_ARROW T_OBJECTS object_decls
+	| T_ARROW T_CONSTANTS constant_decls
+	| T_ARROW T_VARIABLES variable_decls
+	;
+
+sort_list
+	: T_IDENTIFIER								{ unit.declareSort($1); }
+	| sort_list ';' T_IDENTIFIER				{ unit.declareSort($3); }
+	;
+
+object_decls
+	: object_decl
+	| object_decls ';' object_decl
+	;
+
+object_decl
+	: object_list T_DCOLON T_IDENTIFIER			{ unit.declareObjects(*$1, $3); delete $1; }
+	;
+
+object_list
+	: object									{ $$ = new parser::Parser::ObjectList(1, $1); }
+	| object_list ',' object					{ ($$ = $1)->push_back($3); }
+	;
+
+object
+	: T_IDENTIFIER								{ $$.name = $1; $$.integer = false; $$.lo = $$.hi = 0; }
+	| integer									{ $$.name.type = 0; $$.name.text = NULL; $$.name.length = 0; $$.name.loc = @$; $$.integer = true; $$.lo = $$.hi = $1; }
+	| integer T_DDOT integer					{ $$.name.type = 0; $$.name.text = NULL; $$.name.length = 0; $$.name.loc = @$; $$.integer = true; $$.lo = $1; $$.hi = $3; }
+	;
+
+integer
+	: T_INTEGER									{ unit.integer($1, false, $$); }
+	| '-' T_INTEGER								{ unit.integer($2, true, $$); }
+	;
+
+constant_decls
+	: constant_decl
+	| constant_decls ';' constant_decl
+	;
+
+constant_decl
+	: constant_list T_DCOLON T_IDENTIFIER		{ unit.declareConstants(*$1, $3); delete $1; }
+	;
+
+constant_list
+	: constant_sig								{ $$ = new parser::Parser::ConstantList(1, *$1); delete $1; }
+	| constant_list ',' constant_sig			{ ($$ = $1)->push_back(*$3); delete $3; }
+	;
+
+constant_sig
+	: T_IDENTIFIER								{ $$ = new parser::Parser::ConstantSpec(); $$->name = $1; }
+	| T_IDENTIFIER '(' sort_args ')'			{ $$ = new parser::Parser::ConstantSpec(); $$->name = $1; $$->args.swap(*$3); delete $3; }
+	;
+
+sort_args
+	: T_IDENTIFIER								{ $$ = new parser::Parser::TokenList(1, $1); }
+	| sort_args ',' T_IDENTIFIER				{ ($$ = $1)->push_back($3); }
+	;
+
+variable_decls
+	: variable_decl
+	| variable_decls ';' variable_decl
+	;
+
+variable_decl
+	: variable_list T_DCOLON T_IDENTIFIER		{ unit.declareVariables(*$1, $3); delete $1; }
+	;
+
+variable_list
+	: T_VARIABLE								{ $$ = new parser::Parser::TokenList(1, $1); }
+	| variable_list ',' T_VARIABLE				{ ($$ = $1)->push_back($3); }
+	;
+
+/* Rules */
+
+rule
+	: head										{ unit.rule($1.node, NULL, $1.choice); }
+	| head T_ARROW body							{ unit.rule($1.node, $3, $1.choice); delete $3; }
+	| T_ARROW body								{ unit.rule(unit.nodes().truth(false), $2, false); delete $2; }
+	;
+
+head
+	: term										{ $$.node = unit.atom($1, @1); $$.choice = false; }
+	| term T_EQ term							{ $$.node = unit.nodes().make(elements::Node::EQ, $1, $3); $$.choice = false; }
+	| '{' term '}'								{ $$.node = unit.atom($2, @2); $$.choice = true; }
+	| '{' term T_EQ term '}'					{ $$.node = unit.nodes().make(elements::Node::EQ, $2, $4); $$.choice = true; }
+	| T_FALSE									{ $$.node = unit.nodes().truth(false); $$.choice = false; }
+	;
+
+body
+	: literal									{ $$ = new parser::Parser::NodeList(1, $1); }
+	| body ',' literal							{ ($$ = $1)->push_back($3); }
+	;
+
+literal
+	: term										{ $$ = unit.atom($1, @1); }
+	| term relop term							{ $$ = compare(unit, $2, $1, $3); }
+	| T_NOT term								{ $$ = unit.nodes().make(elements::Node::NOT, unit.atom($2, @2)); }
+	| T_NOT term relop term						{ $$ = unit.nodes().make(elements::Node::NOT, compare(unit, $3, $2, $4)); }
+	| T_TRUE									{ $$ = unit.nodes().truth(true); }
+	| T_FALSE									{ $$ = unit.nodes().truth(false); }
+	;
+
+relop
+	: T_EQ										{ $$ = T_EQ; }
+	| T_NEQ										{ $$ = T_NEQ; }
+	| T_LT										{ $$ = T_LT; }
+	| T_LE										{ $$ = T_LE; }
+	| T_GT										{ $$ = T_GT; }
+	| T_GE										{ $$ = T_GE; }
+	;
+
+term
+	: T_IDENTIFIER								{ $$ = unit.apply($1, NULL); }
+	| T_IDENTIFIER '(' terms ')'				{ $$ = unit.apply($1, $3); delete $3; }
+	| T_VARIABLE								{ $$ = unit.variable($1); }
+	| T_INTEGER									{ long v; unit.integer($1, false, v); $$ = unit.nodes().integer(v); }
+	| term '+' term								{ $$ = unit.nodes().make(elements::Node::PLUS, $1, $3); }
+	| term '-' term								{ $$ = unit.nodes().make(elements::Node::MINUS, $1, $3); }
+	| term '*' term								{ $$ = unit.nodes().make(elements::Node::TIMES, $1, $3); }
+	| term '/' term								{ $$ = unit.nodes().make(elements::Node::DIVIDE, $1, $3); }
+	| '-' term %prec UMINUS						{ $$ = ($2->type() == elements::Node::INTEGER) ? unit.nodes().integer(-$2->value()) : unit.nodes().make(elements::Node::NEGATE, $2); }
+	| '(' term ')'								{ $$ = $2; }
+	;
+
+terms
+	: term										{ $$ = new parser::Parser::NodeList(1, $1); }
+	| terms ',' term							{ ($$ = $1)->push_back($3); }
+	;
+
+%%
+
+// Bridges the lexer to the grammar.
+int yylex(YYSTYPE* lval, YYLTYPE* lloc, parser::Lexer& lexer) {
+	int type = lexer.next(lval->token);
+	*lloc = lval->token.loc;
+	return type;
+}
+
+// Reports a syntax error.
+void yyerror(YYLTYPE* lloc, parser::Lexer& lexer, parser::Parser& unit, char const* msg) {
+	unit.error(*lloc, msg);
+}
+
+// Builds a comparison.
+elements::Node const* compare(parser::Parser& unit, int op, elements::Node const* a, elements::Node const* b) {
+	switch (op) {
+	case T_NEQ:		return unit.nodes().make(elements::Node::NOT, unit.nodes().make(elements::Node::EQ, a, b));
+	case T_LT:		return unit.nodes().make(elements::Node::LT, a, b);
+	case T_LE:		return unit.nodes().make(elements::Node::LE, a, b);
+	case T_GT:		return unit.nodes().make(elements::Node::GT, a, b);
+	case T_GE:		return unit.nodes().make(elements::Node::GE, a, b);
+	default:		return unit.nodes().make(elements::Node::EQ, a, b);
+	}
+}
@@ -0,0 +1,169 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+
+#include <boost/cstdint.hpp>
+
+#include "elements/Binary.h"
+
+/**
+ * @file BinaryTest.cpp
+ * @brief Checks that binary programs which refer to the wrong kind of symbol are rejected rather than read.
+ * A small program is written out, and then each case patches a single index within the file before reading it.
+ * Usage: BinaryTest
+ */
+
+using namespace elements;
+
+/// The index used in place of a missing symbol or object (see Binary.cpp).
+#define NONE 0xFFFFFFFFu
+
+/// The sections of a file, in the order the header lists them.
+enum SectionId { SYMBOLS, ELEMENTS, SORTS, NODES, ARGS, RULES, FORMULAS, NAMES, _SECTIONS };
+
+/// The layout of the start of a file.
+struct Header {
+	char magic[8];
+	boost::uint32_t version;
+	boost::uint32_t kind;
+	struct { boost::uint64_t offset, count; } sections[_SECTIONS];
+};
+
+/// The layout of a symbol.
+struct SymbolRecord {
+	boost::uint32_t name, length, arity, sort, args, nargs, domain, ndomain;
+	boost::uint8_t type, declared, pad[6];
+};
+
+/// The layout of an element of a domain.
+struct ElementRecord {
+	boost::int64_t value;
+	boost::uint32_t object, pad;
+};
+
+/// The layout of a node.
+struct NodeRecord {
+	boost::int64_t value;
+	boost::uint32_t symbol, args, arity;
+	boost::uint8_t type, pad[3];
+};
+
+/**
+ * @brief A binary file held in memory, aligned so that it can be read in place.
+ */
+class File {
+	std::vector<boost::uint64_t> mData;	///< The contents of the file.
+	size_t mSize;						///< The size of the file in bytes.
+
+public:
+	/// Copies the written file.
+	File(std::string const& data) : mData(data.size() / 8 + 1), mSize(data.size()) { memcpy(&mData[0], data.data(), data.size()); }
+
+	/// Gets the contents of the file.
+	char* data() { return (char*)&mData[0]; }
+
+	/// Gets the i'th record of a section.
+	template <typename T>
+	T& record(SectionId section, size_t i) { return ((T*)(data() + ((Header*)data())->sections[section].offset))[i]; }
+
+	/// Gets the number of records in a section.
+	size_t count(SectionId section) { return (size_t)((Header*)data())->sections[section].count; }
+
+	/// Finds the first node of a kind.
+	NodeRecord& node(Node::Type type) {
+		for (size_t i = 0; ; i++) {
+			if (record<NodeRecord>(NODES, i).type == type) return record<NodeRecord>(NODES, i);
+		}
+	}
+
+	/// Finds the first element which is an object.
+	ElementRecord& object() {
+		for (size_t i = 0; ; i++) {
+			if (record<ElementRecord>(ELEMENTS, i).object != NONE) return record<ElementRecord>(ELEMENTS, i);
+		}
+	}
+
+	/// Reads the file into a new program.
+	bool read() {
+		Program program;
+		return Binary::read(data(), mSize, program);
+	}
+};
+
+/// The number of cases which failed.
+int gFailed = 0;
+
+/// Reports the outcome of a case.
+void expect(char const* name, bool ok) {
+	std::cout << ((ok) ? "ok      " : "FAILED  ") << name << "\n";
+	if (!ok) gFailed++;
+}
+
+int main() {
+	// :- sorts s. :- objects a, 1 :: s. :- constants q(s) :: boolean. :- variables X :: s.
+	// q(a). <- forall X q(X).
+	Program program;
+	SymbolTable& symbols = program.symbols();
+	Symbol* s = symbols.sort("s");
+	s->declare(Symbol::SORT, NULL);
+	Symbol* a = symbols.symbol("a");
+	a->declare(Symbol::OBJECT, s);
+	s->addElement(a);
+	s->addElement(NULL, 1);
+	Symbol* q = symbols.symbol("q", 1);
+	q->declare(Symbol::PREDICATE, symbols.boolean(), Symbol::SortList(1, s));
+	Symbol* x = symbols.symbol("X");
+	x->declare(Symbol::VARIABLE, s);
+
+	NodeFactory& nodes = program.nodes();
+	program.add(nodes.apply(q, NodeFactory::NodeList(1, nodes.apply(a))), nodes.truth(true));
+	program.add(nodes.make(Node::NOT, nodes.quantify(Node::FORALL, x, nodes.apply(q, NodeFactory::NodeList(1, nodes.variable(x))))));
+
+	std::ostringstream out;
+	Binary::write(out, Binary::GROUND, symbols, program);
+	std::string written = out.str();
+
+	{
+		File f(written);
+		expect("unpatched file is read", f.read());
+	}
+	{
+		File f(written);
+		f.node(Node::APPLY).symbol = (boost::uint32_t)s->id();
+		expect("application of a sort is rejected", !f.read());
+	}
+	{
+		File f(written);
+		f.node(Node::APPLY).symbol = (boost::uint32_t)x->id();
+		expect("application of a variable is rejected", !f.read());
+	}
+	{
+		File f(written);
+		f.node(Node::VARIABLE).symbol = (boost::uint32_t)a->id();
+		expect("variable naming an object is rejected", !f.read());
+	}
+	{
+		File f(written);
+		f.node(Node::FORALL).symbol = (boost::uint32_t)q->id();
+		expect("quantifier over a predicate is rejected", !f.read());
+	}
+	{
+		File f(written);
+		f.record<SymbolRecord>(SYMBOLS, q->id()).sort = (boost::uint32_t)a->id();
+		expect("symbol whose sort is an object is rejected", !f.read());
+	}
+	{
+		File f(written);
+		f.record<boost::uint32_t>(SORTS, f.record<SymbolRecord>(SYMBOLS, q->id()).args) = (boost::uint32_t)q->id();
+		expect("argument sort which is a predicate is rejected", !f.read());
+	}
+	{
+		File f(written);
+		f.object().object = (boost::uint32_t)s->id();
+		expect("domain element which is a sort is rejected", !f.read());
+	}
+
+	return (gFailed) ? 1 : 0;
+}
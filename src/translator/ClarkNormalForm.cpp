@@ -0,0 +1,106 @@
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+#include "translator/ClarkNormalForm.h"
+
+using namespace elements;
+
+namespace translator {
+
+namespace {
+
+// Existentially quantifies the free variables of a formula, other than those provided.
+Node const* close(NodeFactory& nodes, Node const* formula, Symbol::SymbolList const& exclude) {
+	Symbol::SymbolList vars;
+	freeVariables(formula, vars);
+
+	for (Symbol::SymbolList::reverse_iterator it = vars.rbegin(); it != vars.rend(); it++) {
+		if (std::find(exclude.begin(), exclude.end(), *it) != exclude.end()) continue;
+		formula = nodes.quantify(Node::EXISTS, *it, formula);
+	}
+	return formula;
+}
+
+// Gets a canonical head variable.
+Symbol const* canonical(SymbolTable& symbols, char const* prefix, size_t index, Symbol const* sort) {
+	std::ostringstream name;
+	name << prefix << index << "#" << sort->name();
+
+	Symbol* v = symbols.symbol(name.str());
+	v->declare(Symbol::VARIABLE, sort);
+	return v;
+}
+
+}
+
+// Rewrites a program.
+Theory* ClarkNormalForm::translate(Theory const& program) {
+	Theory* out = new Theory();
+	NodeFactory& nodes = out->nodes();
+	NodeFactory::ImportMap imported;
+
+	for (Theory::RuleList::const_iterator r = program.rules().begin(); r != program.rules().end(); r++) {
+		Node const* h = nodes.import(r->head, imported);
+		Node const* body = nodes.import(r->body, imported);
+
+		Node const* app = NULL;
+		Node const* value = NULL;
+		if (h->type() == Node::APPLY) {
+			app = h;
+		} else if (h->type() == Node::EQ) {
+			app = h->arg(0);
+			value = h->arg(1);
+		}
+
+		if (!app) {
+			// Constraints only need their variables quantified.
+			out->add(h, close(nodes, body, Symbol::SymbolList()), r->choice);
+			continue;
+		}
+
+		Symbol::SymbolList vars;
+		headVariables(mSymbols, app->symbol(), vars);
+
+		// Rename variable arguments where we can and equate the rest.
+		NodeFactory::SubstitutionMap rename;
+		NodeFactory::NodeList conj(1, body);
+		for (size_t i = 0; i < vars.size(); i++) {
+			Node const* t = (i < app->arity()) ? app->arg(i) : value;
+			Node const* x = nodes.variable(vars[i]);
+			if (t->type() == Node::VARIABLE && t->symbol()->sort() == vars[i]->sort() && !rename.count(t->symbol())) {
+				rename[t->symbol()] = x;
+			} else {
+				conj.push_back(nodes.make(Node::EQ, x, t));
+			}
+		}
+
+		NodeFactory::ImportMap memo;
+		body = nodes.substitute(nodes.junction(Node::AND, conj), rename, memo);
+		out->add(head(nodes, app->symbol(), vars), close(nodes, body, vars), r->choice);
+	}
+
+	return out;
+}
+
+// Gets the head variables of a constant.
+void ClarkNormalForm::headVariables(SymbolTable& symbols, Symbol const* constant, Symbol::SymbolList& out) {
+	out.clear();
+	for (size_t i = 0; i < constant->args().size(); i++) {
+		out.push_back(canonical(symbols, "X", i + 1, constant->args()[i]));
+	}
+	if (constant->type() == Symbol::FUNCTION) {
+		out.push_back(canonical(symbols, "V", 1, constant->sort()));
+	}
+}
+
+// Gets the canonical head of a constant.
+Node const* ClarkNormalForm::head(NodeFactory& nodes, Symbol const* constant, Symbol::SymbolList const& vars) {
+	NodeFactory::NodeList args;
+	for (size_t i = 0; i < constant->args().size(); i++) args.push_back(nodes.variable(vars[i]));
+
+	Node const* app = nodes.apply(constant, args);
+	return (constant->type() == Symbol::FUNCTION) ? nodes.make(Node::EQ, app, nodes.variable(vars.back())) : app;
+}
+
+}
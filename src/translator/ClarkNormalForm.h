@@ -0,0 +1,71 @@
+#ifndef __H_CLARK_NORMAL_FORM__
+#define __H_CLARK_NORMAL_FORM__
+
+#include "elements/Symbol.h"
+#include "elements/Node.h"
+#include "elements/Program.h"
+
+namespace translator {
+
+/**
+ * @brief Rewrites each rule of a program into Clark normal form.
+ * The head of every rule becomes the constant applied to its canonical head variables (see
+ * headVariables()), either p(X1, ..., Xn) or f(X1, ..., Xn) = V, and the body becomes
+ * exists Y (B & X1 = t1 & ... ), where Y are the remaining variables of the rule.
+ * Where an argument of the head is a variable of the right sort it's renamed instead.
+ * Constraints keep FALSE as their head.
+ */
+class ClarkNormalForm {
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	elements::SymbolTable& mSymbols;			///< The symbols of the program.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param symbols The symbols of the program, which the head variables are added to.
+	 */
+	inline ClarkNormalForm(elements::SymbolTable& symbols) : mSymbols(symbols) { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Rewrites a program into Clark normal form.
+	 * @param program The rules to rewrite, which must have been checked.
+	 * @return A new theory containing the rewritten rules, in the same order. The caller takes ownership.
+	 */
+	elements::Theory* translate(elements::Theory const& program);
+
+	/**
+	 * @brief Gets the canonical variables for the arguments (and value) of a constant.
+	 * The same variables are returned for a given constant every time, and every constant with
+	 * the same argument sorts shares them. Creates the variables if necessary, so this isn't
+	 * safe to call while the symbol table is being read from another thread.
+	 * @param symbols The table to find the variables in.
+	 * @param constant The constant.
+	 * @param out Set to a variable for each argument followed by one for the value, if the constant is a function.
+	 */
+	static void headVariables(elements::SymbolTable& symbols, elements::Symbol const* constant, elements::Symbol::SymbolList& out);
+
+	/**
+	 * @brief Gets the canonical head of a constant: p(X1, ..., Xn) or f(X1, ..., Xn) = V.
+	 * @param nodes The factory to build the head in.
+	 * @param constant The constant.
+	 * @param vars The constant's head variables.
+	 */
+	static elements::Node const* head(elements::NodeFactory& nodes, elements::Symbol const* constant, elements::Symbol::SymbolList const& vars);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include <vector>
+
+#include <boost/bind/bind.hpp>
+
+#include "utilities/ThreadPool.h"
+#include "translator/ClarkNormalForm.h"
+#include "translator/Completion.h"
+
+using namespace elements;
+
+/// The number of chunks to split the constants into per worker thread, to keep the workers evenly loaded.
+#define CHUNKS_PER_THREAD 4
+
+namespace translator {
+
+// Completes a range of constants.
+void Completion::Chunk::run() {
+	NodeFactory::ImportMap memo;
+	for (size_t c = begin; c < end; c++) {
+		Node const* f = owner->complete(c, *in, out.nodes(), memo);
+		if (!f) continue;
+		out.add(f);
+		sources.push_back(owner->mConstants[c]);
+	}
+}
+
+// Computes the completion.
+Theory* Completion::translate(Theory const& cnf) {
+	build(cnf);
+
+	// Split the constants between the workers...
+	size_t threads = utils::ThreadPool::threads(mThreads);
+	size_t n = (threads > 1) ? threads * CHUNKS_PER_THREAD : 1;
+	if (n > mConstants.size()) n = mConstants.size();
+
+	std::vector<Chunk*> chunks;
+	for (size_t i = 0; i < n; i++) {
+		Chunk* chunk = new Chunk();
+		chunk->owner = this;
+		chunk->in = &cnf;
+		chunk->begin = mConstants.size() * i / n;
+		chunk->end = mConstants.size() * (i + 1) / n;
+		chunks.push_back(chunk);
+	}
+
+	if (threads <= 1 || n <= 1) {
+		for (size_t i = 0; i < n; i++) chunks[i]->run();
+	} else {
+		utils::ThreadPool pool((threads < n) ? threads : n);
+		for (size_t i = 0; i < n; i++) pool.post(boost::bind(&Chunk::run, chunks[i]));
+		pool.wait();
+	}
+
+	// ... and merge their results in order.
+	Theory* out = new Theory();
+	for (size_t i = 0; i < n; i++) {
+		out->merge(chunks[i]->out);
+		mSources.insert(mSources.end(), chunks[i]->sources.begin(), chunks[i]->sources.end());
+		delete chunks[i];
+	}
+
+	NodeFactory::ImportMap memo;
+	for (std::vector<size_t>::const_iterator it = mConstraints.begin(); it != mConstraints.end(); it++) {
+		out->add(out->nodes().make(Node::NOT, out->nodes().import(cnf.rules()[*it].body, memo)));
+		mSources.push_back(NULL);
+	}
+	return out;
+}
+
+// Indexes the rules.
+void Completion::build(Theory const& cnf) {
+	mConstants.clear();
+	mVars.clear();
+	mIndex.clear();
+	mConstraints.clear();
+	mSources.clear();
+
+	// Creating the head variables modifies the symbol table, so it has to happen up front.
+	if (mOnly) {
+		mConstants = *mOnly;
+	} else {
+		size_t symbols = mSymbols.size();
+		for (size_t i = 0; i < symbols; i++) {
+			if (mSymbols[i]->constant()) mConstants.push_back(mSymbols[i]);
+		}
+	}
+	for (Symbol::SymbolList::const_iterator it = mConstants.begin(); it != mConstants.end(); it++) {
+		mVars.push_back(Symbol::SymbolList());
+		ClarkNormalForm::headVariables(mSymbols, *it, mVars.back());
+	}
+
+	mIndex.resize(mSymbols.size());
+	for (size_t i = 0; i < cnf.rules().size(); i++) {
+		Node const* h = cnf.rules()[i].head;
+		if (h->type() == Node::EQ) h = h->arg(0);
+
+		if (h->type() == Node::APPLY) mIndex[h->symbol()->id()].push_back(i);
+		else mConstraints.push_back(i);
+	}
+}
+
+// Completes a single constant.
+Node const* Completion::complete(size_t c, Theory const& in, NodeFactory& nodes, NodeFactory::ImportMap& memo) const {
+	Symbol const* s = mConstants[c];
+	Symbol::SymbolList const& vars = mVars[c];
+	std::vector<size_t> const& rules = mIndex[s->id()];
+
+	Node const* h = ClarkNormalForm::head(nodes, s, vars);
+
+	NodeFactory::NodeList bodies;
+	bool open = false;
+	for (std::vector<size_t>::const_iterator it = rules.begin(); it != rules.end(); it++) {
+		Rule const& r = in.rules()[*it];
+		Node const* b = nodes.import(r.body, memo);
+
+		if (r.choice) {
+			// c <-> (... | B & c) is c -> (... | B) when B is true.
+			if (b->type() == Node::TRUE) {
+				open = true;
+				continue;
+			}
+			b = nodes.make(Node::AND, b, h);
+		}
+		bodies.push_back(b);
+	}
+
+	Node const* f;
+	Node const* d = nodes.junction(Node::OR, bodies);
+	if (open) {
+		if (bodies.empty()) return NULL;
+		f = nodes.make(Node::IMPLIES, d, h);
+	} else if (d->type() == Node::FALSE) {
+		f = nodes.make(Node::NOT, h);
+	} else if (d->type() == Node::TRUE) {
+		f = h;
+	} else {
+		f = nodes.make(Node::IFF, h, d);
+	}
+
+	for (Symbol::SymbolList::const_reverse_iterator it = vars.rbegin(); it != vars.rend(); it++) {
+		f = nodes.quantify(Node::FORALL, *it, f);
+	}
+	return f;
+}
+
+}
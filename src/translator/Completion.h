@@ -0,0 +1,129 @@
+#ifndef __H_COMPLETION__
+#define __H_COMPLETION__
+
+#include <vector>
+
+#include "elements/Symbol.h"
+#include "elements/Node.h"
+#include "elements/Program.h"
+
+namespace translator {
+
+/**
+ * @brief Computes the completion of a program in Clark normal form.
+ * For each predicate or function constant c with rules c <- B1, ..., c <- Bn this produces
+ * forall X (c <-> B1 | ... | Bn). A choice rule {c} <- B contributes the disjunct B & c, so a
+ * constant with an unconditional choice rule only has its other rules as sufficient conditions.
+ * Each constraint false <- B produces not B.
+ *
+ * The rules are indexed by the constant in their head in a single pass, and the completion of each
+ * constant is then computed independently on a pool of worker threads. Workers build their formulas
+ * in their own theories, which are merged in order of the constants' ids, so the result doesn't
+ * depend on the number of threads or on scheduling.
+ */
+class Completion {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief The indices of the rules whose head mentions each constant, indexed by symbol id.
+	 */
+	typedef std::vector<std::vector<size_t> > RuleIndex;
+
+private:
+	/***********************************************************************/
+	/* Private Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief A contiguous range of constants to complete on a single worker.
+	 */
+	struct Chunk {
+		Completion const* owner;				///< The completion being computed.
+		elements::Theory const* in;				///< The program in Clark normal form.
+		size_t begin;							///< The first constant to complete.
+		size_t end;								///< One past the last constant to complete.
+		elements::Theory out;					///< The formulas produced for the constants.
+		elements::Symbol::SymbolList sources;	///< The constant each formula completes.
+
+		/// Completes each of the constants in the range.
+		void run();
+	};
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	elements::SymbolTable& mSymbols;				///< The symbols of the program.
+	size_t mThreads;								///< The number of worker threads to use, or 0 for one per hardware thread.
+	elements::Symbol::SymbolList const* mOnly;		///< The only constants to complete, or NULL to complete every constant.
+
+	elements::Symbol::SymbolList mConstants;		///< The constants to complete, ordered by id.
+	std::vector<elements::Symbol::SymbolList> mVars;	///< The head variables of each constant.
+	RuleIndex mIndex;								///< The rules for each constant.
+	std::vector<size_t> mConstraints;				///< The indices of the constraints.
+	elements::Symbol::SymbolList mSources;			///< The constant each formula of the result completes, or NULL for constraints.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param symbols The symbols of the program.
+	 * @param threads The number of worker threads to use, or 0 for one per hardware thread.
+	 * @param only The only constants to complete, ordered by id, or NULL to complete every constant.
+	 * Constants which aren't completed must not appear in the head of any rule. Should outlive the completion.
+	 */
+	inline Completion(elements::SymbolTable& symbols, size_t threads = 0, elements::Symbol::SymbolList const* only = NULL)
+		: mSymbols(symbols), mThreads(threads), mOnly(only) { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Computes the completion of a program.
+	 * @param cnf The program, which must be in Clark normal form.
+	 * @return A new theory containing the completion's formulas. The caller takes ownership.
+	 */
+	elements::Theory* translate(elements::Theory const& cnf);
+
+	/// Gets the index built by the last call to translate().
+	inline RuleIndex const& index() const				{ return mIndex; }
+
+	/// Gets the indices of the constraints among the rules given to the last call to translate(), in the order their formulas were produced.
+	inline std::vector<size_t> const& constraints() const	{ return mConstraints; }
+
+	/**
+	 * @brief Gets where each formula produced by the last call to translate() came from.
+	 * @return For each formula, the constant it completes, or NULL if it's the formula of a constraint (see constraints()).
+	 */
+	inline elements::Symbol::SymbolList const& sources() const	{ return mSources; }
+
+private:
+
+	/**
+	 * @brief Builds the index of rules by head constant.
+	 * @param cnf The program, which must be in Clark normal form.
+	 */
+	void build(elements::Theory const& cnf);
+
+	/**
+	 * @brief Computes the completion of a single constant.
+	 * @param c The position of the constant within mConstants.
+	 * @param in The program in Clark normal form.
+	 * @param nodes The factory to build the formula in.
+	 * @param memo The nodes of the program which have already been imported into the factory.
+	 * @return The formula, or NULL if the constant's completion is trivially true.
+	 */
+	elements::Node const* complete(size_t c, elements::Theory const& in, elements::NodeFactory& nodes, elements::NodeFactory::ImportMap& memo) const;
+
+};
+
+}
+
+#endif
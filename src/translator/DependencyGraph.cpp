@@ -0,0 +1,179 @@
+#include <vector>
+#include <utility>
+
+#include "translator/DependencyGraph.h"
+
+using namespace elements;
+
+namespace translator {
+
+// The vertex which doesn't exist.
+DependencyGraph::Vertex const DependencyGraph::NONE;
+
+namespace {
+
+// A vertex being visited by the search, along with the next of its successors to visit.
+struct Frame {
+	DependencyGraph::Vertex vertex;
+	size_t next;
+};
+
+}
+
+// Constructor
+DependencyGraph::DependencyGraph(SymbolTable const& symbols)
+	: mVertices(symbols.size(), NONE), mRules(0) {
+	for (size_t i = 0; i < symbols.size(); i++) {
+		if (!symbols[i]->constant()) continue;
+		mVertices[i] = (Vertex)mConstants.size();
+		mConstants.push_back(symbols[i]);
+	}
+	mSeen.resize(mConstants.size(), 0);
+	mLoops.resize(mConstants.size(), false);
+}
+
+// Adds a rule.
+void DependencyGraph::add(Rule const& rule) {
+	Node const* h = rule.head;
+	Node const* value = NULL;
+	if (h->type() == Node::EQ) {
+		value = h->arg(1);
+		h = h->arg(0);
+	}
+	if (h->type() != Node::APPLY) return;
+
+	Vertex head = vertex(h->symbol());
+	if (head == NONE) return;
+
+	// Rules are numbered from 1, since 0 marks vertices which haven't been seen in any rule.
+	mRules++;
+	for (size_t i = 0; i < h->arity(); i++) depend(head, h->arg(i));
+	if (value) depend(head, value);
+	depend(head, rule.body);
+}
+
+// Adds every rule in a theory.
+void DependencyGraph::add(Theory const& theory) {
+	for (Theory::RuleList::const_iterator it = theory.rules().begin(); it != theory.rules().end(); it++) add(*it);
+}
+
+// Adds the positive dependencies within a node.
+void DependencyGraph::depend(Vertex head, Node const* node) {
+	switch (node->type()) {
+	case Node::NOT:
+	case Node::IFF:
+		// Nothing within a negation or an equivalence occurs positively.
+		return;
+
+	case Node::IMPLIES:
+		depend(head, node->arg(1));
+		return;
+
+	case Node::APPLY:
+	{
+		Vertex v = vertex(node->symbol());
+		if (v != NONE && mSeen[v] != mRules) {
+			mSeen[v] = mRules;
+			mEdges.push_back(Edge(head, v));
+			if (v == head) mLoops[v] = true;
+		}
+		break;
+	}
+
+	default:
+		break;
+	}
+
+	for (size_t i = 0; i < node->arity(); i++) depend(head, node->arg(i));
+}
+
+// Builds the adjacency and finds the components.
+void DependencyGraph::analyze() {
+	size_t n = mConstants.size();
+
+	// Count the successors of each vertex and then place them, which keeps the order they were added in.
+	mOffsets.assign(n + 1, 0);
+	for (std::vector<Edge>::const_iterator it = mEdges.begin(); it != mEdges.end(); it++) mOffsets[it->first + 1]++;
+	for (size_t v = 0; v < n; v++) mOffsets[v + 1] += mOffsets[v];
+
+	std::vector<size_t> pos(mOffsets.begin(), mOffsets.end() - 1);
+	mTargets.resize(mEdges.size());
+	for (std::vector<Edge>::const_iterator it = mEdges.begin(); it != mEdges.end(); it++) mTargets[pos[it->first]++] = it->second;
+
+	tarjan();
+}
+
+// Finds the components.
+void DependencyGraph::tarjan() {
+	size_t n = mConstants.size();
+	std::vector<Vertex> index(n, NONE);
+	std::vector<Vertex> low(n, NONE);
+	std::vector<bool> stacked(n, false);
+	std::vector<Vertex> stack;
+	std::vector<Frame> frames;
+	Vertex next = 0;
+
+	mComponent.assign(n, NONE);
+	mStarts.assign(1, 0);
+	mMembers.clear();
+	mTight.clear();
+
+	for (Vertex root = 0; root < n; root++) {
+		if (index[root] != NONE) continue;
+
+		Frame f = { root, mOffsets[root] };
+		frames.push_back(f);
+		index[root] = low[root] = next++;
+		stack.push_back(root);
+		stacked[root] = true;
+
+		while (!frames.empty()) {
+			Frame& top = frames.back();
+			Vertex v = top.vertex;
+
+			// Visit the next successor...
+			if (top.next < mOffsets[v + 1]) {
+				Vertex w = mTargets[top.next++];
+				if (index[w] == NONE) {
+					Frame g = { w, mOffsets[w] };
+					frames.push_back(g);
+					index[w] = low[w] = next++;
+					stack.push_back(w);
+					stacked[w] = true;
+				} else if (stacked[w] && index[w] < low[v]) {
+					low[v] = index[w];
+				}
+				continue;
+			}
+
+			// ... or finish the vertex, which is the root of a component if nothing it reaches is further up the stack.
+			frames.pop_back();
+			if (!frames.empty() && low[v] < low[frames.back().vertex]) low[frames.back().vertex] = low[v];
+			if (low[v] != index[v]) continue;
+
+			size_t c = mTight.size();
+			size_t start = mMembers.size();
+			Vertex w;
+			do {
+				w = stack.back();
+				stack.pop_back();
+				stacked[w] = false;
+				mComponent[w] = (Vertex)c;
+				mMembers.push_back(w);
+			} while (w != v);
+
+			mStarts.push_back(mMembers.size());
+			mTight.push_back(mMembers.size() - start == 1 && !mLoops[v]);
+		}
+	}
+}
+
+// Determines whether every component is tight.
+bool DependencyGraph::tight() const {
+	for (size_t c = 0; c < mTight.size(); c++) {
+		if (!mTight[c]) return false;
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,160 @@
+#ifndef __H_DEPENDENCY_GRAPH__
+#define __H_DEPENDENCY_GRAPH__
+
+#include <vector>
+#include <utility>
+
+#include <boost/cstdint.hpp>
+
+#include "elements/Symbol.h"
+#include "elements/Node.h"
+#include "elements/Program.h"
+
+namespace translator {
+
+/**
+ * @brief The positive dependency graph of a program and its strongly connected components.
+ * There is a vertex for each predicate and function constant, and an edge from the constant in the
+ * head of each rule to every constant occurring positively in its body (that is, outside the scope of
+ * any negation, the antecedent of an implication or an equivalence), or in the head's own arguments.
+ *
+ * Rules are added one at a time, after which analyze() packs the edges into a compressed sparse row
+ * adjacency and finds the components with an iterative version of Tarjan's algorithm, in time linear
+ * in the size of the graph. Components are numbered so that each comes after every component it
+ * depends on, which is the order they can be processed in independently of one another.
+ *
+ * Completion is only sound for tight programs, whose components are single constants which don't
+ * depend on themselves.
+ */
+class DependencyGraph {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	typedef boost::uint32_t Vertex;
+	typedef std::vector<Vertex>::const_iterator VertexIterator;
+
+private:
+	/***********************************************************************/
+	/* Private Types */
+	/***********************************************************************/
+
+	/// An edge from the constant in a head to a constant it depends on.
+	typedef std::pair<Vertex, Vertex> Edge;
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	elements::Symbol::SymbolList mConstants;	///< The constant each vertex stands for, ordered by id.
+	std::vector<Vertex> mVertices;			///< The vertex of each symbol, indexed by id, or NONE if it isn't a constant.
+	std::vector<Edge> mEdges;				///< The edges added so far, which analyze() packs into the adjacency.
+	std::vector<size_t> mSeen;				///< The last rule each vertex was found in, so that a rule adds each edge once.
+	std::vector<bool> mLoops;				///< Whether each vertex depends on itself directly.
+	size_t mRules;							///< The number of rules added so far.
+
+	std::vector<size_t> mOffsets;			///< Where the successors of each vertex start within mTargets, with one extra entry at the end.
+	std::vector<Vertex> mTargets;			///< The successors of every vertex, in order.
+
+	std::vector<Vertex> mComponent;			///< The component each vertex belongs to.
+	std::vector<size_t> mStarts;			///< Where the members of each component start within mMembers, with one extra entry at the end.
+	std::vector<Vertex> mMembers;			///< The members of every component, in order.
+	std::vector<bool> mTight;				///< Whether each component is tight.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param symbols The symbols of the program, whose constants become the vertices.
+	 */
+	DependencyGraph(elements::SymbolTable const& symbols);
+
+	/**
+	 * @brief Basic Destructor.
+	 * Does nothing.
+	 */
+	virtual inline ~DependencyGraph() { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/// A vertex which doesn't exist.
+	static Vertex const NONE = 0xFFFFFFFF;
+
+	/**
+	 * @brief Adds the edges of a rule. Constraints don't add any.
+	 * @param rule The rule to add.
+	 */
+	void add(elements::Rule const& rule);
+
+	/**
+	 * @brief Adds the edges of every rule in a theory.
+	 */
+	void add(elements::Theory const& theory);
+
+	/**
+	 * @brief Builds the adjacency from the edges added so far and finds the components.
+	 * Rules may be added afterwards, as long as analyze() is called again.
+	 */
+	void analyze();
+
+	/// Gets the number of vertices.
+	inline size_t vertices() const						{ return mConstants.size(); }
+
+	/// Gets the number of edges, once the graph has been analyzed.
+	inline size_t edges() const							{ return mTargets.size(); }
+
+	/// Gets the constant a vertex stands for.
+	inline elements::Symbol const* constant(Vertex v) const	{ return mConstants[v]; }
+
+	/// Gets the vertex of a constant, or NONE if it isn't one.
+	inline Vertex vertex(elements::Symbol const* s) const	{ return (s->id() < mVertices.size()) ? mVertices[s->id()] : NONE; }
+
+	/// Gets the first successor of a vertex.
+	inline VertexIterator beginSuccessors(Vertex v) const	{ return mTargets.begin() + mOffsets[v]; }
+
+	/// Gets the end of the successors of a vertex.
+	inline VertexIterator endSuccessors(Vertex v) const	{ return mTargets.begin() + mOffsets[v + 1]; }
+
+	/// Gets the number of components.
+	inline size_t components() const					{ return mTight.size(); }
+
+	/// Gets the component a vertex belongs to.
+	inline size_t component(Vertex v) const				{ return mComponent[v]; }
+
+	/// Gets the first member of a component.
+	inline VertexIterator beginMembers(size_t c) const	{ return mMembers.begin() + mStarts[c]; }
+
+	/// Gets the end of the members of a component.
+	inline VertexIterator endMembers(size_t c) const	{ return mMembers.begin() + mStarts[c + 1]; }
+
+	/// Determines whether a component is tight, which is when it's a single constant that doesn't depend on itself.
+	inline bool tight(size_t c) const					{ return mTight[c]; }
+
+	/// Determines whether every component is tight.
+	bool tight() const;
+
+private:
+
+	/**
+	 * @brief Adds an edge from a head to every constant occurring positively within a node.
+	 * @param head The vertex of the constant in the head.
+	 * @param node The node to search.
+	 */
+	void depend(Vertex head, elements::Node const* node);
+
+	/**
+	 * @brief Finds the strongly connected components of the adjacency, using an explicit stack rather than recursion.
+	 */
+	void tarjan();
+
+};
+
+}
+
+#endif
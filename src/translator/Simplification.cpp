@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "translator/VariableElimination.h"
+#include "translator/Simplification.h"
+
+using namespace elements;
+
+/// The most times the bodies are simplified, in case what's learned keeps trickling through a long chain of rules.
+#define SIMPLIFICATION_ROUNDS 16
+
+/// The most rules for the same head which are compared with each other for subsumption, beyond which only duplicates are found.
+#define SUBSUMPTION_GROUP 64
+
+namespace translator {
+
+namespace {
+
+// Determines whether a node is a literal value.
+inline bool literal(Node const* n) {
+	return n->type() == Node::INTEGER || (n->type() == Node::APPLY && n->symbol()->type() == Symbol::OBJECT);
+}
+
+// Gets the constant in the head of a rule, or NULL for a constraint.
+inline Symbol const* constant(Rule const& rule) {
+	Node const* h = (rule.head->type() == Node::EQ) ? rule.head->arg(0) : rule.head;
+	return (h->type() == Node::APPLY) ? h->symbol() : NULL;
+}
+
+// The conjuncts of a rule's body, sorted so that sets of them can be compared, along with a mask of their hashes.
+struct Conjunction {
+	NodeFactory::NodeList conjuncts;
+	boost::uint64_t mask;
+};
+
+// Gets the conjuncts of a body.
+void conjunction(Node const* body, Conjunction& out) {
+	out.conjuncts.clear();
+	if (body->type() == Node::AND) out.conjuncts.assign(body->args(), body->args() + body->arity());
+	else if (body->type() != Node::TRUE) out.conjuncts.push_back(body);
+	std::sort(out.conjuncts.begin(), out.conjuncts.end());
+
+	out.mask = 0;
+	for (NodeFactory::NodeList::const_iterator it = out.conjuncts.begin(); it != out.conjuncts.end(); it++) {
+		out.mask |= (boost::uint64_t)1 << ((*it)->hash() % 64);
+	}
+}
+
+// Determines whether a rule makes another redundant, given that they have the same head.
+bool subsumes(Rule const& a, Conjunction const& ca, Rule const& b, Conjunction const& cb) {
+	// {h} <- B & h is implied by h <- B, but not the other way around.
+	if (a.choice && !b.choice) return false;
+	if ((ca.mask & ~cb.mask) || ca.conjuncts.size() > cb.conjuncts.size()) return false;
+	return std::includes(cb.conjuncts.begin(), cb.conjuncts.end(), ca.conjuncts.begin(), ca.conjuncts.end());
+}
+
+}
+
+// Constructor
+Simplification::Simplification(SymbolTable const& symbols, Symbol::SymbolList const* only)
+	: mSymbols(symbols), mEmpty(false), mCompleted(symbols.size(), false), mRulesBefore(0), mNodesBefore(0), mNodesAfter(0),
+	  mNever(0), mDuplicates(0), mSubsumed(0), mFacts(0), mRounds(0) {
+	for (size_t i = 0; i < symbols.size(); i++) {
+		Symbol const* s = symbols[i];
+		if (s->type() == Symbol::VARIABLE && !inhabited(s->sort())) mEmpty = true;
+		if (!only && s->constant()) mCompleted[i] = true;
+	}
+	if (only) {
+		for (Symbol::SymbolList::const_iterator it = only->begin(); it != only->end(); it++) mCompleted[(*it)->id()] = true;
+	}
+}
+
+// Simplifies a program.
+Theory* Simplification::translate(Theory const& program) {
+	Theory* out = new Theory();
+	translate(program, *out);
+	return out;
+}
+
+// Simplifies a program into an existing theory.
+void Simplification::translate(Theory const& program, Theory& out) {
+	mValues.clear();
+	mNever = mDuplicates = mSubsumed = mFacts = 0;
+	mRulesBefore = program.rules().size();
+	mNodesBefore = count(program.rules());
+
+	std::vector<size_t> sources(program.rules().size());
+	for (size_t i = 0; i < sources.size(); i++) sources[i] = i;
+
+	// Nothing is known to hold yet, but the constants without rules are already known to be false.
+	Theory::RuleList rules;
+	std::vector<size_t> kept;
+	derive(program.rules());
+	simplify(program.rules(), sources, out.nodes(), rules, kept);
+	mRounds = 1;
+
+	while (mRounds < SIMPLIFICATION_ROUNDS && learn(out.nodes(), rules)) {
+		Theory::RuleList next;
+		std::vector<size_t> nextKept;
+		simplify(rules, kept, out.nodes(), next, nextKept);
+		rules.swap(next);
+		kept.swap(nextKept);
+		mRounds++;
+	}
+
+	prune(rules, kept);
+	mNodesAfter = count(rules);
+	mSources.swap(kept);
+
+	out.rules().insert(out.rules().end(), rules.begin(), rules.end());
+	NodeFactory::ImportMap memo;
+	for (Theory::FormulaList::const_iterator it = program.formulas().begin(); it != program.formulas().end(); it++) {
+		out.add(out.nodes().import(*it, memo));
+	}
+}
+
+// Simplifies the bodies of some rules.
+void Simplification::simplify(Theory::RuleList const& rules, std::vector<size_t> const& sources, NodeFactory& nodes,
+		Theory::RuleList& out, std::vector<size_t>& outSources) {
+	NodeFactory::ImportMap memo;
+	NodeFactory::ImportMap heads;
+	Symbol::SymbolList before;
+	Symbol::SymbolList after;
+
+	for (size_t i = 0; i < rules.size(); i++) {
+		Rule const& r = rules[i];
+		Node const* body = simplify(nodes, r.body, memo);
+		if (body->type() == Node::FALSE) {
+			mNever++;
+			continue;
+		}
+
+		// The variables which only occurred in the body are existentially quantified, which isn't trivial over an empty sort.
+		if (mEmpty) {
+			before.clear();
+			after.clear();
+			freeVariables(r.body, before);
+			freeVariables(r.head, after);
+			freeVariables(body, after);
+			for (Symbol::SymbolList::const_iterator it = before.begin(); it != before.end(); it++) {
+				if (inhabited((*it)->sort()) || std::find(after.begin(), after.end(), *it) != after.end()) continue;
+				body = nodes.import(r.body, heads);
+				break;
+			}
+		}
+
+		Rule s = { nodes.import(r.head, heads), body, r.choice };
+		out.push_back(s);
+		outSources.push_back(sources[i]);
+	}
+}
+
+// Simplifies a node.
+Node const* Simplification::simplify(NodeFactory& nodes, Node const* node, NodeFactory::ImportMap& memo) const {
+	NodeFactory::ImportMap::const_iterator it = memo.find(node);
+	if (it != memo.end()) return it->second;
+
+	Node const* result;
+	if (node->quantifier()) {
+		// A quantifier over something which doesn't depend on its variable is redundant, unless there's nothing to range over.
+		Node const* body = simplify(nodes, node->arg(0), memo);
+		bool truth = body->type() == Node::TRUE || body->type() == Node::FALSE;
+		result = (truth && inhabited(node->symbol()->sort())) ? body : nodes.quantify(node->type(), node->symbol(), body);
+	} else if (!node->arity()) {
+		result = nodes.make(node->type(), node->symbol(), node->value(), NULL, 0);
+	} else {
+		NodeFactory::NodeList args(node->arity());
+		for (size_t i = 0; i < node->arity(); i++) args[i] = simplify(nodes, node->arg(i), memo);
+		result = VariableElimination::fold(nodes, node, args);
+	}
+
+	if (result->atom() && mCompleted[result->symbol()->id()] && !mDerivable[result->symbol()->id()]) {
+		result = nodes.truth(false);
+	} else if (result->type() == Node::APPLY || result->type() == Node::EQ) {
+		NodeFactory::ImportMap::const_iterator v = mValues.find(result);
+		if (v != mValues.end()) result = v->second;
+	}
+
+	memo[node] = result;
+	return result;
+}
+
+// Learns from the rules.
+bool Simplification::learn(NodeFactory const& nodes, Theory::RuleList const& rules) {
+	bool changed = derive(rules);
+
+	for (Theory::RuleList::const_iterator it = rules.begin(); it != rules.end(); it++) {
+		if (it->choice || it->body->type() != Node::TRUE || it->head->type() == Node::FALSE) continue;
+		if (!mValues.insert(std::make_pair(it->head, nodes.truth(true))).second) continue;
+
+		// f(t) = v makes f(t) interchangeable with v, while any other value is left for folding to compare.
+		Node const* h = it->head;
+		if (h->type() == Node::EQ && literal(h->arg(1))) mValues.insert(std::make_pair(h->arg(0), h->arg(1)));
+		mFacts++;
+		changed = true;
+	}
+	return changed;
+}
+
+// Finds the constants with rules.
+bool Simplification::derive(Theory::RuleList const& rules) {
+	std::vector<bool> derivable(mSymbols.size(), false);
+	for (Theory::RuleList::const_iterator it = rules.begin(); it != rules.end(); it++) {
+		Symbol const* s = constant(*it);
+		if (s) derivable[s->id()] = true;
+	}
+
+	bool changed = derivable != mDerivable;
+	mDerivable.swap(derivable);
+	return changed;
+}
+
+// Drops duplicate and subsumed rules.
+void Simplification::prune(Theory::RuleList& rules, std::vector<size_t>& sources) {
+	typedef std::pair<std::pair<Node const*, Node const*>, bool> Key;
+	boost::unordered_set<Key> seen;
+	boost::unordered_map<Node const*, std::vector<size_t> > groups;
+	std::vector<Conjunction> conjunctions(rules.size());
+	std::vector<bool> dropped(rules.size(), false);
+
+	for (size_t i = 0; i < rules.size(); i++) {
+		Rule const& r = rules[i];
+		if (!seen.insert(Key(std::make_pair(r.head, r.body), r.choice)).second) {
+			dropped[i] = true;
+			mDuplicates++;
+			continue;
+		}
+
+		// Larger groups would take quadratic time to compare, so they're left as they are.
+		std::vector<size_t>& group = groups[r.head];
+		if (group.size() >= SUBSUMPTION_GROUP) continue;
+		conjunction(r.body, conjunctions[i]);
+
+		for (std::vector<size_t>::const_iterator j = group.begin(); !dropped[i] && j != group.end(); j++) {
+			if (!dropped[*j] && subsumes(rules[*j], conjunctions[*j], r, conjunctions[i])) dropped[i] = true;
+		}
+		if (dropped[i]) {
+			mSubsumed++;
+			continue;
+		}
+		for (std::vector<size_t>::const_iterator j = group.begin(); j != group.end(); j++) {
+			if (dropped[*j] || !subsumes(r, conjunctions[i], rules[*j], conjunctions[*j])) continue;
+			dropped[*j] = true;
+			mSubsumed++;
+		}
+		group.push_back(i);
+	}
+
+	size_t n = 0;
+	for (size_t i = 0; i < rules.size(); i++) {
+		if (dropped[i]) continue;
+		rules[n] = rules[i];
+		sources[n++] = sources[i];
+	}
+	rules.resize(n);
+	sources.resize(n);
+}
+
+// Determines whether a sort has elements.
+bool Simplification::inhabited(Symbol const* sort) const {
+	return !sort || sort == mSymbols.integer() || sort == mSymbols.boolean() || !sort->domain().empty();
+}
+
+// Counts the distinct nodes in some rules.
+size_t Simplification::count(Theory::RuleList const& rules) {
+	boost::unordered_set<Node const*> seen;
+	NodeFactory::NodeList stack;
+	for (Theory::RuleList::const_iterator it = rules.begin(); it != rules.end(); it++) {
+		stack.push_back(it->head);
+		stack.push_back(it->body);
+	}
+
+	while (!stack.empty()) {
+		Node const* n = stack.back();
+		stack.pop_back();
+		if (!seen.insert(n).second) continue;
+		stack.insert(stack.end(), n->args(), n->args() + n->arity());
+	}
+	return seen.size();
+}
+
+}
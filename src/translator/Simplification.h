@@ -0,0 +1,176 @@
+#ifndef __H_SIMPLIFICATION__
+#define __H_SIMPLIFICATION__
+
+#include <vector>
+
+#include "elements/Symbol.h"
+#include "elements/Node.h"
+#include "elements/Program.h"
+
+namespace translator {
+
+/**
+ * @brief Simplifies a program before it's translated, without changing its models.
+ * The body of every rule is rebuilt bottom up, evaluating arithmetic and comparisons over literals
+ * and simplifying away TRUE and FALSE. Rules whose bodies are then FALSE can never be applied, and
+ * are dropped. What the remaining rules make certain is then propagated into every body, and the
+ * bodies are simplified again, until nothing more is learned:
+ *  - The head of each rule whose body is TRUE (other than a choice rule) holds in every model, so
+ *    it's replaced by TRUE wherever it occurs, and a term assigned a literal by such a rule is
+ *    replaced by the literal.
+ *  - A predicate without any rules is false in the completion, so its atoms are replaced by FALSE.
+ * Heads are left alone, so every constant is completed from the same instances as before.
+ *
+ * Finally, duplicate rules are dropped, and so are rules subsumed by another rule for the same head
+ * whose body is a subset of theirs (a choice rule is only subsumed by another choice rule, while a
+ * constraint is subsumed by another constraint). Rules are grouped by hashing their heads, and each
+ * conjunction is summarized by a mask of the hashes of its conjuncts, so most pairs are rejected
+ * without comparing them.
+ */
+class Simplification {
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	elements::SymbolTable const& mSymbols;			///< The symbols of the program.
+	bool mEmpty;									///< Whether any variable ranges over a sort without elements.
+	std::vector<bool> mCompleted;					///< Whether each symbol is a constant which is going to be completed, indexed by id.
+	std::vector<bool> mDerivable;					///< Whether each symbol is the constant in the head of some rule, indexed by id.
+	elements::NodeFactory::ImportMap mValues;		///< The value of each atom, assignment and term known to hold in every model.
+	std::vector<size_t> mSources;					///< The rule of the input each rule of the result came from.
+
+	size_t mRulesBefore;							///< The number of rules of the input.
+	size_t mNodesBefore;							///< The number of distinct nodes in the rules of the input.
+	size_t mNodesAfter;								///< The number of distinct nodes in the rules of the result.
+	size_t mNever;									///< The number of rules dropped because they can never be applied.
+	size_t mDuplicates;								///< The number of rules dropped because they were duplicates.
+	size_t mSubsumed;								///< The number of rules dropped because another rule subsumed them.
+	size_t mFacts;									///< The number of atoms and assignments propagated.
+	size_t mRounds;									///< The number of times the bodies were simplified.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param symbols The symbols of the program.
+	 * @param only The only constants which are going to be completed, ordered by id, or NULL for every constant.
+	 * Only these constants are known to be false when they have no rules.
+	 */
+	Simplification(elements::SymbolTable const& symbols, elements::Symbol::SymbolList const* only = NULL);
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Simplifies a program.
+	 * @param program The rules to simplify, which must have been checked.
+	 * @return A new theory containing the remaining rules, in the same order. The caller takes ownership.
+	 */
+	elements::Theory* translate(elements::Theory const& program);
+
+	/**
+	 * @brief Simplifies a program into an existing theory.
+	 * Nodes which are already in the theory's factory are shared, so that rules which simplify to the same
+	 * rules as before are made of the same nodes.
+	 * @param program The rules to simplify, which must have been checked.
+	 * @param out The theory to add the remaining rules to.
+	 */
+	void translate(elements::Theory const& program, elements::Theory& out);
+
+	/// Gets the index within the input of the rule each rule added by the last translation came from.
+	inline std::vector<size_t> const& sources() const	{ return mSources; }
+
+	/// Gets the number of rules before the last translation.
+	inline size_t rulesBefore() const					{ return mRulesBefore; }
+
+	/// Gets the number of rules after the last translation.
+	inline size_t rulesAfter() const					{ return mSources.size(); }
+
+	/// Gets the number of distinct nodes in the rules before the last translation.
+	inline size_t nodesBefore() const					{ return mNodesBefore; }
+
+	/// Gets the number of distinct nodes in the rules after the last translation.
+	inline size_t nodesAfter() const					{ return mNodesAfter; }
+
+	/// Gets the number of rules which were dropped because they can never be applied.
+	inline size_t never() const							{ return mNever; }
+
+	/// Gets the number of rules which were dropped as duplicates.
+	inline size_t duplicates() const					{ return mDuplicates; }
+
+	/// Gets the number of rules which were dropped because other rules subsumed them.
+	inline size_t subsumed() const						{ return mSubsumed; }
+
+	/// Gets the number of atoms and assignments which were propagated.
+	inline size_t facts() const							{ return mFacts; }
+
+	/// Gets the number of times the bodies were simplified.
+	inline size_t rounds() const						{ return mRounds; }
+
+	/// Determines whether the last translation made the program any smaller.
+	inline bool shrank() const							{ return rulesAfter() < mRulesBefore || mNodesAfter < mNodesBefore; }
+
+private:
+
+	/**
+	 * @brief Simplifies the bodies of some rules, dropping those which can never be applied.
+	 * @param rules The rules to simplify.
+	 * @param sources The rule of the input each of the rules came from.
+	 * @param nodes The factory to build the new rules in.
+	 * @param out The rules which are left.
+	 * @param outSources The rule of the input each of the rules which are left came from.
+	 */
+	void simplify(elements::Theory::RuleList const& rules, std::vector<size_t> const& sources, elements::NodeFactory& nodes,
+		elements::Theory::RuleList& out, std::vector<size_t>& outSources);
+
+	/**
+	 * @brief Simplifies a node given what's known so far.
+	 * @param nodes The factory to build the result in.
+	 * @param node The node to simplify.
+	 * @param memo The nodes which have already been simplified.
+	 */
+	elements::Node const* simplify(elements::NodeFactory& nodes, elements::Node const* node, elements::NodeFactory::ImportMap& memo) const;
+
+	/**
+	 * @brief Finds the constants with rules, and the atoms and assignments which hold in every model.
+	 * @param nodes The factory being simplified into.
+	 * @param rules The rules, whose nodes belong to the factory being simplified into.
+	 * @return True if anything was learned since the last time.
+	 */
+	bool learn(elements::NodeFactory const& nodes, elements::Theory::RuleList const& rules);
+
+	/**
+	 * @brief Finds the constants with rules.
+	 * @param rules The rules.
+	 * @return True if this differs from the last time.
+	 */
+	bool derive(elements::Theory::RuleList const& rules);
+
+	/**
+	 * @brief Drops duplicate and subsumed rules.
+	 * @param rules The rules.
+	 * @param sources The rule of the input each of the rules came from.
+	 */
+	void prune(elements::Theory::RuleList& rules, std::vector<size_t>& sources);
+
+	/**
+	 * @brief Determines whether a sort has any elements, which the built in sorts always do.
+	 * @param sort The sort, or NULL if there isn't one.
+	 */
+	bool inhabited(elements::Symbol const* sort) const;
+
+	/**
+	 * @brief Counts the distinct nodes in some rules.
+	 */
+	static size_t count(elements::Theory::RuleList const& rules);
+
+};
+
+}
+
+#endif
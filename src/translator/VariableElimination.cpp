@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <vector>
+
+#include <boost/bind/bind.hpp>
+
+#include "translator/VariableElimination.h"
+
+using namespace elements;
+
+/// The largest number of formulas eliminated at a time when there's a memory budget.
+#define ELIMINATION_BATCH 256
+
+namespace translator {
+
+namespace {
+
+// Determines whether a node is a literal value.
+inline bool literal(Node const* n) {
+	return n->type() == Node::INTEGER || (n->type() == Node::APPLY && n->symbol()->type() == Symbol::OBJECT);
+}
+
+}
+
+/*****************************************************************************************/
+/* Task */
+/*****************************************************************************************/
+
+// Splits or eliminates a formula.
+void VariableElimination::Task::run(size_t worker) {
+	Node const* f = formula;
+	bool neg = negated;
+	while (f->type() == Node::NOT) {
+		neg = !neg;
+		f = f->arg(0);
+	}
+
+	// Split universally quantified formulas into an instance per element.
+	if (((f->type() == Node::FORALL && !neg) || (f->type() == Node::EXISTS && neg)) && owner->finite(f->symbol()->sort())) {
+		Symbol::DomainList const& domain = f->symbol()->sort()->domain();
+		for (Symbol::DomainList::const_iterator it = domain.begin(); it != domain.end(); it++) {
+			Task* t = new Task();
+			t->owner = owner;
+			t->formula = f->arg(0);
+			t->negated = neg;
+			t->binding = binding;
+			t->binding.push_back(std::make_pair(f->symbol(), *it));
+			t->result = NULL;
+			children.push_back(t);
+		}
+
+		// We take from the back of our queue, so queue them in reverse to work through them in order.
+		for (std::vector<Task*>::reverse_iterator it = children.rbegin(); it != children.rend(); it++) {
+			owner->mPool->spawn(worker, boost::bind(&Task::run, *it, boost::placeholders::_1));
+		}
+		return;
+	}
+
+	NodeFactory& nodes = owner->mWorkers[worker]->nodes();
+	NodeFactory::SubstitutionMap env;
+	for (Binding::const_iterator it = binding.begin(); it != binding.end(); it++) {
+		env[it->first] = element(nodes, it->second);
+	}
+
+	result = owner->ground(f, nodes, env);
+	if (neg) result = negate(nodes, result);
+}
+
+// Destructor
+VariableElimination::Task::~Task() {
+	for (std::vector<Task*>::iterator it = children.begin(); it != children.end(); it++) {
+		delete *it;
+	}
+}
+
+/*****************************************************************************************/
+/* Variable Elimination */
+/*****************************************************************************************/
+
+// Eliminates the variables of a theory.
+Theory* VariableElimination::translate(Theory const& in, Spill* spill) {
+	utils::WorkStealingPool pool(mThreads);
+	mPool = &pool;
+	for (size_t i = 0; i < pool.size(); i++) mWorkers.push_back(new Theory());
+
+	// Without a budget, every formula is eliminated in a single batch.
+	bool budgeted = spill && mBudget;
+	size_t batch = (budgeted) ? 1 : in.formulas().size();
+	size_t base = (spill) ? spill->formulas() : 0;
+
+	Theory* out = new Theory();
+	NodeFactory::ImportMap memo;
+	mEnds.clear();
+	mPeak = 0;
+	for (size_t first = 0, last = 0; first < in.formulas().size(); first = last) {
+		last = std::min(first + batch, in.formulas().size());
+
+		std::vector<Task*> roots;
+		for (size_t i = first; i < last; i++) {
+			Task* t = new Task();
+			t->owner = this;
+			t->formula = in.formulas()[i];
+			t->negated = false;
+			t->result = NULL;
+			roots.push_back(t);
+			pool.post(boost::bind(&Task::run, t, boost::placeholders::_1));
+		}
+
+		pool.run();
+
+		size_t workers = 0;
+		for (std::vector<Theory*>::iterator it = mWorkers.begin(); it != mWorkers.end(); it++) {
+			workers += (*it)->nodes().bytes();
+		}
+
+		// Batches grow while the workers' theories take up less than a quarter of the budget, and shrink while they take up
+		// more than half of it.
+		if (budgeted && workers > mBudget / 2 && batch > 1) batch /= 2;
+		else if (budgeted && workers < mBudget / 4 && batch < ELIMINATION_BATCH) batch *= 2;
+
+		// Collect the results in order, spilling them whenever they outgrow what's left of the budget. The collected
+		// formulas are always left at least half of it, so that a large batch doesn't spill them one at a time.
+		size_t room = mBudget - std::min(workers, mBudget / 2);
+		for (std::vector<Task*>::iterator it = roots.begin(); it != roots.end(); it++) {
+			collect(*it, *out, memo);
+			delete *it;
+
+			size_t working = workers + out->nodes().bytes();
+			mPeak = std::max(mPeak, working);
+			if (budgeted && out->nodes().bytes() > room && spill->write(*out)) {
+				delete out;
+				out = new Theory();
+				memo.clear();
+			}
+			mEnds.push_back(((spill) ? spill->formulas() - base : 0) + out->formulas().size());
+		}
+
+		// The workers start over for the next batch, so the nodes copied from them are forgotten as well.
+		if (last < in.formulas().size()) {
+			for (std::vector<Theory*>::iterator it = mWorkers.begin(); it != mWorkers.end(); it++) {
+				delete *it;
+				*it = new Theory();
+			}
+			memo.clear();
+		}
+	}
+
+	for (std::vector<Theory*>::iterator it = mWorkers.begin(); it != mWorkers.end(); it++) {
+		delete *it;
+	}
+	mWorkers.clear();
+	mPool = NULL;
+
+	return out;
+}
+
+// Collects the results of a task.
+void VariableElimination::collect(Task const* task, Theory& out, NodeFactory::ImportMap& memo) {
+	if (task->result) {
+		if (task->result->type() != Node::TRUE) out.add(out.nodes().import(task->result, memo));
+		return;
+	}
+	for (std::vector<Task*>::const_iterator it = task->children.begin(); it != task->children.end(); it++) {
+		collect(*it, out, memo);
+	}
+}
+
+// Gets the node for an element.
+Node const* VariableElimination::element(NodeFactory& nodes, Symbol::Element const& e) {
+	return (e.object) ? nodes.apply(e.object) : nodes.integer(e.value);
+}
+
+// Eliminates the variables of a node.
+Node const* VariableElimination::ground(Node const* node, NodeFactory& nodes, NodeFactory::SubstitutionMap& env) const {
+	switch (node->type()) {
+	case Node::VARIABLE:
+		{
+			NodeFactory::SubstitutionMap::const_iterator it = env.find(node->symbol());
+			return (it != env.end()) ? it->second : nodes.variable(node->symbol());
+		}
+
+	case Node::EXISTS:
+	case Node::FORALL:
+		{
+			Symbol const* v = node->symbol();
+
+			// Save any binding of the same variable from further out.
+			NodeFactory::SubstitutionMap::iterator outer = env.find(v);
+			Node const* saved = (outer != env.end()) ? outer->second : NULL;
+
+			Node const* r;
+			if (finite(v->sort())) {
+				Node::Type type = (node->type() == Node::FORALL) ? Node::AND : Node::OR;
+				Node const* zero = nodes.truth(type == Node::OR);
+
+				NodeFactory::NodeList parts;
+				Symbol::DomainList const& domain = v->sort()->domain();
+				for (Symbol::DomainList::const_iterator it = domain.begin(); it != domain.end(); it++) {
+					env[v] = element(nodes, *it);
+					parts.push_back(ground(node->arg(0), nodes, env));
+					if (parts.back() == zero) break;
+				}
+				r = nodes.junction(type, parts);
+			} else {
+				env.erase(v);
+				Node const* body = ground(node->arg(0), nodes, env);
+				r = (body->type() == Node::TRUE || body->type() == Node::FALSE) ? body : nodes.quantify(node->type(), v, body);
+			}
+
+			if (saved) env[v] = saved;
+			else env.erase(v);
+			return r;
+		}
+
+	default:
+		{
+			if (!node->arity()) return nodes.make(node->type(), node->symbol(), node->value(), NULL, 0);
+
+			NodeFactory::NodeList args(node->arity());
+			for (size_t i = 0; i < node->arity(); i++) args[i] = ground(node->arg(i), nodes, env);
+			return fold(nodes, node, args);
+		}
+	}
+}
+
+// Builds and evaluates a node.
+Node const* VariableElimination::fold(NodeFactory& nodes, Node const* node, NodeFactory::NodeList const& args) {
+	Node const* a = (args.size() > 0) ? args[0] : NULL;
+	Node const* b = (args.size() > 1) ? args[1] : NULL;
+	bool ints = a && b && a->type() == Node::INTEGER && b->type() == Node::INTEGER;
+	long r;
+
+	switch (node->type()) {
+	case Node::NOT:			return negate(nodes, a);
+	case Node::AND:
+	case Node::OR:			return nodes.junction(node->type(), args);
+
+	case Node::IMPLIES:
+		if (a->type() == Node::TRUE || b->type() == Node::TRUE) return b;
+		if (a->type() == Node::FALSE || a == b) return nodes.truth(true);
+		if (b->type() == Node::FALSE) return negate(nodes, a);
+		break;
+
+	case Node::IFF:
+		if (a == b) return nodes.truth(true);
+		if (a->type() == Node::TRUE) return b;
+		if (b->type() == Node::TRUE) return a;
+		if (a->type() == Node::FALSE) return negate(nodes, b);
+		if (b->type() == Node::FALSE) return negate(nodes, a);
+		break;
+
+	case Node::EQ:
+		// Distinct literals are distinct values.
+		if (a == b) return nodes.truth(true);
+		if (literal(a) && literal(b)) return nodes.truth(false);
+		break;
+
+	case Node::LT:			if (ints) return nodes.truth(a->value() < b->value()); break;
+	case Node::LE:			if (ints) return nodes.truth(a->value() <= b->value()); break;
+	case Node::GT:			if (ints) return nodes.truth(a->value() > b->value()); break;
+	case Node::GE:			if (ints) return nodes.truth(a->value() >= b->value()); break;
+
+	// Arithmetic which overflows is left to the solver, which has unbounded integers.
+	case Node::PLUS:		if (ints && !__builtin_add_overflow(a->value(), b->value(), &r)) return nodes.integer(r); break;
+	case Node::MINUS:		if (ints && !__builtin_sub_overflow(a->value(), b->value(), &r)) return nodes.integer(r); break;
+	case Node::TIMES:		if (ints && !__builtin_mul_overflow(a->value(), b->value(), &r)) return nodes.integer(r); break;
+
+	case Node::DIVIDE:
+		// Only exact quotients are evaluated, since rounding is up to the solver.
+		// Dividing by -1 is negation, since the remainder of LONG_MIN / -1 overflows as well.
+		if (!ints || !b->value()) break;
+		if (b->value() == -1) {
+			if (!__builtin_sub_overflow(0L, a->value(), &r)) return nodes.integer(r);
+		} else if (!(a->value() % b->value())) {
+			return nodes.integer(a->value() / b->value());
+		}
+		break;
+
+	case Node::NEGATE:
+		if (a->type() == Node::INTEGER && !__builtin_sub_overflow(0L, a->value(), &r)) return nodes.integer(r);
+		break;
+
+	default:
+		break;
+	}
+
+	return nodes.make(node->type(), node->symbol(), node->value(), &args[0], args.size());
+}
+
+// Negates a formula.
+Node const* VariableElimination::negate(NodeFactory& nodes, Node const* formula) {
+	switch (formula->type()) {
+	case Node::TRUE:		return nodes.truth(false);
+	case Node::FALSE:		return nodes.truth(true);
+	case Node::NOT:			return formula->arg(0);
+	default:				return nodes.make(Node::NOT, formula);
+	}
+}
+
+}
@@ -0,0 +1,152 @@
+#ifndef __H_VARIABLE_ELIMINATION__
+#define __H_VARIABLE_ELIMINATION__
+
+#include <vector>
+#include <utility>
+
+#include "elements/Symbol.h"
+#include "elements/Node.h"
+#include "elements/Program.h"
+#include "elements/Spill.h"
+#include "utilities/WorkStealingPool.h"
+
+namespace translator {
+
+/**
+ * @brief Eliminates the variables of a theory by expanding quantifiers over the (finite) domains of their sorts.
+ * forall X F becomes the conjunction of F[X/e] for each element e of X's sort, and exists X F the
+ * disjunction. Ground comparisons and arithmetic are evaluated along the way, and TRUE and FALSE are
+ * simplified away. Quantifiers over sorts without a finite domain (such as integer) are left for the solver.
+ *
+ * Since every formula of the theory is closed, no two formulas share an eliminated variable, so each formula
+ * is an independent unit of work. A universally quantified formula is split further into one task per element of
+ * the quantified sort. Tasks are scheduled on a work stealing pool and build their results in per-worker theories,
+ * which are then collected in the order of the input formulas and their elements. The result is therefore the
+ * same regardless of the number of threads.
+ *
+ * Given a memory budget and a spill, the formulas are instead eliminated a batch at a time, and the workers' theories
+ * are freed between batches. Batches start with a single formula and are sized so that the workers' theories take up
+ * between a quarter and a half of the budget. Whenever the ground formulas collected so far (along with the workers'
+ * theories) take up more than the budget, they're written to the spill as a partition and collection starts over in a
+ * new theory; the collected formulas are always allowed at least half of the budget. Nodes are measured by the bytes
+ * they take up, not by the arena chunks reserved for them. A partition always holds every ground formula of at least
+ * one input formula, so a single formula whose ground formulas are larger than the budget still has to fit in memory.
+ */
+class VariableElimination {
+
+private:
+	/***********************************************************************/
+	/* Private Types */
+	/***********************************************************************/
+
+	/// The elements assigned to the variables which have been eliminated so far.
+	typedef std::vector<std::pair<elements::Symbol const*, elements::Symbol::Element> > Binding;
+
+	/**
+	 * @brief The elimination of a single formula (or instance of one).
+	 */
+	struct Task {
+		VariableElimination* owner;				///< The elimination being run.
+		elements::Node const* formula;			///< The formula, from the input theory.
+		bool negated;							///< Whether the formula appears under a negation.
+		Binding binding;						///< The elements assigned to the formula's free variables.
+		elements::Node const* result;			///< The ground formula, from the theory of the worker which ran the task, or NULL if the task was split.
+		std::vector<Task*> children;			///< The tasks the formula was split into.
+
+		/// Splits or eliminates the formula.
+		void run(size_t worker);
+
+		/// Frees the task's children.
+		~Task();
+	};
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	elements::SymbolTable const& mSymbols;		///< The symbols of the theory.
+	size_t mThreads;							///< The number of worker threads to use, or 0 for one per hardware thread.
+	size_t mBudget;								///< The number of bytes the ground formulas may take up before they're spilled, or 0 for no limit.
+	size_t mPeak;								///< The most bytes held by the ground formulas and the workers' theories during the last call to translate().
+
+	utils::WorkStealingPool* mPool;				///< The pool the tasks are running on.
+	std::vector<elements::Theory*> mWorkers;	///< The theory each worker builds its results in.
+	std::vector<size_t> mEnds;					///< One past the last ground formula produced for each formula of the input.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param symbols The symbols of the theory.
+	 * @param threads The number of worker threads to use, or 0 for one per hardware thread.
+	 * @param budget The number of bytes the ground formulas may take up before they're spilled, or 0 for no limit.
+	 */
+	inline VariableElimination(elements::SymbolTable const& symbols, size_t threads = 0, size_t budget = 0)
+		: mSymbols(symbols), mThreads(threads), mBudget(budget), mPeak(0), mPool(NULL) { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Eliminates the variables of each formula in a theory.
+	 * @param in The theory, whose formulas must be closed.
+	 * @param spill The spill to write the ground formulas to once they outgrow the budget, or NULL to keep them all in memory.
+	 * @return A new theory containing the ground formulas which weren't spilled, which follow those written to the spill.
+	 * The caller takes ownership.
+	 */
+	elements::Theory* translate(elements::Theory const& in, elements::Spill* spill = NULL);
+
+	/**
+	 * @brief Gets which ground formulas came from each formula given to the last call to translate().
+	 * The ground formulas of each formula are contiguous and in the same order as the formulas themselves.
+	 * @return For each formula, one past the index of the last ground formula it produced.
+	 */
+	inline std::vector<size_t> const& ends() const			{ return mEnds; }
+
+	/// Gets the most bytes held by the ground formulas and the workers' theories at once during the last call to translate().
+	inline size_t peak() const								{ return mPeak; }
+
+	/**
+	 * @brief Determines whether the variables of a sort can be eliminated.
+	 * Every declared sort is finite, while the built in sorts aren't.
+	 */
+	inline bool finite(elements::Symbol const* sort) const	{ return sort != mSymbols.integer() && sort != mSymbols.boolean(); }
+
+	/**
+	 * @brief Gets the node for an element of a sort's domain.
+	 */
+	static elements::Node const* element(elements::NodeFactory& nodes, elements::Symbol::Element const& e);
+
+	/**
+	 * @brief Builds a node from its (already simplified) children, evaluating it if possible.
+	 * Comparisons and arithmetic over literals are evaluated, and TRUE and FALSE are simplified away.
+	 */
+	static elements::Node const* fold(elements::NodeFactory& nodes, elements::Node const* node, elements::NodeFactory::NodeList const& args);
+
+	/**
+	 * @brief Gets the negation of a formula, evaluating it if possible.
+	 */
+	static elements::Node const* negate(elements::NodeFactory& nodes, elements::Node const* formula);
+
+private:
+
+	/**
+	 * @brief Eliminates the variables of a node.
+	 * @param node The node, from the input theory.
+	 * @param nodes The factory to build the result in.
+	 * @param env The nodes to replace each bound variable with.
+	 * @return The ground node.
+	 */
+	elements::Node const* ground(elements::Node const* node, elements::NodeFactory& nodes, elements::NodeFactory::SubstitutionMap& env) const;
+
+	/// Collects the results of a task and its children, in order.
+	void collect(Task const* task, elements::Theory& out, elements::NodeFactory::ImportMap& memo);
+
+};
+
+}
+
+#endif
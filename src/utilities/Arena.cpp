@@ -0,0 +1,41 @@
+#include <cstdlib>
+#include <new>
+
+#include "Arena.h"
+
+namespace utils {
+
+// Constructor
+Arena::Arena(size_t blockSize)
+	: mBlockSize(blockSize), mPos(NULL), mEnd(NULL), mUsed(0), mReserved(0) {
+	/* Intentionally Left Blank */
+}
+
+// Destructor
+Arena::~Arena() {
+	clear();
+}
+
+// Frees all of the blocks.
+void Arena::clear() {
+	for (std::vector<char*>::iterator it = mBlocks.begin(); it != mBlocks.end(); it++) {
+		free(*it);
+	}
+	mBlocks.clear();
+	mPos = mEnd = NULL;
+	mUsed = mReserved = 0;
+}
+
+// Allocates a new block.
+char* Arena::grow(size_t bytes, size_t align) {
+	size_t size = (bytes + align > mBlockSize) ? bytes + align : mBlockSize;
+	char* block = (char*)malloc(size);
+	if (!block) throw std::bad_alloc();
+
+	mBlocks.push_back(block);
+	mEnd = block + size;
+	mReserved += size;
+	return (char*)(((size_t)block + align - 1) & ~(align - 1));
+}
+
+}
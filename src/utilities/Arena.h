@@ -0,0 +1,86 @@
+#ifndef __H_ARENA__
+#define __H_ARENA__
+
+#include <cstddef>
+#include <vector>
+
+namespace utils {
+
+/**
+ * @brief A region based allocator which hands out memory from large blocks and frees it all at once.
+ * Objects allocated from an arena are never destroyed individually, so they shouldn't own
+ * anything that needs to be released.
+ */
+class Arena {
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	std::vector<char*> mBlocks;			///< The blocks we've allocated so far.
+	size_t mBlockSize;					///< The size to allocate new blocks at.
+	char* mPos;							///< The next free byte within the current block.
+	char* mEnd;							///< One past the end of the current block.
+	size_t mUsed;						///< The total number of bytes handed out.
+	size_t mReserved;					///< The total number of bytes allocated in blocks.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * @param blockSize The number of bytes to allocate at a time.
+	 */
+	Arena(size_t blockSize = 1 << 20);
+
+	/**
+	 * @brief Basic Destructor.
+	 * Frees all blocks.
+	 */
+	virtual ~Arena();
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+	 * @brief Allocates uninitialized memory from the arena.
+	 * @param bytes The number of bytes to allocate.
+	 * @param align The alignment of the allocation. Must be a power of 2.
+	 * @return The allocated memory, which remains valid until the arena is cleared or destroyed.
+	 */
+	inline void* alloc(size_t bytes, size_t align = sizeof(void*)) {
+		char* p = (char*)(((size_t)mPos + align - 1) & ~(align - 1));
+		if (!mPos || p + bytes > mEnd) p = grow(bytes, align);
+		mPos = p + bytes;
+		mUsed += bytes;
+		return p;
+	}
+
+	/**
+	 * @brief Frees everything that has been allocated from the arena at once.
+	 */
+	void clear();
+
+	/// Gets the number of bytes that have been handed out.
+	inline size_t used() const { return mUsed; }
+
+	/// Gets the number of bytes the arena is holding on to.
+	inline size_t reserved() const { return mReserved; }
+
+private:
+
+	/// Allocates a new block large enough for the provided allocation and returns the aligned position within it.
+	char* grow(size_t bytes, size_t align);
+
+	/// Arenas aren't copyable.
+	Arena(Arena const&);
+	Arena& operator=(Arena const&);
+
+};
+
+}
+
+#endif
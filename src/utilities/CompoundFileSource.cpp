@@ -1,250 +1,920 @@
-#include <list>
-#include <string>
-#include <exception>
-#include <fstream>
-#include <cstring>
-
-#include <boost/filesystem/path.hpp>
-#include <boost/filesystem/operations.hpp>
-#include <boost/filesystem/exception.hpp>
-#include <boost/iostreams/device/file.hpp>
-
-#include "utilities/utils.h"
-#include "CompoundFileSource.h"
-
-namespace utils {
-
-/**
- * @brief The number of bytes to allocate to a buffer at a time.
- */
-#define BUFFER_BLOCK_SIZE 1024
-
-
-/*****************************************************************************************/
-/* File Context */
-/*****************************************************************************************/
-
-/// Free the context
-CompoundFileSource::FileContext::~FileContext() {
-	if (buf) delete buf;
-	if (source) {
-		if (source->is_open()) source->close();
-		delete source;
-	}
-}
-
-/******************************************************************************************/
-/* Compound File Source */
-/******************************************************************************************/
-
-// Constructor
-CompoundFileSource::CompoundFileSource(void* nullptr_hack) {
-	state(CLOSED);
-}
-
-// Place a file on the stack.
-bool CompoundFileSource::place(std::string const& filename, bool top, std::list<std::string> const* searchPath) {
-	// State handling...
-	if (state() == ERROR) return false;
-
-	// initialize the new context
-	FileContext* context = new FileContext(filename, "", NULL, 0);
-
-	// Step 1) Validate the name..
-	//if (!boost::filesystem::native(filename)) {
-	//	// The file's name isn't a valid format.
-	//	delete context;
-	//	return false;
-	//}
-
-
-	// Step 2) Attempt to resolve the file.
-
-	// Try the present working directory...
-	boost::filesystem::path filepath;
-	bool found = false;
-
-	if (searchPath) {
-		// Check the search path.
-		for (std::list<std::string>::const_iterator it = searchPath->begin(); it != searchPath->end(); it++) {
-			try {
-				filepath = boost::filesystem::absolute(filename, *it);
-				if (boost::filesystem::exists(filepath)) {
-					found = true;
-					break;
-				}
-			} catch (boost::filesystem::filesystem_error& e) {
-				// Something went wrong with our filesystem shenanigans.
-				// I have no idea what this could be.
-				// TODO: Throw this to some sort of debugging output.
-			}
-		}
-	} else {
-		// Just check the working directory.
-		filepath = boost::filesystem::absolute(filename);
-		if (boost::filesystem::exists(filepath)) found = true;
-	}
-
-	// Check if we (eventually) found it.
-	if (!found) {
-		// We don't really know where the file is.
-		delete context;
-		return false;
-	}
-
-	// Resolve all symlinks and finalize the path we're using.
-	context->resolved = boost::filesystem::canonical(filepath).string();
-
-	// Step 3) Ensure the file is readable and open it.
-	try {
-		context->source = new boost::filesystem::ifstream(filepath);
-	} catch (std::exception& e) {
-		// We can't open the source stream.
-		// TODO: We should really throw this to some sort of debugging output.
-	}
-	if (!context->source || !context->source->good()) {
-		// We can't open the file for some reason.
-		delete context;
-		return false;
-	}
-
-	// make sure we copy our locality!
-	context->source->imbue(mLocale);
-
-	// Step 4) Add the file context to the stack.
-	if (top) {
-		mStack.push_front(context);
-	} else {
-		mStack.push_back(context);
-	}
-
-	// Indicate that our state is good to go.
-	state(GOOD);
-	return true;
-}
-
-// Pops the top file context off the stack.
-bool CompoundFileSource::nextFile() {
-	if (state() == ERROR) return false;
-
-	size_t size = mStack.size();
-
-	// pop off the old state.
-	if (size > 1) {
-		delete mStack.front();
-		mStack.pop_front();
-		state(GOOD);
-	} else {
-		state(END);
-	}
-	return state() == GOOD;
-}
-
-void CompoundFileSource::reset() {
-	if (source()) {
-		source()->clear();
-		state(GOOD);
-	} else {
-		state(END);
-	}
-}
-
-// Closes the stream, freeing all available resourced.
-void CompoundFileSource::close() {
-	for (std::list<FileContext*>::iterator it = mStack.begin(); it != mStack.end(); it++) {
-		delete *it;
-	}
-	mStack.clear();
-	state(CLOSED);
-}
-
-// Places a number of buffered characters into the input stream to be reread later.
-bool CompoundFileSource::putback(char const* c, std::streamsize n) {
-	FileContext* context;
-	std::streamsize newpos;
-
-	switch (state()) {
-	case END:
-	case GOOD:
-		// We should have the last file that we read from
-		// at the top of stack, so let's add it to the buffer
-		context = mStack.front();
-		newpos = context->bufpos + n;
-
-		if (n >= context->bufsize) {
-			// Overflow, expand the buffer.
-			context->bufsize = (size_t)(((n + 1) / BUFFER_BLOCK_SIZE) + 1) * BUFFER_BLOCK_SIZE;
-			context->buf = (char*)realloc(context->buf, context->bufsize);
-		}
-
-		// Copy the contents...
-		// Note that this should be done in reverse order, so the last
-		// part of the buffer comes out first.
-		utils::reverse_copy(c, context->buf + context->bufpos, (size_t)n);
-		context->bufpos = (size_t)newpos;
-		return true;
-
-	case ERROR:
-	case CLOSED:
-	default:
-		return false;
-
-	}
-}
-
-// Imbues the steam with a provided locality for locality sensitive operations.
-void CompoundFileSource::imbue(std::locale const& loc) {
-	mLocale = loc;
-
-	// Propogate the changes to each of the open streams.
-	for (std::list<FileContext*>::iterator it = mStack.begin(); it != mStack.end(); it++) {
-		if ((*it)->source) (*it)->source->imbue(mLocale);
-	}
-}
-
-// Reads from any open files
-std::streamsize CompoundFileSource::read(char* c, std::streamsize n) {
-	std::streamsize needed = n;
-
-	// If we've already hit then end, make sure to tell them.
-	if (state() == END) return -1;
-
-
-	// Read from each file starting from the top until we have 
-	// all the characters we that we need (or run out of files).
-	while (needed && state() == GOOD) {
-		FileContext* context = mStack.front();
-		std::streamsize size;
-
-		// Check the buffer.
-		if (context->bufpos) {
-			// we have something...
-			size = (context->bufpos  > needed) ? needed : context->bufpos;
-			utils::reverse_copy(context->buf + context->bufpos - 1,c, (size_t)size);
-			c += size;
-			needed -= size;
-			context->bufpos -= (size_t)size;
-		}
-
-		// now try the device...
-		if (needed) {
-			context->source->read(c, needed);
-			if (context->source->eof()) {
-				// We've read the entire file.
-				needed -= context->source->gcount();
-				c += context->source->gcount();
-				nextFile();
-			} else if (context->source->fail()) {
-				// Something just went horribly wrong...
-				error();
-			} else {
-				// Everything is a-ok and we have everything we need!
-				needed = 0;
-			}
-		}
-	}
-
-	return n - needed;
-}
-
+#include <list>
+#include <string>
+#include <exception>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+#include <sys/stat.h>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/exception.hpp>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/bind/bind.hpp>
+
+#include "utilities/utils.h"
+#include "CompoundFileSource.h"
+
+namespace utils {
+
+/**
+ * @brief The number of characters that can be put back into a single file context.
+ */
+#define PUSHBACK_SIZE 4096
+
+/**
+ * @brief The number of bytes to read ahead at a time from BUFFERED files.
+ */
+#define READ_BLOCK_SIZE 65536
+
+/**
+ * @brief The number of bytes decoded at a time from compressed files.
+ */
+#define DECODE_BLOCK_SIZE 262144
+
+/**
+ * @brief The most bytes which are decoded ahead of the reader for each compressed file (unless it's wanted in one piece).
+ */
+#define DECODE_AHEAD (64 * DECODE_BLOCK_SIZE)
+
+
+/*****************************************************************************************/
+/* Prefetcher */
+/*****************************************************************************************/
+
+/**
+ * @brief The state shared between the reading thread and the prefetching thread.
+ */
+struct CompoundFileSource::Prefetcher {
+	boost::mutex lock;						///< Guards the stack and the prefetch state of each context.
+	boost::condition_variable cond;			///< Signalled whenever the stack or the prefetch state of a context changes.
+	boost::thread thread;					///< The prefetching thread.
+	size_t used;							///< The number of bytes currently counted against the budget.
+	bool stop;								///< Whether the thread has been asked to exit.
+
+	/// Initializes the state. The thread is launched separately.
+	inline Prefetcher() : used(0), stop(false) { /* Intentionally Left Blank */ }
+};
+
+/*****************************************************************************************/
+/* Decoder */
+/*****************************************************************************************/
+
+/**
+ * @brief The state shared between the reading thread and the thread decoding a compressed file.
+ */
+struct CompoundFileSource::Decoder {
+	boost::mutex lock;						///< Guards everything but the path, the codec and the current block.
+	boost::condition_variable cond;			///< Signalled whenever a block is decoded or taken, or the limits change.
+	boost::thread thread;					///< The decoding thread, once it has been started.
+	std::string path;						///< The file being decoded.
+	codec_t codec;							///< The format of the file.
+	std::list<std::string> blocks;			///< The blocks which have been decoded but not yet taken by the reader.
+	std::string current;					///< The block the reader is reading from. Only used by the reading thread.
+	size_t ahead;							///< The number of bytes in the blocks which haven't been taken.
+	bool started;							///< Whether the thread has been started.
+	bool whole;								///< Whether the whole file is wanted at once, so that there's no limit on how far ahead to decode.
+	bool done;								///< Whether the thread has decoded everything it's going to.
+	bool failed;							///< Whether the file couldn't be read or decoded.
+	bool stop;								///< Whether the thread has been asked to exit.
+
+	/// Initializes the state. The thread is launched separately.
+	inline Decoder(std::string const& _path, codec_t _codec)
+		: path(_path), codec(_codec), ahead(0), started(false), whole(false), done(false), failed(false), stop(false)
+		{ /* Intentionally Left Blank */ }
+
+	/// Stops the thread and waits for it to exit.
+	~Decoder();
+
+	/// Starts the thread if it hasn't been already.
+	void start();
+
+	/**
+	 * @brief Replaces the current block with the next one, waiting for it to be decoded.
+	 * @return False if the file couldn't be decoded. The current block is left empty once everything has been read.
+	 */
+	bool next();
+
+	/**
+	 * @brief Replaces the current block with the rest of the file, waiting for it to be decoded.
+	 * @return False if the file couldn't be decoded.
+	 */
+	bool rest();
+
+	/// The body of the decoding thread.
+	void run();
+};
+
+// Stops the thread.
+CompoundFileSource::Decoder::~Decoder() {
+	if (!started) return;
+	{
+		boost::lock_guard<boost::mutex> guard(lock);
+		stop = true;
+		cond.notify_all();
+	}
+	thread.join();
+}
+
+// Starts the thread.
+void CompoundFileSource::Decoder::start() {
+	if (started) return;
+	started = true;
+	thread = boost::thread(boost::bind(&CompoundFileSource::Decoder::run, this));
+}
+
+// Takes the next block.
+bool CompoundFileSource::Decoder::next() {
+	start();
+	boost::unique_lock<boost::mutex> guard(lock);
+	while (blocks.empty() && !done) cond.wait(guard);
+
+	current.clear();
+	if (!blocks.empty()) {
+		current.swap(blocks.front());
+		blocks.pop_front();
+		ahead -= current.size();
+		cond.notify_all();
+	}
+
+	// Everything which was decoded before a failure is still read.
+	return !current.empty() || !failed;
+}
+
+// Takes the rest of the file.
+bool CompoundFileSource::Decoder::rest() {
+	start();
+	boost::unique_lock<boost::mutex> guard(lock);
+	whole = true;
+	cond.notify_all();
+	while (!done) cond.wait(guard);
+
+	if (blocks.size() == 1) {
+		current.swap(blocks.front());
+	} else {
+		current.clear();
+		current.reserve(ahead);
+		for (std::list<std::string>::const_iterator it = blocks.begin(); it != blocks.end(); it++) current.append(*it);
+	}
+	blocks.clear();
+	ahead = 0;
+	return !failed;
+}
+
+// Decodes the file in the background.
+void CompoundFileSource::Decoder::run() {
+	bool ok = true;
+	try {
+		boost::iostreams::file_source file(path, std::ios::in | std::ios::binary);
+		boost::iostreams::filtering_istream in;
+		if (codec == GZIP) in.push(boost::iostreams::gzip_decompressor());
+		else in.push(boost::iostreams::zstd_decompressor());
+		in.push(file);
+		ok = file.is_open();
+
+		while (ok) {
+			std::string block(DECODE_BLOCK_SIZE, '\0');
+			in.read(&block[0], DECODE_BLOCK_SIZE);
+			block.resize((size_t)in.gcount());
+
+			// Decoding errors are caught by the stream, which is then bad.
+			ok = !in.bad() && (!in.fail() || in.eof());
+			bool end = !ok || in.eof();
+
+			boost::unique_lock<boost::mutex> guard(lock);
+			while (!stop && !whole && ahead >= DECODE_AHEAD) cond.wait(guard);
+			if (stop) return;
+
+			if (!block.empty()) {
+				ahead += block.size();
+				blocks.push_back(std::string());
+				blocks.back().swap(block);
+			}
+			if (end) {
+				failed = !ok;
+				done = true;
+				cond.notify_all();
+				return;
+			}
+			cond.notify_all();
+		}
+	} catch (std::exception& e) {
+		ok = false;
+	}
+
+	boost::lock_guard<boost::mutex> guard(lock);
+	failed = true;
+	done = true;
+	cond.notify_all();
+}
+
+namespace {
+
+/**
+ * @brief Holds a lock for the lifetime of the guard, or does nothing if there isn't one.
+ */
+class OptionalLock {
+	boost::mutex* mMutex;				///< The mutex we're holding, or null.
+public:
+	inline OptionalLock(boost::mutex* mutex) : mMutex(mutex) { if (mMutex) mMutex->lock(); }
+	inline ~OptionalLock() { if (mMutex) mMutex->unlock(); }
+};
+
+}
+
+/*****************************************************************************************/
+/* File Context */
+/*****************************************************************************************/
+
+/// Free the context
+CompoundFileSource::FileContext::~FileContext() {
+	if (decoder) delete decoder;
+	if (buf) delete[] buf;
+	if (block) delete[] block;
+	if (fetched) delete[] fetched;
+	if (source) {
+		if (source->is_open()) source->close();
+		delete source;
+	}
+	if (map) {
+		if (map->is_open()) map->close();
+		delete map;
+	}
+}
+
+// Places characters at the front of the ring.
+bool CompoundFileSource::FileContext::push(char const* c, size_t n) {
+	if (n > PUSHBACK_SIZE - buflen) return false;
+	if (!buf) buf = new char[PUSHBACK_SIZE];
+
+	// Back the head up and copy the characters in, wrapping around the end if we need to.
+	bufhead = (bufhead + PUSHBACK_SIZE - n) % PUSHBACK_SIZE;
+	size_t first = (n > PUSHBACK_SIZE - bufhead) ? PUSHBACK_SIZE - bufhead : n;
+	memcpy(buf + bufhead, c, first);
+	memcpy(buf, c + first, n - first);
+	buflen += n;
+	return true;
+}
+
+// Takes characters from the front of the ring.
+size_t CompoundFileSource::FileContext::pop(char* c, size_t n) {
+	if (n > buflen) n = buflen;
+
+	size_t first = (n > PUSHBACK_SIZE - bufhead) ? PUSHBACK_SIZE - bufhead : n;
+	memcpy(c, buf + bufhead, first);
+	memcpy(c + first, buf, n - first);
+	bufhead = (bufhead + n) % PUSHBACK_SIZE;
+	buflen -= n;
+	return n;
+}
+
+// Reads the next block from the source.
+bool CompoundFileSource::FileContext::fill() {
+	if (decoder) {
+		if (!decoder->next()) return false;
+		base = pos = decoder->current.data();
+		end = pos + decoder->current.size();
+		return true;
+	}
+
+	if (!source) {
+		// The whole file was prefetched, so there isn't anything else.
+		pos = end;
+		return true;
+	}
+
+	source->read(block, READ_BLOCK_SIZE);
+	if (source->bad() || (source->fail() && !source->eof())) return false;
+
+	// Note that gcount() is 0 once we've hit the end of the file.
+	base = pos = block;
+	end = block + source->gcount();
+	return true;
+}
+
+/******************************************************************************************/
+/* Compound File Source */
+/******************************************************************************************/
+
+// Constructor
+CompoundFileSource::CompoundFileSource(void* nullptr_hack) {
+	mMode = STREAMED;
+	mPrefetchDepth = 0;
+	mPrefetchBudget = 0;
+	mPrefetch = NULL;
+	mBytes = 0;
+	mHits = mMisses = mSkipped = 0;
+	mOnce = false;
+	state(CLOSED);
+}
+
+// Constructor
+CompoundFileSource::CompoundFileSource(mode_t mode) {
+	mMode = (mode == DEFAULT) ? STREAMED : mode;
+	mPrefetchDepth = 0;
+	mPrefetchBudget = 0;
+	mPrefetch = NULL;
+	mBytes = 0;
+	mHits = mMisses = mSkipped = 0;
+	mOnce = false;
+	state(CLOSED);
+}
+
+// Tells boost how much to buffer.
+std::streamsize CompoundFileSource::optimal_buffer_size() const {
+	return (mMode == BUFFERED) ? READ_BLOCK_SIZE : 0;
+}
+
+// Place a file on the stack.
+bool CompoundFileSource::place(std::string const& filename, bool top, std::list<std::string> const* searchPath, mode_t mode) {
+	// State handling...
+	if (state() == ERROR) return false;
+	if (mode == DEFAULT) mode = mMode;
+
+	// initialize the new context
+	FileContext* context = new FileContext(filename, "", NULL, mode);
+
+	// Step 1) Validate the name..
+	//if (!boost::filesystem::native(filename)) {
+	//	// The file's name isn't a valid format.
+	//	delete context;
+	//	return false;
+	//}
+
+
+	// Step 2) Attempt to resolve the file, unless we already have.
+	Resolution const& resolution = resolve(filename, searchPath);
+	if (!resolution.found) {
+		// We don't really know where the file is.
+		delete context;
+		return false;
+	}
+
+	// Files which have already been placed aren't read again, if that's what's wanted.
+	FileId id(resolution.device, resolution.inode);
+	if (mOnce && (mIncluded.count(resolution.resolved) || mIncludedIds.count(id))) {
+		delete context;
+		mSkipped++;
+		return true;
+	}
+
+	boost::filesystem::path filepath(resolution.path);
+	context->resolved = resolution.resolved;
+
+	// Step 3) Ensure the file is readable and open it.
+	if (mode == MAPPED) {
+		bool mapped = false;
+		try {
+			// Empty files can't be mapped, but there's nothing to read from them anyways.
+			if (!resolution.size) {
+				mapped = true;
+			} else {
+				context->map = new boost::iostreams::mapped_file_source(filepath);
+				if (context->map->is_open()) {
+					context->base = context->pos = context->map->data();
+					context->end = context->pos + context->map->size();
+					mapped = true;
+
+					// Compressed files are decoded instead, and handed over in one piece once they have been.
+					codec_t codec = detect(context->map->data(), context->map->size());
+					if (codec != PLAIN) {
+						context->map->close();
+						delete context->map;
+						context->map = NULL;
+						context->base = context->pos = context->end = NULL;
+						context->decoder = new Decoder(context->resolved, codec);
+					}
+				}
+			}
+		} catch (std::exception& e) {
+			// We can't map the file.
+			// TODO: We should really throw this to some sort of debugging output.
+		}
+		if (!mapped) {
+			delete context;
+			return false;
+		}
+	} else {
+		try {
+			context->source = new boost::filesystem::ifstream(filepath);
+		} catch (std::exception& e) {
+			// We can't open the source stream.
+			// TODO: We should really throw this to some sort of debugging output.
+		}
+		if (!context->source || !context->source->good()) {
+			// We can't open the file for some reason.
+			delete context;
+			return false;
+		}
+
+		// Compressed files are decoded a block at a time instead.
+		char magic[4];
+		context->source->read(magic, sizeof(magic));
+		codec_t codec = detect(magic, (size_t)context->source->gcount());
+		context->source->clear();
+		context->source->seekg(0);
+
+		if (codec != PLAIN) {
+			delete context->source;
+			context->source = NULL;
+			context->mode = BUFFERED;
+			context->decoder = new Decoder(context->resolved, codec);
+		} else {
+			// make sure we copy our locality!
+			context->source->imbue(mLocale);
+
+			if (mode == BUFFERED) context->block = new char[READ_BLOCK_SIZE];
+		}
+	}
+
+	// The prefetcher would only read the compressed file as it is.
+	if (context->decoder) context->prefetch = CLAIMED;
+
+	// Step 4) Add the file context to the stack.
+	{
+		OptionalLock guard(mPrefetch ? &mPrefetch->lock : NULL);
+		if (top) {
+			mStack.push_front(context);
+		} else {
+			mStack.push_back(context);
+		}
+		if (mPrefetch) mPrefetch->cond.notify_all();
+	}
+	mPlaced.push_back(context->resolved);
+	mIncluded.insert(context->resolved);
+	mIncludedIds.insert(id);
+	startPrefetch();
+	startDecoders();
+
+	// Indicate that our state is good to go.
+	state(GOOD);
+	return true;
+}
+
+// Finds a name along a search path.
+CompoundFileSource::Resolution const& CompoundFileSource::resolve(std::string const& filename, std::list<std::string> const* searchPath) {
+	// The same name can be found in different places along different search paths, so the path is part of the key.
+	std::string key((searchPath) ? "p" : "w");
+	if (searchPath) {
+		for (std::list<std::string>::const_iterator it = searchPath->begin(); it != searchPath->end(); it++) {
+			key += *it;
+			key += '\0';
+		}
+	}
+	key += filename;
+
+	std::pair<ResolutionMap::iterator, bool> entry = mResolutions.insert(std::make_pair(key, Resolution()));
+	Resolution& resolution = entry.first->second;
+	if (!entry.second) {
+		mHits++;
+		return resolution;
+	}
+	mMisses++;
+	resolution.found = false;
+	resolution.device = resolution.inode = resolution.size = 0;
+
+	// Without a search path, just check the working directory.
+	std::list<std::string> here;
+	if (!searchPath) {
+		here.push_back(boost::filesystem::current_path().string());
+		searchPath = &here;
+	}
+
+	for (std::list<std::string>::const_iterator it = searchPath->begin(); it != searchPath->end(); it++) {
+		try {
+			// A single stat both finds the file and identifies it.
+			boost::filesystem::path filepath = boost::filesystem::absolute(filename, *it);
+			struct stat info;
+			if (::stat(filepath.c_str(), &info)) continue;
+
+			// Resolve all symlinks and finalize the path we're using.
+			resolution.resolved = boost::filesystem::canonical(filepath).string();
+			resolution.path = filepath.string();
+			resolution.device = (boost::uintmax_t)info.st_dev;
+			resolution.inode = (boost::uintmax_t)info.st_ino;
+			resolution.size = (boost::uintmax_t)info.st_size;
+			resolution.found = true;
+			break;
+		} catch (boost::filesystem::filesystem_error& e) {
+			// Something went wrong with our filesystem shenanigans.
+			// TODO: Throw this to some sort of debugging output.
+		}
+	}
+	return resolution;
+}
+
+// Pops the top file context off the stack.
+bool CompoundFileSource::nextFile() {
+	if (state() == ERROR) return false;
+
+	size_t size = mStack.size();
+
+	// pop off the old state.
+	if (size > 1) {
+		FileContext* context;
+		{
+			OptionalLock guard(mPrefetch ? &mPrefetch->lock : NULL);
+			context = mStack.front();
+			mStack.pop_front();
+		}
+		discard(context);
+		startDecoders();
+		state(GOOD);
+	} else {
+		state(END);
+	}
+	return state() == GOOD;
+}
+
+void CompoundFileSource::reset() {
+	if (mStack.size()) {
+		// Prefetched and mapped files don't have a source to reset.
+		if (source()) source()->clear();
+		state(GOOD);
+	} else {
+		state(END);
+	}
+}
+
+// Closes the stream, freeing all available resourced.
+void CompoundFileSource::close() {
+	stopPrefetch();
+	for (std::list<FileContext*>::iterator it = mStack.begin(); it != mStack.end(); it++) {
+		delete *it;
+	}
+	mStack.clear();
+	state(CLOSED);
+}
+
+// Places a number of buffered characters into the input stream to be reread later.
+bool CompoundFileSource::putback(char const* c, std::streamsize n) {
+	FileContext* context;
+
+	switch (state()) {
+	case END:
+	case GOOD:
+		// We should have the last file that we read from
+		// at the top of stack, so let's add it to the buffer
+		context = mStack.front();
+
+		// If the characters are exactly those we just read from the mapping or block
+		// then we can just rewind instead of copying them into the buffer.
+		if (context->mode != STREAMED && !context->buflen && context->base
+			&& context->pos - context->base >= n
+			&& !memcmp(context->pos - n, c, (size_t)n)) {
+			context->pos -= n;
+			return true;
+		}
+
+		// Otherwise they go in front of anything else that's been put back.
+		return context->push(c, (size_t)n);
+
+	case ERROR:
+	case CLOSED:
+	default:
+		return false;
+
+	}
+}
+
+// Imbues the steam with a provided locality for locality sensitive operations.
+void CompoundFileSource::imbue(std::locale const& loc) {
+	mLocale = loc;
+
+	// Propogate the changes to each of the open streams.
+	for (std::list<FileContext*>::iterator it = mStack.begin(); it != mStack.end(); it++) {
+		if ((*it)->source) (*it)->source->imbue(mLocale);
+	}
+}
+
+// Reads from any open files
+std::streamsize CompoundFileSource::read(char* c, std::streamsize n) {
+	std::streamsize needed = n;
+
+	// If we've already hit then end, make sure to tell them.
+	if (state() == END) return -1;
+
+
+	// Read from each file starting from the top until we have 
+	// all the characters we that we need (or run out of files).
+	while (needed && state() == GOOD) {
+		FileContext* context = mStack.front();
+		std::streamsize size;
+
+		if (!context->claimed) claim(context);
+		if (state() != GOOD) break;
+
+		// Check the buffer.
+		if (context->buflen) {
+			// we have something...
+			size = (std::streamsize)context->pop(c, (size_t)needed);
+			c += size;
+			needed -= size;
+		}
+
+		// now try the device...
+		if (needed && context->mode != STREAMED) {
+			// Make sure we have something in the block.
+			if (context->pos == context->end && context->mode == BUFFERED && !context->fill()) {
+				error();
+				break;
+			}
+
+			size = context->end - context->pos;
+			if (!size) {
+				// Only move on once we know the caller wants more than this file has.
+				nextFile();
+				continue;
+			}
+
+			if (size > needed) size = needed;
+			memcpy(c, context->pos, (size_t)size);
+			context->pos += size;
+			c += size;
+			needed -= size;
+		} else if (needed) {
+			context->source->read(c, needed);
+			if (context->source->eof()) {
+				// We've read the entire file.
+				needed -= context->source->gcount();
+				c += context->source->gcount();
+				nextFile();
+			} else if (context->source->fail()) {
+				// Something just went horribly wrong...
+				error();
+			} else {
+				// Everything is a-ok and we have everything we need!
+				needed = 0;
+			}
+		}
+	}
+
+	mBytes += (size_t)(n - needed);
+	return n - needed;
+}
+
+// Provides direct access to the remainder of the mapping or block at the top of the stack.
+char const* CompoundFileSource::span(std::streamsize& n) {
+	n = 0;
+	while (state() == GOOD) {
+		FileContext* context = mStack.front();
+		if (!context->claimed) claim(context);
+		if (state() != GOOD) return NULL;
+
+		// Anything that has been put back has to come out first.
+		if (context->mode == STREAMED || context->buflen) return NULL;
+
+		if (context->pos == context->end && context->mode == BUFFERED && !context->fill()) {
+			error();
+			return NULL;
+		}
+
+		if (context->pos != context->end) {
+			n = context->end - context->pos;
+			return context->pos;
+		}
+
+		// This file's exhausted, try the next one.
+		nextFile();
+	}
+	return NULL;
+}
+
+// Reads the remainder of the top file.
+bool CompoundFileSource::readFile(std::string& out) {
+	if (state() != GOOD) return false;
+
+	FileContext* context = mStack.front();
+	if (!context->claimed) claim(context);
+	if (state() != GOOD) return false;
+	size_t start = out.size();
+
+	// Anything put back comes first.
+	if (context->buflen) {
+		size_t old = out.size();
+		out.resize(old + context->buflen);
+		context->pop(&out[old], context->buflen);
+	}
+
+	if (context->mode != STREAMED) {
+		for (;;) {
+			out.append(context->pos, context->end - context->pos);
+			context->pos = context->end;
+
+			if (context->mode != BUFFERED) break;
+			if (!context->fill()) {
+				error();
+				return false;
+			}
+			if (context->pos == context->end) break;
+		}
+	} else {
+		char block[BUFSIZ];
+		do {
+			context->source->read(block, sizeof(block));
+			out.append(block, (size_t)context->source->gcount());
+		} while (context->source->good());
+
+		if (context->source->bad()) {
+			error();
+			return false;
+		}
+	}
+	mBytes += out.size() - start;
+	return true;
+}
+
+// Configures the prefetcher.
+void CompoundFileSource::prefetch(size_t depth, size_t budget) {
+	{
+		OptionalLock guard(mPrefetch ? &mPrefetch->lock : NULL);
+		mPrefetchDepth = depth;
+		mPrefetchBudget = budget;
+		if (mPrefetch) mPrefetch->cond.notify_all();
+	}
+
+	if (!depth) stopPrefetch();
+	else if (mStack.size()) startPrefetch();
+}
+
+// Recognizes compressed files.
+CompoundFileSource::codec_t CompoundFileSource::detect(char const* data, size_t n) {
+	unsigned char const* p = (unsigned char const*)data;
+	if (n >= 2 && p[0] == 0x1f && p[1] == 0x8b) return GZIP;
+	if (n >= 4 && p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f && p[3] == 0xfd) return ZSTD;
+	return PLAIN;
+}
+
+// Marks the context as being read from.
+void CompoundFileSource::claim(FileContext* context) {
+	context->claimed = true;
+	if (context->decoder) {
+		if (context->mode == MAPPED) {
+			if (!context->decoder->rest()) error();
+			context->base = context->pos = context->decoder->current.data();
+			context->end = context->pos + context->decoder->current.size();
+		}
+		return;
+	}
+
+	if (!mPrefetch) {
+		// Nobody else is looking at the context.
+		context->prefetch = CLAIMED;
+		return;
+	}
+
+	boost::unique_lock<boost::mutex> lock(mPrefetch->lock);
+	while (context->prefetch == LOADING) mPrefetch->cond.wait(lock);
+
+	if (context->prefetch == FETCHED) {
+		// Read from memory instead of the source from now on.
+		if (context->source->is_open()) context->source->close();
+		delete context->source;
+		context->source = NULL;
+
+		if (context->block) delete[] context->block;
+		context->block = context->fetched;
+		context->fetched = NULL;
+		context->base = context->pos = context->block;
+		context->end = context->block + context->size;
+		context->mode = BUFFERED;
+	}
+	context->prefetch = CLAIMED;
+}
+
+// Frees a context which is no longer on the stack.
+void CompoundFileSource::discard(FileContext* context) {
+	if (mPrefetch) {
+		boost::unique_lock<boost::mutex> lock(mPrefetch->lock);
+		while (context->prefetch == LOADING) mPrefetch->cond.wait(lock);
+		mPrefetch->used -= context->charged;
+		context->charged = 0;
+		mPrefetch->cond.notify_all();
+	}
+	delete context;
+}
+
+// Starts decoding the files near the top of the stack.
+void CompoundFileSource::startDecoders() {
+	size_t i = 0;
+	for (std::list<FileContext*>::iterator it = mStack.begin(); it != mStack.end() && i < 2; it++, i++) {
+		if ((*it)->decoder) (*it)->decoder->start();
+	}
+}
+
+// Starts the prefetching thread.
+void CompoundFileSource::startPrefetch() {
+	if (mPrefetch || !mPrefetchDepth) return;
+	mPrefetch = new Prefetcher();
+
+	// Account for anything the last prefetcher left behind.
+	for (std::list<FileContext*>::iterator it = mStack.begin(); it != mStack.end(); it++) {
+		mPrefetch->used += (*it)->charged;
+	}
+	mPrefetch->thread = boost::thread(boost::bind(&CompoundFileSource::prefetchLoop, this));
+}
+
+// Stops the prefetching thread.
+void CompoundFileSource::stopPrefetch() {
+	if (!mPrefetch) return;
+	{
+		boost::lock_guard<boost::mutex> guard(mPrefetch->lock);
+		mPrefetch->stop = true;
+		mPrefetch->cond.notify_all();
+	}
+	mPrefetch->thread.join();
+	delete mPrefetch;
+	mPrefetch = NULL;
+}
+
+// Reads queued files into memory in the background.
+void CompoundFileSource::prefetchLoop() {
+	boost::unique_lock<boost::mutex> lock(mPrefetch->lock);
+
+	while (!mPrefetch->stop) {
+		// Find the first file within reach that hasn't been looked at and that we have room for.
+		size_t room = (mPrefetch->used < mPrefetchBudget) ? mPrefetchBudget - mPrefetch->used : 0;
+		FileContext* target = NULL;
+		size_t i = 0;
+		for (std::list<FileContext*>::iterator it = mStack.begin(); it != mStack.end() && i <= mPrefetchDepth; it++, i++) {
+			FileContext* context = *it;
+			if (context->prefetch != NOT_FETCHED || context->mode == MAPPED) continue;
+			if (context->size >= 0 && (size_t)context->size > room) continue;
+			target = context;
+			break;
+		}
+
+		if (!target) {
+			mPrefetch->cond.wait(lock);
+			continue;
+		}
+
+		// Mark the file so the reader waits for us if it gets to it before we're done.
+		target->prefetch = LOADING;
+		std::string path = target->resolved;
+
+		if (target->size < 0) {
+			// Find out how big the file is before we commit to reading it.
+			std::streamsize size;
+			lock.unlock();
+			try {
+				size = (std::streamsize)boost::filesystem::file_size(path);
+			} catch (std::exception& e) {
+				size = -1;
+			}
+			lock.lock();
+
+			room = (mPrefetch->used < mPrefetchBudget) ? mPrefetchBudget - mPrefetch->used : 0;
+			target->size = size;
+			if (size < 0 || (size_t)size > room) {
+				// We can't fetch it, at least not yet.
+				target->prefetch = (size < 0) ? CLAIMED : NOT_FETCHED;
+				mPrefetch->cond.notify_all();
+				continue;
+			}
+		}
+
+		// Reserve the memory and read the file.
+		std::streamsize size = target->size;
+		mPrefetch->used += (size_t)size;
+		target->charged = (size_t)size;
+		lock.unlock();
+
+		char* data = NULL;
+		std::streamsize got = 0;
+		bool ok = false;
+		try {
+			data = new char[(size_t)size + 1];
+			boost::filesystem::ifstream in(path);
+			in.read(data, size);
+			got = in.gcount();
+
+			// If the file has grown since we checked, just let the reader deal with it.
+			ok = !in.bad() && in.peek() == std::char_traits<char>::eof();
+		} catch (std::exception& e) {
+			ok = false;
+		}
+
+		lock.lock();
+		if (ok) {
+			target->fetched = data;
+			target->size = got;
+			target->prefetch = FETCHED;
+		} else {
+			if (data) delete[] data;
+			mPrefetch->used -= target->charged;
+			target->charged = 0;
+			target->prefetch = CLAIMED;
+		}
+		mPrefetch->cond.notify_all();
+	}
+}
+
 }
\ No newline at end of file
@@ -1,242 +1,487 @@
-#ifndef __H_COMPOUND_IFSTREAM__
-#define __H_COMPOUND_IFSTREAM__
-
-#include <boost/iostreams/concepts.hpp>
-#include <boost/iostreams/categories.hpp>
-#include <boost/filesystem/fstream.hpp>
-#include <boost/iostreams/stream.hpp>
-
-#include <string>
-#include <list>
-
-
-namespace utils {
-
-/**
-	* @brief An extension of the ifstream in order to allow for reading from multiple files seamlessly.
-	* @param Ch The character type.
-	*/
-class CompoundFileSource {
-
-public:
-	/***********************************************************************/
-	/* Types */
-	/***********************************************************************/
-
-	/**
-		* @brief The type to use as the character type.
-		*/
-	typedef char char_type;
-	
-	/**
-		* @brief An enumeration of the various states that the file stream can take.
-		*/
-	enum state_t {
-		GOOD = 0,			///< Indicates the stream is ready and has more characters to read.
-		ERROR,				///< Indicates that an error ocurred and the stream has been forcefully closed.
-		END,				///< Indicates that the stream has reached the end of all files.
-		CLOSED				///< Indicates that the stream has been closed and there are no more characters to read.
-	};
-
-
-	/**
-		* @brief The definition of exactly what this device is capable of.
-		* source_tag				- The device is able to read characters.
-		* closable_tag				- The device should be closed when it's obsolete.
-		* peekable_tag				- The device allows for the next character to be seen without reading it.
-		* localizable_tag			- The device should be notified when the locality of the stream changes.
-		* optimally_buffered_tag	- The device provides a default buffer size to use.
-		*/
-	typedef struct
-		: boost::iostreams::source_tag,
-			boost::iostreams::closable_tag,
-			boost::iostreams::peekable_tag,
-			boost::iostreams::localizable_tag,
-			boost::iostreams::optimally_buffered_tag
-	{ } category;
-
-private:
-
-	/***********************************************************************/
-	/* Private types */
-	/***********************************************************************/
-
-	/**
-		* @brief A simple structure representing the current state of a file we are reading.
-		*/
-	struct FileContext {
-		std::string filename;					///< The file name specified by the user.
-		std::string resolved;					///< The complete path
-		char* buf;								///< A buffer used to store data that has be put back into the stream.
-		size_t bufsize;							///< The size of buf.
-		size_t bufpos;							///< The position that we're at within buf.
-		std::ifstream* source;					///< The source used to read from, or null if we don't have a stream open.
-
-		/**
-			* @brief Initializes the context, allocated a buffer if a non-zero buffer size was specified.
-			*/
-		inline FileContext(std::string const& _filename, std::string const& _resolved, std::ifstream* _source, size_t _bufsize)
-			: filename(_filename), resolved(_resolved), buf(NULL), bufsize(_bufsize), bufpos(0), source(_source)
-			{ if (bufsize) buf = new char[bufsize]; }
-
-
-		/**
-			* @brief Deallocated the buffer, closes, and deallocates the source.
-			*/
-		~FileContext();
-
-	};
-
-	/***********************************************************************/
-	/* Members */
-	/***********************************************************************/
-	std::list<FileContext*> mStack;			///< The stack of files we are currently reading through.
-
-	std::locale mLocale;					///< Our current locale. Used to propogate to each source.
-
-	state_t mState;							///< The current state of the stream.
-
-
-public:
-	/***********************************************************************/
-	/* Constructors / Destructors */
-	/***********************************************************************/
-
-	/**
-	 * @brief Basic Constructor.
- 	 * Initializes the filestream.
-	 * @param nullptr_hack a hack argument that can be used to allow boost::iostreams::stream.open to be called. Functionally serves no purpose.
-	 */
-	CompoundFileSource(void* nullptr_hack = NULL);
-
-	/**
-		* @brief Basic Destructor.
-		* Closes all open input streams.
-		*/
-	virtual inline ~CompoundFileSource() { if (state() != CLOSED) close(); };
-
-	/***********************************************************************/
-	/***********************************************************************/
-
-	/**
-		* @brief adds the specified file to the end of the effective input stream.
-		* @param filename The file to add.
-		* @param searchPath A list of locations to search for the file, or NULL to just check the working directory.
-		*/
-	inline bool append(std::string const& filename, std::list<std::string> const* searchPath = NULL) throw(...) { 
-		return place(filename, false, searchPath);
-	}
-
-	/**
-		* @brief adds the specified file to the current location in the effective input stream.
-		* @param filename The file to add.
-		* @param searchPath A list of locations to search for the file, or NULL to just check the working directory.
-		*/
-	inline bool insert(std::string const& filename, std::list<std::string> const* searchPath = NULL) throw(...) {
-		return place(filename, true, searchPath);
-	}
-
-	/**
-	* @brief Attempts to move to the next file in the stream.
-	* @return True if there are still files in the stream. False otherwise.
-	* @throws InvalidStateException If the stream is in an error state and hasn't been reset.
-	*/
-	bool nextFile();
-
-
-	inline std::ifstream const* source() const { return mStack.size() ? mStack.front()->source : NULL; }
-
-	/// Gets the name of the file at the top of the stack, or NULL.
-	inline std::string const* filename() const { return mStack.size() ? &mStack.front()->filename : NULL; }
-
-	/// Gets the absolute name of the file at the top of the stack, or NULL.
-	inline std::string const* resolved() const { return mStack.size() ? &mStack.front()->resolved : NULL; }
-
-	/**
-	 * A function used to tell boost that the input should be unbuffered (from their perspective).
-	 * This is to allow for us to push file contexts onto the read stack dynamically.
-	 */
-	inline std::streamsize optimal_buffer_size() const { return 0; }
-
-	/**
-	 * @brief Determines the state of the stream.
-	 * @returns The current state of the stream.
-	 */
-	inline state_t state() const { return mState; }
-
-	/// Determines if the stream is open.
-	inline bool is_open() const { return state() != CLOSED; }
-
-	/// Determines if the stream is ready to read from.
-	inline bool good() const { return state() == GOOD; }
-
-	/**
-	 * @brief Attempts to reset the IO stream after an error has occurred.
-	 */
-	void reset();
-
-	/**
-	 * @brief Closes all input streams.
-	 */
-	void close();
-
-	/**
-	 * @brief Puts the character back into the read stream.
-	 * @param c The character to put back.
-	 * @return True if successful, false otherwise.
-	 */
-	bool putback(char c) { return putback(&c, 1); }
-
-	/**
-	 * @brief Places a number of buffered characters into the input stream to be reread later.
-	 * @return True if successful, false otherwise.
-	 */
-	bool putback(char const* c, std::streamsize n);
-
-
-	/**
-	 * @brief Imbues the device with the provided locality.
-	 * @param the new locality.
-	 */
-	void imbue(std::locale const& loc);
-
-	/**
-	 * @brief Attempts to read from the input stream.
-	 * @param c The buffer to write to.
-	 * @param n The number of characters to read.
-	 * @returns The number of characters read, or -1 to indicate the end of stream.
-	 */
-	std::streamsize read(char* c, std::streamsize n);
-
-protected:
-
-	/// Gets the source stream for the top of the stack, or NULL.
-	inline std::ifstream* source() { return mStack.size() ? mStack.front()->source : NULL; }
-
-	/// Signals that an error has occurred.
-	inline void error() { state(ERROR); }
-
-	/// Sets the state of the stream.
-	inline void state(state_t state) { mState = state; }
-
-private:
-
-
-	/**
-	 * @brief Resolves and opens the provided file name, placing the resulting context on the stack.
-	 * @param filename The name of the file to open.
-	 * @param top Whether the file should be placed at the top of the stack, or the bottom.
-	 * @param searchPath A list of locations to search for the file, or NULL to just check the working directory.
-	 */
-	bool place(std::string const& filename, bool top, std::list<std::string> const* searchPath = NULL);
-
-};
-
-/**
- * @brief A stream wrapper for working with multiple concurrent source files.
- */
-typedef boost::iostreams::stream<CompoundFileSource> CompoundFileStream;
-
-}
-
+#ifndef __H_COMPOUND_IFSTREAM__
+#define __H_COMPOUND_IFSTREAM__
+
+#include <boost/iostreams/concepts.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/cstdint.hpp>
+
+#include <string>
+#include <list>
+#include <utility>
+
+
+namespace utils {
+
+/**
+	* @brief An extension of the ifstream in order to allow for reading from multiple files seamlessly.
+	* Files compressed with gzip or Zstandard are recognized by their first few bytes, whatever their name, and are
+	* decoded by a helper thread a block at a time, which keeps a bounded number of blocks ahead of the reader. They're
+	* read as though they were BUFFERED, except that those placed as MAPPED are handed over in one piece (as a mapping
+	* would be) once they've been decoded completely. Decoding starts once a file reaches the top of the stack or the
+	* place directly beneath it, so the next file is decoded while the current one is being read.
+	*
+	* Where each name was found along each search path is remembered for as long as the source lives, so a name that's
+	* placed again (as an include would be) costs no file system calls to find. Optionally, a file which has already
+	* been placed is never placed again, even under another name, as recognized by its canonical path or its device
+	* and inode.
+	* @param Ch The character type.
+	*/
+class CompoundFileSource {
+
+public:
+	/***********************************************************************/
+	/* Types */
+	/***********************************************************************/
+
+	/**
+		* @brief The type to use as the character type.
+		*/
+	typedef char char_type;
+	
+	/**
+		* @brief An enumeration of the various states that the file stream can take.
+		*/
+	enum state_t {
+		GOOD = 0,			///< Indicates the stream is ready and has more characters to read.
+		ERROR,				///< Indicates that an error ocurred and the stream has been forcefully closed.
+		END,				///< Indicates that the stream has reached the end of all files.
+		CLOSED				///< Indicates that the stream has been closed and there are no more characters to read.
+	};
+
+	/**
+		* @brief An enumeration of the ways in which a file can be read from once it has been placed on the stack.
+		*/
+	enum mode_t {
+		DEFAULT = -1,		///< Use the mode that the source was constructed with.
+		STREAMED = 0,		///< The file is read through an std::ifstream.
+		BUFFERED,			///< The file is read through an std::ifstream a large block at a time.
+		MAPPED				///< The file is mapped into memory and read directly from the mapping.
+	};
+
+
+	/**
+		* @brief The definition of exactly what this device is capable of.
+		* source_tag				- The device is able to read characters.
+		* closable_tag				- The device should be closed when it's obsolete.
+		* peekable_tag				- The device allows for the next character to be seen without reading it.
+		* localizable_tag			- The device should be notified when the locality of the stream changes.
+		* optimally_buffered_tag	- The device provides a default buffer size to use.
+		*/
+	typedef struct
+		: boost::iostreams::source_tag,
+			boost::iostreams::closable_tag,
+			boost::iostreams::peekable_tag,
+			boost::iostreams::localizable_tag,
+			boost::iostreams::optimally_buffered_tag
+	{ } category;
+
+private:
+
+	/***********************************************************************/
+	/* Private types */
+	/***********************************************************************/
+
+	/**
+		* @brief An enumeration of the states a file can be in with respect to the background prefetcher.
+		*/
+	enum prefetch_t {
+		NOT_FETCHED = 0,		///< The file hasn't been looked at by the prefetcher.
+		LOADING,				///< The prefetcher is currently reading the file into memory.
+		FETCHED,				///< The file has been read into memory and is waiting to be used.
+		CLAIMED					///< The file has started being read from and shouldn't be prefetched.
+	};
+
+	/**
+		* @brief An enumeration of the compressed formats which are recognized by their first few bytes and decoded as they're read.
+		*/
+	enum codec_t {
+		PLAIN = 0,				///< The file isn't compressed.
+		GZIP,					///< The file is compressed with gzip.
+		ZSTD					///< The file is compressed with Zstandard.
+	};
+
+	/**
+		* @brief Where a name was found along a search path, if it was.
+		*/
+	struct Resolution {
+		bool found;								///< Whether the name was found.
+		std::string path;						///< The absolute path the name was found at.
+		std::string resolved;					///< The canonical path, with every symlink resolved.
+		boost::uintmax_t device;				///< The device the file is on.
+		boost::uintmax_t inode;					///< The inode of the file within its device.
+		boost::uintmax_t size;					///< The size of the file when it was found.
+	};
+
+	/// Where each name was found, keyed by the search path and the name.
+	typedef boost::unordered_map<std::string, Resolution> ResolutionMap;
+
+	/// The identity of a file, as its device and inode.
+	typedef std::pair<boost::uintmax_t, boost::uintmax_t> FileId;
+
+	/**
+		* @brief The state shared with the background prefetching thread. Defined in the implementation.
+		*/
+	struct Prefetcher;
+
+	/**
+		* @brief The state shared with the helper thread decoding a compressed file. Defined in the implementation.
+		*/
+	struct Decoder;
+
+	/**
+		* @brief A simple structure representing the current state of a file we are reading.
+		*/
+	struct FileContext {
+		std::string filename;					///< The file name specified by the user.
+		std::string resolved;					///< The complete path
+		char* buf;								///< A fixed size ring used to store data that has be put back into the stream, or null if nothing has been put back yet.
+		size_t bufhead;							///< The position of the next character to read within buf.
+		size_t buflen;							///< The number of characters waiting to be read within buf.
+		std::ifstream* source;					///< The source used to read from, or null if we don't have a stream open.
+		mode_t mode;							///< The way in which the file is read from.
+		boost::iostreams::mapped_file_source* map;	///< The read-only mapping of the file, or null if the file isn't mapped (or is empty).
+		char* block;							///< The read-ahead block for buffered files, or null.
+		char const* base;						///< The beginning of the mapping or read-ahead block.
+		char const* pos;						///< The next unread character within the mapping or read-ahead block.
+		char const* end;						///< One past the last character within the mapping or read-ahead block.
+		bool claimed;							///< Whether we've started reading from this file. Only used by the reading thread.
+		prefetch_t prefetch;					///< The state of the file with respect to the prefetcher. Guarded by the prefetcher's lock.
+		char* fetched;							///< The contents of the file once it has been FETCHED, or null. Guarded by the prefetcher's lock.
+		std::streamsize size;					///< The size of the file, or -1 if it is unknown. Guarded by the prefetcher's lock.
+		size_t charged;							///< The number of bytes counted against the prefetch budget for this file. Guarded by the prefetcher's lock.
+		Decoder* decoder;						///< The decoder of the file if it's compressed, or null.
+
+		/**
+			* @brief Initializes the context.
+			*/
+		inline FileContext(std::string const& _filename, std::string const& _resolved, std::ifstream* _source, mode_t _mode = STREAMED)
+			: filename(_filename), resolved(_resolved), buf(NULL), bufhead(0), buflen(0), source(_source),
+			  mode(_mode), map(NULL), block(NULL), base(NULL), pos(NULL), end(NULL),
+			  claimed(false), prefetch(NOT_FETCHED), fetched(NULL), size(-1), charged(0), decoder(NULL)
+			{ /* Intentionally Left Blank */ }
+
+
+		/**
+			* @brief Deallocated the buffers, closes, and deallocates the source.
+			*/
+		~FileContext();
+
+		/**
+			* @brief Places characters at the front of the pushback ring.
+			* @return True if successful, false if the ring doesn't have room for them.
+			*/
+		bool push(char const* c, size_t n);
+
+		/**
+			* @brief Removes up to n characters from the front of the pushback ring.
+			* @return The number of characters copied to c.
+			*/
+		size_t pop(char* c, size_t n);
+
+		/**
+			* @brief Refills the read-ahead block from the source, or with the next block from the decoder.
+			* @return False if the source couldn't be read from.
+			*/
+		bool fill();
+
+	};
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+	std::list<FileContext*> mStack;			///< The stack of files we are currently reading through.
+
+	std::list<std::string> mPlaced;			///< The absolute name of every file which has been placed in the stream, in the order they were placed.
+
+	std::locale mLocale;					///< Our current locale. Used to propogate to each source.
+
+	state_t mState;							///< The current state of the stream.
+
+	mode_t mMode;							///< The mode used to read files which are placed using DEFAULT.
+
+	size_t mPrefetchDepth;					///< The number of files beneath the top of the stack to read ahead in the background, or 0 to disable prefetching.
+	size_t mPrefetchBudget;					///< The maximum number of bytes the prefetcher may hold in memory at once.
+	Prefetcher* mPrefetch;					///< The running prefetcher, or null if it hasn't been started.
+	size_t mBytes;							///< The number of characters read from the stream so far.
+
+	ResolutionMap mResolutions;				///< Where each name has been found along each search path.
+	size_t mHits;							///< The number of names placed which had been resolved before.
+	size_t mMisses;							///< The number of names placed which had to be resolved.
+	bool mOnce;								///< Whether files which have already been placed are skipped.
+	boost::unordered_set<std::string> mIncluded;	///< The canonical path of every file which has been placed.
+	boost::unordered_set<FileId> mIncludedIds;		///< The identity of every file which has been placed.
+	size_t mSkipped;						///< The number of files which weren't placed because they already had been.
+
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+ 	 * Initializes the filestream.
+	 * @param nullptr_hack a hack argument that can be used to allow boost::iostreams::stream.open to be called. Functionally serves no purpose.
+	 */
+	CompoundFileSource(void* nullptr_hack = NULL);
+
+	/**
+	 * @brief Initializes the filestream to read files in the provided mode by default.
+	 * Sources constructed BUFFERED also ask the wrapping stream to buffer their output (see optimal_buffer_size()).
+	 * @param mode The mode used for files which are placed using DEFAULT.
+	 */
+	CompoundFileSource(mode_t mode);
+
+	/**
+		* @brief Basic Destructor.
+		* Closes all open input streams.
+		*/
+	virtual inline ~CompoundFileSource() { if (state() != CLOSED) close(); };
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/**
+		* @brief adds the specified file to the end of the effective input stream.
+		* @param filename The file to add.
+		* @param searchPath A list of locations to search for the file, or NULL to just check the working directory.
+		* @param mode The way in which the file should be read.
+		*/
+	inline bool append(std::string const& filename, std::list<std::string> const* searchPath = NULL, mode_t mode = DEFAULT) { 
+		return place(filename, false, searchPath, mode);
+	}
+
+	/**
+		* @brief adds the specified file to the current location in the effective input stream.
+		* @param filename The file to add.
+		* @param searchPath A list of locations to search for the file, or NULL to just check the working directory.
+		* @param mode The way in which the file should be read.
+		*/
+	inline bool insert(std::string const& filename, std::list<std::string> const* searchPath = NULL, mode_t mode = DEFAULT) {
+		return place(filename, true, searchPath, mode);
+	}
+
+	/**
+	* @brief Attempts to move to the next file in the stream.
+	* @return True if there are still files in the stream. False otherwise.
+	* @throws InvalidStateException If the stream is in an error state and hasn't been reset.
+	*/
+	bool nextFile();
+
+
+	inline std::ifstream const* source() const { return mStack.size() ? mStack.front()->source : NULL; }
+
+	/// Gets the name of the file at the top of the stack, or NULL.
+	inline std::string const* filename() const { return mStack.size() ? &mStack.front()->filename : NULL; }
+
+	/// Gets the absolute name of the file at the top of the stack, or NULL.
+	inline std::string const* resolved() const { return mStack.size() ? &mStack.front()->resolved : NULL; }
+
+	/// Gets the absolute name of every file which has been appended or inserted, whether or not it has been read yet.
+	inline std::list<std::string> const& placed() const { return mPlaced; }
+
+	/**
+	 * @brief Sets whether files which have already been placed are skipped, so that each is read only once.
+	 * A skipped file is still reported as having been placed successfully.
+	 */
+	inline void once(bool once) { mOnce = once; }
+
+	/// Determines whether files which have already been placed are skipped.
+	inline bool once() const { return mOnce; }
+
+	/// Gets the number of names placed which were found without searching for them, since they had been before.
+	inline size_t resolutionHits() const { return mHits; }
+
+	/// Gets the number of names placed which had to be searched for.
+	inline size_t resolutionMisses() const { return mMisses; }
+
+	/// Gets the number of files which were skipped because they had already been placed.
+	inline size_t skipped() const { return mSkipped; }
+
+	/// Determines whether the file at the top of the stack is being read from a memory mapping.
+	inline bool mapped() const { return mStack.size() && mStack.front()->mode == MAPPED; }
+
+	/**
+	 * @brief Provides direct access to the unread portion of the mapping or read-ahead block for the file at the top of the stack.
+	 * For MAPPED files the returned characters remain valid until the file is popped from the stack, allowing a
+	 * consumer to refer to them without copying. For BUFFERED files they remain valid until the next call to span() or read().
+	 * Once exhausted, the stack is advanced to the next file automatically.
+	 * @param n Set to the number of characters available at the returned location.
+	 * @return A pointer to the next unread character, or NULL if the top file is STREAMED, there are
+	 * characters pending from putback() (which should be drained using read()), or the stream has ended.
+	 */
+	char const* span(std::streamsize& n);
+
+	/**
+	 * @brief Reads the remainder of the file at the top of the stack, including anything put back into it.
+	 * Unlike read(), this doesn't move on to the next file once the top file has been exhausted, so the
+	 * caller can still refer to it. nextFile() should be used to move on.
+	 * @param out The string to append the characters to.
+	 * @return True if successful, false otherwise.
+	 */
+	bool readFile(std::string& out);
+
+	/**
+	 * @brief Marks characters returned from span() as read.
+	 * @param n The number of characters to skip. Must not exceed the size of the last span.
+	 */
+	inline void consume(std::streamsize n) { mStack.front()->pos += n; mBytes += (size_t)n; }
+
+	/// Gets the number of characters read so far, whether through read(), readFile() or span() and consume().
+	inline size_t bytes() const { return mBytes; }
+
+	/**
+	 * A function used to tell boost how much it should buffer from the device.
+	 * Unless the source was constructed BUFFERED this is 0 so that the input is unbuffered (from their perspective),
+	 * allowing for us to push file contexts onto the read stack dynamically. Otherwise this is the size of a read-ahead
+	 * block, and any file inserted is only seen once the characters the stream has already buffered are consumed.
+	 */
+	std::streamsize optimal_buffer_size() const;
+
+	/**
+	 * @brief Determines the state of the stream.
+	 * @returns The current state of the stream.
+	 */
+	inline state_t state() const { return mState; }
+
+	/// Determines if the stream is open.
+	inline bool is_open() const { return state() != CLOSED; }
+
+	/// Determines if the stream is ready to read from.
+	inline bool good() const { return state() == GOOD; }
+
+	/**
+	 * @brief Configures background prefetching of the files queued beneath the top of the stack.
+	 * While the top file is being read, a helper thread reads up to depth of the following STREAMED or BUFFERED files
+	 * entirely into memory so that moving on to them doesn't stall on the file system. Files that have already been
+	 * read from (such as those pushed down by insert()) are never prefetched.
+	 * @param depth The number of files beneath the top of the stack to read ahead, or 0 to disable prefetching.
+	 * @param budget The maximum number of bytes that prefetched files may occupy at once. Files larger than the
+	 * remaining budget are skipped until enough memory is released by moving past earlier files.
+	 */
+	void prefetch(size_t depth, size_t budget);
+
+	/// Gets the number of files that are read ahead in the background.
+	inline size_t prefetchDepth() const { return mPrefetchDepth; }
+
+	/// Gets the maximum number of bytes that prefetched files may occupy at once.
+	inline size_t prefetchBudget() const { return mPrefetchBudget; }
+
+	/**
+	 * @brief Attempts to reset the IO stream after an error has occurred.
+	 */
+	void reset();
+
+	/**
+	 * @brief Closes all input streams.
+	 */
+	void close();
+
+	/**
+	 * @brief Puts the character back into the read stream.
+	 * @param c The character to put back.
+	 * @return True if successful, false otherwise.
+	 */
+	bool putback(char c) { return putback(&c, 1); }
+
+	/**
+	 * @brief Places a number of buffered characters into the input stream to be reread later.
+	 * For mapped and buffered files, characters which match those just read are recovered by rewinding
+	 * rather than being copied. Otherwise they are kept in a fixed size ring, which is drained first.
+	 * @return True if successful, false otherwise (including if the ring would overflow).
+	 */
+	bool putback(char const* c, std::streamsize n);
+
+
+	/**
+	 * @brief Imbues the device with the provided locality.
+	 * @param the new locality.
+	 */
+	void imbue(std::locale const& loc);
+
+	/**
+	 * @brief Attempts to read from the input stream.
+	 * @param c The buffer to write to.
+	 * @param n The number of characters to read.
+	 * @returns The number of characters read, or -1 to indicate the end of stream.
+	 */
+	std::streamsize read(char* c, std::streamsize n);
+
+protected:
+
+	/// Gets the source stream for the top of the stack, or NULL.
+	inline std::ifstream* source() { return mStack.size() ? mStack.front()->source : NULL; }
+
+	/// Signals that an error has occurred.
+	inline void error() { state(ERROR); }
+
+	/// Sets the state of the stream.
+	inline void state(state_t state) { mState = state; }
+
+private:
+
+
+	/**
+	 * @brief Resolves and opens the provided file name, placing the resulting context on the stack.
+	 * @param filename The name of the file to open.
+	 * @param top Whether the file should be placed at the top of the stack, or the bottom.
+	 * @param searchPath A list of locations to search for the file, or NULL to just check the working directory.
+	 * @param mode The way in which the file should be read.
+	 */
+	bool place(std::string const& filename, bool top, std::list<std::string> const* searchPath = NULL, mode_t mode = DEFAULT);
+
+	/**
+	 * @brief Finds a name along a search path, or gets where it was found before.
+	 * @param filename The name to find.
+	 * @param searchPath A list of locations to search for the file, or NULL to just check the working directory.
+	 * @return Where the name was found, if it was.
+	 */
+	Resolution const& resolve(std::string const& filename, std::list<std::string> const* searchPath);
+
+	/**
+	 * @brief Determines whether the first few bytes of a file are those of a compressed format.
+	 * @param data The beginning of the file.
+	 * @param n The number of bytes available, which may be fewer than the file has.
+	 */
+	static codec_t detect(char const* data, size_t n);
+
+	/**
+	 * @brief Marks the context as being read from, waiting for and adopting its prefetched contents if there are any.
+	 * A compressed file read as MAPPED is waited for until it has been decoded completely, and an error is signalled if it can't be.
+	 * @param context The context at the top of the stack.
+	 */
+	void claim(FileContext* context);
+
+	/// Starts decoding the compressed files at the top of the stack and directly beneath it, if they haven't been started already.
+	void startDecoders();
+
+	/**
+	 * @brief Frees a context that has been removed from the stack, returning its memory to the prefetch budget.
+	 * Waits for the prefetcher to finish with it first, so the prefetcher's lock must not be held by the caller.
+	 */
+	void discard(FileContext* context);
+
+	/// Starts the prefetching thread if prefetching is enabled and it isn't already running.
+	void startPrefetch();
+
+	/// Stops the prefetching thread and waits for it to exit.
+	void stopPrefetch();
+
+	/// The body of the prefetching thread.
+	void prefetchLoop();
+
+};
+
+/**
+ * @brief A stream wrapper for working with multiple concurrent source files.
+ */
+typedef boost::iostreams::stream<CompoundFileSource> CompoundFileStream;
+
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include <cerrno>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "FileMonitor.h"
+
+/// The events which mean a file's contents may have changed.
+#define MONITOR_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE)
+
+/// The time (in milliseconds) without any further events after which the files are considered settled.
+#define MONITOR_SETTLE 15
+
+/// The number of seconds a file's modification time may lag the time it was read by.
+#define MONITOR_SLACK 1
+
+/// The size of the buffer events are read into.
+#define MONITOR_BUFFER (1 << 16)
+
+namespace utils {
+
+// Constructor
+FileMonitor::FileMonitor() {
+	mFd = inotify_init1(IN_CLOEXEC);
+}
+
+// Destructor
+FileMonitor::~FileMonitor() {
+	if (mFd >= 0) close(mFd);
+}
+
+// Watches a file.
+bool FileMonitor::watch(std::string const& file, std::time_t since) {
+	if (mFd < 0) return false;
+
+	boost::filesystem::path path;
+	try {
+		path = boost::filesystem::canonical(file);
+	} catch (boost::filesystem::filesystem_error& e) {
+		return false;
+	}
+	if (mFiles.count(path.string())) return true;
+
+	// Watching the same directory again gives back the same descriptor.
+	std::string dir = path.parent_path().string();
+	int wd = inotify_add_watch(mFd, dir.c_str(), MONITOR_EVENTS);
+	if (wd < 0) return false;
+
+	mDirs[wd] = dir;
+	mFiles.insert(path.string());
+
+	// File times lag the clock slightly, so anything modified within a second of being read counts.
+	struct stat st;
+	if (since && stat(path.c_str(), &st) == 0 && st.st_mtime + MONITOR_SLACK >= since) mPending.insert(path.string());
+	return true;
+}
+
+// Waits for a change.
+bool FileMonitor::wait(FileSet& changed) {
+	changed.swap(mPending);
+	mPending.clear();
+	if (mFd < 0) return false;
+
+	// Block for the first change to a watched file...
+	while (changed.empty()) {
+		struct pollfd p = { mFd, POLLIN, 0 };
+		int n = poll(&p, 1, -1);
+		if (n < 0 && errno != EINTR) return false;
+		if (n > 0 && !read(changed)) return false;
+	}
+
+	// ... and then until the events stop, since saving a file often takes several.
+	for (;;) {
+		struct pollfd p = { mFd, POLLIN, 0 };
+		int n = poll(&p, 1, MONITOR_SETTLE);
+		if (n < 0 && errno != EINTR) return false;
+		if (!n) return true;
+		if (n > 0 && !read(changed)) return false;
+	}
+}
+
+// Reads the pending events.
+bool FileMonitor::read(FileSet& changed) {
+	std::vector<char> buffer(MONITOR_BUFFER);
+	ssize_t n = ::read(mFd, &buffer[0], buffer.size());
+	if (n < 0) return errno == EINTR || errno == EAGAIN;
+
+	for (ssize_t i = 0; i < n; ) {
+		inotify_event const* e = (inotify_event const*)&buffer[i];
+		i += sizeof(inotify_event) + e->len;
+
+		boost::unordered_map<int, std::string>::iterator dir = mDirs.find(e->wd);
+		if (dir == mDirs.end()) continue;
+
+		// The directory is gone, so its files have to be watched again once they're back.
+		if (e->mask & IN_IGNORED) {
+			std::string prefix = dir->second + "/";
+			for (FileSet::iterator it = mFiles.lower_bound(prefix); it != mFiles.end() && !it->compare(0, prefix.size(), prefix); ) {
+				if (it->find('/', prefix.size()) == std::string::npos) mFiles.erase(it++);
+				else it++;
+			}
+			mDirs.erase(dir);
+			continue;
+		}
+		if (!e->len) continue;
+
+		std::string file = (boost::filesystem::path(dir->second) / e->name).string();
+		if (mFiles.count(file)) changed.insert(file);
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,96 @@
+#ifndef __H_FILE_MONITOR__
+#define __H_FILE_MONITOR__
+
+#include <set>
+#include <string>
+#include <ctime>
+
+#include <boost/unordered_map.hpp>
+
+namespace utils {
+
+/**
+ * @brief Waits for a set of files to change, using inotify.
+ * Each file is watched through the directory containing it, so that files which are replaced
+ * rather than written in place (as many editors save them) are still noticed. Changes which
+ * arrive in quick succession are reported together, once the files have settled.
+ *
+ * Files stay watched once they've been added, so that changes made while the caller is busy
+ * are queued up and reported by the next wait() rather than lost.
+ */
+class FileMonitor {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	typedef std::set<std::string> FileSet;
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	int mFd;									///< The inotify instance, or -1 if it couldn't be created.
+	boost::unordered_map<int, std::string> mDirs;	///< The directory each watch descriptor refers to.
+	FileSet mFiles;								///< The canonical names of the files being watched.
+	FileSet mPending;							///< The files which may have changed before they were watched.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * Creates the inotify instance, which good() reports the success of.
+	 */
+	FileMonitor();
+
+	/**
+	 * @brief Basic Destructor.
+	 * Stops watching every file.
+	 */
+	virtual ~FileMonitor();
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/// Determines whether the monitor could be set up.
+	inline bool good() const							{ return mFd >= 0; }
+
+	/**
+	 * @brief Starts watching a file, unless it's already being watched.
+	 * @param file The file to watch, which must exist.
+	 * @param since The time the file was read, or 0. If the file wasn't being watched yet and was modified
+	 * since about then, the change couldn't have been noticed, so it's reported by the next wait() instead.
+	 * @return True if successful, false if the file or its directory can't be watched.
+	 */
+	bool watch(std::string const& file, std::time_t since = 0);
+
+	/**
+	 * @brief Blocks until at least one of the files being watched changes, and then until the changes settle.
+	 * @param changed Populated with the canonical names of the files which changed.
+	 * @return True if successful, false if waiting failed.
+	 */
+	bool wait(FileSet& changed);
+
+private:
+
+	/**
+	 * @brief Reads the pending events, adding the files being watched which they refer to.
+	 * @param changed The files which changed.
+	 * @return True if successful, false if reading failed.
+	 */
+	bool read(FileSet& changed);
+
+	/// Monitors aren't copyable.
+	FileMonitor(FileMonitor const&);
+	FileMonitor& operator=(FileMonitor const&);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,170 @@
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "utilities/Stats.h"
+
+namespace utils {
+
+// A count which wasn't measured.
+size_t const Stats::UNKNOWN;
+
+namespace {
+
+// Adds a count to a total, either of which may be unknown.
+inline size_t add(size_t total, size_t n) {
+	if (n == Stats::UNKNOWN) return total;
+	return (total == Stats::UNKNOWN) ? n : total + n;
+}
+
+// Writes a count in a column of a table.
+void column(std::ostream& out, size_t n) {
+	out << std::setw(12);
+	if (n == Stats::UNKNOWN) out << "-";
+	else out << n;
+}
+
+// Writes a count as a JSON value.
+void value(std::ostream& out, char const* name, size_t n) {
+	out << ", \"" << name << "\": ";
+	if (n == Stats::UNKNOWN) out << "null";
+	else out << n;
+}
+
+}
+
+/******************************************************************************************/
+/* Timer */
+/******************************************************************************************/
+
+// Constructor
+Stats::Timer::Timer(Stats* stats, char const* name)
+	: mStats(stats), mName(name), mRunning(stats != NULL) {
+	mCounts.rules = mCounts.formulas = mCounts.nodes = mCounts.bytes = mCounts.hits = mCounts.misses = UNKNOWN;
+	if (mRunning) mStart = sample();
+}
+
+// Records the run.
+void Stats::Timer::stop() {
+	if (!mRunning) return;
+	mRunning = false;
+	mStats->record(mName, mStart, sample(), mCounts);
+}
+
+/******************************************************************************************/
+/* Stats */
+/******************************************************************************************/
+
+// Constructor
+Stats::Stats() {
+	mStart = sample();
+}
+
+// Starts again.
+void Stats::clear() {
+	mStages.clear();
+	mStart = sample();
+}
+
+// Samples the process.
+Stats::Sample Stats::sample() {
+	Sample s;
+	s.wall = boost::posix_time::microsec_clock::universal_time();
+
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage)) {
+		s.cpu = 0;
+		s.rss = 0;
+	} else {
+		s.cpu = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+		s.rss = usage.ru_maxrss;
+	}
+	return s;
+}
+
+// Adds a run of a stage.
+void Stats::record(char const* name, Sample const& start, Sample const& end, Stage const& counts) {
+	StageList::iterator it = mStages.begin();
+	while (it != mStages.end() && it->name != name) it++;
+
+	if (it == mStages.end()) {
+		Stage s = { name, 0, 0, 0, 0, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+		it = mStages.insert(mStages.end(), s);
+	}
+
+	it->runs++;
+	it->wall += (end.wall - start.wall).total_microseconds() / 1e6;
+	it->cpu += end.cpu - start.cpu;
+	it->rss += end.rss - start.rss;
+	it->rules = add(it->rules, counts.rules);
+	it->formulas = add(it->formulas, counts.formulas);
+	it->nodes = add(it->nodes, counts.nodes);
+	it->bytes = add(it->bytes, counts.bytes);
+	it->hits = add(it->hits, counts.hits);
+	it->misses = add(it->misses, counts.misses);
+}
+
+// Writes the stats.
+void Stats::write(std::ostream& out, Format format) const {
+	Sample now = sample();
+
+	// The stream's formatting is left alone.
+	std::ostringstream buffer;
+	buffer << std::fixed << std::setprecision(3);
+	switch (format) {
+	case TEXT:		text(buffer, now); break;
+	case JSON:		json(buffer, now); break;
+	default:		return;
+	}
+	out << buffer.str();
+	out.flush();
+}
+
+// Writes the stages as a table.
+void Stats::text(std::ostream& out, Sample const& now) const {
+	out << std::left << std::setw(14) << "Stage" << std::right << std::setw(6) << "Runs"
+		<< std::setw(12) << "Wall (ms)" << std::setw(12) << "CPU (ms)" << std::setw(12) << "+RSS (KB)"
+		<< std::setw(12) << "Rules" << std::setw(12) << "Formulas" << std::setw(12) << "Nodes" << std::setw(12) << "Bytes"
+		<< std::setw(12) << "Hits" << std::setw(12) << "Misses" << "\n";
+
+	for (StageList::const_iterator it = mStages.begin(); it != mStages.end(); it++) {
+		out << std::left << std::setw(14) << it->name << std::right << std::setw(6) << it->runs
+			<< std::setw(12) << it->wall * 1e3 << std::setw(12) << it->cpu * 1e3 << std::setw(12) << it->rss;
+		column(out, it->rules);
+		column(out, it->formulas);
+		column(out, it->nodes);
+		column(out, it->bytes);
+		column(out, it->hits);
+		column(out, it->misses);
+		out << "\n";
+	}
+
+	out << std::left << std::setw(14) << "total" << std::right << std::setw(6) << ""
+		<< std::setw(12) << (now.wall - mStart.wall).total_microseconds() / 1e3 << std::setw(12) << (now.cpu - mStart.cpu) * 1e3
+		<< std::setw(12) << now.rss << "  (peak RSS)\n";
+}
+
+// Writes the stages as a JSON object.
+void Stats::json(std::ostream& out, Sample const& now) const {
+	// Stage names are identifiers, so they never need escaping.
+	out << "{\"stages\": [";
+	for (StageList::const_iterator it = mStages.begin(); it != mStages.end(); it++) {
+		out << ((it == mStages.begin()) ? "" : ", ") << "{\"name\": \"" << it->name << "\", \"runs\": " << it->runs
+			<< ", \"wall_ms\": " << it->wall * 1e3 << ", \"cpu_ms\": " << it->cpu * 1e3 << ", \"rss_kb\": " << it->rss;
+		value(out, "rules", it->rules);
+		value(out, "formulas", it->formulas);
+		value(out, "nodes", it->nodes);
+		value(out, "bytes", it->bytes);
+		value(out, "hits", it->hits);
+		value(out, "misses", it->misses);
+		out << "}";
+	}
+	out << "], \"total\": {\"wall_ms\": " << (now.wall - mStart.wall).total_microseconds() / 1e3
+		<< ", \"cpu_ms\": " << (now.cpu - mStart.cpu) * 1e3 << ", \"peak_rss_kb\": " << now.rss << "}}\n";
+}
+
+}
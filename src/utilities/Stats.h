@@ -0,0 +1,203 @@
+#ifndef __H_STATS__
+#define __H_STATS__
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+namespace utils {
+
+/**
+ * @brief Measures the stages of a run: how long each took, how much the process grew while it ran and how much it produced.
+ * Each run of a stage is measured by a Timer, which samples the wall clock, the CPU time of the whole process
+ * (across every thread) and its peak resident set size as it starts and stops. Stages which run more than once,
+ * such as the phases which run again for each query, accumulate under the same name in the order they first ran.
+ *
+ * Sampling takes a couple of system calls per stage, so stats are always collected, and only written when
+ * they're asked for, either as a table for people or as a single line of JSON for programs.
+ */
+class Stats {
+
+public:
+	/***********************************************************************/
+	/* Public Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief The ways stats can be written.
+	 */
+	enum Format {
+		NONE = 0,			///< The stats aren't written.
+		TEXT,				///< A table, one stage to a line.
+		JSON				///< A single JSON object.
+	};
+
+	/// A count which wasn't measured.
+	static size_t const UNKNOWN = (size_t)-1;
+
+	/**
+	 * @brief What was measured for a stage, totalled over every time it ran.
+	 */
+	struct Stage {
+		std::string name;					///< The name of the stage.
+		size_t runs;						///< The number of times the stage ran.
+		double wall;						///< The elapsed time, in seconds.
+		double cpu;							///< The CPU time used by every thread, in seconds.
+		long rss;							///< How much the peak resident set size grew, in kilobytes.
+		size_t rules;						///< The number of rules the stage produced, or UNKNOWN.
+		size_t formulas;					///< The number of formulas the stage produced, or UNKNOWN.
+		size_t nodes;						///< The number of nodes the stage built, or UNKNOWN.
+		size_t bytes;						///< The number of bytes the stage read, wrote or allocated for its nodes, or UNKNOWN.
+		size_t hits;						///< The number of lookups the stage answered from what it had found before, or UNKNOWN.
+		size_t misses;						///< The number of lookups the stage had to search for, or UNKNOWN.
+	};
+
+	typedef std::vector<Stage> StageList;
+
+private:
+	/***********************************************************************/
+	/* Private Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief The state of the process at some moment.
+	 */
+	struct Sample {
+		boost::posix_time::ptime wall;		///< The time.
+		double cpu;							///< The CPU time used so far, in seconds.
+		long rss;							///< The peak resident set size so far, in kilobytes.
+	};
+
+public:
+	/**
+	 * @brief Measures a single run of a stage, from when it's constructed until it's stopped or destroyed.
+	 */
+	class Timer {
+
+	private:
+		Stats* mStats;						///< The stats to record the run in, or NULL to record nothing.
+		char const* mName;					///< The name of the stage.
+		Sample mStart;						///< The state of the process when the run started.
+		Stage mCounts;						///< The counts given for the run.
+		bool mRunning;						///< Whether the run hasn't been recorded yet.
+
+	public:
+		/**
+		 * @brief Starts a run.
+		 * @param stats The stats to record the run in, or NULL to record nothing.
+		 * @param name The name of the stage, which should outlive the timer.
+		 */
+		Timer(Stats* stats, char const* name);
+
+		/**
+		 * @brief Basic Destructor.
+		 * Records the run if it hasn't been already.
+		 */
+		virtual inline ~Timer()						{ stop(); }
+
+		/// Sets the number of rules the run produced.
+		inline void rules(size_t n)					{ mCounts.rules = n; }
+
+		/// Sets the number of formulas the run produced.
+		inline void formulas(size_t n)				{ mCounts.formulas = n; }
+
+		/// Sets the number of nodes the run built.
+		inline void nodes(size_t n)					{ mCounts.nodes = n; }
+
+		/// Sets the number of bytes the run read, wrote or allocated.
+		inline void bytes(size_t n)					{ mCounts.bytes = n; }
+
+		/// Sets the number of lookups the run answered from what it had found before.
+		inline void hits(size_t n)					{ mCounts.hits = n; }
+
+		/// Sets the number of lookups the run had to search for.
+		inline void misses(size_t n)				{ mCounts.misses = n; }
+
+		/**
+		 * @brief Stops the run and records it, along with the counts given so far. Does nothing the second time.
+		 */
+		void stop();
+
+	private:
+		/// Timers aren't copyable.
+		Timer(Timer const&);
+		Timer& operator=(Timer const&);
+
+	};
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	StageList mStages;						///< The stages, in the order they first ran.
+	Sample mStart;							///< The state of the process when the stats were started.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * Starts measuring the total.
+	 */
+	Stats();
+
+	/**
+	 * @brief Basic Destructor.
+	 * Does nothing.
+	 */
+	virtual inline ~Stats() { /* Intentionally Left Blank */ }
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/// Gets the stages which have run.
+	inline StageList const& stages() const			{ return mStages; }
+
+	/**
+	 * @brief Forgets every stage and starts measuring the total again.
+	 */
+	void clear();
+
+	/**
+	 * @brief Writes the stages and the total.
+	 * @param out The stream to write to.
+	 * @param format The way to write them.
+	 */
+	void write(std::ostream& out, Format format) const;
+
+private:
+
+	/**
+	 * @brief Samples the state of the process.
+	 */
+	static Sample sample();
+
+	/**
+	 * @brief Adds a run of a stage.
+	 * @param name The name of the stage.
+	 * @param start The state of the process when the run started.
+	 * @param end The state of the process when the run stopped.
+	 * @param counts The counts given for the run.
+	 */
+	void record(char const* name, Sample const& start, Sample const& end, Stage const& counts);
+
+	/**
+	 * @brief Writes the stages as a table.
+	 */
+	void text(std::ostream& out, Sample const& now) const;
+
+	/**
+	 * @brief Writes the stages as a JSON object.
+	 */
+	void json(std::ostream& out, Sample const& now) const;
+
+};
+
+}
+
+#endif
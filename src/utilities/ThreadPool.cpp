@@ -0,0 +1,83 @@
+#include <boost/bind/bind.hpp>
+#include <boost/thread/thread_time.hpp>
+
+#include "ThreadPool.h"
+
+namespace utils {
+
+// Starts the workers.
+ThreadPool::ThreadPool(size_t threads) {
+	mPending = 0;
+	mStop = false;
+
+	threads = ThreadPool::threads(threads);
+	for (size_t i = 0; i < threads; i++) {
+		mThreads.push_back(new boost::thread(boost::bind(&ThreadPool::work, this)));
+	}
+}
+
+// Finishes up and joins the workers.
+ThreadPool::~ThreadPool() {
+	{
+		boost::lock_guard<boost::mutex> guard(mLock);
+		mStop = true;
+		mWork.notify_all();
+	}
+
+	for (std::vector<boost::thread*>::iterator it = mThreads.begin(); it != mThreads.end(); it++) {
+		(*it)->join();
+		delete *it;
+	}
+}
+
+// Queues a task.
+void ThreadPool::post(task_t const& task) {
+	boost::lock_guard<boost::mutex> guard(mLock);
+	mQueue.push_back(task);
+	mPending++;
+	mWork.notify_one();
+}
+
+// Waits for all outstanding tasks.
+void ThreadPool::wait() {
+	boost::unique_lock<boost::mutex> lock(mLock);
+	while (mPending) mIdle.wait(lock);
+}
+
+// Waits for all outstanding tasks, for a while.
+bool ThreadPool::wait(boost::posix_time::time_duration const& timeout) {
+	boost::system_time until = boost::get_system_time() + timeout;
+	boost::unique_lock<boost::mutex> lock(mLock);
+	while (mPending) {
+		if (!mIdle.timed_wait(lock, until)) return !mPending;
+	}
+	return true;
+}
+
+// Resolves a requested thread count.
+size_t ThreadPool::threads(size_t requested) {
+	if (requested) return requested;
+	size_t hw = boost::thread::hardware_concurrency();
+	return hw ? hw : 1;
+}
+
+// Runs tasks until we're told to stop and there's nothing left to do.
+void ThreadPool::work() {
+	boost::unique_lock<boost::mutex> lock(mLock);
+
+	for (;;) {
+		while (mQueue.empty() && !mStop) mWork.wait(lock);
+		if (mQueue.empty()) break;
+
+		task_t task = mQueue.front();
+		mQueue.pop_front();
+
+		lock.unlock();
+		task();
+		lock.lock();
+
+		if (!--mPending) mIdle.notify_all();
+	}
+}
+
+}
@@ -0,0 +1,102 @@
+#ifndef __H_THREAD_POOL__
+#define __H_THREAD_POOL__
+
+#include <list>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace utils {
+
+/**
+ * @brief A fixed size pool of worker threads which run tasks from a shared queue.
+ */
+class ThreadPool {
+
+public:
+	/***********************************************************************/
+	/* Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief The type of a task which can be run by the pool.
+	 */
+	typedef boost::function<void ()> task_t;
+
+private:
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	std::vector<boost::thread*> mThreads;	///< The worker threads.
+	std::list<task_t> mQueue;				///< The tasks waiting to be run.
+
+	boost::mutex mLock;						///< Guards the queue and the counters.
+	boost::condition_variable mWork;		///< Signalled when a task is posted or the pool is stopping.
+	boost::condition_variable mIdle;		///< Signalled when the last outstanding task finishes.
+
+	size_t mPending;						///< The number of tasks that have been posted but haven't finished.
+	bool mStop;								///< Whether the workers have been asked to exit.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Starts the worker threads.
+	 * @param threads The number of workers to start, or 0 to start one per hardware thread.
+	 */
+	ThreadPool(size_t threads = 0);
+
+	/**
+	 * @brief Basic Destructor.
+	 * Finishes any queued tasks and joins the workers.
+	 */
+	virtual ~ThreadPool();
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/// Gets the number of worker threads in the pool.
+	inline size_t size() const { return mThreads.size(); }
+
+	/**
+	 * @brief Queues a task to be run by the next available worker.
+	 * @param task The task to run. Tasks must not throw.
+	 */
+	void post(task_t const& task);
+
+	/**
+	 * @brief Blocks until every task which has been posted has finished.
+	 */
+	void wait();
+
+	/**
+	 * @brief Blocks until every task which has been posted has finished, or for a while at most.
+	 * @param timeout How long to wait for.
+	 * @return True if every task has finished, false if some are still queued or running.
+	 */
+	bool wait(boost::posix_time::time_duration const& timeout);
+
+	/**
+	 * @brief Determines the number of threads to use for a user requested thread count.
+	 * @param requested The requested number of threads, or 0 for one per hardware thread.
+	 * @return The number of threads to use (at least 1).
+	 */
+	static size_t threads(size_t requested);
+
+private:
+
+	/// The body of each worker thread.
+	void work();
+
+};
+
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include <boost/bind/bind.hpp>
+
+#include "ThreadPool.h"
+#include "WorkStealingPool.h"
+
+namespace utils {
+
+// Constructor
+WorkStealingPool::WorkStealingPool(size_t threads) {
+	mQueued = 0;
+	mPending = 0;
+	mNext = 0;
+
+	threads = ThreadPool::threads(threads);
+	for (size_t i = 0; i < threads; i++) mWorkers.push_back(new Worker());
+}
+
+// Destructor
+WorkStealingPool::~WorkStealingPool() {
+	for (std::vector<Worker*>::iterator it = mWorkers.begin(); it != mWorkers.end(); it++) {
+		delete *it;
+	}
+}
+
+// Queues a task on the next worker.
+void WorkStealingPool::post(task_t const& task) {
+	spawn(mNext, task);
+	mNext = (mNext + 1) % mWorkers.size();
+}
+
+// Queues a task on a worker.
+void WorkStealingPool::spawn(size_t worker, task_t const& task) {
+	// Count the task first so that the counters never drop below the number of tasks actually queued.
+	{
+		boost::lock_guard<boost::mutex> guard(mLock);
+		mQueued++;
+		mPending++;
+	}
+	{
+		boost::lock_guard<boost::mutex> guard(mWorkers[worker]->lock);
+		mWorkers[worker]->tasks.push_back(task);
+	}
+	mWork.notify_one();
+}
+
+// Runs everything.
+void WorkStealingPool::run() {
+	if (mWorkers.size() == 1) {
+		work(0);
+		return;
+	}
+
+	std::vector<boost::thread*> threads;
+	for (size_t i = 0; i < mWorkers.size(); i++) {
+		threads.push_back(new boost::thread(boost::bind(&WorkStealingPool::work, this, i)));
+	}
+	for (std::vector<boost::thread*>::iterator it = threads.begin(); it != threads.end(); it++) {
+		(*it)->join();
+		delete *it;
+	}
+}
+
+// Runs tasks until there are none left anywhere.
+void WorkStealingPool::work(size_t worker) {
+	for (;;) {
+		task_t task;
+		if (take(worker, task)) {
+			task(worker);
+
+			boost::lock_guard<boost::mutex> guard(mLock);
+			if (!--mPending) mWork.notify_all();
+			continue;
+		}
+
+		// Nothing to take, so wait for something to be queued or for everything to finish.
+		boost::unique_lock<boost::mutex> lock(mLock);
+		while (!mQueued && mPending) mWork.wait(lock);
+		if (!mPending) break;
+	}
+}
+
+// Takes a task from our own queue or steals one.
+bool WorkStealingPool::take(size_t worker, task_t& task) {
+	bool found = false;
+
+	{
+		Worker* w = mWorkers[worker];
+		boost::lock_guard<boost::mutex> guard(w->lock);
+		if (!w->tasks.empty()) {
+			task.swap(w->tasks.back());
+			w->tasks.pop_back();
+			found = true;
+		}
+	}
+
+	for (size_t i = 1; !found && i < mWorkers.size(); i++) {
+		Worker* w = mWorkers[(worker + i) % mWorkers.size()];
+		boost::lock_guard<boost::mutex> guard(w->lock);
+		if (!w->tasks.empty()) {
+			task.swap(w->tasks.front());
+			w->tasks.pop_front();
+			found = true;
+		}
+	}
+
+	if (found) {
+		boost::lock_guard<boost::mutex> guard(mLock);
+		mQueued--;
+	}
+	return found;
+}
+
+}
@@ -0,0 +1,121 @@
+#ifndef __H_WORK_STEALING_POOL__
+#define __H_WORK_STEALING_POOL__
+
+#include <deque>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace utils {
+
+/**
+ * @brief A pool of worker threads which each keep their own queue of tasks and steal from one another when they run out.
+ * Tasks can spawn further tasks onto the queue of the worker running them, which that worker then runs
+ * depth first while idle workers steal the oldest (and typically largest) tasks from its other end.
+ * This suits recursive work which splits unevenly.
+ */
+class WorkStealingPool {
+
+public:
+	/***********************************************************************/
+	/* Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief The type of a task which can be run by the pool.
+	 * Tasks are passed the index of the worker running them.
+	 */
+	typedef boost::function<void (size_t)> task_t;
+
+private:
+	/***********************************************************************/
+	/* Private Types */
+	/***********************************************************************/
+
+	/**
+	 * @brief The queue belonging to a single worker.
+	 */
+	struct Worker {
+		boost::mutex lock;					///< Guards the tasks.
+		std::deque<task_t> tasks;			///< The tasks queued on this worker. The worker takes from the back and thieves from the front.
+	};
+
+	/***********************************************************************/
+	/* Members */
+	/***********************************************************************/
+
+	std::vector<Worker*> mWorkers;			///< The workers' queues.
+
+	boost::mutex mLock;						///< Guards the counters.
+	boost::condition_variable mWork;		///< Signalled when a task is queued or the last task finishes.
+
+	size_t mQueued;							///< The number of tasks waiting in a queue.
+	size_t mPending;						///< The number of tasks that have been queued but haven't finished.
+	size_t mNext;							///< The worker the next posted task will be queued on.
+
+public:
+	/***********************************************************************/
+	/* Constructors / Destructors */
+	/***********************************************************************/
+
+	/**
+	 * @brief Basic Constructor.
+	 * The worker threads aren't started until run() is called.
+	 * @param threads The number of workers, or 0 for one per hardware thread.
+	 */
+	WorkStealingPool(size_t threads = 0);
+
+	/**
+	 * @brief Basic Destructor.
+	 * Discards any tasks which haven't been run.
+	 */
+	virtual ~WorkStealingPool();
+
+	/***********************************************************************/
+	/***********************************************************************/
+
+	/// Gets the number of workers in the pool.
+	inline size_t size() const { return mWorkers.size(); }
+
+	/**
+	 * @brief Queues a task, spreading tasks evenly across the workers.
+	 * @param task The task to run. Tasks must not throw.
+	 */
+	void post(task_t const& task);
+
+	/**
+	 * @brief Queues a task on a particular worker. Used by tasks to spawn further tasks.
+	 * @param worker The worker to queue the task on, which is normally the one running the caller.
+	 * @param task The task to run. Tasks must not throw.
+	 */
+	void spawn(size_t worker, task_t const& task);
+
+	/**
+	 * @brief Runs the queued tasks, along with any that they spawn, until there are none left.
+	 * With a single worker the tasks are run on the calling thread.
+	 */
+	void run();
+
+private:
+
+	/// The body of each worker thread.
+	void work(size_t worker);
+
+	/**
+	 * @brief Takes the next task for a worker, either from its own queue or from another worker's.
+	 * @return True if a task was taken, false if every queue was empty.
+	 */
+	bool take(size_t worker, task_t& task);
+
+	/// Work stealing pools aren't copyable.
+	WorkStealingPool(WorkStealingPool const&);
+	WorkStealingPool& operator=(WorkStealingPool const&);
+
+};
+
+}
+
+#endif